@@ -202,6 +202,7 @@
 
 		include "../examples/HelloWorld"
 		include "../examples/BasicDemo"
+		include "../examples/HeadlessBenchmark"
 
 		include "../examples/SharedMemory"
 		include "../examples/MultiThreading"
@@ -226,8 +227,13 @@
 		if not _OPTIONS["no-gtest"] then
 			include "../test/gtest-1.7.0"
 --			include "../test/hello_gtest"
+			include "../test/threads"
 			include "../test/collision"
+			include "../test/BulletCollision"
 			include "../test/BulletDynamics/pendulum"
+			include "../test/BulletDynamics/worldbatch"
+			include "../test/BulletDynamics/world"
+			include "../test/BulletSoftBody"
 			if not _OPTIONS["no-bullet3"] then
 				if not _OPTIONS["no-extras"] then
 					include "../test/InverseDynamics"
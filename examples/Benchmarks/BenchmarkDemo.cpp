@@ -255,7 +255,11 @@ public:
 			sum_ms += ms;
 			sum_ms_samples++;
 			btScalar mean_ms = (btScalar)sum_ms/(btScalar)sum_ms_samples;
-			printf("%d rays in %d ms %d %d %f\n", NUMRAYS * frame_counter, ms, min_ms, max_ms, mean_ms);
+			//headless runs have no render interface, keep their stdout for the benchmark report
+			if (m_guiHelper && m_guiHelper->getRenderInterface())
+			{
+				printf("%d rays in %d ms %d %d %f\n", NUMRAYS * frame_counter, ms, min_ms, max_ms, mean_ms);
+			}
 			ms = 0;
 			frame_counter = 0;
 		}
@@ -265,7 +269,7 @@ public:
 	void draw ()
 	{
 		
-		if (m_guiHelper)
+		if (m_guiHelper && m_guiHelper->getRenderInterface())
 		{
 			btAlignedObjectArray<unsigned int> indices;
 			btAlignedObjectArray<btVector3FloatData> points;
@@ -0,0 +1,511 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+///App_HeadlessBenchmark runs the BenchmarkDemo scenes without a window, for a fixed number of steps and a fixed random seed.
+///For each scene it reports the CProfileManager timings, the steps per second, the peak memory and a checksum of the final state,
+///so runs on different builds can be compared. Usage:
+///App_HeadlessBenchmark [--scene=1..7] [--steps=N] [--seed=N] [--format=json|csv] [--output=file]
+///The peak memory is the peak of the whole process so far, so when several scenes run it includes the earlier scenes;
+///run one --scene per process to measure a scene on its own.
+///With --paircache it instead runs --steps rounds of random pair churn on btHashedOverlappingPairCache and
+///btOpenHashOverlappingPairCache and reports the time per round and a hash of the pair order of each cache.
+
+#include "../Benchmarks/BenchmarkDemo.h"
+
+#include "../CommonInterfaces/CommonExampleInterface.h"
+#include "../CommonInterfaces/CommonGUIHelperInterface.h"
+#include "btBulletDynamicsCommon.h"
+#include "LinearMath/btQuickprof.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+static const char* sSceneNames[] =
+{
+	"3000 boxes",
+	"1000 stack",
+	"Ragdolls",
+	"Convex stack",
+	"Prim vs Mesh",
+	"Convex vs Mesh",
+	"Raycast",
+};
+
+static const int sNumScenes = sizeof(sSceneNames)/sizeof(sSceneNames[0]);
+
+///HeadlessGUIHelper doesn't render anything, it only remembers the world of the example to compute the checksum
+struct HeadlessGUIHelper : public DummyGUIHelper
+{
+	btDiscreteDynamicsWorld* m_dynamicsWorld;
+
+	HeadlessGUIHelper()
+		:m_dynamicsWorld(0)
+	{
+	}
+
+	virtual void autogenerateGraphicsObjects(btDiscreteDynamicsWorld* rbWorld)
+	{
+		m_dynamicsWorld = rbWorld;
+	}
+};
+
+struct BenchmarkPhase
+{
+	char m_name[256];
+	float m_totalTime;
+	int m_totalCalls;
+};
+
+struct BenchmarkResult
+{
+	int m_scene;
+	int m_numSteps;
+	int m_seed;
+	int m_numCollisionObjects;
+	double m_totalTime;
+	long m_peakMemoryKb;
+	unsigned int m_checksum;
+	btAlignedObjectArray<BenchmarkPhase> m_phases;
+};
+
+///peak resident set size of the process in kilobytes, -1 if the platform doesn't report it.
+///This is the maximum since the process started, not since the current scene started.
+static long getPeakMemoryKb()
+{
+#ifndef _WIN32
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+#ifdef __APPLE__
+		return long(usage.ru_maxrss / 1024);
+#else
+		return long(usage.ru_maxrss);
+#endif
+	}
+#endif
+	return -1;
+}
+
+static unsigned int hashBytes(unsigned int hash, const void* data, int numBytes)
+{
+	//FNV-1a
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (int i = 0; i < numBytes; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+///hash of the world transforms and velocities of all collision objects, in the order of the collision object array
+static unsigned int computeStateChecksum(const btDiscreteDynamicsWorld* world)
+{
+	unsigned int hash = 2166136261u;
+	if (!world)
+		return hash;
+	const btCollisionObjectArray& objects = world->getCollisionObjectArray();
+	for (int i = 0; i < objects.size(); i++)
+	{
+		const btCollisionObject* obj = objects[i];
+		const btTransform& tr = obj->getWorldTransform();
+		for (int r = 0; r < 3; r++)
+		{
+			hash = hashBytes(hash, &tr.getBasis()[r][0], 3 * sizeof(btScalar));
+		}
+		hash = hashBytes(hash, &tr.getOrigin()[0], 3 * sizeof(btScalar));
+		const btRigidBody* body = btRigidBody::upcast(obj);
+		if (body)
+		{
+			hash = hashBytes(hash, &body->getLinearVelocity()[0], 3 * sizeof(btScalar));
+			hash = hashBytes(hash, &body->getAngularVelocity()[0], 3 * sizeof(btScalar));
+		}
+	}
+	return hash;
+}
+
+///adds the timings of the current profile tree to the phases, btDiscreteDynamicsWorld::stepSimulation resets the tree every step
+static void accumulatePhases(CProfileIterator* profileIterator, const char* parentPath, btAlignedObjectArray<BenchmarkPhase>& phases)
+{
+	btAlignedObjectArray<int> children;
+	for (profileIterator->First(); !profileIterator->Is_Done(); profileIterator->Next())
+	{
+		char name[256];
+		if (parentPath[0])
+			sprintf(name, "%.120s/%.120s", parentPath, profileIterator->Get_Current_Name());
+		else
+			sprintf(name, "%.240s", profileIterator->Get_Current_Name());
+		int index = 0;
+		while (index < phases.size() && strcmp(phases[index].m_name, name) != 0)
+			index++;
+		if (index == phases.size())
+		{
+			BenchmarkPhase phase;
+			strcpy(phase.m_name, name);
+			phase.m_totalTime = 0.f;
+			phase.m_totalCalls = 0;
+			phases.push_back(phase);
+		}
+		phases[index].m_totalTime += profileIterator->Get_Current_Total_Time();
+		phases[index].m_totalCalls += profileIterator->Get_Current_Total_Calls();
+		children.push_back(index);
+	}
+	for (int i = 0; i < children.size(); i++)
+	{
+		char path[256];
+		strcpy(path, phases[children[i]].m_name);
+		profileIterator->Enter_Child(i);
+		accumulatePhases(profileIterator, path, phases);
+		profileIterator->Enter_Parent();
+	}
+}
+
+static void runScene(int scene, int numSteps, int seed, BenchmarkResult& result)
+{
+	HeadlessGUIHelper noGfx;
+	CommonExampleOptions options(&noGfx, scene);
+
+	//the mesh scenes pick random shapes
+	srand(seed);
+	CommonExampleInterface* example = BenchmarkCreateFunc(options);
+	example->initPhysics();
+
+	result.m_scene = scene;
+	result.m_numSteps = numSteps;
+	result.m_seed = seed;
+	result.m_totalTime = 0;
+	result.m_phases.clear();
+	btClock clock;
+	for (int i = 0; i < numSteps; i++)
+	{
+		clock.reset();
+		example->stepSimulation(1.f / 60.f);
+		result.m_totalTime += clock.getTimeMicroseconds() / 1000.0;
+
+		CProfileIterator* profileIterator = CProfileManager::Get_Iterator();
+		accumulatePhases(profileIterator, "", result.m_phases);
+		CProfileManager::Release_Iterator(profileIterator);
+	}
+
+	result.m_numCollisionObjects = noGfx.m_dynamicsWorld ? noGfx.m_dynamicsWorld->getNumCollisionObjects() : 0;
+	result.m_checksum = computeStateChecksum(noGfx.m_dynamicsWorld);
+	result.m_peakMemoryKb = getPeakMemoryKb();
+
+	example->exitPhysics();
+	delete example;
+}
+
+struct PairCacheResult
+{
+	const char* m_name;
+	int m_numRounds;
+	int m_seed;
+	int m_numPairs;
+	double m_addTime;
+	double m_removeTime;
+	double m_findTime;
+	int m_numFound;
+	unsigned int m_checksum;
+};
+
+static unsigned int nextRandom(unsigned int& state)
+{
+	state = state * 1664525u + 1013904223u;
+	return state >> 8;
+}
+
+///adds and removes batches of random pairs between fake proxies, like the broadphase does when many objects move,
+///and looks up random pairs in between. Both caches get the same sequence, so their pair orders should match.
+static void runPairCacheChurn(btOverlappingPairCache* pairCache, const char* name, int numRounds, int seed, PairCacheResult& result)
+{
+	const int numProxies = 8192;
+	const int numPairsPerRound = 16384;
+	const int proxyWindow = 64;
+
+	btAlignedObjectArray<btBroadphaseProxy> proxies;
+	proxies.resize(numProxies);
+	for (int i = 0; i < numProxies; i++)
+	{
+		proxies[i].m_collisionFilterGroup = btBroadphaseProxy::AllFilter;
+		proxies[i].m_collisionFilterMask = btBroadphaseProxy::AllFilter;
+		proxies[i].m_uniqueId = i + 2;
+	}
+
+	result.m_name = name;
+	result.m_numRounds = numRounds;
+	result.m_seed = seed;
+	result.m_addTime = 0;
+	result.m_removeTime = 0;
+	result.m_findTime = 0;
+	result.m_numFound = 0;
+
+	unsigned int state = seed;
+	btAlignedObjectArray<btBroadphaseProxy*> batch;
+	btClock clock;
+	for (int round = 0; round < numRounds; round++)
+	{
+		//new pairs are close in proxy index, so some of them are already in the cache
+		batch.resize(0);
+		for (int i = 0; i < numPairsPerRound; i++)
+		{
+			int a = nextRandom(state) % numProxies;
+			int b = (a + 1 + nextRandom(state) % proxyWindow) % numProxies;
+			batch.push_back(&proxies[a]);
+			batch.push_back(&proxies[b]);
+		}
+		clock.reset();
+		pairCache->addOverlappingPairs(&batch[0], numPairsPerRound);
+		result.m_addTime += clock.getTimeMicroseconds() / 1000.0;
+
+		batch.resize(0);
+		for (int i = 0; i < numPairsPerRound; i++)
+		{
+			int a = nextRandom(state) % numProxies;
+			int b = (a + 1 + nextRandom(state) % proxyWindow) % numProxies;
+			batch.push_back(&proxies[a]);
+			batch.push_back(&proxies[b]);
+		}
+		clock.reset();
+		for (int i = 0; i < numPairsPerRound; i++)
+		{
+			if (pairCache->findPair(batch[i * 2], batch[i * 2 + 1]))
+				result.m_numFound++;
+		}
+		result.m_findTime += clock.getTimeMicroseconds() / 1000.0;
+
+		//remove about a third of the pairs, picked from the pair array
+		const btBroadphasePairArray& pairs = pairCache->getOverlappingPairArray();
+		int numRemove = pairs.size() / 3;
+		batch.resize(0);
+		for (int i = 0; i < numRemove; i++)
+		{
+			const btBroadphasePair& pair = pairs[nextRandom(state) % pairs.size()];
+			batch.push_back(pair.m_pProxy0);
+			batch.push_back(pair.m_pProxy1);
+		}
+		clock.reset();
+		if (numRemove)
+			pairCache->removeOverlappingPairs(&batch[0], numRemove, 0);
+		result.m_removeTime += clock.getTimeMicroseconds() / 1000.0;
+	}
+
+	const btBroadphasePairArray& pairs = pairCache->getOverlappingPairArray();
+	result.m_numPairs = pairs.size();
+	unsigned int checksum = 2166136261u;
+	for (int i = 0; i < pairs.size(); i++)
+	{
+		int uids[2] = {pairs[i].m_pProxy0->getUid(), pairs[i].m_pProxy1->getUid()};
+		checksum = hashBytes(checksum, uids, sizeof(uids));
+	}
+	result.m_checksum = checksum;
+}
+
+static void writePairCacheResults(FILE* f, const PairCacheResult* results, int numResults, bool csv)
+{
+	if (csv)
+		fprintf(f, "cache,rounds,seed,pairs,add_ms,find_ms,remove_ms,ms_per_round,found,checksum\n");
+	else
+		fprintf(f, "[\n");
+	for (int i = 0; i < numResults; i++)
+	{
+		const PairCacheResult& r = results[i];
+		double total = r.m_addTime + r.m_findTime + r.m_removeTime;
+		double perRound = r.m_numRounds ? total / r.m_numRounds : 0;
+		if (csv)
+		{
+			fprintf(f, "%s,%d,%d,%d,%.3f,%.3f,%.3f,%.4f,%d,%08x\n", r.m_name, r.m_numRounds, r.m_seed, r.m_numPairs,
+					r.m_addTime, r.m_findTime, r.m_removeTime, perRound, r.m_numFound, r.m_checksum);
+		}
+		else
+		{
+			fprintf(f, "  {\"cache\": \"%s\", \"rounds\": %d, \"seed\": %d, \"pairs\": %d, \"add_ms\": %.3f, \"find_ms\": %.3f, "
+					   "\"remove_ms\": %.3f, \"ms_per_round\": %.4f, \"found\": %d, \"checksum\": \"%08x\"}%s\n",
+					r.m_name, r.m_numRounds, r.m_seed, r.m_numPairs, r.m_addTime, r.m_findTime, r.m_removeTime, perRound,
+					r.m_numFound, r.m_checksum, i + 1 < numResults ? "," : "");
+		}
+	}
+	if (!csv)
+		fprintf(f, "]\n");
+}
+
+static double getStepsPerSecond(const BenchmarkResult& result)
+{
+	return result.m_totalTime > 0 ? result.m_numSteps * 1000.0 / result.m_totalTime : 0;
+}
+
+static void writeJson(FILE* f, const btAlignedObjectArray<BenchmarkResult*>& results)
+{
+	fprintf(f, "[\n");
+	for (int i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& r = *results[i];
+		fprintf(f, "  {\n");
+		fprintf(f, "    \"scene\": %d,\n", r.m_scene);
+		fprintf(f, "    \"name\": \"%s\",\n", sSceneNames[r.m_scene - 1]);
+		fprintf(f, "    \"steps\": %d,\n", r.m_numSteps);
+		fprintf(f, "    \"seed\": %d,\n", r.m_seed);
+		fprintf(f, "    \"collision_objects\": %d,\n", r.m_numCollisionObjects);
+		fprintf(f, "    \"total_ms\": %.3f,\n", r.m_totalTime);
+		fprintf(f, "    \"steps_per_sec\": %.3f,\n", getStepsPerSecond(r));
+		fprintf(f, "    \"process_peak_memory_kb\": %ld,\n", r.m_peakMemoryKb);
+		fprintf(f, "    \"checksum\": \"%08x\",\n", r.m_checksum);
+		fprintf(f, "    \"phases\": [");
+		for (int p = 0; p < r.m_phases.size(); p++)
+		{
+			const BenchmarkPhase& phase = r.m_phases[p];
+			fprintf(f, "%s\n      {\"name\": \"%s\", \"total_ms\": %.3f, \"ms_per_step\": %.4f, \"calls\": %d}",
+				p ? "," : "", phase.m_name, phase.m_totalTime, r.m_numSteps ? phase.m_totalTime / r.m_numSteps : 0.f, phase.m_totalCalls);
+		}
+		fprintf(f, "\n    ]\n");
+		fprintf(f, "  }%s\n", i + 1 < results.size() ? "," : "");
+	}
+	fprintf(f, "]\n");
+}
+
+static void writeCsv(FILE* f, const btAlignedObjectArray<BenchmarkResult*>& results)
+{
+	fprintf(f, "scene,name,steps,seed,metric,value,calls\n");
+	for (int i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& r = *results[i];
+		const char* name = sSceneNames[r.m_scene - 1];
+		fprintf(f, "%d,%s,%d,%d,collision_objects,%d,\n", r.m_scene, name, r.m_numSteps, r.m_seed, r.m_numCollisionObjects);
+		fprintf(f, "%d,%s,%d,%d,total_ms,%.3f,\n", r.m_scene, name, r.m_numSteps, r.m_seed, r.m_totalTime);
+		fprintf(f, "%d,%s,%d,%d,steps_per_sec,%.3f,\n", r.m_scene, name, r.m_numSteps, r.m_seed, getStepsPerSecond(r));
+		fprintf(f, "%d,%s,%d,%d,process_peak_memory_kb,%ld,\n", r.m_scene, name, r.m_numSteps, r.m_seed, r.m_peakMemoryKb);
+		fprintf(f, "%d,%s,%d,%d,checksum,%08x,\n", r.m_scene, name, r.m_numSteps, r.m_seed, r.m_checksum);
+		for (int p = 0; p < r.m_phases.size(); p++)
+		{
+			const BenchmarkPhase& phase = r.m_phases[p];
+			fprintf(f, "%d,%s,%d,%d,phase_ms:%s,%.3f,%d\n", r.m_scene, name, r.m_numSteps, r.m_seed, phase.m_name, phase.m_totalTime, phase.m_totalCalls);
+		}
+	}
+}
+
+static void printUsage()
+{
+	printf("usage: App_HeadlessBenchmark [--scene=1..%d] [--steps=N] [--seed=N] [--format=json|csv] [--output=file] [--paircache]\n", sNumScenes);
+	for (int i = 0; i < sNumScenes; i++)
+	{
+		printf("  scene %d: %s\n", i + 1, sSceneNames[i]);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	int scene = 0;//all scenes
+	int numSteps = 300;
+	int seed = 0;
+	bool csv = false;
+	const char* outputFileName = 0;
+	bool pairCacheBenchmark = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		if (strncmp(arg, "--scene=", 8) == 0)
+		{
+			scene = atoi(arg + 8);
+		}
+		else if (strncmp(arg, "--steps=", 8) == 0)
+		{
+			numSteps = atoi(arg + 8);
+		}
+		else if (strncmp(arg, "--seed=", 7) == 0)
+		{
+			seed = atoi(arg + 7);
+		}
+		else if (strcmp(arg, "--format=csv") == 0)
+		{
+			csv = true;
+		}
+		else if (strcmp(arg, "--format=json") == 0)
+		{
+			csv = false;
+		}
+		else if (strncmp(arg, "--output=", 9) == 0)
+		{
+			outputFileName = arg + 9;
+		}
+		else if (strcmp(arg, "--paircache") == 0)
+		{
+			pairCacheBenchmark = true;
+		}
+		else
+		{
+			printUsage();
+			return 1;
+		}
+	}
+	if (scene < 0 || scene > sNumScenes || numSteps < 0)
+	{
+		printUsage();
+		return 1;
+	}
+
+	if (pairCacheBenchmark)
+	{
+		PairCacheResult pairCacheResults[2];
+		btHashedOverlappingPairCache hashedPairCache;
+		runPairCacheChurn(&hashedPairCache, "btHashedOverlappingPairCache", numSteps, seed, pairCacheResults[0]);
+		btOpenHashOverlappingPairCache openHashPairCache;
+		runPairCacheChurn(&openHashPairCache, "btOpenHashOverlappingPairCache", numSteps, seed, pairCacheResults[1]);
+
+		FILE* f = outputFileName ? fopen(outputFileName, "w") : stdout;
+		if (!f)
+		{
+			printf("cannot open %s\n", outputFileName);
+			return 1;
+		}
+		writePairCacheResults(f, pairCacheResults, 2, csv);
+		if (f != stdout)
+			fclose(f);
+		return 0;
+	}
+
+	btAlignedObjectArray<BenchmarkResult*> results;
+	for (int s = 1; s <= sNumScenes; s++)
+	{
+		if (scene && scene != s)
+			continue;
+		BenchmarkResult* result = new BenchmarkResult;
+		runScene(s, numSteps, seed, *result);
+		results.push_back(result);
+	}
+
+	FILE* f = outputFileName ? fopen(outputFileName, "w") : stdout;
+	if (!f)
+	{
+		printf("cannot open %s\n", outputFileName);
+		return 1;
+	}
+	if (csv)
+		writeCsv(f, results);
+	else
+		writeJson(f, results);
+	if (f != stdout)
+		fclose(f);
+
+	for (int i = 0; i < results.size(); i++)
+	{
+		delete results[i];
+	}
+	return 0;
+}
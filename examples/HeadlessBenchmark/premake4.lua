@@ -0,0 +1,19 @@
+
+project "App_HeadlessBenchmark"
+
+kind "ConsoleApp"
+
+includedirs {"../../src"}
+
+links {
+	"BulletDynamics","BulletCollision", "LinearMath"
+}
+
+language "C++"
+
+files {
+	"**.cpp",
+	"**.h",
+	"../Benchmarks/BenchmarkDemo.cpp",
+	"../Benchmarks/BenchmarkDemo.h",
+}
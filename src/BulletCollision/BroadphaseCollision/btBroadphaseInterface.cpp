@@ -0,0 +1,59 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2006 Erwin Coumans  http://continuousphysics.com/Bullet/
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose, 
+including commercial applications, and to alter it and redistribute it freely, 
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btBroadphaseInterface.h"
+
+///btPacketLaneRayCallback forwards the proxies hit by a single ray of a packet to the packet callback
+struct btPacketLaneRayCallback : public btBroadphaseRayCallback
+{
+	btBroadphaseRayPacketCallback&	m_packetCallback;
+	int								m_lane;
+	btScalar						m_rayLength;
+
+	btPacketLaneRayCallback(btBroadphaseRayPacketCallback& packetCallback,int lane)
+		:m_packetCallback(packetCallback),
+		m_lane(lane)
+	{
+		btVector3 rayDir = packetCallback.m_rayTo[lane]-packetCallback.m_rayFrom[lane];
+		m_rayLength = rayDir.length();
+		if (m_rayLength > SIMD_EPSILON)
+		{
+			rayDir /= m_rayLength;
+		}
+		m_rayDirectionInverse[0] = rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0];
+		m_rayDirectionInverse[1] = rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1];
+		m_rayDirectionInverse[2] = rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2];
+		m_signs[0] = m_rayDirectionInverse[0] < 0.0;
+		m_signs[1] = m_rayDirectionInverse[1] < 0.0;
+		m_signs[2] = m_rayDirectionInverse[2] < 0.0;
+		m_lambda_max = m_rayLength*packetCallback.m_lambdaMax[lane];
+	}
+
+	virtual bool	process(const btBroadphaseProxy* proxy)
+	{
+		m_packetCallback.process(proxy,1<<m_lane);
+		m_lambda_max = m_rayLength*m_packetCallback.m_lambdaMax[m_lane];
+		return true;
+	}
+};
+
+void	btBroadphaseInterface::rayTestPacket(btBroadphaseRayPacketCallback& packetCallback)
+{
+	for (int lane=0;lane<packetCallback.m_numRays;lane++)
+	{
+		btPacketLaneRayCallback rayCallback(packetCallback,lane);
+		rayTest(packetCallback.m_rayFrom[lane],packetCallback.m_rayTo[lane],rayCallback);
+	}
+}
@@ -45,6 +45,24 @@ struct	btBroadphaseRayCallback : public btBroadphaseAabbCallback
 
 #include "LinearMath/btVector3.h"
 
+///Number of rays traced together by btBroadphaseInterface::rayTestPacket
+#define BT_RAY_PACKET_SIZE 4
+
+///btBroadphaseRayPacketCallback traces a packet of up to BT_RAY_PACKET_SIZE rays through the broadphase.
+///process is called once per proxy with a bit set for every ray of the packet whose segment overlaps the proxy aabb.
+///process lowers m_lambdaMax of a ray once it found a hit, so that proxies further along that ray are culled.
+struct	btBroadphaseRayPacketCallback
+{
+	btVector3		m_rayFrom[BT_RAY_PACKET_SIZE];
+	btVector3		m_rayTo[BT_RAY_PACKET_SIZE];
+	///fraction along each ray, between 0 and 1, beyond which aabbs are not reported
+	btScalar		m_lambdaMax[BT_RAY_PACKET_SIZE];
+	int				m_numRays;
+
+	virtual ~btBroadphaseRayPacketCallback() {}
+	virtual void	process(const btBroadphaseProxy* proxy, int rayMask) = 0;
+};
+
 ///The btBroadphaseInterface class provides an interface to detect aabb-overlapping object pairs.
 ///Some implementations for this broadphase interface include btAxisSweep3, bt32BitAxisSweep3 and btDbvtBroadphase.
 ///The actual overlapping pair management, storage, adding and removing of pairs is dealt by the btOverlappingPairCache class.
@@ -58,8 +76,20 @@ public:
 	virtual void	setAabb(btBroadphaseProxy* proxy,const btVector3& aabbMin,const btVector3& aabbMax, btDispatcher* dispatcher)=0;
 	virtual void	getAabb(btBroadphaseProxy* proxy,btVector3& aabbMin, btVector3& aabbMax ) const =0;
 
+	///setAabbs updates the aabbs of several proxies at once, broadphases that can apply a whole batch more efficiently override it
+	virtual void	setAabbs(btBroadphaseProxy** proxies,const btVector3* aabbMins,const btVector3* aabbMaxs,int numProxies,btDispatcher* dispatcher)
+	{
+		for (int i=0;i<numProxies;i++)
+		{
+			setAabb(proxies[i],aabbMins[i],aabbMaxs[i],dispatcher);
+		}
+	}
+
 	virtual void	rayTest(const btVector3& rayFrom,const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin=btVector3(0,0,0), const btVector3& aabbMax = btVector3(0,0,0)) = 0;
 
+	///rayTestPacket traces all rays of the packet, the default implementation casts them one at a time with rayTest
+	virtual void	rayTestPacket(btBroadphaseRayPacketCallback& packetCallback);
+
 	virtual void	aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback) = 0;
 
 	///calculateOverlappingPairs is optional: incremental algorithms (sweep and prune) might do it during the set aabb
@@ -172,7 +172,8 @@ static void						insertleaf(	btDbvt* pdbvt,
 
 //
 static btDbvtNode*				removeleaf(	btDbvt* pdbvt,
-										   btDbvtNode* leaf)
+										   btDbvtNode* leaf,
+										   bool refit=true)
 {
 	if(leaf==pdbvt->m_root)
 	{
@@ -189,7 +190,8 @@ static btDbvtNode*				removeleaf(	btDbvt* pdbvt,
 			prev->childs[indexof(parent)]=sibling;
 			sibling->parent=prev;
 			deletenode(pdbvt,parent);
-			while(prev)
+			//without refit the ancestors keep their old volume, which still bounds the remaining leaves
+			while(prev&&refit)
 			{
 				const btDbvtVolume	pb=prev->volume;
 				Merge(prev->childs[0]->volume,prev->childs[1]->volume,prev->volume);
@@ -246,6 +248,30 @@ static void						split(	const tNodeArray& leaves,
 	}
 }
 
+//
+static void						refitvolumes(	btDbvt* pdbvt)
+{
+	if(!pdbvt->m_root||pdbvt->m_root->isleaf()) return;
+	tNodeArray	stack;
+	tNodeArray	internals;
+	stack.reserve(btDbvt::SIMPLE_STACKSIZE);
+	internals.reserve(pdbvt->m_leaves);
+	stack.push_back(pdbvt->m_root);
+	do	{
+		btDbvtNode*	n=stack[stack.size()-1];
+		stack.pop_back();
+		internals.push_back(n);
+		if(n->childs[0]->isinternal()) stack.push_back(n->childs[0]);
+		if(n->childs[1]->isinternal()) stack.push_back(n->childs[1]);
+	} while(stack.size()>0);
+	/* parents are visited before their children, so merge in reverse order	*/ 
+	for(int i=internals.size()-1;i>=0;--i)
+	{
+		btDbvtNode*	n=internals[i];
+		Merge(n->childs[0]->volume,n->childs[1]->volume,n->volume);
+	}
+}
+
 //
 static btDbvtVolume				bounds(	const tNodeArray& leaves)
 {
@@ -553,6 +579,39 @@ bool			btDbvt::update(btDbvtNode* leaf,btDbvtVolume& volume,btScalar margin)
 	return(true);
 }
 
+//
+void			btDbvt::updateLeaves(btDbvtNode** leaves,const btDbvtVolume* volumes,int count)
+{
+	/* a single refit walks about log2(leaves) nodes, a full refit walks all of them	*/ 
+	if(count*16<m_leaves)
+	{
+		for(int i=0;i<count;++i)
+		{
+			btDbvtVolume	volume=volumes[i];
+			update(leaves[i],volume);
+		}
+		return;
+	}
+	for(int i=0;i<count;++i)
+	{
+		btDbvtNode*	leaf=leaves[i];
+		btDbvtNode*	root=removeleaf(this,leaf,false);
+		if(root)
+		{
+			if(m_lkhd>=0)
+			{
+				for(int j=0;(j<m_lkhd)&&root->parent;++j)
+				{
+					root=root->parent;
+				}
+			} else root=m_root;
+		}
+		leaf->volume=volumes[i];
+		insertleaf(this,root,leaf);
+	}
+	refitvolumes(this);
+}
+
 //
 void			btDbvt::remove(btDbvtNode* leaf)
 {
@@ -280,6 +280,8 @@ struct	btDbvt
 	bool			update(btDbvtNode* leaf,btDbvtVolume& volume,const btVector3& velocity,btScalar margin);
 	bool			update(btDbvtNode* leaf,btDbvtVolume& volume,const btVector3& velocity);
 	bool			update(btDbvtNode* leaf,btDbvtVolume& volume,btScalar margin);	
+	///reinserts the leaves with the new volumes, for large batches the tree is refitted once at the end instead of after each leaf
+	void			updateLeaves(btDbvtNode** leaves,const btDbvtVolume* volumes,int count);
 	void			remove(btDbvtNode* leaf);
 	void			write(IWriter* iwriter) const;
 	void			clone(btDbvt& dest,IClone* iclone=0) const;
@@ -307,6 +309,12 @@ struct	btDbvt
 		void		collideTTpersistentStack(	const btDbvtNode* root0,
 		  const btDbvtNode* root1,
 		  DBVT_IPOLICY);
+	///collideTTpersistentStack with a stack owned by the caller, so several threads can collide the same trees when each uses its own stack
+	DBVT_PREFIX
+		static void		collideTTpersistentStack(	const btDbvtNode* root0,
+		  const btDbvtNode* root1,
+		  btAlignedObjectArray<sStkNN>& stack,
+		  DBVT_IPOLICY);
 #if 0
 	DBVT_PREFIX
 		void		collideTT(	const btDbvtNode* root0,
@@ -344,6 +352,18 @@ struct	btDbvt
 								const btVector3& aabbMin,
 								const btVector3& aabbMax,
 								DBVT_IPOLICY) const;
+	///rayTestInternal with a stack owned by the caller, so several threads can cast rays against the same tree when each uses its own stack
+	DBVT_PREFIX
+		void		rayTestInternal(	const btDbvtNode* root,
+								const btVector3& rayFrom,
+								const btVector3& rayTo,
+								const btVector3& rayDirectionInverse,
+								unsigned int signs[3],
+								btScalar lambda_max,
+								const btVector3& aabbMin,
+								const btVector3& aabbMax,
+								btAlignedObjectArray<const btDbvtNode*>& stack,
+								DBVT_IPOLICY) const;
 
 	DBVT_PREFIX
 		static void		collideKDOP(const btDbvtNode* root,
@@ -789,6 +809,16 @@ DBVT_PREFIX
 inline void		btDbvt::collideTTpersistentStack(	const btDbvtNode* root0,
 								  const btDbvtNode* root1,
 								  DBVT_IPOLICY)
+{
+	collideTTpersistentStack(root0,root1,m_stkStack,policy);
+}
+
+//
+DBVT_PREFIX
+inline void		btDbvt::collideTTpersistentStack(	const btDbvtNode* root0,
+								  const btDbvtNode* root1,
+								  btAlignedObjectArray<sStkNN>& stack,
+								  DBVT_IPOLICY)
 {
 	DBVT_CHECKTYPE
 		if(root0&&root1)
@@ -796,22 +826,22 @@ inline void		btDbvt::collideTTpersistentStack(	const btDbvtNode* root0,
 			int								depth=1;
 			int								treshold=DOUBLE_STACKSIZE-4;
 			
-			m_stkStack.resize(DOUBLE_STACKSIZE);
-			m_stkStack[0]=sStkNN(root0,root1);
+			stack.resize(DOUBLE_STACKSIZE);
+			stack[0]=sStkNN(root0,root1);
 			do	{		
-				sStkNN	p=m_stkStack[--depth];
+				sStkNN	p=stack[--depth];
 				if(depth>treshold)
 				{
-					m_stkStack.resize(m_stkStack.size()*2);
-					treshold=m_stkStack.size()-4;
+					stack.resize(stack.size()*2);
+					treshold=stack.size()-4;
 				}
 				if(p.a==p.b)
 				{
 					if(p.a->isinternal())
 					{
-						m_stkStack[depth++]=sStkNN(p.a->childs[0],p.a->childs[0]);
-						m_stkStack[depth++]=sStkNN(p.a->childs[1],p.a->childs[1]);
-						m_stkStack[depth++]=sStkNN(p.a->childs[0],p.a->childs[1]);
+						stack[depth++]=sStkNN(p.a->childs[0],p.a->childs[0]);
+						stack[depth++]=sStkNN(p.a->childs[1],p.a->childs[1]);
+						stack[depth++]=sStkNN(p.a->childs[0],p.a->childs[1]);
 					}
 				}
 				else if(Intersect(p.a->volume,p.b->volume))
@@ -820,23 +850,23 @@ inline void		btDbvt::collideTTpersistentStack(	const btDbvtNode* root0,
 					{
 						if(p.b->isinternal())
 						{
-							m_stkStack[depth++]=sStkNN(p.a->childs[0],p.b->childs[0]);
-							m_stkStack[depth++]=sStkNN(p.a->childs[1],p.b->childs[0]);
-							m_stkStack[depth++]=sStkNN(p.a->childs[0],p.b->childs[1]);
-							m_stkStack[depth++]=sStkNN(p.a->childs[1],p.b->childs[1]);
+							stack[depth++]=sStkNN(p.a->childs[0],p.b->childs[0]);
+							stack[depth++]=sStkNN(p.a->childs[1],p.b->childs[0]);
+							stack[depth++]=sStkNN(p.a->childs[0],p.b->childs[1]);
+							stack[depth++]=sStkNN(p.a->childs[1],p.b->childs[1]);
 						}
 						else
 						{
-							m_stkStack[depth++]=sStkNN(p.a->childs[0],p.b);
-							m_stkStack[depth++]=sStkNN(p.a->childs[1],p.b);
+							stack[depth++]=sStkNN(p.a->childs[0],p.b);
+							stack[depth++]=sStkNN(p.a->childs[1],p.b);
 						}
 					}
 					else
 					{
 						if(p.b->isinternal())
 						{
-							m_stkStack[depth++]=sStkNN(p.a,p.b->childs[0]);
-							m_stkStack[depth++]=sStkNN(p.a,p.b->childs[1]);
+							stack[depth++]=sStkNN(p.a,p.b->childs[0]);
+							stack[depth++]=sStkNN(p.a,p.b->childs[1]);
 						}
 						else
 						{
@@ -960,6 +990,22 @@ inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
 								const btVector3& aabbMin,
 								const btVector3& aabbMax,
 								DBVT_IPOLICY) const
+{
+	rayTestInternal(root,rayFrom,rayTo,rayDirectionInverse,signs,lambda_max,aabbMin,aabbMax,m_rayTestStack,policy);
+}
+
+//
+DBVT_PREFIX
+inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
+								const btVector3& rayFrom,
+								const btVector3& rayTo,
+								const btVector3& rayDirectionInverse,
+								unsigned int signs[3],
+								btScalar lambda_max,
+								const btVector3& aabbMin,
+								const btVector3& aabbMax,
+								btAlignedObjectArray<const btDbvtNode*>& stack,
+								DBVT_IPOLICY) const
 {
         (void) rayTo;
 	DBVT_CHECKTYPE
@@ -969,7 +1015,6 @@ inline void		btDbvt::rayTestInternal(	const btDbvtNode* root,
 
 		int								depth=1;
 		int								treshold=DOUBLE_STACKSIZE-2;
-		btAlignedObjectArray<const btDbvtNode*>&	stack = m_rayTestStack;
 		stack.resize(DOUBLE_STACKSIZE);
 		stack[0]=root;
 		btVector3 bounds[2];
@@ -16,6 +16,7 @@ subject to the following restrictions:
 ///btDbvtBroadphase implementation by Nathanael Presson
 
 #include "btDbvtBroadphase.h"
+#include "LinearMath/btQuickprof.h"
 
 //
 // Profiling
@@ -114,6 +115,71 @@ struct	btDbvtTreeCollider : btDbvt::ICollide
 	}
 };
 
+/* Buffered tree collider, used by the parallel pair finding	*/ 
+struct	btDbvtBufferedTreeCollider : btDbvt::ICollide
+{
+	btAlignedObjectArray<btBroadphaseProxy*>*	pairs;
+	btDbvtBufferedTreeCollider(btAlignedObjectArray<btBroadphaseProxy*>* p) : pairs(p) {}
+	void	Process(const btDbvtNode* na,const btDbvtNode* nb)
+	{
+		if(na!=nb)
+		{
+			btDbvtProxy*	pa=(btDbvtProxy*)na->data;
+			btDbvtProxy*	pb=(btDbvtProxy*)nb->data;
+#if DBVT_BP_SORTPAIRS
+			if(pa->m_uniqueId>pb->m_uniqueId) 
+				btSwap(pa,pb);
+#endif
+			pairs->push_back(pa);
+			pairs->push_back(pb);
+		}
+	}
+};
+
+/* Collides a range of tasks into the buffer of the current thread	*/ 
+struct	btDbvtCollideLoop : btIParallelForBody
+{
+	btDbvtBroadphase*	pbp;
+	bool				batch;
+	btDbvtCollideLoop(btDbvtBroadphase* p,bool b) : pbp(p),batch(b) {}
+	void	forLoop(int iBegin,int iEnd) const
+	{
+		btDbvtPairBuffer&			buffer=pbp->m_pairBuffers[btGetCurrentThreadIndex()];
+		btDbvtBufferedTreeCollider	collider(&buffer.m_pairs);
+		btDbvtPairSegment			segment;
+		segment.m_firstTask		=	iBegin;
+		segment.m_firstPair		=	buffer.m_pairs.size()/2;
+		segment.m_threadIndex	=	btGetCurrentThreadIndex();
+		for(int i=iBegin;i<iEnd;++i)
+		{
+			if(batch)
+			{
+				const btDbvtNode*	leaf=pbp->m_batchCollide[i]->leaf;
+				btDbvt::collideTTpersistentStack(pbp->m_sets[1].m_root,leaf,buffer.m_stack,collider);
+				btDbvt::collideTTpersistentStack(pbp->m_sets[0].m_root,leaf,buffer.m_stack,collider);
+			}
+			else
+			{
+				const btDbvt::sStkNN&	task=pbp->m_collideTasks[i];
+				btDbvt::collideTTpersistentStack(task.a,task.b,buffer.m_stack,collider);
+			}
+		}
+		segment.m_numPairs=buffer.m_pairs.size()/2-segment.m_firstPair;
+		if(segment.m_numPairs)
+		{
+			buffer.m_segments.push_back(segment);
+		}
+	}
+};
+
+struct	btDbvtPairSegmentSortPredicate
+{
+	bool operator() (const btDbvtPairSegment& a,const btDbvtPairSegment& b) const
+	{
+		return a.m_firstTask<b.m_firstTask;
+	}
+};
+
 //
 // btDbvtBroadphase
 //
@@ -227,6 +293,8 @@ struct	BroadphaseRayTester : btDbvt::ICollide
 void	btDbvtBroadphase::rayTest(const btVector3& rayFrom,const btVector3& rayTo, btBroadphaseRayCallback& rayCallback,const btVector3& aabbMin,const btVector3& aabbMax)
 {
 	BroadphaseRayTester callback(rayCallback);
+	//each thread has its own traversal stack, so rays can be cast concurrently as long as the trees don't change
+	btAlignedObjectArray<const btDbvtNode*>& stack = m_rayTestStacks[btGetCurrentThreadIndex()];
 
 	m_sets[0].rayTestInternal(	m_sets[0].m_root,
 		rayFrom,
@@ -236,6 +304,7 @@ void	btDbvtBroadphase::rayTest(const btVector3& rayFrom,const btVector3& rayTo,
 		rayCallback.m_lambda_max,
 		aabbMin,
 		aabbMax,
+		stack,
 		callback);
 
 	m_sets[1].rayTestInternal(	m_sets[1].m_root,
@@ -246,11 +315,111 @@ void	btDbvtBroadphase::rayTest(const btVector3& rayFrom,const btVector3& rayTo,
 		rayCallback.m_lambda_max,
 		aabbMin,
 		aabbMax,
+		stack,
 		callback);
 
 }
 
 
+//
+struct	btDbvtRayPacket
+{
+	btScalar	m_origin[3][BT_RAY_PACKET_SIZE];
+	btScalar	m_invDir[3][BT_RAY_PACKET_SIZE];
+	btVector3	m_direction;	// Sum of the ray directions, used to order the children
+	int			m_activeMask;
+};
+
+// Returns a bit for every active ray of the packet whose segment [0,lambdaMax] overlaps the volume
+static DBVT_INLINE int		rayPacketTestVolume(const btDbvtRayPacket& packet,const btScalar* lambdaMax,const btDbvtVolume& volume)
+{
+#if defined(BT_USE_SSE) && (BT_RAY_PACKET_SIZE==4)
+	__m128	tmin=_mm_setzero_ps();
+	__m128	tmax=_mm_loadu_ps(lambdaMax);
+	for(int k=0;k<3;++k)
+	{
+		const __m128	origin=_mm_loadu_ps(packet.m_origin[k]);
+		const __m128	invDir=_mm_loadu_ps(packet.m_invDir[k]);
+		const __m128	t0=_mm_mul_ps(_mm_sub_ps(_mm_set1_ps(volume.Mins()[k]),origin),invDir);
+		const __m128	t1=_mm_mul_ps(_mm_sub_ps(_mm_set1_ps(volume.Maxs()[k]),origin),invDir);
+		tmin=_mm_max_ps(tmin,_mm_min_ps(t0,t1));
+		tmax=_mm_min_ps(tmax,_mm_max_ps(t0,t1));
+	}
+	return(_mm_movemask_ps(_mm_cmple_ps(tmin,tmax))&packet.m_activeMask);
+#else
+	int	mask=0;
+	for(int lane=0;lane<BT_RAY_PACKET_SIZE;++lane)
+	{
+		btScalar	tmin=0;
+		btScalar	tmax=lambdaMax[lane];
+		for(int k=0;k<3;++k)
+		{
+			const btScalar	t0=(volume.Mins()[k]-packet.m_origin[k][lane])*packet.m_invDir[k][lane];
+			const btScalar	t1=(volume.Maxs()[k]-packet.m_origin[k][lane])*packet.m_invDir[k][lane];
+			tmin=btMax(tmin,btMin(t0,t1));
+			tmax=btMin(tmax,btMax(t0,t1));
+		}
+		if(tmin<=tmax) mask|=1<<lane;
+	}
+	return(mask&packet.m_activeMask);
+#endif
+}
+
+//
+static void					rayTestPacketTree(	const btDbvtNode* root,
+												const btDbvtRayPacket& packet,
+												btBroadphaseRayPacketCallback& callback,
+												btAlignedObjectArray<const btDbvtNode*>& stack)
+{
+	if(!root) return;
+	stack.resize(0);
+	stack.push_back(root);
+	while(stack.size())
+	{
+		const btDbvtNode*	node=stack[stack.size()-1];
+		stack.pop_back();
+		const int			mask=rayPacketTestVolume(packet,callback.m_lambdaMax,node->volume);
+		if(!mask) continue;
+		if(node->isinternal())
+		{
+			/* Visit the nearer child first, its hits shorten the rays before the other one is tested	*/ 
+			const btVector3	delta=node->childs[1]->volume.Center()-node->childs[0]->volume.Center();
+			const int		nearest=packet.m_direction.dot(delta)<0?1:0;
+			stack.push_back(node->childs[1-nearest]);
+			stack.push_back(node->childs[nearest]);
+		}
+		else
+		{
+			callback.process((btDbvtProxy*)node->data,mask);
+		}
+	}
+}
+
+//
+void	btDbvtBroadphase::rayTestPacket(btBroadphaseRayPacketCallback& packetCallback)
+{
+	btAssert(packetCallback.m_numRays>0 && packetCallback.m_numRays<=BT_RAY_PACKET_SIZE);
+	btDbvtRayPacket	packet;
+	packet.m_direction.setZero();
+	packet.m_activeMask=(1<<packetCallback.m_numRays)-1;
+	for(int lane=0;lane<BT_RAY_PACKET_SIZE;++lane)
+	{
+		/* Unused lanes repeat the first ray and are masked out		*/ 
+		const int		ray=lane<packetCallback.m_numRays?lane:0;
+		const btVector3	rayDir=packetCallback.m_rayTo[ray]-packetCallback.m_rayFrom[ray];
+		for(int k=0;k<3;++k)
+		{
+			packet.m_origin[k][lane]=packetCallback.m_rayFrom[ray][k];
+			packet.m_invDir[k][lane]=rayDir[k]==btScalar(0.0)?btScalar(BT_LARGE_FLOAT):btScalar(1.0)/rayDir[k];
+		}
+		if(lane<packetCallback.m_numRays) packet.m_direction+=rayDir;
+	}
+	//each thread has its own traversal stack, so packets can be traced concurrently as long as the trees don't change
+	btAlignedObjectArray<const btDbvtNode*>& stack = m_rayTestStacks[btGetCurrentThreadIndex()];
+	rayTestPacketTree(m_sets[0].m_root,packet,packetCallback,stack);
+	rayTestPacketTree(m_sets[1].m_root,packet,packetCallback,stack);
+}
+
 struct	BroadphaseAabbTester : btDbvt::ICollide
 {
 	btBroadphaseAabbCallback& m_aabbCallback;
@@ -346,6 +515,88 @@ void							btDbvtBroadphase::setAabb(		btBroadphaseProxy* absproxy,
 }
 
 
+//
+void							btDbvtBroadphase::setAabbs(		btBroadphaseProxy** absproxies,
+														  const btVector3* aabbMins,
+														  const btVector3* aabbMaxs,
+														  int numProxies,
+														  btDispatcher* /*dispatcher*/)
+{
+	m_batchLeaves.resize(0);
+	m_batchVolumes.resize(0);
+	m_batchCollide.resize(0);
+	for(int i=0;i<numProxies;++i)
+	{
+		btDbvtProxy*						proxy=(btDbvtProxy*)absproxies[i];
+		const btVector3&					aabbMin=aabbMins[i];
+		const btVector3&					aabbMax=aabbMaxs[i];
+		ATTRIBUTE_ALIGNED16(btDbvtVolume)	aabb=btDbvtVolume::FromMM(aabbMin,aabbMax);
+#if DBVT_BP_PREVENTFALSEUPDATE
+		if(!NotEqual(aabb,proxy->leaf->volume)) continue;
+#endif
+		bool	docollide=false;
+		if(proxy->stage==STAGECOUNT)
+		{/* fixed -> dynamic set	*/ 
+			m_sets[1].remove(proxy->leaf);
+			proxy->leaf=m_sets[0].insert(aabb,proxy);
+			docollide=true;
+		}
+		else
+		{/* dynamic set, same logic as setAabb but the tree update is deferred	*/ 
+			++m_updates_call;
+			if(Intersect(proxy->leaf->volume,aabb))
+			{/* Moving				*/ 
+
+				if(!proxy->leaf->volume.Contain(aabb))
+				{
+					const btVector3	delta=aabbMin-proxy->m_aabbMin;
+					btVector3		velocity(((proxy->m_aabbMax-proxy->m_aabbMin)/2)*m_prediction);
+					if(delta[0]<0) velocity[0]=-velocity[0];
+					if(delta[1]<0) velocity[1]=-velocity[1];
+					if(delta[2]<0) velocity[2]=-velocity[2];
+#ifdef DBVT_BP_MARGIN				
+					aabb.Expand(btVector3(DBVT_BP_MARGIN,DBVT_BP_MARGIN,DBVT_BP_MARGIN));
+#endif
+					aabb.SignedExpand(velocity);
+					m_batchLeaves.push_back(proxy->leaf);
+					m_batchVolumes.push_back(aabb);
+					++m_updates_done;
+					docollide=true;
+				}
+			}
+			else
+			{/* Teleporting			*/ 
+				m_batchLeaves.push_back(proxy->leaf);
+				m_batchVolumes.push_back(aabb);
+				++m_updates_done;
+				docollide=true;
+			}	
+		}
+		listremove(proxy,m_stageRoots[proxy->stage]);
+		proxy->m_aabbMin = aabbMin;
+		proxy->m_aabbMax = aabbMax;
+		proxy->stage	=	m_stageCurrent;
+		listappend(proxy,m_stageRoots[m_stageCurrent]);
+		if(docollide)
+		{
+			m_batchCollide.push_back(proxy);
+		}
+	}
+
+	if(m_batchLeaves.size())
+	{
+		m_sets[0].updateLeaves(&m_batchLeaves[0],&m_batchVolumes[0],m_batchLeaves.size());
+	}
+	if(m_batchCollide.size())
+	{
+		m_needcleanup=true;
+		if(!m_deferedcollide)
+		{
+			collideBatch();
+		}
+	}
+}
+
 //
 void							btDbvtBroadphase::setAabbForceUpdate(		btBroadphaseProxy* absproxy,
 														  const btVector3& aabbMin,
@@ -541,18 +792,10 @@ void							btDbvtBroadphase::collide(btDispatcher* dispatcher)
 		m_needcleanup=true;
 	}
 	/* collide dynamics		*/ 
+	if(m_deferedcollide)
 	{
-		btDbvtTreeCollider	collider(this);
-		if(m_deferedcollide)
-		{
-			SPC(m_profiling.m_fdcollide);
-			m_sets[0].collideTTpersistentStack(m_sets[0].m_root,m_sets[1].m_root,collider);
-		}
-		if(m_deferedcollide)
-		{
-			SPC(m_profiling.m_ddcollide);
-			m_sets[0].collideTTpersistentStack(m_sets[0].m_root,m_sets[0].m_root,collider);
-		}
+		SPC(m_profiling.m_ddcollide);
+		collideTrees();
 	}
 	/* clean up				*/ 
 	if(m_needcleanup)
@@ -592,6 +835,101 @@ void							btDbvtBroadphase::collide(btDispatcher* dispatcher)
 	m_updates_call/=2;
 }
 
+//
+void							btDbvtBroadphase::collideBatch()
+{
+	BT_PROFILE("collideBatch");
+	btDbvtCollideLoop	loop(this,true);
+	btParallelFor(0,m_batchCollide.size(),64,loop);
+	addBufferedPairs();
+}
+
+//
+void							btDbvtBroadphase::collideTrees()
+{
+	BT_PROFILE("collideTrees");
+	/* dynamic vs fixed and dynamic vs dynamic, as in collideTTpersistentStack	*/ 
+	m_collideTasks.resize(0);
+	if(m_sets[0].m_root&&m_sets[1].m_root)
+	{
+		m_collideTasks.push_back(btDbvt::sStkNN(m_sets[0].m_root,m_sets[1].m_root));
+	}
+	if(m_sets[0].m_root)
+	{
+		m_collideTasks.push_back(btDbvt::sStkNN(m_sets[0].m_root,m_sets[0].m_root));
+	}
+	/* expand breadth first until there are enough independent node pairs. The tasks
+	don't depend on the number of threads, so neither does the order of the pairs	*/ 
+	int	first=0;
+	while((first<m_collideTasks.size())&&(m_collideTasks.size()-first<DBVT_BP_COLLIDE_TASKS))
+	{
+		const btDbvt::sStkNN	p=m_collideTasks[first];
+		if(p.a==p.b)
+		{
+			if(!p.a->isinternal()) { ++first;continue; }
+			m_collideTasks[first]=btDbvt::sStkNN(p.a->childs[0],p.a->childs[0]);
+			m_collideTasks.push_back(btDbvt::sStkNN(p.a->childs[1],p.a->childs[1]));
+			m_collideTasks.push_back(btDbvt::sStkNN(p.a->childs[0],p.a->childs[1]));
+		}
+		else if(!Intersect(p.a->volume,p.b->volume))
+		{
+			m_collideTasks[first]=m_collideTasks[m_collideTasks.size()-1];
+			m_collideTasks.pop_back();
+		}
+		else if(p.a->isinternal()&&p.b->isinternal())
+		{
+			m_collideTasks[first]=btDbvt::sStkNN(p.a->childs[0],p.b->childs[0]);
+			m_collideTasks.push_back(btDbvt::sStkNN(p.a->childs[1],p.b->childs[0]));
+			m_collideTasks.push_back(btDbvt::sStkNN(p.a->childs[0],p.b->childs[1]));
+			m_collideTasks.push_back(btDbvt::sStkNN(p.a->childs[1],p.b->childs[1]));
+		}
+		else if(p.a->isinternal())
+		{
+			m_collideTasks[first]=btDbvt::sStkNN(p.a->childs[0],p.b);
+			m_collideTasks.push_back(btDbvt::sStkNN(p.a->childs[1],p.b));
+		}
+		else if(p.b->isinternal())
+		{
+			m_collideTasks[first]=btDbvt::sStkNN(p.a,p.b->childs[0]);
+			m_collideTasks.push_back(btDbvt::sStkNN(p.a,p.b->childs[1]));
+		}
+		else
+		{
+			/* overlapping leaves, reported by the task itself	*/ 
+			++first;
+		}
+	}
+	btDbvtCollideLoop	loop(this,false);
+	btParallelFor(0,m_collideTasks.size(),1,loop);
+	addBufferedPairs();
+}
+
+//
+void							btDbvtBroadphase::addBufferedPairs()
+{
+	m_pairSegments.resize(0);
+	for(int i=0;i<BT_MAX_THREAD_COUNT;++i)
+	{
+		btDbvtPairBuffer&	buffer=m_pairBuffers[i];
+		for(int j=0;j<buffer.m_segments.size();++j)
+		{
+			m_pairSegments.push_back(buffer.m_segments[j]);
+		}
+	}
+	m_pairSegments.quickSort(btDbvtPairSegmentSortPredicate());
+	for(int i=0;i<m_pairSegments.size();++i)
+	{
+		const btDbvtPairSegment&	segment=m_pairSegments[i];
+		m_paircache->addOverlappingPairs(&m_pairBuffers[segment.m_threadIndex].m_pairs[segment.m_firstPair*2],segment.m_numPairs);
+		m_newpairs+=segment.m_numPairs;
+	}
+	for(int i=0;i<BT_MAX_THREAD_COUNT;++i)
+	{
+		m_pairBuffers[i].m_pairs.resize(0);
+		m_pairBuffers[i].m_segments.resize(0);
+	}
+}
+
 //
 void							btDbvtBroadphase::optimize()
 {
@@ -19,6 +19,7 @@ subject to the following restrictions:
 
 #include "BulletCollision/BroadphaseCollision/btDbvt.h"
 #include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
+#include "LinearMath/btThreads.h"
 
 //
 // Compile time config
@@ -30,6 +31,7 @@ subject to the following restrictions:
 #define DBVT_BP_ACCURATESLEEPING		0
 #define DBVT_BP_ENABLE_BENCHMARK		0
 #define DBVT_BP_MARGIN					(btScalar)0.05
+#define DBVT_BP_COLLIDE_TASKS			256
 
 #if DBVT_BP_PROFILE
 #define	DBVT_BP_PROFILING_RATE	256
@@ -56,6 +58,23 @@ struct btDbvtProxy : btBroadphaseProxy
 
 typedef btAlignedObjectArray<btDbvtProxy*>	btDbvtProxyArray;
 
+///pairs found by one btParallelFor range of the parallel pair finding, merged in order of m_firstTask
+struct btDbvtPairSegment
+{
+	int				m_firstTask;
+	int				m_firstPair;
+	int				m_numPairs;
+	int				m_threadIndex;
+};
+
+///pair finding buffers of one thread
+struct btDbvtPairBuffer
+{
+	btAlignedObjectArray<btDbvt::sStkNN>	m_stack;	// Tree collide stack
+	btAlignedObjectArray<btBroadphaseProxy*>	m_pairs;	// Two proxies per pair found
+	btAlignedObjectArray<btDbvtPairSegment>	m_segments;	// Pairs found by each loop range
+};
+
 ///The btDbvtBroadphase implements a broadphase using two dynamic AABB bounding volume hierarchies/trees (see btDbvt).
 ///One tree is used for static/non-moving objects, and another tree is used for dynamic objects. Objects can move from one tree to the other.
 ///This is a very fast broadphase, especially for very dynamic worlds where many objects are moving. Its insert/add and remove of objects is generally faster than the sweep and prune broadphases btAxisSweep3 and bt32BitAxisSweep3.
@@ -87,6 +106,13 @@ struct	btDbvtBroadphase : btBroadphaseInterface
 	bool					m_releasepaircache;			// Release pair cache on delete
 	bool					m_deferedcollide;			// Defere dynamic/static collision to collide call
 	bool					m_needcleanup;				// Need to run cleanup?
+	btAlignedObjectArray<btDbvtNode*>	m_batchLeaves;		// Leaves reinserted by setAabbs
+	btAlignedObjectArray<btDbvtVolume>	m_batchVolumes;		// Their new volumes
+	btAlignedObjectArray<btDbvtProxy*>	m_batchCollide;		// Proxies to collide after setAabbs
+	btAlignedObjectArray<const btDbvtNode*>	m_rayTestStacks[BT_MAX_THREAD_COUNT];	// Ray test stack per thread
+	btDbvtPairBuffer					m_pairBuffers[BT_MAX_THREAD_COUNT];	// Pair finding buffers per thread
+	btAlignedObjectArray<btDbvtPairSegment>	m_pairSegments;	// Segments of all threads, sorted before the merge
+	btAlignedObjectArray<btDbvt::sStkNN>	m_collideTasks;	// Independent node pairs of the deferred tree collide
 #if DBVT_BP_PROFILE
 	btClock					m_clock;
 	struct	{
@@ -101,13 +127,23 @@ struct	btDbvtBroadphase : btBroadphaseInterface
 	btDbvtBroadphase(btOverlappingPairCache* paircache=0);
 	~btDbvtBroadphase();
 	void							collide(btDispatcher* dispatcher);
+	///collides the leaves of the m_batchCollide proxies with both trees in parallel, the pairs are added in the same order as by a serial loop
+	void							collideBatch();
+	///splits the tree vs tree collisions of the dynamic set into independent node pairs and collides those in parallel
+	void							collideTrees();
+	///adds the pairs in the per thread buffers to the pair cache in task order and clears the buffers
+	void							addBufferedPairs();
 	void							optimize();
 	
 	/* btBroadphaseInterface Implementation	*/
 	btBroadphaseProxy*				createProxy(const btVector3& aabbMin,const btVector3& aabbMax,int shapeType,void* userPtr,short int collisionFilterGroup,short int collisionFilterMask,btDispatcher* dispatcher,void* multiSapProxy);
 	virtual void					destroyProxy(btBroadphaseProxy* proxy,btDispatcher* dispatcher);
 	virtual void					setAabb(btBroadphaseProxy* proxy,const btVector3& aabbMin,const btVector3& aabbMax,btDispatcher* dispatcher);
+	///setAabbs moves all proxies first and reinserts their leaves with a single refit of the dynamic tree, see btDbvt::updateLeaves
+	virtual void					setAabbs(btBroadphaseProxy** proxies,const btVector3* aabbMins,const btVector3* aabbMaxs,int numProxies,btDispatcher* dispatcher);
 	virtual void					rayTest(const btVector3& rayFrom,const btVector3& rayTo, btBroadphaseRayCallback& rayCallback, const btVector3& aabbMin=btVector3(0,0,0), const btVector3& aabbMax = btVector3(0,0,0));
+	///rayTestPacket walks the trees once for the whole packet, testing all rays against each node volume together
+	virtual void					rayTestPacket(btBroadphaseRayPacketCallback& packetCallback);
 	virtual void					aabbTest(const btVector3& aabbMin, const btVector3& aabbMax, btBroadphaseAabbCallback& callback);
 
 	virtual void					getAabb(btBroadphaseProxy* proxy,btVector3& aabbMin, btVector3& aabbMax ) const;
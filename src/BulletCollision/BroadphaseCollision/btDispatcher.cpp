@@ -20,3 +20,8 @@ btDispatcher::~btDispatcher()
 
 }
 
+void	btDispatcher::dispatchCollisionPairs(btOverlappingPairCache* pairCache,const int* /*pairIndices*/,int /*numPairs*/,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher)
+{
+	dispatchAllCollisionPairs(pairCache,dispatchInfo,dispatcher);
+}
+
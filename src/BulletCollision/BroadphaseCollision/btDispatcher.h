@@ -87,6 +87,10 @@ public:
 
 	virtual void	dispatchAllCollisionPairs(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher)  =0;
 
+	///dispatches only the pairs at the given indices of the overlapping pair array, the indices are in increasing order.
+	///The default implementation dispatches all pairs, which is always correct but does not skip the others.
+	virtual void	dispatchCollisionPairs(btOverlappingPairCache* pairCache,const int* pairIndices,int numPairs,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher);
+
 	virtual int getNumManifolds() const = 0;
 
 	virtual btPersistentManifold* getManifoldByIndexInternal(int index) = 0;
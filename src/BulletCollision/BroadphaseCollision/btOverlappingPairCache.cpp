@@ -34,7 +34,10 @@ int gFindPairs =0;
 
 btHashedOverlappingPairCache::btHashedOverlappingPairCache():
 	m_overlapFilterCallback(0),
-	m_ghostPairCallback(0)
+	m_ghostPairCallback(0),
+	m_numAddedPairs(0),
+	m_numRemovedPairs(0),
+	m_countPairChanges(false)
 {
 	int initialAllocatedSize= 2;
 	m_overlappingPairArray.reserve(initialAllocatedSize);
@@ -259,6 +262,8 @@ btBroadphasePair* btHashedOverlappingPairCache::internalAddPair(btBroadphaseProx
 //	pair->m_pProxy1 = proxy1;
 	pair->m_algorithm = 0;
 	pair->m_internalTmpValue = 0;
+	if (m_countPairChanges)
+		m_numAddedPairs++;
 	
 
 	m_next[count] = m_hashTable[hash];
@@ -289,6 +294,8 @@ void* btHashedOverlappingPairCache::removeOverlappingPair(btBroadphaseProxy* pro
 	}
 
 	cleanOverlappingPair(*pair,dispatcher);
+	if (m_countPairChanges)
+		m_numRemovedPairs++;
 
 	void* userData = pair->m_internalInfo1;
 
@@ -399,6 +406,9 @@ void	btHashedOverlappingPairCache::sortOverlappingPairs(btDispatcher* dispatcher
 {
 	///need to keep hashmap in sync with pair address, so rebuild all
 	btBroadphasePairArray tmpPairs;
+	//the rebuild doesn't change the set of pairs
+	unsigned int numAddedPairs = m_numAddedPairs;
+	unsigned int numRemovedPairs = m_numRemovedPairs;
 	int i;
 	for (i=0;i<m_overlappingPairArray.size();i++)
 	{
@@ -422,10 +432,258 @@ void	btHashedOverlappingPairCache::sortOverlappingPairs(btDispatcher* dispatcher
 		addOverlappingPair(tmpPairs[i].m_pProxy0,tmpPairs[i].m_pProxy1);
 	}
 
+	m_numAddedPairs = numAddedPairs;
+	m_numRemovedPairs = numRemovedPairs;
 	
 }
 
 
+btOpenHashOverlappingPairCache::btOpenHashOverlappingPairCache():
+	m_overlapFilterCallback(0),
+	m_ghostPairCallback(0),
+	m_numAddedPairs(0),
+	m_numRemovedPairs(0),
+	m_countPairChanges(false)
+{
+	reserveSlots(2);
+}
+
+btOpenHashOverlappingPairCache::~btOpenHashOverlappingPairCache()
+{
+}
+
+void	btOpenHashOverlappingPairCache::reserveSlots(int numPairs)
+{
+	//keep the load factor at or below 3/4
+	int numSlots = m_slotHashes.size() ? m_slotHashes.size() : 16;
+	while (numPairs*4 > numSlots*3)
+	{
+		numSlots *= 2;
+	}
+	if (numSlots == m_slotHashes.size())
+		return;
+
+	m_slotHashes.resize(numSlots);
+	m_slotPairIndices.resize(numSlots);
+	rebuildSlots();
+}
+
+void	btOpenHashOverlappingPairCache::rebuildSlots()
+{
+	for (int i=0;i<m_slotHashes.size();i++)
+	{
+		m_slotHashes[i] = 0;
+	}
+	for (int i=0;i<m_overlappingPairArray.size();i++)
+	{
+		const btBroadphasePair& pair = m_overlappingPairArray[i];
+		insertSlot(getHash(static_cast<unsigned int>(pair.m_pProxy0->getUid()),static_cast<unsigned int>(pair.m_pProxy1->getUid())),i);
+	}
+}
+
+void	btOpenHashOverlappingPairCache::insertSlot(unsigned int hash,int pairIndex)
+{
+	int mask = m_slotHashes.size()-1;
+	int pos = int(hash) & mask;
+	for (int dist=0;;dist++)
+	{
+		unsigned int slotHash = m_slotHashes[pos];
+		if (slotHash == 0)
+		{
+			m_slotHashes[pos] = hash;
+			m_slotPairIndices[pos] = pairIndex;
+			return;
+		}
+		//take the slot from entries that are closer to their home slot, and carry those on
+		int slotDist = (pos - (int(slotHash) & mask)) & mask;
+		if (slotDist < dist)
+		{
+			btSwap(m_slotHashes[pos],hash);
+			btSwap(m_slotPairIndices[pos],pairIndex);
+			dist = slotDist;
+		}
+		pos = (pos+1) & mask;
+	}
+}
+
+void	btOpenHashOverlappingPairCache::eraseSlot(int pos)
+{
+	//shift the following entries back until an empty slot or an entry in its home slot, so no tombstones are needed
+	int mask = m_slotHashes.size()-1;
+	int next = (pos+1) & mask;
+	while (m_slotHashes[next] != 0 && ((next - (int(m_slotHashes[next]) & mask)) & mask) != 0)
+	{
+		m_slotHashes[pos] = m_slotHashes[next];
+		m_slotPairIndices[pos] = m_slotPairIndices[next];
+		pos = next;
+		next = (next+1) & mask;
+	}
+	m_slotHashes[pos] = 0;
+}
+
+btBroadphasePair*	btOpenHashOverlappingPairCache::internalAddPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1)
+{
+	if(proxy0->m_uniqueId>proxy1->m_uniqueId) 
+		btSwap(proxy0,proxy1);
+	int proxyId1 = proxy0->getUid();
+	int proxyId2 = proxy1->getUid();
+	unsigned int hash = getHash(static_cast<unsigned int>(proxyId1),static_cast<unsigned int>(proxyId2));
+
+	int pos = findSlot(proxy0,proxy1,hash);
+	if (pos >= 0)
+	{
+		return &m_overlappingPairArray[m_slotPairIndices[pos]];
+	}
+
+	//this is where we add an actual pair, so also call the 'ghost'
+	if (m_ghostPairCallback)
+		m_ghostPairCallback->addOverlappingPair(proxy0,proxy1);
+
+	int count = m_overlappingPairArray.size();
+	reserveSlots(count+1);
+
+	insertSlot(hash,count);
+
+	void* mem = &m_overlappingPairArray.expandNonInitializing();
+	btBroadphasePair* pair = new (mem) btBroadphasePair(*proxy0,*proxy1);
+	pair->m_algorithm = 0;
+	pair->m_internalTmpValue = 0;
+	if (m_countPairChanges)
+		m_numAddedPairs++;
+	return pair;
+}
+
+void	btOpenHashOverlappingPairCache::addOverlappingPairs(btBroadphaseProxy* const* proxyPairs,int numPairs)
+{
+	//grow the table once, the filtered and existing pairs only make it a little emptier
+	reserveSlots(m_overlappingPairArray.size()+numPairs);
+	for (int i=0;i<numPairs;i++)
+	{
+		addOverlappingPair(proxyPairs[i*2],proxyPairs[i*2+1]);
+	}
+}
+
+void*	btOpenHashOverlappingPairCache::removeOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1,btDispatcher* dispatcher)
+{
+	gRemovePairs++;
+	if(proxy0->m_uniqueId>proxy1->m_uniqueId) 
+		btSwap(proxy0,proxy1);
+	int proxyId1 = proxy0->getUid();
+	int proxyId2 = proxy1->getUid();
+	unsigned int hash = getHash(static_cast<unsigned int>(proxyId1),static_cast<unsigned int>(proxyId2));
+
+	int pos = findSlot(proxy0,proxy1,hash);
+	if (pos < 0)
+	{
+		return 0;
+	}
+	int pairIndex = m_slotPairIndices[pos];
+	btBroadphasePair& pair = m_overlappingPairArray[pairIndex];
+	cleanOverlappingPair(pair,dispatcher);
+	if (m_countPairChanges)
+		m_numRemovedPairs++;
+	void* userData = pair.m_internalInfo1;
+	eraseSlot(pos);
+
+	if (m_ghostPairCallback)
+		m_ghostPairCallback->removeOverlappingPair(proxy0,proxy1,dispatcher);
+
+	//move the last pair into the gap, like btHashedOverlappingPairCache, and point its slot to the new index
+	int lastPairIndex = m_overlappingPairArray.size()-1;
+	if (pairIndex != lastPairIndex)
+	{
+		const btBroadphasePair& last = m_overlappingPairArray[lastPairIndex];
+		unsigned int lastHash = getHash(static_cast<unsigned int>(last.m_pProxy0->getUid()),static_cast<unsigned int>(last.m_pProxy1->getUid()));
+		int lastPos = findSlot(last.m_pProxy0,last.m_pProxy1,lastHash);
+		btAssert(lastPos >= 0);
+		m_slotPairIndices[lastPos] = pairIndex;
+		m_overlappingPairArray[pairIndex] = last;
+	}
+	m_overlappingPairArray.pop_back();
+	return userData;
+}
+
+void	btOpenHashOverlappingPairCache::cleanOverlappingPair(btBroadphasePair& pair,btDispatcher* dispatcher)
+{
+	if (pair.m_algorithm && dispatcher)
+	{
+		pair.m_algorithm->~btCollisionAlgorithm();
+		dispatcher->freeCollisionAlgorithm(pair.m_algorithm);
+		pair.m_algorithm=0;
+	}
+}
+
+void	btOpenHashOverlappingPairCache::cleanProxyFromPairs(btBroadphaseProxy* proxy,btDispatcher* dispatcher)
+{
+	for (int i=0;i<m_overlappingPairArray.size();i++)
+	{
+		btBroadphasePair& pair = m_overlappingPairArray[i];
+		if ((pair.m_pProxy0 == proxy) || (pair.m_pProxy1 == proxy))
+		{
+			cleanOverlappingPair(pair,dispatcher);
+		}
+	}
+}
+
+void	btOpenHashOverlappingPairCache::removeOverlappingPairsContainingProxy(btBroadphaseProxy* proxy,btDispatcher* dispatcher)
+{
+	for (int i=0;i<m_overlappingPairArray.size();)
+	{
+		btBroadphasePair& pair = m_overlappingPairArray[i];
+		if ((pair.m_pProxy0 == proxy) || (pair.m_pProxy1 == proxy))
+		{
+			//the last pair moves to index i
+			removeOverlappingPair(pair.m_pProxy0,pair.m_pProxy1,dispatcher);
+		} else
+		{
+			i++;
+		}
+	}
+}
+
+void	btOpenHashOverlappingPairCache::processAllOverlappingPairs(btOverlapCallback* callback,btDispatcher* dispatcher)
+{
+	for (int i=0;i<m_overlappingPairArray.size();)
+	{
+		btBroadphasePair* pair = &m_overlappingPairArray[i];
+		if (callback->processOverlap(*pair))
+		{
+			removeOverlappingPair(pair->m_pProxy0,pair->m_pProxy1,dispatcher);
+
+			gOverlappingPairs--;
+		} else
+		{
+			i++;
+		}
+	}
+}
+
+btBroadphasePair*	btOpenHashOverlappingPairCache::findPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1)
+{
+	gFindPairs++;
+	if(proxy0->m_uniqueId>proxy1->m_uniqueId) 
+		btSwap(proxy0,proxy1);
+	int proxyId1 = proxy0->getUid();
+	int proxyId2 = proxy1->getUid();
+	int pos = findSlot(proxy0,proxy1,getHash(static_cast<unsigned int>(proxyId1),static_cast<unsigned int>(proxyId2)));
+	if (pos < 0)
+	{
+		return NULL;
+	}
+	return &m_overlappingPairArray[m_slotPairIndices[pos]];
+}
+
+void	btOpenHashOverlappingPairCache::sortOverlappingPairs(btDispatcher* dispatcher)
+{
+	for (int i=0;i<m_overlappingPairArray.size();i++)
+	{
+		cleanOverlappingPair(m_overlappingPairArray[i],dispatcher);
+	}
+	m_overlappingPairArray.quickSort(btBroadphasePairSortPredicate());
+	rebuildSlots();
+}
+
+
 void*	btSortedOverlappingPairCache::removeOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1, btDispatcher* dispatcher )
 {
 	if (!hasDeferredRemoval())
@@ -436,6 +694,8 @@ void*	btSortedOverlappingPairCache::removeOverlappingPair(btBroadphaseProxy* pro
 		if (findIndex < m_overlappingPairArray.size())
 		{
 			gOverlappingPairs--;
+			if (m_countPairChanges)
+				m_numRemovedPairs++;
 			btBroadphasePair& pair = m_overlappingPairArray[findIndex];
 			void* userData = pair.m_internalInfo1;
 			cleanOverlappingPair(pair,dispatcher);
@@ -471,6 +731,8 @@ btBroadphasePair*	btSortedOverlappingPairCache::addOverlappingPair(btBroadphaseP
 	
 	gOverlappingPairs++;
 	gAddedPairs++;
+	if (m_countPairChanges)
+		m_numAddedPairs++;
 	
 	if (m_ghostPairCallback)
 		m_ghostPairCallback->addOverlappingPair(proxy0, proxy1);
@@ -527,6 +789,8 @@ void	btSortedOverlappingPairCache::processAllOverlappingPairs(btOverlapCallback*
 			m_overlappingPairArray.swap(i,m_overlappingPairArray.size()-1);
 			m_overlappingPairArray.pop_back();
 			gOverlappingPairs--;
+			if (m_countPairChanges)
+				m_numRemovedPairs++;
 		} else
 		{
 			i++;
@@ -541,7 +805,10 @@ btSortedOverlappingPairCache::btSortedOverlappingPairCache():
 	m_blockedForChanges(false),
 	m_hasDeferredRemoval(true),
 	m_overlapFilterCallback(0),
-	m_ghostPairCallback(0)
+	m_ghostPairCallback(0),
+	m_numAddedPairs(0),
+	m_numRemovedPairs(0),
+	m_countPairChanges(false)
 {
 	int initialAllocatedSize= 2;
 	m_overlappingPairArray.reserve(initialAllocatedSize);
@@ -86,6 +86,40 @@ public:
 
 	virtual void	sortOverlappingPairs(btDispatcher* dispatcher) = 0;
 
+	///getNumAddedPairs and getNumRemovedPairs count the pairs added to and removed from the cache while counting is enabled
+	///with setCountPairChanges, the difference between two calls gives the pair changes in between. Caches that don't count return 0.
+	virtual unsigned int	getNumAddedPairs() const
+	{
+		return 0;
+	}
+
+	virtual unsigned int	getNumRemovedPairs() const
+	{
+		return 0;
+	}
+
+	///counting is disabled by default, btCollisionWorld enables it while it needs the counts
+	virtual void	setCountPairChanges(bool /*countPairChanges*/)
+	{
+	}
+
+	///adds numPairs pairs, proxyPairs holds two proxies for each pair. Caches can override it to grow their storage once for the whole batch
+	virtual void	addOverlappingPairs(btBroadphaseProxy* const* proxyPairs,int numPairs)
+	{
+		for (int i=0;i<numPairs;i++)
+		{
+			addOverlappingPair(proxyPairs[i*2],proxyPairs[i*2+1]);
+		}
+	}
+
+	///removes numPairs pairs, proxyPairs holds two proxies for each pair
+	virtual void	removeOverlappingPairs(btBroadphaseProxy* const* proxyPairs,int numPairs,btDispatcher* dispatcher)
+	{
+		for (int i=0;i<numPairs;i++)
+		{
+			removeOverlappingPair(proxyPairs[i*2],proxyPairs[i*2+1],dispatcher);
+		}
+	}
 
 };
 
@@ -100,6 +134,9 @@ protected:
 	btAlignedObjectArray<int>	m_hashTable;
 	btAlignedObjectArray<int>	m_next;
 	btOverlappingPairCallback*	m_ghostPairCallback;
+	unsigned int				m_numAddedPairs;
+	unsigned int				m_numRemovedPairs;
+	bool						m_countPairChanges;
 
 
 public:
@@ -184,6 +221,21 @@ public:
 	{
 		return m_overlappingPairArray.size();
 	}
+
+	virtual unsigned int	getNumAddedPairs() const
+	{
+		return m_numAddedPairs;
+	}
+
+	virtual unsigned int	getNumRemovedPairs() const
+	{
+		return m_numRemovedPairs;
+	}
+
+	virtual void	setCountPairChanges(bool countPairChanges)
+	{
+		m_countPairChanges = countPairChanges;
+	}
 private:
 	
 	btBroadphasePair* 	internalAddPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1);
@@ -295,6 +347,10 @@ class	btSortedOverlappingPairCache : public btOverlappingPairCache
 
 		btOverlappingPairCallback*	m_ghostPairCallback;
 
+		unsigned int	m_numAddedPairs;
+		unsigned int	m_numRemovedPairs;
+		bool			m_countPairChanges;
+
 	public:
 			
 		btSortedOverlappingPairCache();	
@@ -354,6 +410,21 @@ class	btSortedOverlappingPairCache : public btOverlappingPairCache
 		{
 			return m_overlappingPairArray.size();
 		}
+
+		virtual unsigned int	getNumAddedPairs() const
+		{
+			return m_numAddedPairs;
+		}
+
+		virtual unsigned int	getNumRemovedPairs() const
+		{
+			return m_numRemovedPairs;
+		}
+
+		virtual void	setCountPairChanges(bool countPairChanges)
+		{
+			m_countPairChanges = countPairChanges;
+		}
 		
 		btOverlapFilterCallback* getOverlapFilterCallback()
 		{
@@ -382,6 +453,175 @@ class	btSortedOverlappingPairCache : public btOverlappingPairCache
 
 
 
+///btOpenHashOverlappingPairCache is a hashed pair cache that uses open addressing with Robin Hood probing instead of the
+///separate hash and next chains of btHashedOverlappingPairCache. The table is split into two parallel arrays: m_slotHashes keeps
+///the full 32 bit hash of each slot and m_slotPairIndices the index of its pair. A probe scans the densely packed hashes, and
+///only reads the pair index and the pair array when a hash matches.
+///The pairs stay densely packed in the pair array, in the same order as in btHashedOverlappingPairCache.
+class btOpenHashOverlappingPairCache : public btOverlappingPairCache
+{
+	btBroadphasePairArray	m_overlappingPairArray;
+	btAlignedObjectArray<unsigned int>	m_slotHashes;	//0 for an empty slot
+	btAlignedObjectArray<int>	m_slotPairIndices;
+	btOverlapFilterCallback*	m_overlapFilterCallback;
+	btOverlappingPairCallback*	m_ghostPairCallback;
+	unsigned int	m_numAddedPairs;
+	unsigned int	m_numRemovedPairs;
+	bool			m_countPairChanges;
+
+	SIMD_FORCE_INLINE static unsigned int getHash(unsigned int uid0, unsigned int uid1)
+	{
+		unsigned int hash = uid0 * 0x9e3779b1u;
+		hash ^= uid1 + 0x7f4a7c15u + (hash << 6) + (hash >> 2);
+		//murmur3 finalizer
+		hash ^= hash >> 16;
+		hash *= 0x85ebca6bu;
+		hash ^= hash >> 13;
+		hash *= 0xc2b2ae35u;
+		hash ^= hash >> 16;
+		//0 marks an empty slot
+		return hash ? hash : 1;
+	}
+
+	///returns the slot of the pair or -1, proxy0 must have the smaller unique id
+	SIMD_FORCE_INLINE int findSlot(const btBroadphaseProxy* proxy0, const btBroadphaseProxy* proxy1, unsigned int hash) const
+	{
+		int mask = m_slotHashes.size()-1;
+		int pos = int(hash) & mask;
+		for (int dist=0;;dist++)
+		{
+			unsigned int slotHash = m_slotHashes[pos];
+			//Robin Hood: the pair would have displaced any slot that is closer to its home
+			if (slotHash == 0 || ((pos - (int(slotHash) & mask)) & mask) < dist)
+				return -1;
+			if (slotHash == hash)
+			{
+				const btBroadphasePair& pair = m_overlappingPairArray[m_slotPairIndices[pos]];
+				if (pair.m_pProxy0 == proxy0 && pair.m_pProxy1 == proxy1)
+					return pos;
+			}
+			pos = (pos+1) & mask;
+		}
+	}
+
+	void	insertSlot(unsigned int hash,int pairIndex);
+
+	void	eraseSlot(int pos);
+
+	///makes sure numPairs pairs fit below the maximum load factor
+	void	reserveSlots(int numPairs);
+
+	///inserts the slots of all pairs into the emptied table
+	void	rebuildSlots();
+
+	btBroadphasePair*	internalAddPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1);
+
+public:
+
+	btOpenHashOverlappingPairCache();
+	virtual ~btOpenHashOverlappingPairCache();
+
+	SIMD_FORCE_INLINE bool needsBroadphaseCollision(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1) const
+	{
+		if (m_overlapFilterCallback)
+			return m_overlapFilterCallback->needBroadphaseCollision(proxy0,proxy1);
+
+		bool collides = (proxy0->m_collisionFilterGroup & proxy1->m_collisionFilterMask) != 0;
+		collides = collides && (proxy1->m_collisionFilterGroup & proxy0->m_collisionFilterMask);
+
+		return collides;
+	}
+
+	virtual btBroadphasePair*	addOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1)
+	{
+		gAddedPairs++;
+
+		if (!needsBroadphaseCollision(proxy0,proxy1))
+			return 0;
+
+		return internalAddPair(proxy0,proxy1);
+	}
+
+	virtual void*	removeOverlappingPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1,btDispatcher* dispatcher);
+
+	virtual void	addOverlappingPairs(btBroadphaseProxy* const* proxyPairs,int numPairs);
+
+	virtual void	removeOverlappingPairsContainingProxy(btBroadphaseProxy* proxy,btDispatcher* dispatcher);
+
+	virtual void	cleanProxyFromPairs(btBroadphaseProxy* proxy,btDispatcher* dispatcher);
+
+	virtual void	cleanOverlappingPair(btBroadphasePair& pair,btDispatcher* dispatcher);
+
+	virtual void	processAllOverlappingPairs(btOverlapCallback*,btDispatcher* dispatcher);
+
+	virtual btBroadphasePair*	findPair(btBroadphaseProxy* proxy0,btBroadphaseProxy* proxy1);
+
+	virtual btBroadphasePair*	getOverlappingPairArrayPtr()
+	{
+		return &m_overlappingPairArray[0];
+	}
+
+	const btBroadphasePair*	getOverlappingPairArrayPtr() const
+	{
+		return &m_overlappingPairArray[0];
+	}
+
+	btBroadphasePairArray&	getOverlappingPairArray()
+	{
+		return m_overlappingPairArray;
+	}
+
+	const btBroadphasePairArray&	getOverlappingPairArray() const
+	{
+		return m_overlappingPairArray;
+	}
+
+	int	getNumOverlappingPairs() const
+	{
+		return m_overlappingPairArray.size();
+	}
+
+	virtual unsigned int	getNumAddedPairs() const
+	{
+		return m_numAddedPairs;
+	}
+
+	virtual unsigned int	getNumRemovedPairs() const
+	{
+		return m_numRemovedPairs;
+	}
+
+	virtual void	setCountPairChanges(bool countPairChanges)
+	{
+		m_countPairChanges = countPairChanges;
+	}
+
+	btOverlapFilterCallback* getOverlapFilterCallback()
+	{
+		return m_overlapFilterCallback;
+	}
+
+	void setOverlapFilterCallback(btOverlapFilterCallback* callback)
+	{
+		m_overlapFilterCallback = callback;
+	}
+
+	virtual bool	hasDeferredRemoval()
+	{
+		return false;
+	}
+
+	virtual	void	setInternalGhostPairCallback(btOverlappingPairCallback* ghostPairCallback)
+	{
+		m_ghostPairCallback = ghostPairCallback;
+	}
+
+	///sorts the pairs and rebuilds the table. Like btHashedOverlappingPairCache it releases the collision algorithms of all pairs
+	virtual void	sortOverlappingPairs(btDispatcher* dispatcher);
+};
+
+
+
 ///btNullPairCache skips add/removal of overlapping pairs. Userful for benchmarking and unit testing.
 class btNullPairCache : public btOverlappingPairCache
 {
@@ -18,6 +18,8 @@ subject to the following restrictions:
 #include "LinearMath/btAabbUtil2.h"
 #include "LinearMath/btIDebugDraw.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btQuickprof.h"
 
 #define RAYAABB2
 
@@ -54,7 +56,13 @@ void btQuantizedBvh::buildInternal()
 
 	m_curNodeIndex = 0;
 
-	buildTree(0,numLeafNodes);
+	if (gBvhUseSahBuilder && numLeafNodes)
+	{
+		buildTreeSah(numLeafNodes);
+	} else
+	{
+		buildTree(0,numLeafNodes);
+	}
 
 	///if the entire tree is small then subtree size, we need to create a header info for the tree
 	if(m_useQuantization && !m_SubtreeHeaders.size())
@@ -327,6 +335,411 @@ int	btQuantizedBvh::calcSplittingAxis(int startIndex,int endIndex)
 }
 
 
+bool gBvhUseSahBuilder = false;
+
+///number of bins per axis used to evaluate the surface area heuristic
+#define BT_BVH_SAH_BIN_COUNT 16
+///deeper nodes split at the middle index, so degenerate inputs can't cause stack overflows
+#define BT_BVH_SAH_MAX_DEPTH 64
+///nodes with more primitives compute their bounds and bins in parallel chunks of this size
+#define BT_BVH_SAH_CHUNK_SIZE 8192
+
+///a node range that buildTreeSah hands to buildSahSubtree
+struct btBvhSahSubtree
+{
+	int m_nodeIndex;
+	int m_startIndex;
+	int m_endIndex;
+	int m_depth;
+};
+
+ATTRIBUTE_ALIGNED16(struct) btBvhSahPrimitive
+{
+	btVector3	m_aabbMin;
+	btVector3	m_aabbMax;
+	btVector3	m_centroid;
+	int			m_leafIndex;
+};
+
+struct btBvhSahBounds
+{
+	btVector3	m_aabbMin;
+	btVector3	m_aabbMax;
+	btVector3	m_centroidMin;
+	btVector3	m_centroidMax;
+
+	void	clear()
+	{
+		m_aabbMin.setValue(BT_LARGE_FLOAT,BT_LARGE_FLOAT,BT_LARGE_FLOAT);
+		m_aabbMax.setValue(-BT_LARGE_FLOAT,-BT_LARGE_FLOAT,-BT_LARGE_FLOAT);
+		m_centroidMin = m_aabbMin;
+		m_centroidMax = m_aabbMax;
+	}
+
+	void	merge(const btBvhSahBounds& other)
+	{
+		m_aabbMin.setMin(other.m_aabbMin);
+		m_aabbMax.setMax(other.m_aabbMax);
+		m_centroidMin.setMin(other.m_centroidMin);
+		m_centroidMax.setMax(other.m_centroidMax);
+	}
+};
+
+struct btBvhSahBin
+{
+	btVector3	m_aabbMin;
+	btVector3	m_aabbMax;
+	int			m_count;
+
+	void	clear()
+	{
+		m_aabbMin.setValue(BT_LARGE_FLOAT,BT_LARGE_FLOAT,BT_LARGE_FLOAT);
+		m_aabbMax.setValue(-BT_LARGE_FLOAT,-BT_LARGE_FLOAT,-BT_LARGE_FLOAT);
+		m_count = 0;
+	}
+
+	void	merge(const btBvhSahBin& other)
+	{
+		m_aabbMin.setMin(other.m_aabbMin);
+		m_aabbMax.setMax(other.m_aabbMax);
+		m_count += other.m_count;
+	}
+};
+
+static SIMD_FORCE_INLINE btScalar btBvhSahHalfArea(const btVector3& aabbMin,const btVector3& aabbMax)
+{
+	btVector3 d = aabbMax-aabbMin;
+	return d.getX()*d.getY() + d.getY()*d.getZ() + d.getZ()*d.getX();
+}
+
+static SIMD_FORCE_INLINE int btBvhSahBinIndex(btScalar centroid,btScalar centroidMin,btScalar binScale)
+{
+	int bin = int((centroid-centroidMin)*binScale);
+	return btMax(0,btMin(bin,BT_BVH_SAH_BIN_COUNT-1));
+}
+
+static void btCalcSahBounds(const btBvhSahPrimitive* primitives,int startIndex,int endIndex,btBvhSahBounds& bounds)
+{
+	bounds.clear();
+	for (int i=startIndex;i<endIndex;i++)
+	{
+		const btBvhSahPrimitive& prim = primitives[i];
+		bounds.m_aabbMin.setMin(prim.m_aabbMin);
+		bounds.m_aabbMax.setMax(prim.m_aabbMax);
+		bounds.m_centroidMin.setMin(prim.m_centroid);
+		bounds.m_centroidMax.setMax(prim.m_centroid);
+	}
+}
+
+///fills BT_BVH_SAH_BIN_COUNT bins for each axis
+static void btBinSahPrimitives(const btBvhSahPrimitive* primitives,int startIndex,int endIndex,const btVector3& centroidMin,const btVector3& binScale,btBvhSahBin* bins)
+{
+	for (int i=0;i<3*BT_BVH_SAH_BIN_COUNT;i++)
+	{
+		bins[i].clear();
+	}
+	for (int i=startIndex;i<endIndex;i++)
+	{
+		const btBvhSahPrimitive& prim = primitives[i];
+		for (int axis=0;axis<3;axis++)
+		{
+			btBvhSahBin& bin = bins[axis*BT_BVH_SAH_BIN_COUNT + btBvhSahBinIndex(prim.m_centroid[axis],centroidMin[axis],binScale[axis])];
+			bin.m_aabbMin.setMin(prim.m_aabbMin);
+			bin.m_aabbMax.setMax(prim.m_aabbMax);
+			bin.m_count++;
+		}
+	}
+}
+
+///the chunks are independent of the number of threads, so the tree doesn't depend on it either
+struct btBvhSahChunkBody : public btIParallelForBody
+{
+	const btBvhSahPrimitive* m_primitives;
+	int m_startIndex;
+	int m_endIndex;
+	btBvhSahBounds* m_chunkBounds;
+	btBvhSahBin* m_chunkBins;
+	btVector3 m_centroidMin;
+	btVector3 m_binScale;
+
+	void forLoop( int iBegin, int iEnd ) const
+	{
+		for (int chunk=iBegin;chunk<iEnd;chunk++)
+		{
+			int chunkStart = m_startIndex + chunk*BT_BVH_SAH_CHUNK_SIZE;
+			int chunkEnd = btMin(chunkStart + BT_BVH_SAH_CHUNK_SIZE,m_endIndex);
+			if (m_chunkBounds)
+			{
+				btCalcSahBounds(m_primitives,chunkStart,chunkEnd,m_chunkBounds[chunk]);
+			} else
+			{
+				btBinSahPrimitives(m_primitives,chunkStart,chunkEnd,m_centroidMin,m_binScale,&m_chunkBins[chunk*3*BT_BVH_SAH_BIN_COUNT]);
+			}
+		}
+	}
+};
+
+int	btQuantizedBvh::splitSahNode(btBvhSahPrimitive* primitives,int nodeIndex,int startIndex,int endIndex,int depth)
+{
+	int numIndices = endIndex-startIndex;
+	int numChunks = (numIndices + BT_BVH_SAH_CHUNK_SIZE-1)/BT_BVH_SAH_CHUNK_SIZE;
+
+	btBvhSahBounds bounds;
+	btAlignedObjectArray<btBvhSahBounds> chunkBounds;
+	btAlignedObjectArray<btBvhSahBin> chunkBins;
+	btBvhSahChunkBody chunkBody;
+	chunkBody.m_primitives = primitives;
+	chunkBody.m_startIndex = startIndex;
+	chunkBody.m_endIndex = endIndex;
+	if (numChunks > 1)
+	{
+		chunkBounds.resize(numChunks);
+		chunkBody.m_chunkBounds = &chunkBounds[0];
+		chunkBody.m_chunkBins = 0;
+		btParallelFor(0,numChunks,1,chunkBody);
+		bounds = chunkBounds[0];
+		for (int i=1;i<numChunks;i++)
+		{
+			bounds.merge(chunkBounds[i]);
+		}
+	} else
+	{
+		btCalcSahBounds(primitives,startIndex,endIndex,bounds);
+	}
+
+	//quantize is monotonic, so this gives the same internal node as merging the quantized leaf nodes
+	setInternalNodeAabbMin(nodeIndex,bounds.m_aabbMin);
+	setInternalNodeAabbMax(nodeIndex,bounds.m_aabbMax);
+	//a subtree with n leaf nodes has 2n-1 nodes
+	setInternalNodeEscapeIndex(nodeIndex,2*numIndices-1);
+
+	int splitIndex = startIndex + (numIndices>>1);
+	btVector3 centroidExtent = bounds.m_centroidMax - bounds.m_centroidMin;
+	if (numIndices <= 2 || depth >= BT_BVH_SAH_MAX_DEPTH || centroidExtent[centroidExtent.maxAxis()] <= btScalar(0.))
+	{
+		return splitIndex;
+	}
+
+	btVector3 binScale;
+	for (int axis=0;axis<3;axis++)
+	{
+		binScale[axis] = centroidExtent[axis] > btScalar(0.) ? btScalar(BT_BVH_SAH_BIN_COUNT)*btScalar(1.-1e-5)/centroidExtent[axis] : btScalar(0.);
+	}
+
+	btBvhSahBin bins[3*BT_BVH_SAH_BIN_COUNT];
+	if (numChunks > 1)
+	{
+		chunkBins.resize(numChunks*3*BT_BVH_SAH_BIN_COUNT);
+		chunkBody.m_chunkBounds = 0;
+		chunkBody.m_chunkBins = &chunkBins[0];
+		chunkBody.m_centroidMin = bounds.m_centroidMin;
+		chunkBody.m_binScale = binScale;
+		btParallelFor(0,numChunks,1,chunkBody);
+		for (int i=0;i<3*BT_BVH_SAH_BIN_COUNT;i++)
+		{
+			bins[i] = chunkBins[i];
+			for (int chunk=1;chunk<numChunks;chunk++)
+			{
+				bins[i].merge(chunkBins[chunk*3*BT_BVH_SAH_BIN_COUNT+i]);
+			}
+		}
+	} else
+	{
+		btBinSahPrimitives(primitives,startIndex,endIndex,bounds.m_centroidMin,binScale,bins);
+	}
+
+	//cost of splitting after bin b is area(left)*count(left)+area(right)*count(right)
+	btScalar bestCost = SIMD_INFINITY;
+	int bestAxis = -1;
+	int bestBin = 0;
+	for (int axis=0;axis<3;axis++)
+	{
+		if (binScale[axis] == btScalar(0.))
+			continue;
+		const btBvhSahBin* axisBins = &bins[axis*BT_BVH_SAH_BIN_COUNT];
+		btScalar rightCost[BT_BVH_SAH_BIN_COUNT];
+		btBvhSahBin right;
+		right.clear();
+		for (int b=BT_BVH_SAH_BIN_COUNT-1;b>0;b--)
+		{
+			right.merge(axisBins[b]);
+			rightCost[b] = right.m_count ? btBvhSahHalfArea(right.m_aabbMin,right.m_aabbMax)*btScalar(right.m_count) : btScalar(0.);
+		}
+		btBvhSahBin left;
+		left.clear();
+		for (int b=1;b<BT_BVH_SAH_BIN_COUNT;b++)
+		{
+			left.merge(axisBins[b-1]);
+			if (!left.m_count || left.m_count == numIndices)
+				continue;
+			btScalar cost = btBvhSahHalfArea(left.m_aabbMin,left.m_aabbMax)*btScalar(left.m_count) + rightCost[b];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b;
+			}
+		}
+	}
+
+	if (bestAxis < 0)
+	{
+		return splitIndex;
+	}
+
+	//move the primitives of the bins before bestBin to the front
+	int i = startIndex;
+	int j = endIndex-1;
+	btScalar centroidMin = bounds.m_centroidMin[bestAxis];
+	btScalar scale = binScale[bestAxis];
+	while (i <= j)
+	{
+		if (btBvhSahBinIndex(primitives[i].m_centroid[bestAxis],centroidMin,scale) < bestBin)
+		{
+			i++;
+		} else
+		{
+			btSwap(primitives[i],primitives[j]);
+			j--;
+		}
+	}
+	btAssert(i > startIndex && i < endIndex);
+	return i;
+}
+
+void	btQuantizedBvh::buildSahSubtree(btBvhSahPrimitive* primitives,int nodeIndex,int startIndex,int endIndex,int depth)
+{
+	int numIndices = endIndex-startIndex;
+	btAssert(numIndices>0);
+
+	if (numIndices==1)
+	{
+		assignInternalNodeFromLeafNode(nodeIndex,primitives[startIndex].m_leafIndex);
+		return;
+	}
+
+	int splitIndex = splitSahNode(primitives,nodeIndex,startIndex,endIndex,depth);
+	int leftChildNodeIndex = nodeIndex+1;
+	int rightChildNodeIndex = leftChildNodeIndex + 2*(splitIndex-startIndex)-1;
+	buildSahSubtree(primitives,leftChildNodeIndex,startIndex,splitIndex,depth+1);
+	buildSahSubtree(primitives,rightChildNodeIndex,splitIndex,endIndex,depth+1);
+}
+
+void	btQuantizedBvh::addSahSubtreeHeaders(int nodeIndex)
+{
+	const btQuantizedBvhNode& node = m_quantizedContiguousNodes[nodeIndex];
+	if (node.isLeafNode())
+		return;
+	int subtreeSize = node.getEscapeIndex();
+	if (subtreeSize * static_cast<int>(sizeof(btQuantizedBvhNode)) <= MAX_SUBTREE_SIZE_IN_BYTES)
+		return;
+
+	const btQuantizedBvhNode& leftChildNode = m_quantizedContiguousNodes[nodeIndex+1];
+	int leftChildNodeIndex = nodeIndex+1;
+	int rightChildNodeIndex = leftChildNodeIndex + (leftChildNode.isLeafNode() ? 1 : leftChildNode.getEscapeIndex());
+	addSahSubtreeHeaders(leftChildNodeIndex);
+	addSahSubtreeHeaders(rightChildNodeIndex);
+	updateSubtreeHeaders(leftChildNodeIndex,rightChildNodeIndex);
+}
+
+void	btQuantizedBvh::buildTreeSah(int numLeafNodes)
+{
+	BT_PROFILE("btQuantizedBvh::buildTreeSah");
+
+	btAssert(numLeafNodes>0);
+	m_curNodeIndex = 2*numLeafNodes-1;
+
+	struct UpdaterSahPrimitives : public btIParallelForBody
+	{
+		btQuantizedBvh* m_bvh;
+		btBvhSahPrimitive* m_primitives;
+
+		void forLoop( int iBegin, int iEnd ) const
+		{
+			for (int i=iBegin;i<iEnd;i++)
+			{
+				btBvhSahPrimitive& prim = m_primitives[i];
+				prim.m_aabbMin = m_bvh->getAabbMin(i);
+				prim.m_aabbMax = m_bvh->getAabbMax(i);
+				prim.m_centroid = btScalar(0.5)*(prim.m_aabbMin+prim.m_aabbMax);
+				prim.m_leafIndex = i;
+			}
+		}
+	};
+
+	struct UpdaterSahSubtrees : public btIParallelForBody
+	{
+		btQuantizedBvh* m_bvh;
+		btBvhSahPrimitive* m_primitives;
+		const btBvhSahSubtree* m_subtrees;
+
+		void forLoop( int iBegin, int iEnd ) const
+		{
+			for (int i=iBegin;i<iEnd;i++)
+			{
+				const btBvhSahSubtree& subtree = m_subtrees[i];
+				m_bvh->buildSahSubtree(m_primitives,subtree.m_nodeIndex,subtree.m_startIndex,subtree.m_endIndex,subtree.m_depth);
+			}
+		}
+	};
+
+	btAlignedObjectArray<btBvhSahPrimitive> primitives;
+	primitives.resizeNoInitialize(numLeafNodes);
+
+	UpdaterSahPrimitives updatePrimitives;
+	updatePrimitives.m_bvh = this;
+	updatePrimitives.m_primitives = &primitives[0];
+	btParallelFor(0,numLeafNodes,1024,updatePrimitives);
+
+	//split the top levels one node at a time, with parallel bounds and binning for the big nodes,
+	//until there are enough subtrees to keep all threads busy
+	int numThreads = btGetTaskScheduler() ? btGetTaskScheduler()->getNumThreads() : 1;
+	int maxSubtreeSize = btMax(numLeafNodes/(4*numThreads),BT_BVH_SAH_CHUNK_SIZE);
+	btAlignedObjectArray<btBvhSahSubtree> subtrees;
+	btAlignedObjectArray<btBvhSahSubtree> pending;
+	btBvhSahSubtree root;
+	root.m_nodeIndex = 0;
+	root.m_startIndex = 0;
+	root.m_endIndex = numLeafNodes;
+	root.m_depth = 0;
+	pending.push_back(root);
+	while (pending.size())
+	{
+		btBvhSahSubtree node = pending[pending.size()-1];
+		pending.pop_back();
+		if (node.m_endIndex-node.m_startIndex <= maxSubtreeSize)
+		{
+			subtrees.push_back(node);
+			continue;
+		}
+		int splitIndex = splitSahNode(&primitives[0],node.m_nodeIndex,node.m_startIndex,node.m_endIndex,node.m_depth);
+		btBvhSahSubtree left;
+		left.m_nodeIndex = node.m_nodeIndex+1;
+		left.m_startIndex = node.m_startIndex;
+		left.m_endIndex = splitIndex;
+		left.m_depth = node.m_depth+1;
+		btBvhSahSubtree right;
+		right.m_nodeIndex = left.m_nodeIndex + 2*(splitIndex-node.m_startIndex)-1;
+		right.m_startIndex = splitIndex;
+		right.m_endIndex = node.m_endIndex;
+		right.m_depth = node.m_depth+1;
+		pending.push_back(right);
+		pending.push_back(left);
+	}
+
+	UpdaterSahSubtrees updateSubtrees;
+	updateSubtrees.m_bvh = this;
+	updateSubtrees.m_primitives = &primitives[0];
+	updateSubtrees.m_subtrees = &subtrees[0];
+	btParallelFor(0,subtrees.size(),1,updateSubtrees);
+
+	if (m_useQuantization)
+	{
+		addSahSubtreeHeaders(0);
+	}
+}
+
+
 
 void	btQuantizedBvh::reportAabbOverlappingNodex(btNodeOverlapCallback* nodeCallback,const btVector3& aabbMin,const btVector3& aabbMax) const
 {
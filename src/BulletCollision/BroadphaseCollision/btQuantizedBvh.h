@@ -162,6 +162,14 @@ public:
 
 
 
+///when true btQuantizedBvh and btOptimizedBvh build their trees with the binned surface area heuristic builder
+///that splits subtrees with btParallelFor, otherwise (the default) with the single threaded builder that splits at the mean
+///of the centroids. Both produce the same node and subtree header format, but the trees differ, so queries report
+///overlapping leaves in a different order.
+extern bool gBvhUseSahBuilder;
+
+struct btBvhSahPrimitive;
+
 ///for code readability:
 typedef btAlignedObjectArray<btOptimizedBvhNode>	NodeArray;
 typedef btAlignedObjectArray<btQuantizedBvhNode>	QuantizedNodeArray;
@@ -308,6 +316,19 @@ protected:
 	int	calcSplittingAxis(int startIndex,int endIndex);
 
 	int	sortAndCalcSplittingIndex(int startIndex,int endIndex,int splitAxis);
+
+	///builds the tree of all leaf nodes with the binned surface area heuristic. The subtrees below the top levels are built in parallel.
+	///The nodes are laid out in the same depth first order as buildTree, with the same subtree headers
+	void	buildTreeSah(int numLeafNodes);
+
+	///writes the internal node for the primitives from startIndex to endIndex and partitions them, returns the split index
+	int	splitSahNode(btBvhSahPrimitive* primitives,int nodeIndex,int startIndex,int endIndex,int depth);
+
+	///builds the subtree rooted at nodeIndex for the primitives from startIndex to endIndex, single threaded
+	void	buildSahSubtree(btBvhSahPrimitive* primitives,int nodeIndex,int startIndex,int endIndex,int depth);
+
+	///adds the subtree headers below nodeIndex in the order buildTree adds them
+	void	addSahSubtreeHeaders(int nodeIndex);
 	
 	void	walkStacklessTree(btNodeOverlapCallback* nodeCallback,const btVector3& aabbMin,const btVector3& aabbMax) const;
 
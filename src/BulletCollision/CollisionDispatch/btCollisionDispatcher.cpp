@@ -86,7 +86,7 @@ btPersistentManifold*	btCollisionDispatcher::getNewManifold(const btCollisionObj
 		
  	void* mem = 0;
 	
-	if (m_persistentManifoldPoolAllocator->getFreeCount())
+	if (m_persistentManifoldPoolAllocator->canAllocate())
 	{
 		mem = m_persistentManifoldPoolAllocator->allocate(sizeof(btPersistentManifold));
 	} else
@@ -98,7 +98,7 @@ btPersistentManifold*	btCollisionDispatcher::getNewManifold(const btCollisionObj
 		} else
 		{
 			btAssert(0);
-			//make sure to increase the m_defaultMaxPersistentManifoldPoolSize in the btDefaultCollisionConstructionInfo/btDefaultCollisionConfiguration
+			//make sure to increase the m_defaultMaxPersistentManifoldPoolSize in the btDefaultCollisionConstructionInfo/btDefaultCollisionConfiguration, or call reserve/setGrowSize on getInternalManifoldPool()
 			return 0;
 		}
 	}
@@ -247,6 +247,16 @@ void	btCollisionDispatcher::dispatchAllCollisionPairs(btOverlappingPairCache* pa
 
 }
 
+void	btCollisionDispatcher::dispatchCollisionPairs(btOverlappingPairCache* pairCache,const int* pairIndices,int numPairs,const btDispatcherInfo& dispatchInfo,btDispatcher* /*dispatcher*/)
+{
+	btBroadphasePair* pairArray = pairCache->getOverlappingPairArrayPtr();
+	btNearCallback nearCallback = getNearCallback();
+	for (int i=0;i<numPairs;i++)
+	{
+		(*nearCallback)(pairArray[pairIndices[i]],*this,dispatchInfo);
+	}
+}
+
 
 
 
@@ -293,7 +303,7 @@ void btCollisionDispatcher::defaultNearCallback(btBroadphasePair& collisionPair,
 
 void* btCollisionDispatcher::allocateCollisionAlgorithm(int size)
 {
-	if (m_collisionAlgorithmPoolAllocator->getFreeCount())
+	if (m_collisionAlgorithmPoolAllocator->canAllocate())
 	{
 		return m_collisionAlgorithmPoolAllocator->allocate(size);
 	}
@@ -123,6 +123,8 @@ public:
 	
 	virtual void	dispatchAllCollisionPairs(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher) ;
 
+	virtual void	dispatchCollisionPairs(btOverlappingPairCache* pairCache,const int* pairIndices,int numPairs,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher) ;
+
 	void	setNearCallback(btNearCallback	nearCallback)
 	{
 		m_nearCallback = nearCallback; 
@@ -155,6 +157,7 @@ public:
 		m_collisionConfiguration = config;
 	}
 
+	///the manifold pool can be resized at runtime with reserve, or made growable with setGrowSize, instead of falling back to btAlignedAlloc per manifold when it runs out
 	virtual	btPoolAllocator*	getInternalManifoldPool()
 	{
 		return m_persistentManifoldPoolAllocator;
@@ -0,0 +1,376 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "btCollisionDispatcherMt.h"
+
+#include "BulletCollision/CollisionShapes/btCollisionShape.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObject.h"
+#include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
+#include "BulletCollision/CollisionDispatch/btCollisionConfiguration.h"
+#include "LinearMath/btPoolAllocator.h"
+#include "LinearMath/btQuickprof.h"
+
+extern int gNumManifold;
+
+
+btCollisionDispatcherMt::btCollisionDispatcherMt(btCollisionConfiguration* collisionConfiguration, int grainSize)
+	:btCollisionDispatcher(collisionConfiguration),
+	m_batchUpdating(false),
+	m_grainSize(btMax(grainSize, 1))
+{
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		ThreadLocalData& data = m_threadLocalData[i];
+		data.m_persistentManifoldPool = 0;
+		data.m_collisionAlgorithmPool = 0;
+		data.m_ownsPools = false;
+		data.m_pairIndex = 0;
+		data.m_sequence = 0;
+	}
+	//the first thread shares the pools of the collision configuration
+	m_threadLocalData[0].m_persistentManifoldPool = m_persistentManifoldPoolAllocator;
+	m_threadLocalData[0].m_collisionAlgorithmPool = m_collisionAlgorithmPoolAllocator;
+}
+
+btCollisionDispatcherMt::~btCollisionDispatcherMt()
+{
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		ThreadLocalData& data = m_threadLocalData[i];
+		if (data.m_ownsPools)
+		{
+			data.m_persistentManifoldPool->~btPoolAllocator();
+			btAlignedFree(data.m_persistentManifoldPool);
+			data.m_collisionAlgorithmPool->~btPoolAllocator();
+			btAlignedFree(data.m_collisionAlgorithmPool);
+		}
+	}
+}
+
+static btPoolAllocator* createThreadPool(const btPoolAllocator* sharedPool)
+{
+	//a growable shared pool lets each thread start with a single chunk instead of a full copy of the shared capacity
+	int growSize = sharedPool->getGrowSize();
+	void* mem = btAlignedAlloc(sizeof(btPoolAllocator),16);
+	btPoolAllocator* pool = new (mem) btPoolAllocator(sharedPool->getElementSize(), growSize>0 ? growSize : sharedPool->getMaxCount());
+	pool->setGrowSize(growSize);
+	return pool;
+}
+
+///gives ptr back to the pool and returns true if it came from there. The owning thread may add a chunk to the pool at the same time,
+///so the chunk list is only read under the pool mutex.
+static bool freeToPool(btPoolAllocator* pool, btSpinMutex& poolMutex, void* ptr)
+{
+	btMutexLock(&poolMutex);
+	bool owned = pool->validPtr(ptr);
+	if (owned)
+	{
+		pool->freeMemory(ptr);
+	}
+	btMutexUnlock(&poolMutex);
+	return owned;
+}
+
+btCollisionDispatcherMt::ThreadLocalData& btCollisionDispatcherMt::getThreadLocalData()
+{
+	ThreadLocalData& data = m_threadLocalData[btGetCurrentThreadIndex()];
+	if (!data.m_persistentManifoldPool)
+	{
+		//only the owning thread creates its pools, other threads read the pointers to find the owner of a freed block.
+		//They are set under the pool mutex, which the other threads take before they look into the pool.
+		btPoolAllocator* algorithmPool = createThreadPool(m_collisionAlgorithmPoolAllocator);
+		btPoolAllocator* manifoldPool = createThreadPool(m_persistentManifoldPoolAllocator);
+		btMutexLock(&data.m_poolMutex);
+		data.m_ownsPools = true;
+		data.m_collisionAlgorithmPool = algorithmPool;
+		data.m_persistentManifoldPool = manifoldPool;
+		btMutexUnlock(&data.m_poolMutex);
+	}
+	return data;
+}
+
+
+btPersistentManifold*	btCollisionDispatcherMt::getNewManifold(const btCollisionObject* body0,const btCollisionObject* body1)
+{
+	//optional relative contact breaking threshold, turned on by default (use setDispatcherFlags to switch off feature for improved performance)
+	btScalar contactBreakingThreshold =  (m_dispatcherFlags & btCollisionDispatcher::CD_USE_RELATIVE_CONTACT_BREAKING_THRESHOLD) ?
+		btMin(body0->getCollisionShape()->getContactBreakingThreshold(gContactBreakingThreshold) , body1->getCollisionShape()->getContactBreakingThreshold(gContactBreakingThreshold))
+		: gContactBreakingThreshold ;
+
+	btScalar contactProcessingThreshold = btMin(body0->getContactProcessingThreshold(),body1->getContactProcessingThreshold());
+
+	ThreadLocalData& data = getThreadLocalData();
+
+	void* mem = 0;
+	btMutexLock(&data.m_poolMutex);
+	if (data.m_persistentManifoldPool->canAllocate())
+	{
+		mem = data.m_persistentManifoldPool->allocate(sizeof(btPersistentManifold));
+	}
+	btMutexUnlock(&data.m_poolMutex);
+
+	if (!mem)
+	{
+		//we got a pool memory overflow, by default we fallback to dynamically allocate memory. If we require a contiguous contact pool then assert.
+		if ((m_dispatcherFlags&CD_DISABLE_CONTACTPOOL_DYNAMIC_ALLOCATION)==0)
+		{
+			mem = btAlignedAlloc(sizeof(btPersistentManifold),16);
+		} else
+		{
+			btAssert(0);
+			//make sure to increase the m_defaultMaxPersistentManifoldPoolSize in the btDefaultCollisionConstructionInfo/btDefaultCollisionConfiguration, or call reserve/setGrowSize on getInternalManifoldPool()
+			return 0;
+		}
+	}
+	btPersistentManifold* manifold = new(mem) btPersistentManifold (body0,body1,0,contactBreakingThreshold,contactProcessingThreshold);
+
+	if (m_batchUpdating)
+	{
+		//the manifold is added to m_manifoldsPtr after the batch, in pair order
+		ManifoldEvent ev;
+		ev.m_manifold = manifold;
+		ev.m_pairIndex = data.m_pairIndex;
+		ev.m_sequence = data.m_sequence++;
+		manifold->m_index1a = -1;
+		data.m_newManifolds.push_back(ev);
+	} else
+	{
+		gNumManifold++;
+		manifold->m_index1a = m_manifoldsPtr.size();
+		m_manifoldsPtr.push_back(manifold);
+	}
+	return manifold;
+}
+
+void btCollisionDispatcherMt::removeManifoldFromArray(btPersistentManifold* manifold)
+{
+	int findIndex = manifold->m_index1a;
+	btAssert(findIndex >= 0 && findIndex < m_manifoldsPtr.size());
+	m_manifoldsPtr.swap(findIndex,m_manifoldsPtr.size()-1);
+	m_manifoldsPtr[findIndex]->m_index1a = findIndex;
+	m_manifoldsPtr.pop_back();
+}
+
+void btCollisionDispatcherMt::freeManifoldMemory(btPersistentManifold* manifold)
+{
+	manifold->~btPersistentManifold();
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		ThreadLocalData& data = m_threadLocalData[i];
+		if (data.m_persistentManifoldPool && freeToPool(data.m_persistentManifoldPool, data.m_poolMutex, manifold))
+		{
+			return;
+		}
+	}
+	btAlignedFree(manifold);
+}
+
+void btCollisionDispatcherMt::releaseManifold(btPersistentManifold* manifold)
+{
+	if (m_batchUpdating)
+	{
+		//defer the release, so the order of m_manifoldsPtr doesn't depend on the thread scheduling
+		ThreadLocalData& data = getThreadLocalData();
+		ManifoldEvent ev;
+		ev.m_manifold = manifold;
+		ev.m_pairIndex = data.m_pairIndex;
+		ev.m_sequence = data.m_sequence++;
+		data.m_releasedManifolds.push_back(ev);
+		return;
+	}
+
+	gNumManifold--;
+	clearManifold(manifold);
+	removeManifoldFromArray(manifold);
+	freeManifoldMemory(manifold);
+}
+
+
+void* btCollisionDispatcherMt::allocateCollisionAlgorithm(int size)
+{
+	ThreadLocalData& data = getThreadLocalData();
+	void* mem = 0;
+	btMutexLock(&data.m_poolMutex);
+	if (data.m_collisionAlgorithmPool->canAllocate())
+	{
+		mem = data.m_collisionAlgorithmPool->allocate(size);
+	}
+	btMutexUnlock(&data.m_poolMutex);
+	if (mem)
+	{
+		return mem;
+	}
+	//warn user for overflow?
+	return	btAlignedAlloc(static_cast<size_t>(size), 16);
+}
+
+void btCollisionDispatcherMt::freeCollisionAlgorithm(void* ptr)
+{
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		ThreadLocalData& data = m_threadLocalData[i];
+		if (data.m_collisionAlgorithmPool && freeToPool(data.m_collisionAlgorithmPool, data.m_poolMutex, ptr))
+		{
+			return;
+		}
+	}
+	btAlignedFree(ptr);
+}
+
+
+class btManifoldEventSortPredicate
+{
+public:
+	SIMD_FORCE_INLINE bool operator() ( const btCollisionDispatcherMt::ManifoldEvent& lhs, const btCollisionDispatcherMt::ManifoldEvent& rhs ) const
+	{
+		if (lhs.m_pairIndex != rhs.m_pairIndex)
+		{
+			return lhs.m_pairIndex < rhs.m_pairIndex;
+		}
+		return lhs.m_sequence < rhs.m_sequence;
+	}
+};
+
+void btCollisionDispatcherMt::gatherManifoldEvents(btAlignedObjectArray<ManifoldEvent>& events, bool released)
+{
+	events.resize(0);
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		btAlignedObjectArray<ManifoldEvent>& threadEvents = released ? m_threadLocalData[i].m_releasedManifolds : m_threadLocalData[i].m_newManifolds;
+		for (int j=0;j<threadEvents.size();j++)
+		{
+			events.push_back(threadEvents[j]);
+		}
+		threadEvents.resize(0);
+	}
+	//a pair is always processed by a single thread, so (pairIndex, sequence) gives a unique and thread count independent order
+	events.quickSort(btManifoldEventSortPredicate());
+}
+
+
+struct btCollisionDispatcherUpdater : public btIParallelForBody
+{
+	btBroadphasePair*			m_pairArray;
+	const int*					m_pairIndices;
+	btNearCallback				m_callback;
+	btCollisionDispatcher*		m_dispatcher;
+	const btDispatcherInfo*		m_info;
+	int*						m_pairIndexPtrs[BT_MAX_THREAD_COUNT];
+
+	btCollisionDispatcherUpdater()
+	{
+		m_pairArray = 0;
+		m_pairIndices = 0;
+		m_callback = 0;
+		m_dispatcher = 0;
+		m_info = 0;
+	}
+
+	void forLoop( int iBegin, int iEnd ) const
+	{
+		int* pairIndex = m_pairIndexPtrs[btGetCurrentThreadIndex()];
+		for ( int i = iBegin; i < iEnd; ++i )
+		{
+			btBroadphasePair* pair = &m_pairArray[ m_pairIndices ? m_pairIndices[ i ] : i ];
+			*pairIndex = i;
+			m_callback( *pair, *m_dispatcher, *m_info );
+		}
+	}
+};
+
+
+void	btCollisionDispatcherMt::dispatchAllCollisionPairs(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher)
+{
+	int pairCount = pairCache->getNumOverlappingPairs();
+	if (pairCount == 0 || dispatchInfo.m_dispatchFunc != btDispatcherInfo::DISPATCH_DISCRETE)
+	{
+		//the time of impact is accumulated in dispatchInfo, which is not thread safe
+		btCollisionDispatcher::dispatchAllCollisionPairs(pairCache, dispatchInfo, dispatcher);
+		return;
+	}
+	dispatchPairsParallel(pairCache->getOverlappingPairArrayPtr(), 0, pairCount, dispatchInfo);
+}
+
+void	btCollisionDispatcherMt::dispatchCollisionPairs(btOverlappingPairCache* pairCache,const int* pairIndices,int numPairs,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher)
+{
+	if (numPairs == 0 || dispatchInfo.m_dispatchFunc != btDispatcherInfo::DISPATCH_DISCRETE)
+	{
+		btCollisionDispatcher::dispatchCollisionPairs(pairCache, pairIndices, numPairs, dispatchInfo, dispatcher);
+		return;
+	}
+	dispatchPairsParallel(pairCache->getOverlappingPairArrayPtr(), pairIndices, numPairs, dispatchInfo);
+}
+
+void	btCollisionDispatcherMt::dispatchPairsParallel(btBroadphasePair* pairArray,const int* pairIndices,int numPairs,const btDispatcherInfo& dispatchInfo)
+{
+	//the manifold events are ordered by the position in the processed pair list, which follows the pair array order
+	btCollisionDispatcherUpdater updater;
+	updater.m_callback = getNearCallback();
+	updater.m_pairArray = pairArray;
+	updater.m_pairIndices = pairIndices;
+	updater.m_dispatcher = this;
+	updater.m_info = &dispatchInfo;
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		ThreadLocalData& data = m_threadLocalData[i];
+		data.m_sequence = 0;
+		updater.m_pairIndexPtrs[i] = &data.m_pairIndex;
+		if (data.m_ownsPools)
+		{
+			//pick up grow sizes that were changed on the shared pools at runtime
+			data.m_persistentManifoldPool->setGrowSize(m_persistentManifoldPoolAllocator->getGrowSize());
+			data.m_collisionAlgorithmPool->setGrowSize(m_collisionAlgorithmPoolAllocator->getGrowSize());
+		}
+	}
+
+	m_batchUpdating = true;
+	btParallelFor( 0, numPairs, m_grainSize, updater );
+	m_batchUpdating = false;
+
+	{
+		BT_PROFILE("mergeManifolds");
+		btAlignedObjectArray<ManifoldEvent> events;
+
+		//first append the new manifolds, then apply the deferred releases, both in pair order
+		gatherManifoldEvents(events, false);
+		for (int i=0;i<events.size();i++)
+		{
+			btPersistentManifold* manifold = events[i].m_manifold;
+			gNumManifold++;
+			manifold->m_index1a = m_manifoldsPtr.size();
+			m_manifoldsPtr.push_back(manifold);
+		}
+
+		gatherManifoldEvents(events, true);
+		for (int i=0;i<events.size();i++)
+		{
+			releaseManifold(events[i].m_manifold);
+		}
+	}
+}
+
+int btCollisionDispatcherMt::getManifoldPoolHighWaterMark() const
+{
+	int highWaterMark = 0;
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		if (m_threadLocalData[i].m_persistentManifoldPool)
+		{
+			highWaterMark += m_threadLocalData[i].m_persistentManifoldPool->getHighWaterMark();
+		}
+	}
+	return highWaterMark;
+}
@@ -0,0 +1,97 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_COLLISION_DISPATCHER_MT_H
+#define BT_COLLISION_DISPATCHER_MT_H
+
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "LinearMath/btThreads.h"
+
+
+///btCollisionDispatcherMt processes the overlapping pairs in parallel chunks using btParallelFor.
+///Collision algorithms and manifolds are allocated from per-thread pools. Manifolds that are created or released
+///while the pairs are processed are only recorded, and applied to the manifold array afterwards in pair order,
+///so the resulting manifold array is identical no matter how many threads were used.
+///Continuous (time of impact) dispatch is not thread safe and falls back to the serial btCollisionDispatcher path.
+class btCollisionDispatcherMt : public btCollisionDispatcher
+{
+public:
+
+	///a manifold creation or release that happened while the pairs were processed in parallel
+	struct ManifoldEvent
+	{
+		btPersistentManifold*	m_manifold;
+		int						m_pairIndex;
+		int						m_sequence;
+	};
+
+protected:
+
+	struct ThreadLocalData
+	{
+		btSpinMutex			m_poolMutex;
+		btPoolAllocator*	m_persistentManifoldPool;
+		btPoolAllocator*	m_collisionAlgorithmPool;
+		bool				m_ownsPools;
+		int					m_pairIndex;
+		int					m_sequence;
+		btAlignedObjectArray<ManifoldEvent>	m_newManifolds;
+		btAlignedObjectArray<ManifoldEvent>	m_releasedManifolds;
+	};
+
+	ThreadLocalData		m_threadLocalData[BT_MAX_THREAD_COUNT];
+	bool				m_batchUpdating;
+	int					m_grainSize;
+
+	ThreadLocalData&	getThreadLocalData();
+	void	gatherManifoldEvents(btAlignedObjectArray<ManifoldEvent>& events, bool released);
+	void	removeManifoldFromArray(btPersistentManifold* manifold);
+	void	freeManifoldMemory(btPersistentManifold* manifold);
+	void	dispatchPairsParallel(btBroadphasePair* pairArray,const int* pairIndices,int numPairs,const btDispatcherInfo& dispatchInfo);
+
+public:
+
+	btCollisionDispatcherMt(btCollisionConfiguration* collisionConfiguration, int grainSize = 40);
+
+	virtual ~btCollisionDispatcherMt();
+
+	virtual btPersistentManifold*	getNewManifold(const btCollisionObject* body0,const btCollisionObject* body1);
+
+	virtual void releaseManifold(btPersistentManifold* manifold);
+
+	virtual void	dispatchAllCollisionPairs(btOverlappingPairCache* pairCache,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher);
+
+	virtual void	dispatchCollisionPairs(btOverlappingPairCache* pairCache,const int* pairIndices,int numPairs,const btDispatcherInfo& dispatchInfo,btDispatcher* dispatcher);
+
+	virtual	void* allocateCollisionAlgorithm(int size);
+
+	virtual	void freeCollisionAlgorithm(void* ptr);
+
+	///sum of the manifold high-water marks of the shared pool and the per-thread pools
+	int		getManifoldPoolHighWaterMark() const;
+
+	///sets the number of pairs that are processed as one unit of work
+	void	setGrainSize(int grainSize)
+	{
+		m_grainSize = btMax(grainSize, 1);
+	}
+
+	int		getGrainSize() const
+	{
+		return m_grainSize;
+	}
+};
+
+#endif //BT_COLLISION_DISPATCHER_MT_H
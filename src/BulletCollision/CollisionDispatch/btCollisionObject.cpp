@@ -15,6 +15,7 @@ subject to the following restrictions:
 
 
 #include "btCollisionObject.h"
+#include "btCollisionWorld.h"
 #include "LinearMath/btSerializer.h"
 
 btCollisionObject::btCollisionObject()
@@ -28,8 +29,13 @@ btCollisionObject::btCollisionObject()
 		m_collisionFlags(btCollisionObject::CF_STATIC_OBJECT),
 		m_islandTag1(-1),
 		m_companionId(-1),
+		m_worldArrayIndex(-1),
 		m_activationState1(1),
 		m_deactivationTime(btScalar(0.)),
+		m_activationWorld(0),
+		m_activationListIndex(-1),
+		m_inActiveList(false),
+		m_activationChangeQueued(false),
 		m_friction(btScalar(0.5)),
 		m_restitution(btScalar(0.)),
 		m_rollingFriction(0.0f),
@@ -52,12 +58,26 @@ btCollisionObject::~btCollisionObject()
 void btCollisionObject::setActivationState(int newState) const
 { 
 	if ( (m_activationState1 != DISABLE_DEACTIVATION) && (m_activationState1 != DISABLE_SIMULATION))
+	{
+		bool wasActive = isActive();
 		m_activationState1 = newState;
+		notifyActivationChange(wasActive);
+	}
 }
 
 void btCollisionObject::forceActivationState(int newState) const
 {
+	bool wasActive = isActive();
 	m_activationState1 = newState;
+	notifyActivationChange(wasActive);
+}
+
+void btCollisionObject::notifyActivationChange(bool wasActive) const
+{
+	if (m_activationWorld && wasActive != isActive())
+	{
+		m_activationWorld->queueActivationChange(this);
+	}
 }
 
 void btCollisionObject::activate(bool forceActivation) const
@@ -28,6 +28,7 @@ subject to the following restrictions:
 struct	btBroadphaseProxy;
 class	btCollisionShape;
 struct btCollisionShapeData;
+class	btCollisionWorld;
 #include "LinearMath/btMotionState.h"
 #include "LinearMath/btAlignedAllocator.h"
 #include "LinearMath/btAlignedObjectArray.h"
@@ -79,10 +80,20 @@ protected:
 
 	int				m_islandTag1;
 	int				m_companionId;
+	///index of the object in the collision object array of its world, -1 if it isn't in a world
+	int				m_worldArrayIndex;
 
 	mutable int				m_activationState1;
 	mutable btScalar			m_deactivationTime;
 
+	///the world that keeps this object in its active or sleeping object list, see btCollisionWorld::setSplitActiveObjects
+	btCollisionWorld*		m_activationWorld;
+	///index in the active or the sleeping object list of m_activationWorld
+	int						m_activationListIndex;
+	bool					m_inActiveList;
+	///set while the object waits in the activation change queue of m_activationWorld
+	mutable bool			m_activationChangeQueued;
+
 	btScalar		m_friction;
 	btScalar		m_restitution;
 	btScalar		m_rollingFriction;
@@ -115,6 +126,11 @@ protected:
 	int			m_updateRevision;
 
 
+	///the activation state setters report sleeping and waking objects to m_activationWorld
+	void	notifyActivationChange(bool wasActive) const;
+
+	friend class btCollisionWorld;
+
 public:
 
 	BT_DECLARE_ALIGNED_ALLOCATOR();
@@ -405,6 +421,17 @@ public:
 		m_islandTag1 = tag;
 	}
 
+	SIMD_FORCE_INLINE int getWorldArrayIndex() const
+	{
+		return	m_worldArrayIndex;
+	}
+
+	///only used by btCollisionWorld, which keeps the index in sync with its collision object array
+	void	setWorldArrayIndex(int index)
+	{
+		m_worldArrayIndex = index;
+	}
+
 	SIMD_FORCE_INLINE int getCompanionId() const
 	{
 		return	m_companionId;
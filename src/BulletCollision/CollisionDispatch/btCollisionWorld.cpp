@@ -31,6 +31,7 @@ subject to the following restrictions:
 #include "BulletCollision/BroadphaseCollision/btDbvt.h"
 #include "LinearMath/btAabbUtil2.h"
 #include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
 #include "LinearMath/btSerializer.h"
 #include "BulletCollision/CollisionShapes/btConvexPolyhedron.h"
 #include "BulletCollision/CollisionDispatch/btCollisionObjectWrapper.h"
@@ -70,7 +71,14 @@ btCollisionWorld::btCollisionWorld(btDispatcher* dispatcher,btBroadphaseInterfac
 :m_dispatcher1(dispatcher),
 m_broadphasePairCache(pairCache),
 m_debugDrawer(0),
-m_forceUpdateAllAabbs(true)
+m_forceUpdateAllAabbs(true),
+m_splitActiveObjects(false),
+m_numActivationChanges(0),
+m_awakePairsValid(false),
+m_awakePairsNumPairs(0),
+m_awakePairsNumAdded(0),
+m_awakePairsNumRemoved(0),
+m_awakePairsNumActivationChanges(0)
 {
 }
 
@@ -94,6 +102,10 @@ btCollisionWorld::~btCollisionWorld()
 			getBroadphase()->destroyProxy(bp,m_dispatcher1);
 			collisionObject->setBroadphaseHandle(0);
 		}
+		collisionObject->setWorldArrayIndex(-1);
+		collisionObject->m_activationWorld = 0;
+		collisionObject->m_activationListIndex = -1;
+		collisionObject->m_activationChangeQueued = false;
 	}
 
 
@@ -116,8 +128,14 @@ void	btCollisionWorld::addCollisionObject(btCollisionObject* collisionObject,sho
 	//check that the object isn't already added
 	btAssert( m_collisionObjects.findLinearSearch(collisionObject)  == m_collisionObjects.size());
 
+	collisionObject->setWorldArrayIndex(m_collisionObjects.size());
 	m_collisionObjects.push_back(collisionObject);
 
+	if (m_splitActiveObjects)
+	{
+		insertActivationList(collisionObject);
+	}
+
 	//calculate new AABB
 	btTransform trans = collisionObject->getWorldTransform();
 
@@ -144,9 +162,8 @@ void	btCollisionWorld::addCollisionObject(btCollisionObject* collisionObject,sho
 
 
 
-void	btCollisionWorld::updateSingleAabb(btCollisionObject* colObj)
+void	btCollisionWorld::computeObjectAabb(const btCollisionObject* colObj, btVector3& minAabb, btVector3& maxAabb) const
 {
-	btVector3 minAabb,maxAabb;
 	colObj->getCollisionShape()->getAabb(colObj->getWorldTransform(), minAabb,maxAabb);
 	//need to increase the aabb for contact thresholds
 	btVector3 contactThreshold(gContactBreakingThreshold,gContactBreakingThreshold,gContactBreakingThreshold);
@@ -162,46 +179,130 @@ void	btCollisionWorld::updateSingleAabb(btCollisionObject* colObj)
 		minAabb.setMin(minAabb2);
 		maxAabb.setMax(maxAabb2);
 	}
+}
 
-	btBroadphaseInterface* bp = (btBroadphaseInterface*)m_broadphasePairCache;
-
+bool	btCollisionWorld::checkObjectAabb(btCollisionObject* colObj, const btVector3& minAabb, const btVector3& maxAabb)
+{
 	//moving objects should be moderately sized, probably something wrong if not
 	if ( colObj->isStaticObject() || ((maxAabb-minAabb).length2() < btScalar(1e12)))
 	{
-		bp->setAabb(colObj->getBroadphaseHandle(),minAabb,maxAabb, m_dispatcher1);
-	} else
+		return true;
+	}
+
+	//something went wrong, investigate
+	//this assert is unwanted in 3D modelers (danger of loosing work)
+	colObj->setActivationState(DISABLE_SIMULATION);
+
+	static bool reportMe = true;
+	if (reportMe && m_debugDrawer)
 	{
-		//something went wrong, investigate
-		//this assert is unwanted in 3D modelers (danger of loosing work)
-		colObj->setActivationState(DISABLE_SIMULATION);
+		reportMe = false;
+		m_debugDrawer->reportErrorWarning("Overflow in AABB, object removed from simulation");
+		m_debugDrawer->reportErrorWarning("If you can reproduce this, please email bugs@continuousphysics.com\n");
+		m_debugDrawer->reportErrorWarning("Please include above information, your Platform, version of OS.\n");
+		m_debugDrawer->reportErrorWarning("Thanks.\n");
+	}
+	return false;
+}
 
-		static bool reportMe = true;
-		if (reportMe && m_debugDrawer)
+void	btCollisionWorld::updateSingleAabb(btCollisionObject* colObj)
+{
+	btVector3 minAabb,maxAabb;
+	computeObjectAabb(colObj,minAabb,maxAabb);
+
+	if (checkObjectAabb(colObj,minAabb,maxAabb))
+	{
+		btBroadphaseInterface* bp = (btBroadphaseInterface*)m_broadphasePairCache;
+		bp->setAabb(colObj->getBroadphaseHandle(),minAabb,maxAabb, m_dispatcher1);
+	}
+}
+
+struct btUpdateAabbsLoop : public btIParallelForBody
+{
+	const btCollisionWorld*		m_world;
+	btCollisionObject* const*	m_objects;
+	btVector3*					m_aabbMin;
+	btVector3*					m_aabbMax;
+
+	void forLoop( int iBegin, int iEnd ) const
+	{
+		for ( int i = iBegin; i < iEnd; ++i )
 		{
-			reportMe = false;
-			m_debugDrawer->reportErrorWarning("Overflow in AABB, object removed from simulation");
-			m_debugDrawer->reportErrorWarning("If you can reproduce this, please email bugs@continuousphysics.com\n");
-			m_debugDrawer->reportErrorWarning("Please include above information, your Platform, version of OS.\n");
-			m_debugDrawer->reportErrorWarning("Thanks.\n");
+			m_world->computeObjectAabb( m_objects[ i ], m_aabbMin[ i ], m_aabbMax[ i ] );
 		}
 	}
-}
+};
+
+class btWorldArrayIndexSortPredicate
+{
+public:
+	SIMD_FORCE_INLINE bool operator() ( const btCollisionObject* lhs, const btCollisionObject* rhs ) const
+	{
+		return lhs->getWorldArrayIndex() < rhs->getWorldArrayIndex();
+	}
+};
 
 void	btCollisionWorld::updateAabbs()
 {
 	BT_PROFILE("updateAabbs");
 
-	btTransform predictedTrans;
-	for ( int i=0;i<m_collisionObjects.size();i++)
+	m_updateAabbObjects.resize(0);
+	if (m_splitActiveObjects && !m_forceUpdateAllAabbs)
 	{
-		btCollisionObject* colObj = m_collisionObjects[i];
+		updateActiveObjects();
+		for (int i=0;i<m_activeObjects.size();i++)
+		{
+			m_updateAabbObjects.push_back(m_activeObjects[i]);
+		}
+		//the broadphase results depend on the update order, use the order of the collision object array like below
+		m_updateAabbObjects.quickSort(btWorldArrayIndexSortPredicate());
+	} else
+	{
+		for ( int i=0;i<m_collisionObjects.size();i++)
+		{
+			btCollisionObject* colObj = m_collisionObjects[i];
 
-		//only update aabb of active objects
-		if (m_forceUpdateAllAabbs || colObj->isActive())
+			//only update aabb of active objects
+			if (m_forceUpdateAllAabbs || colObj->isActive())
+			{
+				m_updateAabbObjects.push_back(colObj);
+			}
+		}
+	}
+	int numObjects = m_updateAabbObjects.size();
+	if (!numObjects)
+	{
+		return;
+	}
+	m_updateAabbMin.resizeNoInitialize(numObjects);
+	m_updateAabbMax.resizeNoInitialize(numObjects);
+	m_updateAabbProxies.resizeNoInitialize(numObjects);
+
+	//getAabb only reads the shape and the transform, so the objects are independent
+	btUpdateAabbsLoop loop;
+	loop.m_world = this;
+	loop.m_objects = &m_updateAabbObjects[0];
+	loop.m_aabbMin = &m_updateAabbMin[0];
+	loop.m_aabbMax = &m_updateAabbMax[0];
+	btParallelFor( 0, numObjects, 256, loop );
+
+	//the broadphase is not thread safe, drop the invalid aabbs and hand the rest over in one batch
+	int numValid = 0;
+	for (int i=0;i<numObjects;i++)
+	{
+		btCollisionObject* colObj = m_updateAabbObjects[i];
+		if (checkObjectAabb(colObj,m_updateAabbMin[i],m_updateAabbMax[i]))
 		{
-			updateSingleAabb(colObj);
+			m_updateAabbProxies[numValid] = colObj->getBroadphaseHandle();
+			m_updateAabbMin[numValid] = m_updateAabbMin[i];
+			m_updateAabbMax[numValid] = m_updateAabbMax[i];
+			numValid++;
 		}
 	}
+	if (numValid)
+	{
+		m_broadphasePairCache->setAabbs(&m_updateAabbProxies[0],&m_updateAabbMin[0],&m_updateAabbMax[0],numValid,m_dispatcher1);
+	}
 }
 
 
@@ -217,17 +318,165 @@ void	btCollisionWorld::performDiscreteCollisionDetection()
 
 	btDispatcherInfo& dispatchInfo = getDispatchInfo();
 
+	//the broadphase can already add pairs while the aabbs are updated
+	btOverlappingPairCache* pairCache = m_broadphasePairCache->getOverlappingPairCache();
+	pairCache->setCountPairChanges(needsPairChangeCounts());
+
 	updateAabbs();
 
 	computeOverlappingPairs();
 
 	btDispatcher* dispatcher = getDispatcher();
+	if (dispatcher && m_splitActiveObjects && !pairCache->hasDeferredRemoval())
+	{
+		BT_PROFILE("dispatchAwakeCollisionPairs");
+		updateActiveObjects();
+		updateAwakePairs(pairCache);
+		if (m_awakePairIndices.size())
+		{
+			dispatcher->dispatchCollisionPairs(pairCache,&m_awakePairIndices[0],m_awakePairIndices.size(),dispatchInfo,m_dispatcher1);
+		}
+	} else
 	{
 		BT_PROFILE("dispatchAllCollisionPairs");
 		if (dispatcher)
-			dispatcher->dispatchAllCollisionPairs(m_broadphasePairCache->getOverlappingPairCache(),dispatchInfo,m_dispatcher1);
+			dispatcher->dispatchAllCollisionPairs(pairCache,dispatchInfo,m_dispatcher1);
+	}
+
+}
+
+
+void	btCollisionWorld::setSplitActiveObjects(bool splitActiveObjects)
+{
+	if (splitActiveObjects == m_splitActiveObjects)
+	{
+		return;
+	}
+	m_splitActiveObjects = splitActiveObjects;
+	m_activeObjects.resize(0);
+	m_sleepingObjects.resize(0);
+	m_activationChangedObjects.resize(0);
+	m_awakePairIndices.resize(0);
+	m_awakePairProxies.resize(0);
+	m_awakePairsValid = false;
+	for (int i=0;i<m_collisionObjects.size();i++)
+	{
+		btCollisionObject* colObj = m_collisionObjects[i];
+		colObj->m_activationChangeQueued = false;
+		if (splitActiveObjects)
+		{
+			insertActivationList(colObj);
+		} else
+		{
+			colObj->m_activationWorld = 0;
+			colObj->m_activationListIndex = -1;
+		}
+	}
+}
+
+void	btCollisionWorld::insertActivationList(btCollisionObject* colObj)
+{
+	btCollisionObjectArray& list = colObj->isActive() ? m_activeObjects : m_sleepingObjects;
+	colObj->m_activationWorld = this;
+	colObj->m_inActiveList = colObj->isActive();
+	colObj->m_activationListIndex = list.size();
+	list.push_back(colObj);
+}
+
+void	btCollisionWorld::removeActivationList(btCollisionObject* colObj)
+{
+	btCollisionObjectArray& list = colObj->m_inActiveList ? m_activeObjects : m_sleepingObjects;
+	int index = colObj->m_activationListIndex;
+	btAssert(index >= 0 && index < list.size() && list[index] == colObj);
+	list.swap(index,list.size()-1);
+	list[index]->m_activationListIndex = index;
+	list.pop_back();
+	colObj->m_activationListIndex = -1;
+}
+
+void	btCollisionWorld::queueActivationChange(const btCollisionObject* colObj)
+{
+	btMutexLock(&m_activationChangedMutex);
+	if (!colObj->m_activationChangeQueued)
+	{
+		colObj->m_activationChangeQueued = true;
+		m_activationChangedObjects.push_back(const_cast<btCollisionObject*>(colObj));
 	}
+	btMutexUnlock(&m_activationChangedMutex);
+}
 
+void	btCollisionWorld::updateActiveObjects()
+{
+	for (int i=0;i<m_activationChangedObjects.size();i++)
+	{
+		btCollisionObject* colObj = m_activationChangedObjects[i];
+		colObj->m_activationChangeQueued = false;
+		//an object can fall asleep and wake up again before the lists are updated
+		if (colObj->isActive() != colObj->m_inActiveList)
+		{
+			removeActivationList(colObj);
+			insertActivationList(colObj);
+			m_numActivationChanges++;
+		}
+	}
+	m_activationChangedObjects.resize(0);
+}
+
+static SIMD_FORCE_INLINE bool btIsAwakePair(const btBroadphasePair& pair)
+{
+	const btCollisionObject* colObj0 = (const btCollisionObject*)pair.m_pProxy0->m_clientObject;
+	const btCollisionObject* colObj1 = (const btCollisionObject*)pair.m_pProxy1->m_clientObject;
+	return colObj0->isActive() || colObj1->isActive();
+}
+
+void	btCollisionWorld::updateAwakePairs(btOverlappingPairCache* pairCache)
+{
+	int numPairs = pairCache->getNumOverlappingPairs();
+	btBroadphasePair* pairs = numPairs ? pairCache->getOverlappingPairArrayPtr() : 0;
+	unsigned int numAdded = pairCache->getNumAddedPairs();
+	unsigned int numRemoved = pairCache->getNumRemovedPairs();
+
+	//without removals the pair array only grows at the end, and without activation changes the old pairs keep their state
+	bool appendOnly = m_awakePairsValid &&
+		m_awakePairsNumActivationChanges == m_numActivationChanges &&
+		m_awakePairsNumRemoved == numRemoved &&
+		numAdded - m_awakePairsNumAdded == unsigned(numPairs - m_awakePairsNumPairs);
+	if (appendOnly)
+	{
+		//sortOverlappingPairs reorders the pairs without changing the counters
+		for (int i=0;i<m_awakePairIndices.size();i++)
+		{
+			const btBroadphasePair& pair = pairs[m_awakePairIndices[i]];
+			if (pair.m_pProxy0 != m_awakePairProxies[2*i] || pair.m_pProxy1 != m_awakePairProxies[2*i+1])
+			{
+				appendOnly = false;
+				break;
+			}
+		}
+	}
+
+	int first = m_awakePairsNumPairs;
+	if (!appendOnly)
+	{
+		first = 0;
+		m_awakePairIndices.resize(0);
+		m_awakePairProxies.resize(0);
+	}
+	for (int i=first;i<numPairs;i++)
+	{
+		if (btIsAwakePair(pairs[i]))
+		{
+			m_awakePairIndices.push_back(i);
+			m_awakePairProxies.push_back(pairs[i].m_pProxy0);
+			m_awakePairProxies.push_back(pairs[i].m_pProxy1);
+		}
+	}
+
+	m_awakePairsValid = true;
+	m_awakePairsNumPairs = numPairs;
+	m_awakePairsNumAdded = numAdded;
+	m_awakePairsNumRemoved = numRemoved;
+	m_awakePairsNumActivationChanges = m_numActivationChanges;
 }
 
 
@@ -253,8 +502,32 @@ void	btCollisionWorld::removeCollisionObject(btCollisionObject* collisionObject)
 	}
 
 
+	if (collisionObject->m_activationWorld == this)
+	{
+		removeActivationList(collisionObject);
+		if (collisionObject->m_activationChangeQueued)
+		{
+			m_activationChangedObjects.remove(collisionObject);
+			collisionObject->m_activationChangeQueued = false;
+		}
+		collisionObject->m_activationWorld = 0;
+	}
+
 	//swapremove
-	m_collisionObjects.remove(collisionObject);
+	int worldIndex = collisionObject->getWorldArrayIndex();
+	if (worldIndex >= 0 && worldIndex < m_collisionObjects.size() && m_collisionObjects[worldIndex] == collisionObject)
+	{
+		m_collisionObjects.swap(worldIndex,m_collisionObjects.size()-1);
+		m_collisionObjects.pop_back();
+		if (worldIndex < m_collisionObjects.size())
+		{
+			m_collisionObjects[worldIndex]->setWorldArrayIndex(worldIndex);
+		}
+	} else
+	{
+		m_collisionObjects.remove(collisionObject);
+	}
+	collisionObject->setWorldArrayIndex(-1);
 
 }
 
@@ -940,6 +1213,128 @@ void	btCollisionWorld::rayTest(const btVector3& rayFromWorld, const btVector3& r
 }
 
 
+///btBatchedRayResultCallback keeps the closest hit of one ray of rayTestBatch in the caller's result array
+struct btBatchedRayResultCallback : public btCollisionWorld::RayResultCallback
+{
+	btVector3	m_rayFromWorld;
+	btVector3	m_rayToWorld;
+	btCollisionWorld::BatchedRayResult*	m_result;
+
+	virtual	btScalar	addSingleResult(btCollisionWorld::LocalRayResult& rayResult,bool normalInWorldSpace)
+	{
+		//caller already does the filter on the m_closestHitFraction
+		btAssert(rayResult.m_hitFraction <= m_closestHitFraction);
+
+		m_closestHitFraction = rayResult.m_hitFraction;
+		m_collisionObject = rayResult.m_collisionObject;
+		if (normalInWorldSpace)
+		{
+			m_result->m_hitNormalWorld = rayResult.m_hitNormalLocal;
+		} else
+		{
+			///need to transform normal into worldspace
+			m_result->m_hitNormalWorld = m_collisionObject->getWorldTransform().getBasis()*rayResult.m_hitNormalLocal;
+		}
+		m_result->m_hitPointWorld.setInterpolate3(m_rayFromWorld,m_rayToWorld,rayResult.m_hitFraction);
+		return rayResult.m_hitFraction;
+	}
+};
+
+///btRayPacketCallback runs the exact ray test for the rays of a packet that overlap a proxy
+struct btRayPacketCallback : public btBroadphaseRayPacketCallback
+{
+	btTransform	m_rayFromTrans[BT_RAY_PACKET_SIZE];
+	btTransform	m_rayToTrans[BT_RAY_PACKET_SIZE];
+	btBatchedRayResultCallback	m_resultCallbacks[BT_RAY_PACKET_SIZE];
+
+	virtual void	process(const btBroadphaseProxy* proxy, int rayMask)
+	{
+		btCollisionObject*	collisionObject = (btCollisionObject*)proxy->m_clientObject;
+		for (int lane=0;lane<m_numRays;lane++)
+		{
+			btBatchedRayResultCallback& resultCallback = m_resultCallbacks[lane];
+			if ((rayMask & (1<<lane)) && resultCallback.needsCollision(collisionObject->getBroadphaseHandle()))
+			{
+				btCollisionWorld::rayTestSingle(m_rayFromTrans[lane],m_rayToTrans[lane],
+					collisionObject,
+					collisionObject->getCollisionShape(),
+					collisionObject->getWorldTransform(),
+					resultCallback);
+				m_lambdaMax[lane] = resultCallback.m_closestHitFraction;
+			}
+		}
+	}
+};
+
+struct btRayTestBatchLoop : public btIParallelForBody
+{
+	btBroadphaseInterface*	m_broadphase;
+	const btVector3*	m_rayFromWorld;
+	const btVector3*	m_rayToWorld;
+	btCollisionWorld::BatchedRayResult*	m_results;
+	int	m_numRays;
+	short int	m_collisionFilterGroup;
+	short int	m_collisionFilterMask;
+
+	void forLoop( int iBegin, int iEnd ) const
+	{
+		btRayPacketCallback packetCallback;
+		for (int packetIndex=iBegin;packetIndex<iEnd;packetIndex++)
+		{
+			const int firstRay = packetIndex*BT_RAY_PACKET_SIZE;
+			packetCallback.m_numRays = btMin(m_numRays-firstRay,int(BT_RAY_PACKET_SIZE));
+			for (int lane=0;lane<packetCallback.m_numRays;lane++)
+			{
+				const btVector3& rayFrom = m_rayFromWorld[firstRay+lane];
+				const btVector3& rayTo = m_rayToWorld[firstRay+lane];
+				btBatchedRayResultCallback& resultCallback = packetCallback.m_resultCallbacks[lane];
+				resultCallback.m_closestHitFraction = btScalar(1.);
+				resultCallback.m_collisionObject = 0;
+				resultCallback.m_collisionFilterGroup = m_collisionFilterGroup;
+				resultCallback.m_collisionFilterMask = m_collisionFilterMask;
+				resultCallback.m_rayFromWorld = rayFrom;
+				resultCallback.m_rayToWorld = rayTo;
+				resultCallback.m_result = &m_results[firstRay+lane];
+				packetCallback.m_rayFrom[lane] = rayFrom;
+				packetCallback.m_rayTo[lane] = rayTo;
+				packetCallback.m_rayFromTrans[lane].setIdentity();
+				packetCallback.m_rayFromTrans[lane].setOrigin(rayFrom);
+				packetCallback.m_rayToTrans[lane].setIdentity();
+				packetCallback.m_rayToTrans[lane].setOrigin(rayTo);
+				packetCallback.m_lambdaMax[lane] = btScalar(1.);
+			}
+			m_broadphase->rayTestPacket(packetCallback);
+			for (int lane=0;lane<packetCallback.m_numRays;lane++)
+			{
+				const btBatchedRayResultCallback& resultCallback = packetCallback.m_resultCallbacks[lane];
+				btCollisionWorld::BatchedRayResult& result = m_results[firstRay+lane];
+				result.m_collisionObject = resultCallback.m_collisionObject;
+				result.m_hitFraction = resultCallback.m_closestHitFraction;
+				if (!resultCallback.hasHit())
+				{
+					result.m_hitNormalWorld.setZero();
+					result.m_hitPointWorld = resultCallback.m_rayToWorld;
+				}
+			}
+		}
+	}
+};
+
+void	btCollisionWorld::rayTestBatch(const btVector3* rayFromWorld, const btVector3* rayToWorld, int numRays, BatchedRayResult* results, short int collisionFilterGroup, short int collisionFilterMask) const
+{
+	BT_PROFILE("rayTestBatch");
+	btRayTestBatchLoop loop;
+	loop.m_broadphase = m_broadphasePairCache;
+	loop.m_rayFromWorld = rayFromWorld;
+	loop.m_rayToWorld = rayToWorld;
+	loop.m_results = results;
+	loop.m_numRays = numRays;
+	loop.m_collisionFilterGroup = collisionFilterGroup;
+	loop.m_collisionFilterMask = collisionFilterMask;
+	const int numPackets = (numRays+BT_RAY_PACKET_SIZE-1)/BT_RAY_PACKET_SIZE;
+	btParallelFor( 0, numPackets, 16, loop );
+}
+
 struct btSingleSweepCallback : public btBroadphaseRayCallback
 {
 
@@ -83,6 +83,7 @@ class btSerializer;
 #include "btCollisionDispatcher.h"
 #include "BulletCollision/BroadphaseCollision/btOverlappingPairCache.h"
 #include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btThreads.h"
 
 ///CollisionWorld is interface and container for the collision detection
 class btCollisionWorld
@@ -105,8 +106,50 @@ protected:
 	///it is true by default, because it is error-prone (setting the position of static objects wouldn't update their AABB)
 	bool m_forceUpdateAllAabbs;
 
+	///scratch arrays of updateAabbs, the aabbs are computed in parallel and then passed to btBroadphaseInterface::setAabbs
+	btAlignedObjectArray<btCollisionObject*>	m_updateAabbObjects;
+	btAlignedObjectArray<btBroadphaseProxy*>	m_updateAabbProxies;
+	btAlignedObjectArray<btVector3>	m_updateAabbMin;
+	btAlignedObjectArray<btVector3>	m_updateAabbMax;
+
+	///m_splitActiveObjects keeps the awake and the sleeping objects in separate lists, see setSplitActiveObjects
+	bool	m_splitActiveObjects;
+	btCollisionObjectArray	m_activeObjects;
+	btCollisionObjectArray	m_sleepingObjects;
+	///objects that fell asleep or woke up since the lists were last updated, filled by btCollisionObject::setActivationState
+	btCollisionObjectArray	m_activationChangedObjects;
+	btSpinMutex	m_activationChangedMutex;
+	///counts the objects that moved between the active and the sleeping list
+	unsigned int	m_numActivationChanges;
+
+	///the overlapping pairs with at least one awake object, in pair array order
+	///the proxies of each pair are kept to detect that the pair array was reordered
+	btAlignedObjectArray<int>	m_awakePairIndices;
+	btAlignedObjectArray<btBroadphaseProxy*>	m_awakePairProxies;
+	///the state of the pair cache and the object lists when m_awakePairIndices was last updated
+	bool			m_awakePairsValid;
+	int				m_awakePairsNumPairs;
+	unsigned int	m_awakePairsNumAdded;
+	unsigned int	m_awakePairsNumRemoved;
+	unsigned int	m_awakePairsNumActivationChanges;
+
+	void	insertActivationList(btCollisionObject* colObj);
+	void	removeActivationList(btCollisionObject* colObj);
+
+	///updates m_awakePairIndices, only the pairs appended since the last update are visited if no pair was removed and no object fell asleep or woke up
+	void	updateAwakePairs(btOverlappingPairCache* pairCache);
+
+	///true if the pair cache has to count added and removed pairs, see btOverlappingPairCache::setCountPairChanges
+	virtual bool	needsPairChangeCounts() const
+	{
+		return m_splitActiveObjects;
+	}
+
 	void	serializeCollisionObjects(btSerializer* serializer);
 
+	///returns false and removes the object from the simulation if its aabb is too large
+	bool	checkObjectAabb(btCollisionObject* colObj, const btVector3& minAabb, const btVector3& maxAabb);
+
 public:
 
 	//this constructor doesn't own the dispatcher and paircache/broadphase
@@ -145,8 +188,12 @@ public:
 		return m_dispatcher1;
 	}
 
+	///computes the broadphase aabb of the object, including the contact threshold and the motion for continuous collision detection
+	void	computeObjectAabb(const btCollisionObject* colObj, btVector3& minAabb, btVector3& maxAabb) const;
+
 	void	updateSingleAabb(btCollisionObject* colObj);
 
+	///updates the aabbs of all active objects, the shape aabbs are computed with btParallelFor
 	virtual void	updateAabbs();
 
 	///the computeOverlappingPairs is usually already called by performDiscreteCollisionDetection (or stepSimulation)
@@ -444,6 +491,25 @@ public:
 	/// This allows for several queries: first hit, all hits, any hit, dependent on the value returned by the callback.
 	virtual void rayTest(const btVector3& rayFromWorld, const btVector3& rayToWorld, RayResultCallback& resultCallback) const; 
 
+	///BatchedRayResult is the closest hit of one ray of rayTestBatch
+	struct	BatchedRayResult
+	{
+		btVector3	m_hitNormalWorld;
+		btVector3	m_hitPointWorld;
+		const btCollisionObject*	m_collisionObject;//0 if the ray didn't hit anything
+		btScalar	m_hitFraction;
+
+		bool	hasHit() const
+		{
+			return (m_collisionObject != 0);
+		}
+	};
+
+	/// rayTestBatch finds the closest hit of numRays rays and writes it to results[i], without a callback per hit.
+	/// Consecutive rays are traced through the broadphase in packets of BT_RAY_PACKET_SIZE, so neighbouring rays should be coherent (same origin or similar direction).
+	/// Packets are distributed over the threads of the task scheduler, see btParallelFor.
+	void	rayTestBatch(const btVector3* rayFromWorld, const btVector3* rayToWorld, int numRays, BatchedRayResult* results, short int collisionFilterGroup=btBroadphaseProxy::DefaultFilter, short int collisionFilterMask=btBroadphaseProxy::AllFilter) const;
+
 	/// convexTest performs a swept convex cast on all objects in the btCollisionWorld, and calls the resultCallback
 	/// This allows for several queries: first hit, all hits, any hit, dependent on the value return by the callback.
 	void    convexSweepTest (const btConvexShape* castShape, const btTransform& from, const btTransform& to, ConvexResultCallback& resultCallback,  btScalar allowedCcdPenetration = btScalar(0.)) const;
@@ -517,6 +583,46 @@ public:
 		m_forceUpdateAllAabbs = forceUpdateAllAabbs;
 	}
 
+	///keeps the awake and the sleeping objects in two lists, so the near callback is only called for the pairs with an awake
+	///object, updateAabbs only visits the awake objects once setForceUpdateAllAabbs(false) is used, and btDiscreteDynamicsWorld
+	///only integrates the awake bodies. An object counts as awake if isActive() returns true. The lists are updated from the
+	///activation state changes, which costs a queue push for each object that falls asleep or wakes up. It is off by default.
+	///Forces applied to a sleeping body are kept until it wakes up. Pair arrays that are reordered every frame
+	///(btSortedOverlappingPairCache) still dispatch all pairs.
+	void	setSplitActiveObjects(bool splitActiveObjects);
+
+	bool	getSplitActiveObjects() const
+	{
+		return m_splitActiveObjects;
+	}
+
+	///moves the objects that fell asleep or woke up since the last call to the right list
+	void	updateActiveObjects();
+
+	///the objects that were awake when updateActiveObjects was last called, only filled with setSplitActiveObjects
+	btCollisionObjectArray&	getActiveObjectArray()
+	{
+		return m_activeObjects;
+	}
+
+	const btCollisionObjectArray&	getActiveObjectArray() const
+	{
+		return m_activeObjects;
+	}
+
+	btCollisionObjectArray&	getSleepingObjectArray()
+	{
+		return m_sleepingObjects;
+	}
+
+	const btCollisionObjectArray&	getSleepingObjectArray() const
+	{
+		return m_sleepingObjects;
+	}
+
+	///called by btCollisionObject when an object falls asleep or wakes up, it can be called from several threads
+	void	queueActivationChange(const btCollisionObject* colObj);
+
 	///Preliminary serialization test for Bullet 2.76. Loading those files requires a separate parser (Bullet/Demos/SerializeDemo)
 	virtual	void	serialize(btSerializer* serializer);
 
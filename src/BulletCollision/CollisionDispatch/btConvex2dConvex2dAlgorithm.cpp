@@ -118,7 +118,13 @@ void btConvex2dConvex2dAlgorithm ::processCollision (const btCollisionObjectWrap
 
 		btGjkPairDetector::ClosestPointInput input;
 
+#if BT_THREADSAFE
+		//the simplex solver of the collision configuration is shared by all algorithms, pairs may be processed concurrently
+		btVoronoiSimplexSolver	simplexSolver;
+		btGjkPairDetector	gjkPairDetector(min0,min1,&simplexSolver,m_pdSolver);
+#else
 		btGjkPairDetector	gjkPairDetector(min0,min1,m_simplexSolver,m_pdSolver);
+#endif //BT_THREADSAFE
 		//TODO: if (dispatchInfo.m_useContinuous)
 		gjkPairDetector.setMinkowskiA(min0);
 		gjkPairDetector.setMinkowskiB(min1);
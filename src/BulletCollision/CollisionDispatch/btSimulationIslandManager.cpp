@@ -26,7 +26,8 @@ subject to the following restrictions:
 #include "LinearMath/btQuickprof.h"
 
 btSimulationIslandManager::btSimulationIslandManager():
-m_splitIslands(true)
+m_splitIslands(true),
+m_incrementalIslands(false)
 {
 }
 
@@ -72,6 +73,12 @@ void btSimulationIslandManager::findUnions(btDispatcher* /* dispatcher */,btColl
 #ifdef STATIC_SIMULATION_ISLAND_OPTIMIZATION
 void   btSimulationIslandManager::updateActivationState(btCollisionWorld* colWorld,btDispatcher* dispatcher)
 {
+	if (m_incrementalIslands)
+	{
+		updateIncrementalActivationState(colWorld);
+		return;
+	}
+
 
 	// put the index into m_controllers into m_tag   
 	int index = 0;
@@ -99,6 +106,12 @@ void   btSimulationIslandManager::updateActivationState(btCollisionWorld* colWor
 
 void   btSimulationIslandManager::storeIslandActivationState(btCollisionWorld* colWorld)
 {
+	if (m_incrementalIslands)
+	{
+		storeIncrementalActivationState(colWorld);
+		return;
+	}
+
 	// put the islandId ('find' value) into m_tag   
 	{
 		int index = 0;
@@ -126,6 +139,12 @@ void   btSimulationIslandManager::storeIslandActivationState(btCollisionWorld* c
 #else //STATIC_SIMULATION_ISLAND_OPTIMIZATION
 void	btSimulationIslandManager::updateActivationState(btCollisionWorld* colWorld,btDispatcher* dispatcher)
 {
+	if (m_incrementalIslands)
+	{
+		updateIncrementalActivationState(colWorld);
+		return;
+	}
+
 
 	initUnionFind( int (colWorld->getCollisionObjectArray().size()));
 
@@ -151,6 +170,12 @@ void	btSimulationIslandManager::updateActivationState(btCollisionWorld* colWorld
 
 void	btSimulationIslandManager::storeIslandActivationState(btCollisionWorld* colWorld)
 {
+	if (m_incrementalIslands)
+	{
+		storeIncrementalActivationState(colWorld);
+		return;
+	}
+
 	// put the islandId ('find' value) into m_tag	
 	{
 
@@ -202,6 +227,11 @@ class btPersistentManifoldSortPredicate
 
 void btSimulationIslandManager::buildIslands(btDispatcher* dispatcher,btCollisionWorld* collisionWorld)
 {
+	if (m_incrementalIslands)
+	{
+		buildIncrementalIslands(dispatcher,collisionWorld);
+		return;
+	}
 
 	BT_PROFILE("islandUnionFindAndQuickSort");
 	
@@ -304,17 +334,14 @@ void btSimulationIslandManager::buildIslands(btDispatcher* dispatcher,btCollisio
 		}
 	}
 
-	
+	collectIslandManifolds(dispatcher);
+}
+
+void	btSimulationIslandManager::collectIslandManifolds(btDispatcher* dispatcher)
+{
 	int i;
 	int maxNumManifolds = dispatcher->getNumManifolds();
 
-//#define SPLIT_ISLANDS 1
-//#ifdef SPLIT_ISLANDS
-
-	
-//#endif //SPLIT_ISLANDS
-
-	
 	for (i=0;i<maxNumManifolds ;i++)
 	{
 		 btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
@@ -353,6 +380,12 @@ void btSimulationIslandManager::buildIslands(btDispatcher* dispatcher,btCollisio
 ///@todo: this is random access, it can be walked 'cache friendly'!
 void btSimulationIslandManager::buildAndProcessIslands(btDispatcher* dispatcher,btCollisionWorld* collisionWorld, IslandCallback* callback)
 {
+	if (m_incrementalIslands)
+	{
+		processIncrementalIslands(dispatcher,collisionWorld,callback);
+		return;
+	}
+
 	btCollisionObjectArray& collisionObjects = collisionWorld->getCollisionObjectArray();
 
 	buildIslands(dispatcher,collisionWorld);
@@ -448,3 +481,288 @@ void btSimulationIslandManager::buildAndProcessIslands(btDispatcher* dispatcher,
 	} // else if(!splitIslands) 
 
 }
+
+void	btSimulationIslandManager::updateIncrementalActivationState(btCollisionWorld* colWorld)
+{
+	btCollisionObjectArray& collisionObjects = colWorld->getCollisionObjectArray();
+
+	//like the default islands, the union find elements are the dynamic objects in collision object array order
+	int numSlots = 0;
+	bool objectsChanged = false;
+	int i;
+	for (i=0;i<collisionObjects.size();i++)
+	{
+		btCollisionObject* collisionObject = collisionObjects[i];
+		if (!collisionObject->isStaticOrKinematicObject())
+		{
+			if (numSlots >= m_slotObjects.size() || m_slotObjects[numSlots] != collisionObject)
+			{
+				objectsChanged = true;
+			} else
+			{
+				m_slotAwake[numSlots] = collisionObject->getActivationState() != ISLAND_SLEEPING;
+				m_rootWoken[numSlots] = 0;
+			}
+			collisionObject->setIslandTag(numSlots++);
+		}
+		collisionObject->setCompanionId(-1);
+		collisionObject->setHitFraction(btScalar(1.));
+	}
+
+	m_awakeSlots.resize(0);
+	if (objectsChanged || numSlots != m_slotObjects.size())
+	{
+		//objects were added or removed, build all islands again
+		m_slotObjects.resize(numSlots);
+		m_slotRoots.resize(numSlots);
+		m_slotAwake.resize(numSlots);
+		m_rootWoken.resize(numSlots);
+		m_rootIslands.resize(numSlots);
+		m_islandRoots.resize(0);
+		m_unionFind.reset(numSlots);
+		int slot = 0;
+		for (i=0;i<collisionObjects.size();i++)
+		{
+			btCollisionObject* collisionObject = collisionObjects[i];
+			if (!collisionObject->isStaticOrKinematicObject())
+			{
+				m_slotObjects[slot] = collisionObject;
+				m_slotAwake[slot] = 1;
+				m_rootIslands[slot] = -1;
+				m_awakeSlots.push_back(slot);
+				slot++;
+			}
+		}
+	} else
+	{
+		//keep the islands that are still sleeping, an island is united again once one of its objects is awake
+		int slot;
+		for (slot=0;slot<numSlots;slot++)
+		{
+			int root = m_unionFind.find(slot);
+			m_slotRoots[slot] = root;
+			if (m_slotAwake[slot])
+				m_rootWoken[root] = 1;
+		}
+		//the elements are only reset once all roots are known
+		for (slot=0;slot<numSlots;slot++)
+		{
+			m_slotAwake[slot] = m_rootWoken[m_slotRoots[slot]];
+			if (m_slotAwake[slot])
+				m_awakeSlots.push_back(slot);
+		}
+		for (i=0;i<m_awakeSlots.size();i++)
+		{
+			btElement& element = m_unionFind.getElement(m_awakeSlots[i]);
+			element.m_id = m_awakeSlots[i];
+			element.m_sz = 1;
+		}
+	}
+
+	//pairs between objects of kept sleeping islands don't change, an awake object touching a sleeping island wakes all of it.
+	//This is still a scan over all pairs, only the unite is skipped for pairs of two sleeping islands
+	btOverlappingPairCache* pairCachePtr = colWorld->getPairCache();
+	const int numOverlappingPairs = pairCachePtr->getNumOverlappingPairs();
+	if (numOverlappingPairs)
+	{
+		btBroadphasePair* pairPtr = pairCachePtr->getOverlappingPairArrayPtr();
+		for (i=0;i<numOverlappingPairs;i++)
+		{
+			const btBroadphasePair& collisionPair = pairPtr[i];
+			btCollisionObject* colObj0 = (btCollisionObject*)collisionPair.m_pProxy0->m_clientObject;
+			btCollisionObject* colObj1 = (btCollisionObject*)collisionPair.m_pProxy1->m_clientObject;
+
+			if (((colObj0) && ((colObj0)->mergesSimulationIslands())) &&
+				((colObj1) && ((colObj1)->mergesSimulationIslands())))
+			{
+				int tag0 = colObj0->getIslandTag();
+				int tag1 = colObj1->getIslandTag();
+				if (m_slotAwake[tag0] || m_slotAwake[tag1])
+					m_unionFind.unite(tag0,tag1);
+			}
+		}
+	}
+}
+
+void	btSimulationIslandManager::storeIncrementalActivationState(btCollisionWorld* colWorld)
+{
+	btCollisionObjectArray& collisionObjects = colWorld->getCollisionObjectArray();
+	int slot = 0;
+	for (int i=0;i<collisionObjects.size();i++)
+	{
+		btCollisionObject* collisionObject = collisionObjects[i];
+		if (!collisionObject->isStaticOrKinematicObject())
+		{
+			int root = m_unionFind.find(slot);
+			m_slotRoots[slot] = root;
+			collisionObject->setIslandTag(root);
+			collisionObject->setCompanionId(-1);
+			slot++;
+		} else
+		{
+			collisionObject->setIslandTag(-1);
+			collisionObject->setCompanionId(-2);
+		}
+	}
+}
+
+void	btSimulationIslandManager::buildIncrementalIslands(btDispatcher* dispatcher,btCollisionWorld* /*collisionWorld*/)
+{
+	BT_PROFILE("islandUnionFindIncremental");
+
+	m_islandmanifold.resize(0);
+
+	int i;
+	for (i=0;i<m_islandRoots.size();i++)
+	{
+		m_rootIslands[m_islandRoots[i]] = -1;
+	}
+	m_islandRoots.resize(0);
+
+	//only the islands with an awake object are visited, number them in increasing island id order without sorting
+	int numSlots = m_slotObjects.size();
+	for (i=0;i<m_awakeSlots.size();i++)
+	{
+		m_rootIslands[m_slotRoots[m_awakeSlots[i]]] = -2;
+	}
+	int slot;
+	for (slot=0;slot<numSlots;slot++)
+	{
+		if (m_rootIslands[slot] == -2)
+		{
+			m_rootIslands[slot] = m_islandRoots.size();
+			m_islandRoots.push_back(slot);
+		}
+	}
+
+	//counting sort of the bodies by island
+	int numIslands = m_islandRoots.size();
+	m_islandBodyOffsets.resize(numIslands+1);
+	for (i=0;i<=numIslands;i++)
+	{
+		m_islandBodyOffsets[i] = 0;
+	}
+	for (slot=0;slot<numSlots;slot++)
+	{
+		int island = m_rootIslands[m_slotRoots[slot]];
+		if (island >= 0)
+			m_islandBodyOffsets[island+1]++;
+	}
+	for (i=0;i<numIslands;i++)
+	{
+		m_islandBodyOffsets[i+1] += m_islandBodyOffsets[i];
+	}
+	m_islandBodyArray.resize(m_islandBodyOffsets[numIslands]);
+	for (slot=0;slot<numSlots;slot++)
+	{
+		int island = m_rootIslands[m_slotRoots[slot]];
+		if (island >= 0)
+			m_islandBodyArray[m_islandBodyOffsets[island]++] = m_slotObjects[slot];
+	}
+	for (i=numIslands;i>0;i--)
+	{
+		m_islandBodyOffsets[i] = m_islandBodyOffsets[i-1];
+	}
+	m_islandBodyOffsets[0] = 0;
+
+	//update the sleeping state for bodies, if all are sleeping
+	for (int island=0;island<numIslands;island++)
+	{
+		int startIslandIndex = m_islandBodyOffsets[island];
+		int endIslandIndex = m_islandBodyOffsets[island+1];
+		bool allSleeping = true;
+		int idx;
+		for (idx=startIslandIndex;idx<endIslandIndex;idx++)
+		{
+			btCollisionObject* colObj0 = m_islandBodyArray[idx];
+			if (colObj0->getActivationState()== ACTIVE_TAG || colObj0->getActivationState()== DISABLE_DEACTIVATION)
+			{
+				allSleeping = false;
+				break;
+			}
+		}
+		for (idx=startIslandIndex;idx<endIslandIndex;idx++)
+		{
+			btCollisionObject* colObj0 = m_islandBodyArray[idx];
+			if (allSleeping)
+			{
+				colObj0->setActivationState( ISLAND_SLEEPING );
+			} else if (colObj0->getActivationState() == ISLAND_SLEEPING)
+			{
+				colObj0->setActivationState( WANTS_DEACTIVATION);
+				colObj0->setDeactivationTime(0.f);
+			}
+		}
+	}
+
+	collectIslandManifolds(dispatcher);
+}
+
+void	btSimulationIslandManager::processIncrementalIslands(btDispatcher* dispatcher,btCollisionWorld* collisionWorld, IslandCallback* callback)
+{
+	buildIncrementalIslands(dispatcher,collisionWorld);
+
+	BT_PROFILE("processIslands");
+
+	if(!m_splitIslands)
+	{
+		btCollisionObjectArray& collisionObjects = collisionWorld->getCollisionObjectArray();
+		btPersistentManifold** manifold = dispatcher->getInternalManifoldPointer();
+		int maxNumManifolds = dispatcher->getNumManifolds();
+		callback->processIsland(&collisionObjects[0],collisionObjects.size(),manifold,maxNumManifolds, -1);
+		return;
+	}
+
+	//counting sort of the manifolds by island, the manifolds of islands that were kept sleeping are skipped
+	int numIslands = m_islandRoots.size();
+	int i;
+	m_islandManifoldOffsets.resize(numIslands+1);
+	for (i=0;i<=numIslands;i++)
+	{
+		m_islandManifoldOffsets[i] = 0;
+	}
+	for (i=0;i<m_islandmanifold.size();i++)
+	{
+		int islandId = getIslandId(m_islandmanifold[i]);
+		if (islandId >= 0 && m_rootIslands[islandId] >= 0)
+			m_islandManifoldOffsets[m_rootIslands[islandId]+1]++;
+	}
+	for (i=0;i<numIslands;i++)
+	{
+		m_islandManifoldOffsets[i+1] += m_islandManifoldOffsets[i];
+	}
+	m_sortedIslandManifolds.resize(m_islandManifoldOffsets[numIslands]);
+	for (i=0;i<m_islandmanifold.size();i++)
+	{
+		int islandId = getIslandId(m_islandmanifold[i]);
+		if (islandId >= 0 && m_rootIslands[islandId] >= 0)
+			m_sortedIslandManifolds[m_islandManifoldOffsets[m_rootIslands[islandId]]++] = m_islandmanifold[i];
+	}
+	for (i=numIslands;i>0;i--)
+	{
+		m_islandManifoldOffsets[i] = m_islandManifoldOffsets[i-1];
+	}
+	m_islandManifoldOffsets[0] = 0;
+
+	//traverse the simulation islands, and call the solver, unless all objects are sleeping/deactivated
+	for (int island=0;island<numIslands;island++)
+	{
+		int numBodies = m_islandBodyOffsets[island+1]-m_islandBodyOffsets[island];
+		btCollisionObject** bodies = &m_islandBodyArray[m_islandBodyOffsets[island]];
+		bool islandSleeping = true;
+		for (i=0;i<numBodies;i++)
+		{
+			if (bodies[i]->isActive())
+			{
+				islandSleeping = false;
+				break;
+			}
+		}
+		if (!islandSleeping)
+		{
+			int numIslandManifolds = m_islandManifoldOffsets[island+1]-m_islandManifoldOffsets[island];
+			btPersistentManifold** startManifold = numIslandManifolds ? &m_sortedIslandManifolds[m_islandManifoldOffsets[island]] : 0;
+			callback->processIsland(bodies,numBodies,startManifold,numIslandManifolds,m_islandRoots[island]);
+		}
+	}
+}
@@ -36,6 +36,21 @@ class btSimulationIslandManager
 	btAlignedObjectArray<btCollisionObject* >  m_islandBodies;
 	
 	bool m_splitIslands;
+
+	bool m_incrementalIslands;
+
+	//incremental islands keep the union find of the sleeping islands between steps
+	btAlignedObjectArray<btCollisionObject*>	m_slotObjects;		//dynamic object of each union find element, to detect changes of the object set
+	btAlignedObjectArray<int>	m_slotRoots;
+	btAlignedObjectArray<unsigned char>	m_slotAwake;		//element was reset this step, it doesn't belong to a kept sleeping island
+	btAlignedObjectArray<unsigned char>	m_rootWoken;
+	btAlignedObjectArray<int>	m_awakeSlots;
+	btAlignedObjectArray<int>	m_rootIslands;		//island index of each union find root with an awake element, -1 otherwise
+	btAlignedObjectArray<int>	m_islandRoots;
+	btAlignedObjectArray<int>	m_islandBodyOffsets;
+	btAlignedObjectArray<btCollisionObject*>	m_islandBodyArray;	//bodies grouped by island
+	btAlignedObjectArray<int>	m_islandManifoldOffsets;
+	btAlignedObjectArray<btPersistentManifold*>	m_sortedIslandManifolds;
 	
 public:
 	btSimulationIslandManager();
@@ -75,6 +90,35 @@ public:
 		m_splitIslands = doSplitIslands;
 	}
 
+	bool getIncrementalIslands() const
+	{
+		return m_incrementalIslands;
+	}
+	///with incremental islands the union find is not rebuilt every step: sleeping islands are kept as they are until an awake
+	///object touches them or one of their objects is activated, and only islands with awake objects are united again.
+	///The islands are grouped with linear passes instead of sorting all union find elements and all manifolds.
+	///Each step still scans all collision objects and all overlapping pairs, so the cost stays O(bodies+pairs); what is saved
+	///is the union find work and the O(n log n) sorts for the sleeping islands, not the scans.
+	///Islands are processed in the same increasing id order, but the bodies and manifolds inside an island can be in a different order.
+	void setIncrementalIslands(bool incrementalIslands)
+	{
+		m_incrementalIslands = incrementalIslands;
+		m_slotObjects.resize(0);
+	}
+
+private:
+
+	///collects the manifolds for the solver and lets kinematic objects wake up the objects they touch
+	void	collectIslandManifolds(btDispatcher* dispatcher);
+
+	void	updateIncrementalActivationState(btCollisionWorld* colWorld);
+
+	void	storeIncrementalActivationState(btCollisionWorld* colWorld);
+
+	void	buildIncrementalIslands(btDispatcher* dispatcher,btCollisionWorld* colWorld);
+
+	void	processIncrementalIslands(btDispatcher* dispatcher,btCollisionWorld* collisionWorld, IslandCallback* callback);
+
 };
 
 #endif //BT_SIMULATION_ISLAND_MANAGER_H
@@ -23,7 +23,8 @@ subject to the following restrictions:
 #include "LinearMath/btQuaternion.h"
 #include "LinearMath/btSerializer.h"
 
-btConvexHullShape ::btConvexHullShape (const btScalar* points,int numPoints,int stride) : btPolyhedralConvexAabbCachingShape ()
+btConvexHullShape ::btConvexHullShape (const btScalar* points,int numPoints,int stride) : btPolyhedralConvexAabbCachingShape (),
+	m_soaPointsDirty(false)
 {
 	m_shapeType = CONVEX_HULL_SHAPE_PROXYTYPE;
 	m_unscaledPoints.resize(numPoints);
@@ -49,11 +50,43 @@ void btConvexHullShape::setLocalScaling(const btVector3& scaling)
 	recalcLocalAabb();
 }
 
+void btConvexHullShape::packPoints()
+{
+	m_soaPointsDirty = false;
+	int numPoints = m_unscaledPoints.size();
+	m_soaPoints.resize(btVector3_soaSize(numPoints));
+	if (numPoints)
+	{
+		btVector3_packSoa(&m_unscaledPoints[0], numPoints, &m_soaPoints[0]);
+	}
+}
+
+void btConvexHullShape::recalcLocalAabb()
+{
+	//the aabb is computed with the support functions, which read the packed points
+	packPoints();
+	btPolyhedralConvexAabbCachingShape::recalcLocalAabb();
+}
+
 void btConvexHullShape::addPoint(const btVector3& point, bool recalculateLocalAabb)
 {
 	m_unscaledPoints.push_back(point);
+
+	if (m_soaPointsDirty)
+	{
+		//the earlier points may have been changed through getUnscaledPoints
+		packPoints();
+	} else
+	{
+		//only the last block changes, its padding now repeats the new point
+		int numPoints = m_unscaledPoints.size();
+		int blockStart = ((numPoints-1)/BT_VECTOR3_SOA_BLOCK)*BT_VECTOR3_SOA_BLOCK;
+		m_soaPoints.resize(btVector3_soaSize(numPoints));
+		btVector3_packSoa(&m_unscaledPoints[blockStart], numPoints-blockStart, &m_soaPoints[blockStart*3]);
+	}
+	//the points are packed already
 	if (recalculateLocalAabb)
-		recalcLocalAabb();
+		btPolyhedralConvexAabbCachingShape::recalcLocalAabb();
 
 }
 
@@ -66,7 +99,7 @@ btVector3	btConvexHullShape::localGetSupportingVertexWithoutMargin(const btVecto
     if( 0 < m_unscaledPoints.size() )
     {
         btVector3 scaled = vec * m_localScaling;
-        int index = (int) scaled.maxDot( &m_unscaledPoints[0], m_unscaledPoints.size(), maxDot); // FIXME: may violate encapsulation of m_unscaledPoints
+        int index = (int) scaled.maxDotSoa( getSoaPoints(), m_unscaledPoints.size(), maxDot);
         return m_unscaledPoints[index] * m_localScaling;
     }
 
@@ -89,7 +122,7 @@ void	btConvexHullShape::batchedUnitVectorGetSupportingVertexWithoutMargin(const
         btVector3 vec = vectors[j] * m_localScaling;        // dot(a*b,c) = dot(a,b*c)
         if( 0 <  m_unscaledPoints.size() )
         {
-            int i = (int) vec.maxDot( &m_unscaledPoints[0], m_unscaledPoints.size(), newDot);
+            int i = (int) vec.maxDotSoa( getSoaPoints(), m_unscaledPoints.size(), newDot);
             supportVerticesOut[j] = getScaledPoint(i);
             supportVerticesOut[j][3] = newDot;        
         }
@@ -213,20 +246,18 @@ void btConvexHullShape::project(const btTransform& trans, const btVector3& dir,
 	maxProj = -FLT_MAX;
 
 	int numVerts = m_unscaledPoints.size();
-	for(int i=0;i<numVerts;i++)
+	if (numVerts)
 	{
-		btVector3 vtx = m_unscaledPoints[i] * m_localScaling;
-		btVector3 pt = trans * vtx;
-		btScalar dp = pt.dot(dir);
-		if(dp < minProj)	
+		//the witness points are only transformed for the two extreme vertices
+		long minIndex,maxIndex;
+		btVector3_projectSoa(getSoaPoints(), numVerts, &m_localScaling, &trans.getBasis()[0], &trans.getOrigin(), &dir, &minIndex, &minProj, &maxIndex, &maxProj);
+		if (minIndex>=0)
 		{
-			minProj = dp;
-			witnesPtMin = pt;
+			witnesPtMin = trans * (m_unscaledPoints[minIndex] * m_localScaling);
 		}
-		if(dp > maxProj)	
+		if (maxIndex>=0)
 		{
-			maxProj = dp;
-			witnesPtMax=pt;
+			witnesPtMax = trans * (m_unscaledPoints[maxIndex] * m_localScaling);
 		}
 	}
 #else
@@ -26,6 +26,11 @@ subject to the following restrictions:
 ATTRIBUTE_ALIGNED16(class) btConvexHullShape : public btPolyhedralConvexAabbCachingShape
 {
 	btAlignedObjectArray<btVector3>	m_unscaledPoints;
+	///copy of m_unscaledPoints in the btVector3_packSoa layout, used by the support and project functions.
+	///It is only rebuilt by packPoints and recalcLocalAabb, never while the shape is read, so several threads can share the shape.
+	btAlignedObjectArray<btScalar>	m_soaPoints;
+	///set when the points were handed out by the non-const getUnscaledPoints, addPoint then repacks all points
+	bool	m_soaPointsDirty;
 
 public:
 	BT_DECLARE_ALIGNED_ALLOCATOR();
@@ -39,8 +44,11 @@ public:
 	void addPoint(const btVector3& point, bool recalculateLocalAabb = true);
 
 	
+	///the points may be changed through the returned pointer. Call recalcLocalAabb (or packPoints) after changing them,
+	///until then the support and project functions still use the old points.
 	btVector3* getUnscaledPoints()
 	{
+		m_soaPointsDirty = true;
 		return &m_unscaledPoints[0];
 	}
 
@@ -49,6 +57,18 @@ public:
 		return &m_unscaledPoints[0];
 	}
 
+	///the points in the btVector3_packSoa layout, 0 for a hull without points. As of the last packPoints or recalcLocalAabb call.
+	const btScalar* getSoaPoints() const
+	{
+		return m_soaPoints.size() ? &m_soaPoints[0] : 0;
+	}
+
+	///rebuilds the packed copy of the points
+	void	packPoints();
+
+	///repacks the points and recomputes the cached local aabb, call it after changing the points through getUnscaledPoints
+	void	recalcLocalAabb();
+
 	///getPoints is obsolete, please use getUnscaledPoints
 	const btVector3* getPoints() const
 	{
@@ -101,6 +101,11 @@ bool btConvexPolyhedron::testContainment() const
 
 void	btConvexPolyhedron::initialize()
 {
+	m_soaVertices.resize(btVector3_soaSize(m_vertices.size()));
+	if (m_vertices.size())
+	{
+		btVector3_packSoa(&m_vertices[0], m_vertices.size(), &m_soaVertices[0]);
+	}
 
 	btHashMap<btInternalVertexPair,btInternalEdge> edges;
 
@@ -280,19 +285,37 @@ void btConvexPolyhedron::project(const btTransform& trans, const btVector3& dir,
 	minProj = FLT_MAX;
 	maxProj = -FLT_MAX;
 	int numVerts = m_vertices.size();
-	for(int i=0;i<numVerts;i++)
+	if (numVerts && m_soaVertices.size() == btVector3_soaSize(numVerts))
 	{
-		btVector3 pt = trans * m_vertices[i];
-		btScalar dp = pt.dot(dir);
-		if(dp < minProj)
+		//the witness points are only transformed for the two extreme vertices
+		btVector3 unitScaling(btScalar(1.),btScalar(1.),btScalar(1.));
+		long minIndex,maxIndex;
+		btVector3_projectSoa(&m_soaVertices[0], numVerts, &unitScaling, &trans.getBasis()[0], &trans.getOrigin(), &dir, &minIndex, &minProj, &maxIndex, &maxProj);
+		if (minIndex>=0)
 		{
-			minProj = dp;
-			witnesPtMin = pt;
+			witnesPtMin = trans * m_vertices[minIndex];
 		}
-		if(dp > maxProj)
+		if (maxIndex>=0)
+		{
+			witnesPtMax = trans * m_vertices[maxIndex];
+		}
+	} else
+	{
+		//initialize was not called since the vertices changed
+		for(int i=0;i<numVerts;i++)
 		{
-			maxProj = dp;
-			witnesPtMax = pt;
+			btVector3 pt = trans * m_vertices[i];
+			btScalar dp = pt.dot(dir);
+			if(dp < minProj)
+			{
+				minProj = dp;
+				witnesPtMin = pt;
+			}
+			if(dp > maxProj)
+			{
+				maxProj = dp;
+				witnesPtMax = pt;
+			}
 		}
 	}
 	if(minProj>maxProj)
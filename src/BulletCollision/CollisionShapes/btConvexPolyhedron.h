@@ -46,6 +46,8 @@ ATTRIBUTE_ALIGNED16(class) btConvexPolyhedron
 	btAlignedObjectArray<btVector3>	m_vertices;
 	btAlignedObjectArray<btFace>	m_faces;
 	btAlignedObjectArray<btVector3> m_uniqueEdges;
+	///copy of m_vertices in the btVector3_packSoa layout, filled by initialize and used by project
+	btAlignedObjectArray<btScalar>	m_soaVertices;
 
 	btVector3		m_localCenter;
 	btVector3		m_extents;
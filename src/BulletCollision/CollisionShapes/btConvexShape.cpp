@@ -286,10 +286,13 @@ btVector3 btConvexShape::localGetSupportVertexWithoutMarginNonVirtual (const btV
 	}
 	case CONVEX_HULL_SHAPE_PROXYTYPE:
 	{
-		btConvexHullShape* convexHullShape = (btConvexHullShape*)this;
-		btVector3* points = convexHullShape->getUnscaledPoints();
-		int numPoints = convexHullShape->getNumPoints ();
-		return convexHullSupport (localDir, points, numPoints,convexHullShape->getLocalScalingNV());
+		const btConvexHullShape* convexHullShape = (const btConvexHullShape*)this;
+		const btVector3& localScaling = convexHullShape->getLocalScalingNV();
+		btVector3 vec = localDir * localScaling;
+		btScalar maxDot;
+		long ptIndex = vec.maxDotSoa( convexHullShape->getSoaPoints(), convexHullShape->getNumPoints(), maxDot);
+		btAssert(ptIndex >= 0);
+		return convexHullShape->getUnscaledPoints()[ptIndex] * localScaling;
 	}
     default:
 #ifndef __SPU__
@@ -181,7 +181,13 @@ void btOptimizedBvh::build(btStridingMeshInterface* triangles, bool useQuantized
 
 	m_curNodeIndex = 0;
 
-	buildTree(0,numLeafNodes);
+	if (gBvhUseSahBuilder && numLeafNodes)
+	{
+		buildTreeSah(numLeafNodes);
+	} else
+	{
+		buildTree(0,numLeafNodes);
+	}
 
 	///if the entire tree is small then subtree size, we need to create a header info for the tree
 	if(m_useQuantization && !m_SubtreeHeaders.size())
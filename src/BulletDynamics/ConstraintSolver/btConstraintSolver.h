@@ -17,6 +17,7 @@ subject to the following restrictions:
 #define BT_CONSTRAINT_SOLVER_H
 
 #include "LinearMath/btScalar.h"
+#include "LinearMath/btMinMax.h"
 
 class btPersistentManifold;
 class btRigidBody;
@@ -37,6 +38,45 @@ enum btConstraintSolverType
 	BT_NNCG_SOLVER=4
 };
 
+///btSolverStatistics sums the work done by the solveGroup calls of a constraint solver
+struct btSolverStatistics
+{
+	int	m_numSolveGroupCalls;
+	int	m_numBodies;
+	int	m_numContactRows;
+	int	m_numFrictionRows;
+	int	m_numNonContactRows;
+	int	m_numIterations;///summed over all solveGroup calls
+	int	m_maxIterations;///most iterations used by a single solveGroup call
+
+	btSolverStatistics()
+	{
+		reset();
+	}
+
+	void	reset()
+	{
+		m_numSolveGroupCalls = 0;
+		m_numBodies = 0;
+		m_numContactRows = 0;
+		m_numFrictionRows = 0;
+		m_numNonContactRows = 0;
+		m_numIterations = 0;
+		m_maxIterations = 0;
+	}
+
+	void	add(const btSolverStatistics& other)
+	{
+		m_numSolveGroupCalls += other.m_numSolveGroupCalls;
+		m_numBodies += other.m_numBodies;
+		m_numContactRows += other.m_numContactRows;
+		m_numFrictionRows += other.m_numFrictionRows;
+		m_numNonContactRows += other.m_numNonContactRows;
+		m_numIterations += other.m_numIterations;
+		m_maxIterations = btMax(m_maxIterations, other.m_maxIterations);
+	}
+};
+
 class btConstraintSolver
 {
 
@@ -56,6 +96,13 @@ public:
 
 	virtual btConstraintSolverType	getSolverType() const=0;
 
+	///adds the statistics gathered since the last resetStatistics to stats. Solvers that don't keep statistics add nothing
+	virtual void	accumulateStatistics(btSolverStatistics& /* stats */) const {;}
+
+	virtual void	resetStatistics() {;}
+
+	///statistics are only gathered while enabled, btDiscreteDynamicsWorld::setStepStatsEnabled enables them
+	virtual void	setStatisticsEnabled(bool /* enable */) {;}
 
 };
 
@@ -29,7 +29,10 @@ enum	btSolverMode
 	SOLVER_CACHE_FRIENDLY = 128,
 	SOLVER_SIMD = 256,
 	SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS = 512,
-	SOLVER_ALLOW_ZERO_LENGTH_FRICTION_DIRECTIONS = 1024
+	SOLVER_ALLOW_ZERO_LENGTH_FRICTION_DIRECTIONS = 1024,
+	///solve contact and friction rows that share no dynamic body in batches of BT_SOLVER_BATCH_WIDTH, see btSolverConstraintBatch.
+	///The rows keep a fixed order, so SOLVER_RANDMIZE_ORDER and SOLVER_INTERLEAVE_CONTACT_AND_FRICTION_CONSTRAINTS don't apply to them
+	SOLVER_BATCHED_CONTACT_ROWS = 2048
 };
 
 struct btContactSolverInfoData
@@ -58,6 +61,7 @@ struct btContactSolverInfoData
 	int			m_minimumSolverBatchSize;
 	btScalar	m_maxGyroscopicForce;
 	btScalar	m_singleAxisRollingFrictionThreshold;
+	btScalar	m_leastSquaresResidualThreshold;
 
 
 };
@@ -91,6 +95,7 @@ struct btContactSolverInfo : public btContactSolverInfoData
 		m_minimumSolverBatchSize = 128; //try to combine islands until the amount of constraints reaches this limit
 		m_maxGyroscopicForce = 100.f; ///it is only used for 'explicit' version of gyroscopic force
 		m_singleAxisRollingFrictionThreshold = 1e30f;///if the velocity is above this threshold, it will use a single constraint row (axis), otherwise 3 rows.
+		m_leastSquaresResidualThreshold = 0.f;///stop the solver iterations once the sum of the squared impulse corrections of an iteration drops below this value, 0 disables the early exit
 	}
 };
 
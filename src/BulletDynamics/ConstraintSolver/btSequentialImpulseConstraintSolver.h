@@ -24,8 +24,10 @@ class btCollisionObject;
 #include "BulletDynamics/ConstraintSolver/btContactSolverInfo.h"
 #include "BulletDynamics/ConstraintSolver/btSolverBody.h"
 #include "BulletDynamics/ConstraintSolver/btSolverConstraint.h"
+#include "BulletDynamics/ConstraintSolver/btSolverConstraintBatch.h"
 #include "BulletCollision/NarrowPhaseCollision/btManifoldPoint.h"
 #include "BulletDynamics/ConstraintSolver/btConstraintSolver.h"
+#include "LinearMath/btHashMap.h"
 
 typedef btSimdScalar(*btSingleConstraintRowSolver)(btSolverBody&, btSolverBody&, const btSolverConstraint&);
 
@@ -45,6 +47,14 @@ protected:
 	btAlignedObjectArray<btTypedConstraint::btConstraintInfo1> m_tmpConstraintSizesPool;
 	int							m_maxOverrideNumSolverIterations;
 	int m_fixedBodyId;
+	///kinematic bodies can touch several islands that are solved at the same time, so their solver body id
+	///is kept in this per-solver map instead of the shared companion id of the body
+	btHashMap<btHashPtr,int>	m_kinematicBodyToSolverBodyId;
+
+	///contact and friction rows in structure-of-arrays batches, only used with SOLVER_BATCHED_CONTACT_ROWS
+	btSolverConstraintBatchPool	m_contactConstraintBatches;
+	btSolverConstraintBatchPool	m_frictionConstraintBatches;
+	btSolverBodyVelocityPool	m_batchedBodyVelocities;
 
 	btSingleConstraintRowSolver m_resolveSingleConstraintRowGeneric;
 	btSingleConstraintRowSolver m_resolveSingleConstraintRowLowerLimit;
@@ -74,6 +84,14 @@ protected:
 	///m_btSeed2 is used for re-arranging the constraint rows. improves convergence/quality of friction
 	unsigned long	m_btSeed2;
 
+	///sum of the squared impulse corrections of the last solver iteration and the number of iterations it took, see getLeastSquaresResidual
+	btScalar	m_leastSquaresResidual;
+	int			m_numIterationsUsed;
+
+	///work done by the solveGroup calls since the last resetStatistics, only while m_statisticsEnabled
+	btSolverStatistics	m_statistics;
+	bool				m_statisticsEnabled;
+
 	
 	btScalar restitutionCurve(btScalar rel_vel, btScalar restitution);
 
@@ -82,11 +100,11 @@ protected:
 	void	convertContact(btPersistentManifold* manifold,const btContactSolverInfo& infoGlobal);
 
 
-	void	resolveSplitPenetrationSIMD(
+	btScalar	resolveSplitPenetrationSIMD(
      btSolverBody& bodyA,btSolverBody& bodyB,
         const btSolverConstraint& contactConstraint);
 
-	void	resolveSplitPenetrationImpulseCacheFriendly(
+	btScalar	resolveSplitPenetrationImpulseCacheFriendly(
        btSolverBody& bodyA,btSolverBody& bodyB,
         const btSolverConstraint& contactConstraint);
 
@@ -98,6 +116,12 @@ protected:
 	btSimdScalar	resolveSingleConstraintRowGenericSIMD(btSolverBody& bodyA,btSolverBody& bodyB,const btSolverConstraint& contactConstraint);
 	btSimdScalar	resolveSingleConstraintRowLowerLimit(btSolverBody& bodyA,btSolverBody& bodyB,const btSolverConstraint& contactConstraint);
 	btSimdScalar	resolveSingleConstraintRowLowerLimitSIMD(btSolverBody& bodyA,btSolverBody& bodyB,const btSolverConstraint& contactConstraint);
+
+	///one pass over the contact and then the friction batches, on the packed delta velocities of m_batchedBodyVelocities
+	btScalar	solveConstraintBatches();
+
+	///the current applied impulse of a contact row, which the batched mode keeps in m_contactConstraintBatches until the end of the iterations
+	btScalar	getContactAppliedImpulse(int contactIndex, const btContactSolverInfo& infoGlobal) const;
 		
 protected:
 	
@@ -135,12 +159,39 @@ public:
 		return m_btSeed2;
 	}
 
+	///returns the sum of the squared impulse corrections of the last iteration of the most recent solveGroup call.
+	///solveGroupCacheFriendlyIterations stops early once it drops below btContactSolverInfo::m_leastSquaresResidualThreshold
+	btScalar	getLeastSquaresResidual() const
+	{
+		return m_leastSquaresResidual;
+	}
+	///returns the number of iterations that the most recent solveGroup call used
+	int		getNumIterationsUsed() const
+	{
+		return m_numIterationsUsed;
+	}
+
 	
 	virtual btConstraintSolverType	getSolverType() const
 	{
 		return BT_SEQUENTIAL_IMPULSE_SOLVER;
 	}
 
+	virtual void	accumulateStatistics(btSolverStatistics& stats) const
+	{
+		stats.add(m_statistics);
+	}
+
+	virtual void	resetStatistics()
+	{
+		m_statistics.reset();
+	}
+
+	virtual void	setStatisticsEnabled(bool enable)
+	{
+		m_statisticsEnabled = enable;
+	}
+
 	btSingleConstraintRowSolver	getActiveConstraintRowSolverGeneric()
 	{
 		return m_resolveSingleConstraintRowGeneric;
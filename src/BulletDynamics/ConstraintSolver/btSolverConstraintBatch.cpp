@@ -0,0 +1,388 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btSolverConstraintBatch.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+#include "LinearMath/btMinMax.h"
+#include <string.h> //for memset
+
+#ifdef BT_USE_SSE
+
+#if BT_SOLVER_BATCH_WIDTH == 8
+#include <immintrin.h>
+
+typedef __m256 btLanes;
+
+static SIMD_FORCE_INLINE btLanes btLanesLoad(const btScalar* p) { return _mm256_loadu_ps(p); }
+static SIMD_FORCE_INLINE void btLanesStore(btScalar* p, btLanes a) { _mm256_storeu_ps(p, a); }
+static SIMD_FORCE_INLINE btLanes btLanesAdd(btLanes a, btLanes b) { return _mm256_add_ps(a, b); }
+static SIMD_FORCE_INLINE btLanes btLanesSub(btLanes a, btLanes b) { return _mm256_sub_ps(a, b); }
+static SIMD_FORCE_INLINE btLanes btLanesMul(btLanes a, btLanes b) { return _mm256_mul_ps(a, b); }
+static SIMD_FORCE_INLINE btLanes btLanesMin(btLanes a, btLanes b) { return _mm256_min_ps(a, b); }
+static SIMD_FORCE_INLINE btLanes btLanesMax(btLanes a, btLanes b) { return _mm256_max_ps(a, b); }
+
+#else //BT_SOLVER_BATCH_WIDTH == 8
+
+typedef __m128 btLanes;
+
+//the lanes of btSolverConstraintBatch are 16 byte aligned
+static SIMD_FORCE_INLINE btLanes btLanesLoad(const btScalar* p) { return _mm_load_ps(p); }
+static SIMD_FORCE_INLINE void btLanesStore(btScalar* p, btLanes a) { _mm_store_ps(p, a); }
+static SIMD_FORCE_INLINE btLanes btLanesAdd(btLanes a, btLanes b) { return _mm_add_ps(a, b); }
+static SIMD_FORCE_INLINE btLanes btLanesSub(btLanes a, btLanes b) { return _mm_sub_ps(a, b); }
+static SIMD_FORCE_INLINE btLanes btLanesMul(btLanes a, btLanes b) { return _mm_mul_ps(a, b); }
+static SIMD_FORCE_INLINE btLanes btLanesMin(btLanes a, btLanes b) { return _mm_min_ps(a, b); }
+static SIMD_FORCE_INLINE btLanes btLanesMax(btLanes a, btLanes b) { return _mm_max_ps(a, b); }
+
+#endif //BT_SOLVER_BATCH_WIDTH == 8
+
+#else //BT_USE_SSE
+
+//plain lane loops, the compiler may still vectorize them
+struct btLanes
+{
+	btScalar m[BT_SOLVER_BATCH_WIDTH];
+};
+
+static SIMD_FORCE_INLINE btLanes btLanesLoad(const btScalar* p)
+{
+	btLanes r;
+	for (int l=0;l<BT_SOLVER_BATCH_WIDTH;l++)
+		r.m[l] = p[l];
+	return r;
+}
+static SIMD_FORCE_INLINE void btLanesStore(btScalar* p, const btLanes& a)
+{
+	for (int l=0;l<BT_SOLVER_BATCH_WIDTH;l++)
+		p[l] = a.m[l];
+}
+#define BT_LANES_BINARY_OP(name, expr) \
+static SIMD_FORCE_INLINE btLanes name(const btLanes& a, const btLanes& b) \
+{ \
+	btLanes r; \
+	for (int l=0;l<BT_SOLVER_BATCH_WIDTH;l++) \
+		r.m[l] = expr; \
+	return r; \
+}
+BT_LANES_BINARY_OP(btLanesAdd, a.m[l]+b.m[l])
+BT_LANES_BINARY_OP(btLanesSub, a.m[l]-b.m[l])
+BT_LANES_BINARY_OP(btLanesMul, a.m[l]*b.m[l])
+BT_LANES_BINARY_OP(btLanesMin, btMin(a.m[l],b.m[l]))
+BT_LANES_BINARY_OP(btLanesMax, btMax(a.m[l],b.m[l]))
+#undef BT_LANES_BINARY_OP
+
+#endif //BT_USE_SSE
+
+
+static SIMD_FORCE_INLINE btLanes btLanesDot3(const btScalar a[3][BT_SOLVER_BATCH_WIDTH], const btLanes* b)
+{
+	return btLanesAdd(btLanesAdd(btLanesMul(btLanesLoad(a[0]), b[0]), btLanesMul(btLanesLoad(a[1]), b[1])), btLanesMul(btLanesLoad(a[2]), b[2]));
+}
+
+static SIMD_FORCE_INLINE void btLanesAddScaled(btLanes* v, const btScalar a[3][BT_SOLVER_BATCH_WIDTH], btLanes s)
+{
+	for (int k=0;k<3;k++)
+		v[k] = btLanesAdd(v[k], btLanesMul(btLanesLoad(a[k]), s));
+}
+
+///transposes the x,y,z of the vectors of the lanes
+static SIMD_FORCE_INLINE void btGatherLanes(const btVector3* vectors, const int* ids, btLanes* xyz)
+{
+#ifdef BT_USE_SSE
+	__m128 quads[BT_SOLVER_BATCH_WIDTH/4][3];
+	for (int i=0;i<BT_SOLVER_BATCH_WIDTH/4;i++)
+	{
+		__m128 r0 = vectors[ids[i*4+0]].mVec128;
+		__m128 r1 = vectors[ids[i*4+1]].mVec128;
+		__m128 r2 = vectors[ids[i*4+2]].mVec128;
+		__m128 r3 = vectors[ids[i*4+3]].mVec128;
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		quads[i][0] = r0;
+		quads[i][1] = r1;
+		quads[i][2] = r2;
+	}
+	for (int k=0;k<3;k++)
+	{
+#if BT_SOLVER_BATCH_WIDTH == 8
+		xyz[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(quads[0][k]), quads[1][k], 1);
+#else
+		xyz[k] = quads[0][k];
+#endif
+	}
+#else
+	for (int l=0;l<BT_SOLVER_BATCH_WIDTH;l++)
+	{
+		const btVector3& v = vectors[ids[l]];
+		xyz[0].m[l] = v.getX();
+		xyz[1].m[l] = v.getY();
+		xyz[2].m[l] = v.getZ();
+	}
+#endif //BT_USE_SSE
+}
+
+///writes the lanes back to the vectors, only for the lanes that are set in mask
+static SIMD_FORCE_INLINE void btScatterLanes(btVector3* vectors, const int* ids, int mask, const btLanes* xyz)
+{
+#ifdef BT_USE_SSE
+	for (int i=0;i<BT_SOLVER_BATCH_WIDTH/4;i++)
+	{
+		if (!((mask >> (i*4)) & 15))
+			continue;
+#if BT_SOLVER_BATCH_WIDTH == 8
+		__m128 r[4] = { i ? _mm256_extractf128_ps(xyz[0], 1) : _mm256_castps256_ps128(xyz[0]),
+						i ? _mm256_extractf128_ps(xyz[1], 1) : _mm256_castps256_ps128(xyz[1]),
+						i ? _mm256_extractf128_ps(xyz[2], 1) : _mm256_castps256_ps128(xyz[2]),
+						_mm_setzero_ps() };
+#else
+		__m128 r[4] = { xyz[0], xyz[1], xyz[2], _mm_setzero_ps() };
+#endif
+		_MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+		for (int j=0;j<4;j++)
+		{
+			if (mask & (1 << (i*4+j)))
+				vectors[ids[i*4+j]].mVec128 = r[j];
+		}
+	}
+#else
+	for (int l=0;l<BT_SOLVER_BATCH_WIDTH;l++)
+	{
+		if (mask & (1 << l))
+			vectors[ids[l]].setValue(xyz[0].m[l], xyz[1].m[l], xyz[2].m[l]);
+	}
+#endif //BT_USE_SSE
+}
+
+///the batched equivalent of gResolveSingleConstraintRowGeneric_scalar_reference, adds the squared delta impulses to leastSquaresResidual
+static SIMD_FORCE_INLINE void btSolveConstraintBatch(btSolverConstraintBatch& batch, btVector3* deltaLinearVelocities, btVector3* deltaAngularVelocities, btLanes& leastSquaresResidual)
+{
+	btLanes deltaLinearVelocityA[3], deltaAngularVelocityA[3];
+	btLanes deltaLinearVelocityB[3], deltaAngularVelocityB[3];
+	btGatherLanes(deltaLinearVelocities, batch.m_solverBodyIdA, deltaLinearVelocityA);
+	btGatherLanes(deltaAngularVelocities, batch.m_solverBodyIdA, deltaAngularVelocityA);
+	btGatherLanes(deltaLinearVelocities, batch.m_solverBodyIdB, deltaLinearVelocityB);
+	btGatherLanes(deltaAngularVelocities, batch.m_solverBodyIdB, deltaAngularVelocityB);
+
+	btLanes appliedImpulse = btLanesLoad(batch.m_appliedImpulse);
+	btLanes jacDiagABInv = btLanesLoad(batch.m_jacDiagABInv);
+	btLanes deltaImpulse = btLanesSub(btLanesLoad(batch.m_rhs), btLanesMul(appliedImpulse, btLanesLoad(batch.m_cfm)));
+	btLanes deltaVel1Dotn = btLanesAdd(btLanesDot3(batch.m_contactNormal1, deltaLinearVelocityA), btLanesDot3(batch.m_relpos1CrossNormal, deltaAngularVelocityA));
+	btLanes deltaVel2Dotn = btLanesAdd(btLanesDot3(batch.m_contactNormal2, deltaLinearVelocityB), btLanesDot3(batch.m_relpos2CrossNormal, deltaAngularVelocityB));
+	deltaImpulse = btLanesSub(deltaImpulse, btLanesMul(deltaVel1Dotn, jacDiagABInv));
+	deltaImpulse = btLanesSub(deltaImpulse, btLanesMul(deltaVel2Dotn, jacDiagABInv));
+
+	btLanes sum = btLanesAdd(appliedImpulse, deltaImpulse);
+	btLanes clampedSum = btLanesMin(btLanesMax(sum, btLanesLoad(batch.m_lowerLimit)), btLanesLoad(batch.m_upperLimit));
+	deltaImpulse = btLanesSub(clampedSum, appliedImpulse);
+	btLanesStore(batch.m_appliedImpulse, clampedSum);
+
+	btLanesAddScaled(deltaLinearVelocityA, batch.m_linearComponentA, deltaImpulse);
+	btLanesAddScaled(deltaAngularVelocityA, batch.m_angularComponentA, deltaImpulse);
+	btLanesAddScaled(deltaLinearVelocityB, batch.m_linearComponentB, deltaImpulse);
+	btLanesAddScaled(deltaAngularVelocityB, batch.m_angularComponentB, deltaImpulse);
+
+	btScatterLanes(deltaLinearVelocities, batch.m_solverBodyIdA, batch.m_dynamicMaskA, deltaLinearVelocityA);
+	btScatterLanes(deltaAngularVelocities, batch.m_solverBodyIdA, batch.m_dynamicMaskA, deltaAngularVelocityA);
+	btScatterLanes(deltaLinearVelocities, batch.m_solverBodyIdB, batch.m_dynamicMaskB, deltaLinearVelocityB);
+	btScatterLanes(deltaAngularVelocities, batch.m_solverBodyIdB, batch.m_dynamicMaskB, deltaAngularVelocityB);
+
+	leastSquaresResidual = btLanesAdd(leastSquaresResidual, btLanesMul(deltaImpulse, deltaImpulse));
+}
+
+
+void btSolverBodyVelocityPool::load(const btAlignedObjectArray<btSolverBody>& bodies)
+{
+	m_deltaLinearVelocity.resizeNoInitialize(bodies.size());
+	m_deltaAngularVelocity.resizeNoInitialize(bodies.size());
+	for (int i=0;i<bodies.size();i++)
+	{
+		m_deltaLinearVelocity[i] = bodies[i].m_deltaLinearVelocity;
+		m_deltaAngularVelocity[i] = bodies[i].m_deltaAngularVelocity;
+	}
+}
+
+void btSolverBodyVelocityPool::store(btAlignedObjectArray<btSolverBody>& bodies) const
+{
+	btAssert(bodies.size() == m_deltaLinearVelocity.size());
+	for (int i=0;i<bodies.size();i++)
+	{
+		bodies[i].m_deltaLinearVelocity = m_deltaLinearVelocity[i];
+		bodies[i].m_deltaAngularVelocity = m_deltaAngularVelocity[i];
+	}
+}
+
+
+static SIMD_FORCE_INLINE bool btIsDynamicSolverBody(const btSolverBody& body)
+{
+	//only dynamic bodies receive impulses, static and kinematic bodies can be shared by all lanes of a batch
+	return body.m_originalBody && body.m_originalBody->getInvMass() != btScalar(0);
+}
+
+int btSolverConstraintBatchPool::findOpenBatch(int batchIndex)
+{
+	//m_nextOpenBatch[i] == i for batches with a free lane and for the sentinel at m_batches.size(),
+	//a full batch points to a later batch, path halving keeps the chains short
+	while (m_nextOpenBatch[batchIndex] != batchIndex)
+	{
+		m_nextOpenBatch[batchIndex] = m_nextOpenBatch[m_nextOpenBatch[batchIndex]];
+		batchIndex = m_nextOpenBatch[batchIndex];
+	}
+	return batchIndex;
+}
+
+void btSolverConstraintBatchPool::build(const btConstraintArray& rows, const btAlignedObjectArray<btSolverBody>& bodies)
+{
+	clear();
+	m_nextOpenBatch.push_back(0);
+	m_rowLocation.resizeNoInitialize(rows.size());
+	m_bodyLastBatch.resizeNoInitialize(bodies.size());
+	for (int i=0;i<bodies.size();i++)
+	{
+		m_bodyLastBatch[i] = -1;
+	}
+
+	for (int i=0;i<rows.size();i++)
+	{
+		const btSolverConstraint& c = rows[i];
+		const btSolverBody& bodyA = bodies[c.m_solverBodyIdA];
+		const btSolverBody& bodyB = bodies[c.m_solverBodyIdB];
+		bool dynamicA = btIsDynamicSolverBody(bodyA);
+		bool dynamicB = btIsDynamicSolverBody(bodyB);
+
+		int batchIndex = 0;
+		if (dynamicA)
+			batchIndex = btMax(batchIndex, m_bodyLastBatch[c.m_solverBodyIdA]+1);
+		if (dynamicB)
+			batchIndex = btMax(batchIndex, m_bodyLastBatch[c.m_solverBodyIdB]+1);
+		batchIndex = findOpenBatch(batchIndex);
+
+		if (batchIndex == m_batches.size())
+		{
+			btSolverConstraintBatch& newBatch = m_batches.expandNonInitializing();
+			memset(&newBatch, 0, sizeof(btSolverConstraintBatch));
+			m_nextOpenBatch.push_back(batchIndex+1);
+		}
+		btSolverConstraintBatch& batch = m_batches[batchIndex];
+		int lane = batch.m_numRows++;
+		if (batch.m_numRows == BT_SOLVER_BATCH_WIDTH)
+		{
+			m_nextOpenBatch[batchIndex] = batchIndex+1;
+		}
+
+		btVector3 linearComponentA = dynamicA ? c.m_contactNormal1*bodyA.m_invMass*bodyA.m_linearFactor : btVector3(0,0,0);
+		btVector3 angularComponentA = dynamicA ? c.m_angularComponentA*bodyA.m_angularFactor : btVector3(0,0,0);
+		btVector3 linearComponentB = dynamicB ? c.m_contactNormal2*bodyB.m_invMass*bodyB.m_linearFactor : btVector3(0,0,0);
+		btVector3 angularComponentB = dynamicB ? c.m_angularComponentB*bodyB.m_angularFactor : btVector3(0,0,0);
+		for (int k=0;k<3;k++)
+		{
+			batch.m_contactNormal1[k][lane] = c.m_contactNormal1.m_floats[k];
+			batch.m_relpos1CrossNormal[k][lane] = c.m_relpos1CrossNormal.m_floats[k];
+			batch.m_contactNormal2[k][lane] = c.m_contactNormal2.m_floats[k];
+			batch.m_relpos2CrossNormal[k][lane] = c.m_relpos2CrossNormal.m_floats[k];
+			batch.m_linearComponentA[k][lane] = linearComponentA.m_floats[k];
+			batch.m_angularComponentA[k][lane] = angularComponentA.m_floats[k];
+			batch.m_linearComponentB[k][lane] = linearComponentB.m_floats[k];
+			batch.m_angularComponentB[k][lane] = angularComponentB.m_floats[k];
+		}
+		batch.m_rhs[lane] = c.m_rhs;
+		batch.m_cfm[lane] = c.m_cfm;
+		batch.m_jacDiagABInv[lane] = c.m_jacDiagABInv;
+		batch.m_lowerLimit[lane] = c.m_lowerLimit;
+		batch.m_upperLimit[lane] = c.m_upperLimit;
+		batch.m_friction[lane] = c.m_friction;
+		batch.m_appliedImpulse[lane] = c.m_appliedImpulse;
+		batch.m_solverBodyIdA[lane] = c.m_solverBodyIdA;
+		batch.m_solverBodyIdB[lane] = c.m_solverBodyIdB;
+		m_rowLocation[i] = batchIndex*BT_SOLVER_BATCH_WIDTH+lane;
+		batch.m_frictionIndex[lane] = c.m_frictionIndex;
+		if (dynamicA)
+			batch.m_dynamicMaskA |= 1 << lane;
+		if (dynamicB)
+			batch.m_dynamicMaskB |= 1 << lane;
+
+		if (dynamicA)
+			m_bodyLastBatch[c.m_solverBodyIdA] = batchIndex;
+		if (dynamicB)
+			m_bodyLastBatch[c.m_solverBodyIdB] = batchIndex;
+	}
+
+	//unused lanes have zero coefficients and limits so their impulse stays zero, they read the bodies of the first lane and are never written back
+	for (int b=0;b<m_batches.size();b++)
+	{
+		btSolverConstraintBatch& batch = m_batches[b];
+		for (int lane=batch.m_numRows;lane<BT_SOLVER_BATCH_WIDTH;lane++)
+		{
+			batch.m_solverBodyIdA[lane] = batch.m_solverBodyIdA[0];
+			batch.m_solverBodyIdB[lane] = batch.m_solverBodyIdB[0];
+		}
+	}
+}
+
+btScalar btSolverConstraintBatchPool::solve(btSolverBodyVelocityPool& velocities, const btSolverConstraintBatchPool* contactBatches)
+{
+	if (!m_batches.size())
+		return 0.f;
+
+	btVector3* deltaLinearVelocities = velocities.getDeltaLinearVelocities();
+	btVector3* deltaAngularVelocities = velocities.getDeltaAngularVelocities();
+
+	ATTRIBUTE_ALIGNED16(btScalar zero[BT_SOLVER_BATCH_WIDTH]);
+	for (int lane=0;lane<BT_SOLVER_BATCH_WIDTH;lane++)
+		zero[lane] = 0.f;
+	btLanes leastSquaresResidual = btLanesLoad(zero);
+
+	for (int b=0;b<m_batches.size();b++)
+	{
+		btSolverConstraintBatch& batch = m_batches[b];
+		if (contactBatches)
+		{
+			for (int lane=0;lane<batch.m_numRows;lane++)
+			{
+				btScalar totalImpulse = contactBatches->getAppliedImpulse(batch.m_frictionIndex[lane]);
+				if (totalImpulse>btScalar(0))
+				{
+					batch.m_lowerLimit[lane] = -(batch.m_friction[lane]*totalImpulse);
+					batch.m_upperLimit[lane] = batch.m_friction[lane]*totalImpulse;
+				} else
+				{
+					//the sequential solver skips the row, pinning the impulse has the same effect
+					batch.m_lowerLimit[lane] = batch.m_appliedImpulse[lane];
+					batch.m_upperLimit[lane] = batch.m_appliedImpulse[lane];
+				}
+			}
+		}
+
+		btSolveConstraintBatch(batch, deltaLinearVelocities, deltaAngularVelocities, leastSquaresResidual);
+	}
+	m_hasNewImpulses = true;
+
+	ATTRIBUTE_ALIGNED16(btScalar residual[BT_SOLVER_BATCH_WIDTH]);
+	btLanesStore(residual, leastSquaresResidual);
+	btScalar sum = 0.f;
+	for (int lane=0;lane<BT_SOLVER_BATCH_WIDTH;lane++)
+		sum += residual[lane];
+	return sum;
+}
+
+void btSolverConstraintBatchPool::writeAppliedImpulses(btConstraintArray& rows)
+{
+	if (!m_hasNewImpulses)
+		return;
+	btAssert(rows.size() == m_rowLocation.size());
+	for (int i=0;i<rows.size();i++)
+	{
+		rows[i].m_appliedImpulse = getAppliedImpulse(i);
+	}
+	m_hasNewImpulses = false;
+}
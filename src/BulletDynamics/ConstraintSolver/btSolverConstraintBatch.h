@@ -0,0 +1,160 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_SOLVER_CONSTRAINT_BATCH_H
+#define BT_SOLVER_CONSTRAINT_BATCH_H
+
+#include "btSolverBody.h"
+#include "btSolverConstraint.h"
+#include "LinearMath/btAlignedObjectArray.h"
+
+///number of constraint rows that are solved together, one per SIMD lane
+#if defined (BT_USE_SSE) && defined (__AVX__)
+#define BT_SOLVER_BATCH_WIDTH 8
+#else
+#define BT_SOLVER_BATCH_WIDTH 4
+#endif
+
+///btSolverConstraintBatch stores up to BT_SOLVER_BATCH_WIDTH contact or friction rows that don't share a dynamic body,
+///in structure-of-arrays layout so that each SIMD instruction works on the same quantity of all rows.
+///The constant parts of the rows are copied from the btSolverConstraint pool, only the applied impulse changes during the iterations.
+ATTRIBUTE_ALIGNED16(struct) btSolverConstraintBatch
+{
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btScalar	m_contactNormal1[3][BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_relpos1CrossNormal[3][BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_contactNormal2[3][BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_relpos2CrossNormal[3][BT_SOLVER_BATCH_WIDTH];
+	//impulse to delta velocity, including the inverse mass and the linear/angular factors of the body
+	btScalar	m_linearComponentA[3][BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_angularComponentA[3][BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_linearComponentB[3][BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_angularComponentB[3][BT_SOLVER_BATCH_WIDTH];
+
+	btScalar	m_rhs[BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_cfm[BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_jacDiagABInv[BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_lowerLimit[BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_upperLimit[BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_friction[BT_SOLVER_BATCH_WIDTH];
+	btScalar	m_appliedImpulse[BT_SOLVER_BATCH_WIDTH];
+
+	int			m_solverBodyIdA[BT_SOLVER_BATCH_WIDTH];
+	int			m_solverBodyIdB[BT_SOLVER_BATCH_WIDTH];
+	int			m_frictionIndex[BT_SOLVER_BATCH_WIDTH];
+	//one bit per lane, set when the solver body receives impulses and its velocity has to be written back
+	int			m_dynamicMaskA;
+	int			m_dynamicMaskB;
+	int			m_numRows;
+};
+
+///btSolverBodyVelocityPool holds the delta velocities of the solver bodies in two packed arrays while the batched rows are solved.
+///The batches only read and write these, so a row touches 2x16 bytes per body instead of a cache line in the middle of a btSolverBody,
+///the inverse mass, factors and jacobians are already folded into the constant part of the batches.
+class btSolverBodyVelocityPool
+{
+	btAlignedObjectArray<btVector3>	m_deltaLinearVelocity;
+	btAlignedObjectArray<btVector3>	m_deltaAngularVelocity;
+
+public:
+
+	///copies the delta velocities out of the solver bodies
+	void	load(const btAlignedObjectArray<btSolverBody>& bodies);
+
+	///copies the delta velocities back into the solver bodies, the other rows of the solver work on btSolverBody
+	void	store(btAlignedObjectArray<btSolverBody>& bodies) const;
+
+	btVector3*	getDeltaLinearVelocities()
+	{
+		return m_deltaLinearVelocity.size() ? &m_deltaLinearVelocity[0] : 0;
+	}
+
+	btVector3*	getDeltaAngularVelocities()
+	{
+		return m_deltaAngularVelocity.size() ? &m_deltaAngularVelocity[0] : 0;
+	}
+
+	int		size() const
+	{
+		return m_deltaLinearVelocity.size();
+	}
+
+	void	clear()
+	{
+		m_deltaLinearVelocity.resizeNoInitialize(0);
+		m_deltaAngularVelocity.resizeNoInitialize(0);
+	}
+};
+
+///btSolverConstraintBatchPool groups the contact or friction rows of a btSequentialImpulseConstraintSolver into batches
+///and solves a whole batch at once, it is used for the SOLVER_BATCHED_CONTACT_ROWS solver mode.
+class btSolverConstraintBatchPool
+{
+	btAlignedObjectArray<btSolverConstraintBatch>	m_batches;
+	//last batch that contains a row of a solver body, -1 if none
+	btAlignedObjectArray<int>	m_bodyLastBatch;
+	//skip list over the full batches, see findOpenBatch
+	btAlignedObjectArray<int>	m_nextOpenBatch;
+	//batch index * BT_SOLVER_BATCH_WIDTH + lane of each row
+	btAlignedObjectArray<int>	m_rowLocation;
+	//the applied impulses in the batches are newer than the ones in the rows
+	bool	m_hasNewImpulses;
+
+	int		findOpenBatch(int batchIndex);
+
+public:
+
+	btSolverConstraintBatchPool() :m_hasNewImpulses(false)
+	{
+	}
+
+	///copies the rows into batches. A row goes into the first batch with a free lane after the last batch that touches
+	///one of its dynamic bodies, so all rows that act on the same body are still solved in their original order.
+	void	build(const btConstraintArray& rows, const btAlignedObjectArray<btSolverBody>& bodies);
+
+	///runs one Gauss Seidel pass over all batches and returns the sum of the squared delta impulses. For friction rows,
+	///'contactBatches' holds the contact rows whose normal impulse limits the friction impulse, it is 0 for contact rows.
+	btScalar	solve(btSolverBodyVelocityPool& velocities, const btSolverConstraintBatchPool* contactBatches);
+
+	///copies the applied impulses back into the rows that were passed to build, if any batch was solved since then
+	void	writeAppliedImpulses(btConstraintArray& rows);
+
+	btScalar	getAppliedImpulse(int rowIndex) const
+	{
+		int location = m_rowLocation[rowIndex];
+		return m_batches[location/BT_SOLVER_BATCH_WIDTH].m_appliedImpulse[location%BT_SOLVER_BATCH_WIDTH];
+	}
+
+	void	clear()
+	{
+		m_batches.resizeNoInitialize(0);
+		m_nextOpenBatch.resizeNoInitialize(0);
+		m_rowLocation.resizeNoInitialize(0);
+		m_hasNewImpulses = false;
+	}
+
+	int		getNumBatches() const
+	{
+		return m_batches.size();
+	}
+
+	int		getNumRows() const
+	{
+		return m_rowLocation.size();
+	}
+};
+
+#endif //BT_SOLVER_CONSTRAINT_BATCH_H
@@ -211,7 +211,8 @@ m_fixedTimeStep(0),
 m_synchronizeAllMotionStates(false),
 m_applySpeculativeContactRestitution(false),
 m_profileTimings(0),
-m_latencyMotionStateInterpolation(true)
+m_latencyMotionStateInterpolation(true),
+m_stepStatsEnabled(false)
 
 {
 	if (!m_constraintSolver)
@@ -259,14 +260,38 @@ btDiscreteDynamicsWorld::~btDiscreteDynamicsWorld()
 	}
 }
 
+btAlignedObjectArray<btRigidBody*>&	btDiscreteDynamicsWorld::collectStepRigidBodies()
+{
+	if (!m_splitActiveObjects)
+	{
+		return m_nonStaticRigidBodies;
+	}
+	updateActiveObjects();
+	m_awakeRigidBodies.resize(0);
+	for (int i=0;i<m_activeObjects.size();i++)
+	{
+		btRigidBody* body = btRigidBody::upcast(m_activeObjects[i]);
+		if (body && !body->isStaticObject())
+		{
+			m_awakeRigidBodies.push_back(body);
+		}
+	}
+	return m_awakeRigidBodies;
+}
+
 void	btDiscreteDynamicsWorld::saveKinematicState(btScalar timeStep)
 {
 ///would like to iterate over m_nonStaticRigidBodies, but unfortunately old API allows
 ///to switch status _after_ adding kinematic objects to the world
 ///fix it for Bullet 3.x release
-	for (int i=0;i<m_collisionObjects.size();i++)
+	if (m_splitActiveObjects)
 	{
-		btCollisionObject* colObj = m_collisionObjects[i];
+		updateActiveObjects();
+	}
+	btCollisionObjectArray& collisionObjects = m_splitActiveObjects ? m_activeObjects : m_collisionObjects;
+	for (int i=0;i<collisionObjects.size();i++)
+	{
+		btCollisionObject* colObj = collisionObjects[i];
 		btRigidBody* body = btRigidBody::upcast(colObj);
 		if (body && body->getActivationState() != ISLAND_SLEEPING)
 		{
@@ -325,10 +350,11 @@ void	btDiscreteDynamicsWorld::debugDrawWorld()
 
 void	btDiscreteDynamicsWorld::clearForces()
 {
-	///@todo: iterate over awake simulation islands!
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	//with setSplitActiveObjects the forces of sleeping bodies are kept until they wake up
+	btAlignedObjectArray<btRigidBody*>& bodies = collectStepRigidBodies();
+	for ( int i=0;i<bodies.size();i++)
 	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
+		btRigidBody* body = bodies[i];
 		//need to check if next line is ok
 		//it might break backward compatibility (people applying forces on sleeping objects get never cleared and accumulate on wake-up
 		body->clearForces();
@@ -338,10 +364,10 @@ void	btDiscreteDynamicsWorld::clearForces()
 ///apply gravity, call this once per timestep
 void	btDiscreteDynamicsWorld::applyGravity()
 {
-	///@todo: iterate over awake simulation islands!
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	btAlignedObjectArray<btRigidBody*>& bodies = collectStepRigidBodies();
+	for ( int i=0;i<bodies.size();i++)
 	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
+		btRigidBody* body = bodies[i];
 		if (body->isActive())
 		{
 			body->applyGravity();
@@ -388,9 +414,10 @@ void	btDiscreteDynamicsWorld::synchronizeMotionStates()
 	} else
 	{
 		//iterate over all active rigid bodies
-		for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+		btAlignedObjectArray<btRigidBody*>& bodies = collectStepRigidBodies();
+		for ( int i=0;i<bodies.size();i++)
 		{
-			btRigidBody* body = m_nonStaticRigidBodies[i];
+			btRigidBody* body = bodies[i];
 			if (body->isActive())
 				synchronizeSingleMotionState(body);
 		}
@@ -404,6 +431,11 @@ int	btDiscreteDynamicsWorld::stepSimulation( btScalar timeStep,int maxSubSteps,
 
 	BT_PROFILE("stepSimulation");
 
+	if (m_stepStatsEnabled)
+	{
+		m_stepStats.reset();
+	}
+
 	int numSimulationSubSteps = 0;
 
 	if (maxSubSteps)
@@ -476,10 +508,28 @@ void	btDiscreteDynamicsWorld::internalSingleStepSimulation(btScalar timeStep)
 
 	BT_PROFILE("internalSingleStepSimulation");
 
+	btOverlappingPairCache* pairCache = getBroadphase()->getOverlappingPairCache();
+	unsigned int numAddedPairs = 0;
+	unsigned int numRemovedPairs = 0;
+	if (m_stepStatsEnabled)
+	{
+		m_stepStats.m_numSubSteps++;
+		numAddedPairs = pairCache->getNumAddedPairs();
+		numRemovedPairs = pairCache->getNumRemovedPairs();
+		//the solver may have been replaced since the stats were enabled
+		m_constraintSolver->setStatisticsEnabled(true);
+		m_constraintSolver->resetStatistics();
+	}
+
 	if(0 != m_internalPreTickCallback) {
 		(*m_internalPreTickCallback)(this, timeStep);
 	}
 
+	if (m_splitActiveObjects)
+	{
+		m_substepAwakeRigidBodies.copyFromArray(collectStepRigidBodies());
+	}
+
 	///apply gravity, predict motion
 	predictUnconstraintMotion(timeStep);
 
@@ -519,6 +569,73 @@ void	btDiscreteDynamicsWorld::internalSingleStepSimulation(btScalar timeStep)
 	if(0 != m_internalTickCallback) {
 		(*m_internalTickCallback)(this, timeStep);
 	}
+
+	if (m_stepStatsEnabled)
+	{
+		//the counters of the pair cache only grow, so the differences are the changes of this substep
+		m_stepStats.m_numAddedPairs += int(pairCache->getNumAddedPairs() - numAddedPairs);
+		m_stepStats.m_numRemovedPairs += int(pairCache->getNumRemovedPairs() - numRemovedPairs);
+		m_stepStats.m_numOverlappingPairs = pairCache->getNumOverlappingPairs();
+		m_constraintSolver->accumulateStatistics(m_stepStats.m_solver);
+		gatherStepStats();
+	}
+}
+
+void	btDiscreteDynamicsWorld::gatherStepStats()
+{
+	BT_PROFILE("gatherStepStats");
+
+	int numManifolds = getDispatcher()->getNumManifolds();
+	int numContactPoints = 0;
+	for (int i=0;i<numManifolds;i++)
+	{
+		numContactPoints += getDispatcher()->getManifoldByIndexInternal(i)->getNumContacts();
+	}
+	m_stepStats.m_numManifolds = numManifolds;
+	m_stepStats.m_numContactPoints = numContactPoints;
+
+	//island tags are indices into the union find of the island manager, so they are smaller than the number of objects
+	m_stepStatsIslandSizes.resize(0);
+	m_stepStatsIslandSizes.resize(m_collisionObjects.size(),0);
+	int numIslands = 0;
+	int numIslandBodies = 0;
+	int largestIsland = 0;
+	for (int i=0;i<m_collisionObjects.size();i++)
+	{
+		const btCollisionObject* colObj = m_collisionObjects[i];
+		int tag = colObj->getIslandTag();
+		if (tag < 0 || !colObj->isActive() || colObj->isStaticOrKinematicObject())
+			continue;
+		if (tag >= m_stepStatsIslandSizes.size())
+			m_stepStatsIslandSizes.resize(tag+1,0);
+		int size = ++m_stepStatsIslandSizes[tag];
+		if (size == 1)
+			numIslands++;
+		numIslandBodies++;
+		largestIsland = btMax(largestIsland,size);
+	}
+	m_stepStats.m_numIslands = numIslands;
+	m_stepStats.m_numIslandBodies = numIslandBodies;
+	m_stepStats.m_largestIsland = largestIsland;
+
+	//the histogram describes the last substep like the other island counts
+	for (int i=0;i<BT_STEP_STATS_ISLAND_HISTOGRAM_SIZE;i++)
+	{
+		m_stepStats.m_islandSizeHistogram[i] = 0;
+	}
+	for (int i=0;i<m_stepStatsIslandSizes.size();i++)
+	{
+		int size = m_stepStatsIslandSizes[i];
+		if (size)
+		{
+			int bucket = 0;
+			while ((size >>= 1) && bucket < BT_STEP_STATS_ISLAND_HISTOGRAM_SIZE-1)
+			{
+				bucket++;
+			}
+			m_stepStats.m_islandSizeHistogram[bucket]++;
+		}
+	}
 }
 
 void	btDiscreteDynamicsWorld::setGravity(const btVector3& gravity)
@@ -622,9 +739,24 @@ void	btDiscreteDynamicsWorld::updateActivationState(btScalar timeStep)
 {
 	BT_PROFILE("updateActivationState");
 
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	btAlignedObjectArray<btRigidBody*>& bodies = collectStepRigidBodies();
+	if (m_splitActiveObjects)
 	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
+		//the sleeping bodies are skipped, except the ones that fell asleep in this substep: they are stopped once,
+		//and their forces are cleared now because clearForces only visits the awake bodies
+		for ( int i=0;i<m_substepAwakeRigidBodies.size();i++)
+		{
+			btRigidBody* body = m_substepAwakeRigidBodies[i];
+			if (!body->isActive())
+			{
+				body->clearForces();
+				bodies.push_back(body);
+			}
+		}
+	}
+	for ( int i=0;i<bodies.size();i++)
+	{
+		btRigidBody* body = bodies[i];
 		if (body)
 		{
 			body->updateDeactivation(timeStep);
@@ -894,9 +1026,10 @@ void	btDiscreteDynamicsWorld::createPredictiveContacts(btScalar timeStep)
 	}
 
 	btTransform predictedTrans;
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	btAlignedObjectArray<btRigidBody*>& bodies = collectStepRigidBodies();
+	for ( int i=0;i<bodies.size();i++)
 	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
+		btRigidBody* body = bodies[i];
 		body->setHitFraction(1.f);
 
 		if (body->isActive() && (!body->isStaticOrKinematicObject()))
@@ -912,6 +1045,10 @@ void	btDiscreteDynamicsWorld::createPredictiveContacts(btScalar timeStep)
 				if (body->getCollisionShape()->isConvex())
 				{
 					gNumClampedCcdMotions++;
+					if (m_stepStatsEnabled)
+					{
+						m_stepStats.m_numCcdSweeps++;
+					}
 #ifdef PREDICTIVE_CONTACT_USE_STATIC_ONLY
 					class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
 					{
@@ -974,112 +1111,171 @@ void	btDiscreteDynamicsWorld::createPredictiveContacts(btScalar timeStep)
 		}
 	}
 }
-void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
+bool	btDiscreteDynamicsWorld::needsCcdMotionClamping(btRigidBody* body, const btTransform& predictedTrans) const
 {
-	BT_PROFILE("integrateTransforms");
-	btTransform predictedTrans;
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	btScalar squareMotion = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
+	return getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion
+		&& body->getCollisionShape()->isConvex();
+}
+
+btScalar	btDiscreteDynamicsWorld::computeCcdHitFraction(btRigidBody* body, const btTransform& predictedTrans, bool* testedMovingBody)
+{
+#ifdef USE_STATIC_ONLY
+	class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
 	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
-		body->setHitFraction(1.f);
+	public:
 
-		if (body->isActive() && (!body->isStaticOrKinematicObject()))
+		StaticOnlyCallback (btCollisionObject* me,const btVector3& fromA,const btVector3& toA,btOverlappingPairCache* pairCache,btDispatcher* dispatcher) :
+		  btClosestNotMeConvexResultCallback(me,fromA,toA,pairCache,dispatcher)
 		{
+		}
 
-			body->predictIntegratedTransform(timeStep, predictedTrans);
-
-			btScalar squareMotion = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
+	  	virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+		{
+			btCollisionObject* otherObj = (btCollisionObject*) proxy0->m_clientObject;
+			if (!otherObj->isStaticOrKinematicObject())
+				return false;
+			return btClosestNotMeConvexResultCallback::needsCollision(proxy0);
+		}
+	};
 
+	StaticOnlyCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
+	if (testedMovingBody)
+	{
+		*testedMovingBody = false;
+	}
+#else
+	///notes if the sweep tests a body that integrateTransforms moves, the result then depends on whether that body moved already
+	class MovingBodyCallback : public btClosestNotMeConvexResultCallback
+	{
+	public:
+		mutable bool m_testedMovingBody;
 
+		MovingBodyCallback (btCollisionObject* me,const btVector3& fromA,const btVector3& toA,btOverlappingPairCache* pairCache,btDispatcher* dispatcher) :
+		  btClosestNotMeConvexResultCallback(me,fromA,toA,pairCache,dispatcher),
+		  m_testedMovingBody(false)
+		{
+		}
 
-			if (getDispatchInfo().m_useContinuous && body->getCcdSquareMotionThreshold() && body->getCcdSquareMotionThreshold() < squareMotion)
+	  	virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+		{
+			if (!btClosestNotMeConvexResultCallback::needsCollision(proxy0))
+				return false;
+			const btRigidBody* otherBody = btRigidBody::upcast((btCollisionObject*) proxy0->m_clientObject);
+			if (otherBody && otherBody->isActive() && !otherBody->isStaticOrKinematicObject())
 			{
-				BT_PROFILE("CCD motion clamping");
-				if (body->getCollisionShape()->isConvex())
-				{
-					gNumClampedCcdMotions++;
-#ifdef USE_STATIC_ONLY
-					class StaticOnlyCallback : public btClosestNotMeConvexResultCallback
-					{
-					public:
-
-						StaticOnlyCallback (btCollisionObject* me,const btVector3& fromA,const btVector3& toA,btOverlappingPairCache* pairCache,btDispatcher* dispatcher) :
-						  btClosestNotMeConvexResultCallback(me,fromA,toA,pairCache,dispatcher)
-						{
-						}
-
-					  	virtual bool needsCollision(btBroadphaseProxy* proxy0) const
-						{
-							btCollisionObject* otherObj = (btCollisionObject*) proxy0->m_clientObject;
-							if (!otherObj->isStaticOrKinematicObject())
-								return false;
-							return btClosestNotMeConvexResultCallback::needsCollision(proxy0);
-						}
-					};
+				m_testedMovingBody = true;
+			}
+			return true;
+		}
+	};
 
-					StaticOnlyCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
-#else
-					btClosestNotMeConvexResultCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
+	MovingBodyCallback sweepResults(body,body->getWorldTransform().getOrigin(),predictedTrans.getOrigin(),getBroadphase()->getOverlappingPairCache(),getDispatcher());
 #endif
-					//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
-					btSphereShape tmpSphere(body->getCcdSweptSphereRadius());//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
-					sweepResults.m_allowedPenetration=getDispatchInfo().m_allowedCcdPenetration;
-
-					sweepResults.m_collisionFilterGroup = body->getBroadphaseProxy()->m_collisionFilterGroup;
-					sweepResults.m_collisionFilterMask  = body->getBroadphaseProxy()->m_collisionFilterMask;
-					btTransform modifiedPredictedTrans = predictedTrans;
-					modifiedPredictedTrans.setBasis(body->getWorldTransform().getBasis());
-
-					convexSweepTest(&tmpSphere,body->getWorldTransform(),modifiedPredictedTrans,sweepResults);
-					if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
-					{
+	//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
+	btSphereShape tmpSphere(body->getCcdSweptSphereRadius());//btConvexShape* convexShape = static_cast<btConvexShape*>(body->getCollisionShape());
+	sweepResults.m_allowedPenetration=getDispatchInfo().m_allowedCcdPenetration;
+
+	sweepResults.m_collisionFilterGroup = body->getBroadphaseProxy()->m_collisionFilterGroup;
+	sweepResults.m_collisionFilterMask  = body->getBroadphaseProxy()->m_collisionFilterMask;
+	btTransform modifiedPredictedTrans = predictedTrans;
+	modifiedPredictedTrans.setBasis(body->getWorldTransform().getBasis());
+
+	convexSweepTest(&tmpSphere,body->getWorldTransform(),modifiedPredictedTrans,sweepResults);
+#ifndef USE_STATIC_ONLY
+	if (testedMovingBody)
+	{
+		*testedMovingBody = sweepResults.m_testedMovingBody;
+	}
+#endif
+	if (sweepResults.hasHit() && (sweepResults.m_closestHitFraction < 1.f))
+	{
+		return sweepResults.m_closestHitFraction;
+	}
+	return 1.f;
+}
 
-						//printf("clamped integration to hit fraction = %f\n",fraction);
-						body->setHitFraction(sweepResults.m_closestHitFraction);
-						body->predictIntegratedTransform(timeStep*body->getHitFraction(), predictedTrans);
-						body->setHitFraction(0.f);
-						body->proceedToTransform( predictedTrans);
+void	btDiscreteDynamicsWorld::clampCcdMotion(btRigidBody* body, btScalar hitFraction, btScalar timeStep)
+{
+	//printf("clamped integration to hit fraction = %f\n",fraction);
+	btTransform predictedTrans;
+	body->setHitFraction(hitFraction);
+	body->predictIntegratedTransform(timeStep*body->getHitFraction(), predictedTrans);
+	body->setHitFraction(0.f);
+	body->proceedToTransform( predictedTrans);
 
 #if 0
-						btVector3 linVel = body->getLinearVelocity();
+	btVector3 linVel = body->getLinearVelocity();
 
-						btScalar maxSpeed = body->getCcdMotionThreshold()/getSolverInfo().m_timeStep;
-						btScalar maxSpeedSqr = maxSpeed*maxSpeed;
-						if (linVel.length2()>maxSpeedSqr)
-						{
-							linVel.normalize();
-							linVel*= maxSpeed;
-							body->setLinearVelocity(linVel);
-							btScalar ms2 = body->getLinearVelocity().length2();
-							body->predictIntegratedTransform(timeStep, predictedTrans);
-
-							btScalar sm2 = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
-							btScalar smt = body->getCcdSquareMotionThreshold();
-							printf("sm2=%f\n",sm2);
-						}
+	btScalar maxSpeed = body->getCcdMotionThreshold()/getSolverInfo().m_timeStep;
+	btScalar maxSpeedSqr = maxSpeed*maxSpeed;
+	if (linVel.length2()>maxSpeedSqr)
+	{
+		linVel.normalize();
+		linVel*= maxSpeed;
+		body->setLinearVelocity(linVel);
+		btScalar ms2 = body->getLinearVelocity().length2();
+		body->predictIntegratedTransform(timeStep, predictedTrans);
+
+		btScalar sm2 = (predictedTrans.getOrigin()-body->getWorldTransform().getOrigin()).length2();
+		btScalar smt = body->getCcdSquareMotionThreshold();
+		printf("sm2=%f\n",sm2);
+	}
 #else
 
-						//don't apply the collision response right now, it will happen next frame
-						//if you really need to, you can uncomment next 3 lines. Note that is uses zero restitution.
-						//btScalar appliedImpulse = 0.f;
-						//btScalar depth = 0.f;
-						//appliedImpulse = resolveSingleCollision(body,(btCollisionObject*)sweepResults.m_hitCollisionObject,sweepResults.m_hitPointWorld,sweepResults.m_hitNormalWorld,getSolverInfo(), depth);
+	//don't apply the collision response right now, it will happen next frame
+	//if you really need to, you can uncomment next 3 lines. Note that is uses zero restitution.
+	//btScalar appliedImpulse = 0.f;
+	//btScalar depth = 0.f;
+	//appliedImpulse = resolveSingleCollision(body,(btCollisionObject*)sweepResults.m_hitCollisionObject,sweepResults.m_hitPointWorld,sweepResults.m_hitNormalWorld,getSolverInfo(), depth);
 
 
 #endif
+}
 
-        				continue;
-					}
+void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
+{
+	BT_PROFILE("integrateTransforms");
+	btTransform predictedTrans;
+	btAlignedObjectArray<btRigidBody*>& bodies = collectStepRigidBodies();
+	for ( int i=0;i<bodies.size();i++)
+	{
+		btRigidBody* body = bodies[i];
+		body->setHitFraction(1.f);
+
+		if (body->isActive() && (!body->isStaticOrKinematicObject()))
+		{
+
+			body->predictIntegratedTransform(timeStep, predictedTrans);
+
+			if (needsCcdMotionClamping(body, predictedTrans))
+			{
+				BT_PROFILE("CCD motion clamping");
+				gNumClampedCcdMotions++;
+				btScalar hitFraction = computeCcdHitFraction(body, predictedTrans);
+				if (m_stepStatsEnabled)
+				{
+					m_stepStats.m_numCcdSweeps++;
+					m_stepStats.m_numCcdClampedMotions += hitFraction < 1.f ? 1 : 0;
+				}
+				if (hitFraction < 1.f)
+				{
+					clampCcdMotion(body, hitFraction, timeStep);
+					continue;
 				}
 			}
 
-
 			body->proceedToTransform( predictedTrans);
 
 		}
 
 	}
 
+	applySpeculativeContactRestitution();
+}
+
+void	btDiscreteDynamicsWorld::applySpeculativeContactRestitution()
+{
 	///this should probably be switched on by default, but it is not well tested yet
 	if (m_applySpeculativeContactRestitution)
 	{
@@ -1117,17 +1313,11 @@ void	btDiscreteDynamicsWorld::integrateTransforms(btScalar timeStep)
 
 }
 
-
-
-
-
-
-void	btDiscreteDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
+void	btDiscreteDynamicsWorld::predictUnconstraintMotionInternal(btRigidBody** bodies, int numBodies, btScalar timeStep)
 {
-	BT_PROFILE("predictUnconstraintMotion");
-	for ( int i=0;i<m_nonStaticRigidBodies.size();i++)
+	for ( int i=0;i<numBodies;i++)
 	{
-		btRigidBody* body = m_nonStaticRigidBodies[i];
+		btRigidBody* body = bodies[i];
 		if (!body->isStaticOrKinematicObject())
 		{
 			//don't integrate/update velocities here, it happens in the constraint solver
@@ -1139,6 +1329,16 @@ void	btDiscreteDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
 	}
 }
 
+void	btDiscreteDynamicsWorld::predictUnconstraintMotion(btScalar timeStep)
+{
+	BT_PROFILE("predictUnconstraintMotion");
+	btAlignedObjectArray<btRigidBody*>& bodies = collectStepRigidBodies();
+	if (bodies.size())
+	{
+		predictUnconstraintMotionInternal(&bodies[0], bodies.size(), timeStep);
+	}
+}
+
 
 void	btDiscreteDynamicsWorld::startProfiling(btScalar timeStep)
 {
@@ -30,7 +30,55 @@ class btIDebugDraw;
 struct InplaceSolverIslandCallback;
 
 #include "LinearMath/btAlignedObjectArray.h"
+#include "BulletDynamics/ConstraintSolver/btConstraintSolver.h"
 
+///number of buckets of btSimulationStepStats::m_islandSizeHistogram
+#define BT_STEP_STATS_ISLAND_HISTOGRAM_SIZE 16
+
+///btSimulationStepStats counts the work done by the last stepSimulation call, see btDiscreteDynamicsWorld::setStepStatsEnabled.
+///The pair, manifold, contact and island counts describe the state after the last substep, the other counters are summed over all substeps.
+struct btSimulationStepStats
+{
+	int	m_numSubSteps;
+	int	m_numOverlappingPairs;
+	int	m_numAddedPairs;
+	int	m_numRemovedPairs;
+	int	m_numManifolds;
+	int	m_numContactPoints;
+	int	m_numIslands;///islands with at least one active body
+	int	m_numIslandBodies;///bodies in those islands
+	int	m_largestIsland;
+	///m_islandSizeHistogram[i] counts the islands with 2^i to 2^(i+1)-1 active bodies, the last bucket also counts all bigger islands
+	int	m_islandSizeHistogram[BT_STEP_STATS_ISLAND_HISTOGRAM_SIZE];
+	int	m_numCcdSweeps;
+	int	m_numCcdClampedMotions;
+	btSolverStatistics	m_solver;
+
+	btSimulationStepStats()
+	{
+		reset();
+	}
+
+	void	reset()
+	{
+		m_numSubSteps = 0;
+		m_numOverlappingPairs = 0;
+		m_numAddedPairs = 0;
+		m_numRemovedPairs = 0;
+		m_numManifolds = 0;
+		m_numContactPoints = 0;
+		m_numIslands = 0;
+		m_numIslandBodies = 0;
+		m_largestIsland = 0;
+		for (int i=0;i<BT_STEP_STATS_ISLAND_HISTOGRAM_SIZE;i++)
+		{
+			m_islandSizeHistogram[i] = 0;
+		}
+		m_numCcdSweeps = 0;
+		m_numCcdClampedMotions = 0;
+		m_solver.reset();
+	}
+};
 
 ///btDiscreteDynamicsWorld provides discrete rigid body simulation
 ///those classes replace the obsolete CcdPhysicsEnvironment/CcdPhysicsController
@@ -49,6 +97,11 @@ protected:
 
 	btAlignedObjectArray<btRigidBody*> m_nonStaticRigidBodies;
 
+	///the non static rigid bodies that are awake, only used when the collision world splits the active objects
+	btAlignedObjectArray<btRigidBody*> m_awakeRigidBodies;
+	///the awake bodies at the start of the substep, updateActivationState stops the ones that fell asleep since
+	btAlignedObjectArray<btRigidBody*> m_substepAwakeRigidBodies;
+
 	btVector3	m_gravity;
 
 	//for variable timesteps
@@ -69,9 +122,41 @@ protected:
 
 	btAlignedObjectArray<btPersistentManifold*>	m_predictiveManifolds;
 
+	bool	m_stepStatsEnabled;
+	btSimulationStepStats	m_stepStats;
+	btAlignedObjectArray<int>	m_stepStatsIslandSizes;
+
+	///counts the manifolds, contact points and awake islands after a substep
+	void	gatherStepStats();
+
+	virtual bool	needsPairChangeCounts() const
+	{
+		return m_stepStatsEnabled || btCollisionWorld::needsPairChangeCounts();
+	}
+
+	///returns the bodies the per body loops of a step visit: m_nonStaticRigidBodies, or with setSplitActiveObjects
+	///only the awake ones, gathered from the active object list each time it is called
+	btAlignedObjectArray<btRigidBody*>&	collectStepRigidBodies();
+
 	virtual void	predictUnconstraintMotion(btScalar timeStep);
+
+	///applies damping and predicts the unconstrained motion of the bodies, each body is only touched by its own iteration
+	void	predictUnconstraintMotionInternal(btRigidBody** bodies, int numBodies, btScalar timeStep);
 	
 	virtual void	integrateTransforms(btScalar timeStep);
+
+	///true if the motion from the current to the predicted transform is large enough to be clamped by a CCD sweep
+	bool	needsCcdMotionClamping(btRigidBody* body, const btTransform& predictedTrans) const;
+
+	///sweeps the ccd swept sphere of the body to the predicted transform and returns the hit fraction, or 1 without a hit.
+	///It only queries the collision world, so sweeps of different bodies can run at the same time. testedMovingBody, if given,
+	///is set when the sweep tested another body that integrateTransforms moves, whose result depends on the order of the moves.
+	btScalar	computeCcdHitFraction(btRigidBody* body, const btTransform& predictedTrans, bool* testedMovingBody = 0);
+
+	///moves the body to the hit fraction of its motion over timeStep
+	void	clampCcdMotion(btRigidBody* body, btScalar hitFraction, btScalar timeStep);
+
+	void	applySpeculativeContactRestitution();
 		
 	virtual void	calculateSimulationIslands();
 
@@ -229,6 +314,24 @@ public:
 	{
 		return m_latencyMotionStateInterpolation;
 	}
+
+	///collect the btSimulationStepStats of each stepSimulation call. Disabled by default, then nothing is counted:
+	///the pair cache and the constraint solver only update their counters while the stats are enabled
+	void	setStepStatsEnabled(bool enable)
+	{
+		m_stepStatsEnabled = enable;
+		m_constraintSolver->setStatisticsEnabled(enable);
+	}
+	bool	isStepStatsEnabled() const
+	{
+		return m_stepStatsEnabled;
+	}
+
+	///the counters of the last stepSimulation call, only filled in when step stats are enabled
+	const btSimulationStepStats&	getStepStats() const
+	{
+		return m_stepStats;
+	}
 };
 
 #endif //BT_DISCRETE_DYNAMICS_WORLD_H
@@ -0,0 +1,617 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "btDiscreteDynamicsWorldMt.h"
+
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+#include "BulletCollision/CollisionDispatch/btCollisionObject.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolver.h"
+#include "BulletDynamics/ConstraintSolver/btTypedConstraint.h"
+#include "BulletDynamics/ConstraintSolver/btContactSolverInfo.h"
+#include "BulletDynamics/Dynamics/btRigidBody.h"
+#include "LinearMath/btQuickprof.h"
+
+extern int gNumClampedCcdMotions;
+
+
+btConstraintSolverPoolMt::btConstraintSolverPoolMt( int numSolvers )
+{
+	btAlignedObjectArray<btConstraintSolver*> solvers;
+	solvers.reserve( numSolvers );
+	for ( int i = 0; i < numSolvers; ++i )
+	{
+		void* mem = btAlignedAlloc( sizeof( btSequentialImpulseConstraintSolver ), 16 );
+		btConstraintSolver* solver = new ( mem ) btSequentialImpulseConstraintSolver();
+		solvers.push_back( solver );
+	}
+	init( &solvers[ 0 ], numSolvers );
+	m_ownsSolvers = true;
+}
+
+btConstraintSolverPoolMt::btConstraintSolverPoolMt( btConstraintSolver** solvers, int numSolvers )
+{
+	init( solvers, numSolvers );
+	m_ownsSolvers = false;
+}
+
+void btConstraintSolverPoolMt::init( btConstraintSolver** solvers, int numSolvers )
+{
+	btAssert( numSolvers > 0 );
+	m_solverType = BT_SEQUENTIAL_IMPULSE_SOLVER;
+	m_solvers.resize( numSolvers );
+	for ( int i = 0; i < numSolvers; ++i )
+	{
+		m_solvers[ i ].m_solver = solvers[ i ];
+	}
+	if ( numSolvers > 0 )
+	{
+		m_solverType = solvers[ 0 ]->getSolverType();
+	}
+}
+
+btConstraintSolverPoolMt::~btConstraintSolverPoolMt()
+{
+	if ( m_ownsSolvers )
+	{
+		for ( int i = 0; i < m_solvers.size(); ++i )
+		{
+			btConstraintSolver* solver = m_solvers[ i ].m_solver;
+			solver->~btConstraintSolver();
+			btAlignedFree( solver );
+		}
+	}
+}
+
+btConstraintSolverPoolMt::ThreadSolver* btConstraintSolverPoolMt::getAndLockThreadSolver()
+{
+	//start with the solver of the current thread, so the threads usually don't compete for the same solver
+	int i = btGetCurrentThreadIndex() % m_solvers.size();
+	while ( true )
+	{
+		ThreadSolver& solver = m_solvers[ i ];
+		if ( btMutexTryLock( &solver.m_mutex ) )
+		{
+			return &solver;
+		}
+		// failed, try the next one
+		i = ( i + 1 ) % m_solvers.size();
+	}
+	return NULL;
+}
+
+void btConstraintSolverPoolMt::prepareSolve( int numBodies, int numManifolds )
+{
+	for ( int i = 0; i < m_solvers.size(); ++i )
+	{
+		m_solvers[ i ].m_solver->prepareSolve( numBodies, numManifolds );
+	}
+}
+
+btScalar btConstraintSolverPoolMt::solveGroup( btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info, btIDebugDraw* debugDrawer, btDispatcher* dispatcher )
+{
+	ThreadSolver* ts = getAndLockThreadSolver();
+	ts->m_solver->solveGroup( bodies, numBodies, manifolds, numManifolds, constraints, numConstraints, info, debugDrawer, dispatcher );
+	btMutexUnlock( &ts->m_mutex );
+	return 0.0f;
+}
+
+void btConstraintSolverPoolMt::allSolved( const btContactSolverInfo& info, btIDebugDraw* debugDrawer )
+{
+	for ( int i = 0; i < m_solvers.size(); ++i )
+	{
+		m_solvers[ i ].m_solver->allSolved( info, debugDrawer );
+	}
+}
+
+void btConstraintSolverPoolMt::reset()
+{
+	for ( int i = 0; i < m_solvers.size(); ++i )
+	{
+		m_solvers[ i ].m_solver->reset();
+	}
+}
+
+void btConstraintSolverPoolMt::accumulateStatistics( btSolverStatistics& stats ) const
+{
+	for ( int i = 0; i < m_solvers.size(); ++i )
+	{
+		m_solvers[ i ].m_solver->accumulateStatistics( stats );
+	}
+}
+
+void btConstraintSolverPoolMt::resetStatistics()
+{
+	for ( int i = 0; i < m_solvers.size(); ++i )
+	{
+		m_solvers[ i ].m_solver->resetStatistics();
+	}
+}
+
+void btConstraintSolverPoolMt::setStatisticsEnabled( bool enable )
+{
+	for ( int i = 0; i < m_solvers.size(); ++i )
+	{
+		m_solvers[ i ].m_solver->setStatisticsEnabled( enable );
+	}
+}
+
+
+
+static SIMD_FORCE_INLINE int btGetConstraintIslandIdMt( const btTypedConstraint* lhs )
+{
+	const btCollisionObject& rcolObj0 = lhs->getRigidBodyA();
+	const btCollisionObject& rcolObj1 = lhs->getRigidBodyB();
+	return rcolObj0.getIslandTag() >= 0 ? rcolObj0.getIslandTag() : rcolObj1.getIslandTag();
+}
+
+
+class btSortConstraintOnIslandPredicateMt
+{
+public:
+
+	bool operator() ( const btTypedConstraint* lhs, const btTypedConstraint* rhs ) const
+	{
+		return btGetConstraintIslandIdMt( lhs ) < btGetConstraintIslandIdMt( rhs );
+	}
+};
+
+
+///ParallelSolverIslandCallback collects the islands while btSimulationIslandManager walks them,
+///then groups them into batches that are solved with btParallelFor
+struct ParallelSolverIslandCallback : public btSimulationIslandManager::IslandCallback
+{
+	struct Island
+	{
+		int m_id;
+		int m_bodyStart;
+		int m_numBodies;
+		int m_manifoldStart;
+		int m_numManifolds;
+		int m_constraintStart;
+		int m_numConstraints;
+
+		int getSolverSize() const
+		{
+			return m_numManifolds + m_numConstraints;
+		}
+	};
+
+	btContactSolverInfo*	m_solverInfo;
+	btConstraintSolver*		m_solver;
+	btTypedConstraint**		m_sortedConstraints;
+	int						m_numConstraints;
+	int						m_constraintCursor;
+	btIDebugDraw*			m_debugDrawer;
+	btDispatcher*			m_dispatcher;
+
+	btAlignedObjectArray<Island> m_islands;
+	btAlignedObjectArray<btCollisionObject*> m_islandBodies;
+	btAlignedObjectArray<btPersistentManifold*> m_islandManifolds;
+	btAlignedObjectArray<btTypedConstraint*> m_islandConstraints;
+
+	//the islands of a batch are copied next to each other, so a batch can be passed to solveGroup as one group
+	btAlignedObjectArray<Island> m_batches;
+	btAlignedObjectArray<btCollisionObject*> m_batchBodies;
+	btAlignedObjectArray<btPersistentManifold*> m_batchManifolds;
+	btAlignedObjectArray<btTypedConstraint*> m_batchConstraints;
+
+	ParallelSolverIslandCallback( btConstraintSolver* solver, btDispatcher* dispatcher )
+		:m_solverInfo( NULL ),
+		m_solver( solver ),
+		m_sortedConstraints( NULL ),
+		m_numConstraints( 0 ),
+		m_constraintCursor( 0 ),
+		m_debugDrawer( NULL ),
+		m_dispatcher( dispatcher )
+	{
+	}
+
+	ParallelSolverIslandCallback& operator=( ParallelSolverIslandCallback& other )
+	{
+		btAssert( 0 );
+		(void) other;
+		return *this;
+	}
+
+	SIMD_FORCE_INLINE void setup( btContactSolverInfo* solverInfo, btTypedConstraint** sortedConstraints, int numConstraints, btIDebugDraw* debugDrawer )
+	{
+		btAssert( solverInfo );
+		m_solverInfo = solverInfo;
+		m_sortedConstraints = sortedConstraints;
+		m_numConstraints = numConstraints;
+		m_constraintCursor = 0;
+		m_debugDrawer = debugDrawer;
+		m_islands.resize( 0 );
+		m_islandBodies.resize( 0 );
+		m_islandManifolds.resize( 0 );
+		m_islandConstraints.resize( 0 );
+	}
+
+	virtual	void processIsland( btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, int islandId )
+	{
+		if ( islandId < 0 )
+		{
+			///we don't split islands, so all constraints/contact manifolds/bodies are passed into the solver regardless the island id
+			m_solver->solveGroup( bodies, numBodies, manifolds, numManifolds, m_sortedConstraints, m_numConstraints, *m_solverInfo, m_debugDrawer, m_dispatcher );
+			return;
+		}
+
+		Island island;
+		island.m_id = islandId;
+		island.m_bodyStart = m_islandBodies.size();
+		island.m_numBodies = numBodies;
+		island.m_manifoldStart = m_islandManifolds.size();
+		island.m_numManifolds = numManifolds;
+		island.m_constraintStart = m_islandConstraints.size();
+
+		int i;
+		for ( i = 0; i < numBodies; i++ )
+			m_islandBodies.push_back( bodies[ i ] );
+		for ( i = 0; i < numManifolds; i++ )
+			m_islandManifolds.push_back( manifolds[ i ] );
+
+		//islands are visited in increasing id order, the same order as the sorted constraints,
+		//so the constraints of all islands are found in a single pass
+		while ( m_constraintCursor < m_numConstraints && btGetConstraintIslandIdMt( m_sortedConstraints[ m_constraintCursor ] ) < islandId )
+		{
+			m_constraintCursor++;
+		}
+		while ( m_constraintCursor < m_numConstraints && btGetConstraintIslandIdMt( m_sortedConstraints[ m_constraintCursor ] ) == islandId )
+		{
+			m_islandConstraints.push_back( m_sortedConstraints[ m_constraintCursor ] );
+			m_constraintCursor++;
+		}
+		island.m_numConstraints = m_islandConstraints.size() - island.m_constraintStart;
+
+		m_islands.push_back( island );
+	}
+
+	class IslandSortPredicate
+	{
+	public:
+		bool operator() ( const Island& lhs, const Island& rhs ) const
+		{
+			//largest first, ties are broken by island id to keep the batches deterministic
+			if ( lhs.getSolverSize() != rhs.getSolverSize() )
+			{
+				return lhs.getSolverSize() > rhs.getSolverSize();
+			}
+			return lhs.m_id < rhs.m_id;
+		}
+	};
+
+	void appendIslandToBatch( const Island& island, Island& batch )
+	{
+		int i;
+		for ( i = 0; i < island.m_numBodies; i++ )
+			m_batchBodies.push_back( m_islandBodies[ island.m_bodyStart + i ] );
+		for ( i = 0; i < island.m_numManifolds; i++ )
+			m_batchManifolds.push_back( m_islandManifolds[ island.m_manifoldStart + i ] );
+		for ( i = 0; i < island.m_numConstraints; i++ )
+			m_batchConstraints.push_back( m_islandConstraints[ island.m_constraintStart + i ] );
+		batch.m_numBodies += island.m_numBodies;
+		batch.m_numManifolds += island.m_numManifolds;
+		batch.m_numConstraints += island.m_numConstraints;
+	}
+
+	void buildBatches()
+	{
+		BT_PROFILE( "buildBatches" );
+		m_islands.quickSort( IslandSortPredicate() );
+
+		m_batches.resize( 0 );
+		m_batchBodies.resize( 0 );
+		m_batchManifolds.resize( 0 );
+		m_batchConstraints.resize( 0 );
+
+		Island* batch = NULL;
+		for ( int i = 0; i < m_islands.size(); i++ )
+		{
+			if ( batch == NULL )
+			{
+				batch = &m_batches.expandNonInitializing();
+				batch->m_id = m_batches.size() - 1;
+				batch->m_bodyStart = m_batchBodies.size();
+				batch->m_manifoldStart = m_batchManifolds.size();
+				batch->m_constraintStart = m_batchConstraints.size();
+				batch->m_numBodies = 0;
+				batch->m_numManifolds = 0;
+				batch->m_numConstraints = 0;
+			}
+			appendIslandToBatch( m_islands[ i ], *batch );
+			//large islands end up alone in a batch, small ones are merged until the batch is big enough
+			if ( batch->getSolverSize() > m_solverInfo->m_minimumSolverBatchSize )
+			{
+				batch = NULL;
+			}
+		}
+	}
+
+	struct SolveBatchLoop : public btIParallelForBody
+	{
+		ParallelSolverIslandCallback* m_callback;
+
+		SolveBatchLoop( ParallelSolverIslandCallback* callback ) : m_callback( callback ) {}
+
+		void forLoop( int iBegin, int iEnd ) const
+		{
+			for ( int i = iBegin; i < iEnd; ++i )
+			{
+				m_callback->solveBatch( m_callback->m_batches[ i ] );
+			}
+		}
+	};
+
+	void solveBatch( const Island& batch )
+	{
+		btCollisionObject** bodies = batch.m_numBodies ? &m_batchBodies[ batch.m_bodyStart ] : 0;
+		btPersistentManifold** manifolds = batch.m_numManifolds ? &m_batchManifolds[ batch.m_manifoldStart ] : 0;
+		btTypedConstraint** constraints = batch.m_numConstraints ? &m_batchConstraints[ batch.m_constraintStart ] : 0;
+		m_solver->solveGroup( bodies, batch.m_numBodies, manifolds, batch.m_numManifolds, constraints, batch.m_numConstraints, *m_solverInfo, m_debugDrawer, m_dispatcher );
+	}
+
+	void processConstraints()
+	{
+		if ( m_islands.size() == 0 )
+		{
+			return;
+		}
+		buildBatches();
+
+		BT_PROFILE( "solveBatches" );
+		//the batches are already sorted largest first, one batch per task gives the best load balance
+		SolveBatchLoop loop( this );
+		btParallelFor( 0, m_batches.size(), 1, loop );
+	}
+};
+
+
+
+btDiscreteDynamicsWorldMt::btDiscreteDynamicsWorldMt(btDispatcher* dispatcher,
+	btBroadphaseInterface* pairCache,
+	btConstraintSolverPoolMt* constraintSolver,
+	btCollisionConfiguration* collisionConfiguration)
+:btDiscreteDynamicsWorld(dispatcher,pairCache,constraintSolver,collisionConfiguration)
+{
+	void* mem = btAlignedAlloc( sizeof( ParallelSolverIslandCallback ), 16 );
+	m_parallelSolverIslandCallback = new ( mem ) ParallelSolverIslandCallback( m_constraintSolver, dispatcher );
+}
+
+
+btDiscreteDynamicsWorldMt::~btDiscreteDynamicsWorldMt()
+{
+	if ( m_parallelSolverIslandCallback )
+	{
+		m_parallelSolverIslandCallback->~ParallelSolverIslandCallback();
+		btAlignedFree( m_parallelSolverIslandCallback );
+	}
+}
+
+
+void btDiscreteDynamicsWorldMt::solveConstraints(btContactSolverInfo& solverInfo)
+{
+	BT_PROFILE("solveConstraints");
+
+	m_sortedConstraints.resize( m_constraints.size() );
+	for ( int i = 0; i < getNumConstraints(); i++ )
+	{
+		m_sortedConstraints[ i ] = m_constraints[ i ];
+	}
+	m_sortedConstraints.quickSort( btSortConstraintOnIslandPredicateMt() );
+
+	btTypedConstraint** constraintsPtr = getNumConstraints() ? &m_sortedConstraints[ 0 ] : 0;
+
+	//the solver may have been replaced with setConstraintSolver
+	m_parallelSolverIslandCallback->m_solver = m_constraintSolver;
+	m_parallelSolverIslandCallback->setup( &solverInfo, constraintsPtr, m_sortedConstraints.size(), getDebugDrawer() );
+	m_constraintSolver->prepareSolve( getCollisionWorld()->getNumCollisionObjects(), getCollisionWorld()->getDispatcher()->getNumManifolds() );
+
+	/// gather the islands, then solve them in parallel
+	m_islandManager->buildAndProcessIslands( getCollisionWorld()->getDispatcher(), getCollisionWorld(), m_parallelSolverIslandCallback );
+
+	m_parallelSolverIslandCallback->processConstraints();
+
+	m_constraintSolver->allSolved( solverInfo, m_debugDrawer );
+}
+
+
+void btDiscreteDynamicsWorldMt::predictUnconstraintMotion( btScalar timeStep )
+{
+	BT_PROFILE( "predictUnconstraintMotion" );
+
+	struct UpdaterUnconstrainedMotion : public btIParallelForBody
+	{
+		btDiscreteDynamicsWorldMt* m_world;
+		btRigidBody** m_bodies;
+		btScalar m_timeStep;
+
+		void forLoop( int iBegin, int iEnd ) const
+		{
+			m_world->predictUnconstraintMotionInternal( &m_bodies[ iBegin ], iEnd - iBegin, m_timeStep );
+		}
+	};
+
+	btAlignedObjectArray<btRigidBody*>& bodies = collectStepRigidBodies();
+	int numBodies = bodies.size();
+	if ( numBodies == 0 )
+	{
+		return;
+	}
+	UpdaterUnconstrainedMotion update;
+	update.m_world = this;
+	update.m_bodies = &bodies[ 0 ];
+	update.m_timeStep = timeStep;
+	btParallelFor( 0, numBodies, 64, update );
+}
+
+
+void btDiscreteDynamicsWorldMt::integrateTransforms( btScalar timeStep )
+{
+	BT_PROFILE( "integrateTransforms" );
+
+	//predicts the transform of every body and marks the ones that need CCD motion clamping, no body moves yet
+	struct UpdaterPredictTransforms : public btIParallelForBody
+	{
+		btDiscreteDynamicsWorldMt* m_world;
+		btRigidBody** m_bodies;
+		btScalar m_timeStep;
+
+		void forLoop( int iBegin, int iEnd ) const
+		{
+			for ( int i = iBegin; i < iEnd; ++i )
+			{
+				btRigidBody* body = m_bodies[ i ];
+				body->setHitFraction( 1.f );
+				int motion = BT_NO_MOTION;
+				if ( body->isActive() && ( !body->isStaticOrKinematicObject() ) )
+				{
+					body->predictIntegratedTransform( m_timeStep, m_world->m_predictedTransforms[ i ] );
+					motion = m_world->needsCcdMotionClamping( body, m_world->m_predictedTransforms[ i ] ) ? BT_CCD_MOTION : BT_FREE_MOTION;
+				}
+				m_world->m_bodyMotions[ i ] = motion;
+			}
+		}
+	};
+
+	//sweeps run before any body moves, a sweep that only tests bodies which don't move gives the same result as in the serial loop
+	struct UpdaterCcdSweeps : public btIParallelForBody
+	{
+		btDiscreteDynamicsWorldMt* m_world;
+		btRigidBody** m_bodies;
+
+		void forLoop( int iBegin, int iEnd ) const
+		{
+			for ( int i = iBegin; i < iEnd; ++i )
+			{
+				int bodyIndex = m_world->m_ccdBodyIndices[ i ];
+				bool testedMovingBody = false;
+				m_world->m_ccdHitFractions[ i ] = m_world->computeCcdHitFraction( m_bodies[ bodyIndex ], m_world->m_predictedTransforms[ bodyIndex ], &testedMovingBody );
+				m_world->m_ccdOrderDependent[ i ] = testedMovingBody ? 1 : 0;
+			}
+		}
+	};
+
+	struct UpdaterMotions : public btIParallelForBody
+	{
+		btDiscreteDynamicsWorldMt* m_world;
+		btRigidBody** m_bodies;
+		btScalar m_timeStep;
+
+		void forLoop( int iBegin, int iEnd ) const
+		{
+			for ( int i = iBegin; i < iEnd; ++i )
+			{
+				m_world->applyMotion( m_bodies[ i ], i, m_timeStep );
+			}
+		}
+	};
+
+	btAlignedObjectArray<btRigidBody*>& bodies = collectStepRigidBodies();
+	int numBodies = bodies.size();
+	if ( numBodies == 0 )
+	{
+		applySpeculativeContactRestitution();
+		return;
+	}
+	m_predictedTransforms.resizeNoInitialize( numBodies );
+	m_bodyMotions.resizeNoInitialize( numBodies );
+
+	UpdaterPredictTransforms predict;
+	predict.m_world = this;
+	predict.m_bodies = &bodies[ 0 ];
+	predict.m_timeStep = timeStep;
+	btParallelFor( 0, numBodies, 64, predict );
+
+	//the CCD bodies in the order of the serial loop, each marked with its slot
+	m_ccdBodyIndices.resize( 0 );
+	for ( int i = 0; i < numBodies; ++i )
+	{
+		if ( m_bodyMotions[ i ] == BT_CCD_MOTION )
+		{
+			m_bodyMotions[ i ] = m_ccdBodyIndices.size();
+			m_ccdBodyIndices.push_back( i );
+		}
+	}
+
+	//bodies before the first sweep that depends on the order of the moves can move in parallel
+	int numParallelBodies = numBodies;
+	int numCcdBodies = m_ccdBodyIndices.size();
+	if ( numCcdBodies )
+	{
+		BT_PROFILE( "CCD motion clamping" );
+		gNumClampedCcdMotions += numCcdBodies;
+		m_ccdHitFractions.resizeNoInitialize( numCcdBodies );
+		m_ccdOrderDependent.resizeNoInitialize( numCcdBodies );
+
+		UpdaterCcdSweeps sweeps;
+		sweeps.m_world = this;
+		sweeps.m_bodies = &bodies[ 0 ];
+		btParallelFor( 0, numCcdBodies, 4, sweeps );
+
+		for ( int i = 0; i < numCcdBodies; ++i )
+		{
+			if ( m_ccdOrderDependent[ i ] )
+			{
+				numParallelBodies = m_ccdBodyIndices[ i ];
+				break;
+			}
+		}
+	}
+
+	UpdaterMotions motions;
+	motions.m_world = this;
+	motions.m_bodies = &bodies[ 0 ];
+	motions.m_timeStep = timeStep;
+	btParallelFor( 0, numParallelBodies, 64, motions );
+
+	//from there on the serial order is kept, and sweeps that tested moving bodies are done again once the bodies before them moved
+	for ( int i = numParallelBodies; i < numBodies; ++i )
+	{
+		int ccdIndex = m_bodyMotions[ i ];
+		if ( ccdIndex >= 0 && m_ccdOrderDependent[ ccdIndex ] )
+		{
+			m_ccdHitFractions[ ccdIndex ] = computeCcdHitFraction( bodies[ i ], m_predictedTransforms[ i ] );
+		}
+		applyMotion( bodies[ i ], i, timeStep );
+	}
+
+	if ( m_stepStatsEnabled )
+	{
+		m_stepStats.m_numCcdSweeps += numCcdBodies;
+		for ( int i = 0; i < numCcdBodies; ++i )
+		{
+			m_stepStats.m_numCcdClampedMotions += m_ccdHitFractions[ i ] < 1.f ? 1 : 0;
+		}
+	}
+
+	applySpeculativeContactRestitution();
+}
+
+
+void btDiscreteDynamicsWorldMt::applyMotion( btRigidBody* body, int bodyIndex, btScalar timeStep )
+{
+	int motion = m_bodyMotions[ bodyIndex ];
+	if ( motion == BT_NO_MOTION )
+	{
+		return;
+	}
+	if ( motion >= 0 && m_ccdHitFractions[ motion ] < 1.f )
+	{
+		clampCcdMotion( body, m_ccdHitFractions[ motion ], timeStep );
+		return;
+	}
+	body->proceedToTransform( m_predictedTransforms[ bodyIndex ] );
+}
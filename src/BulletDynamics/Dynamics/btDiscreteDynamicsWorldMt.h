@@ -0,0 +1,131 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#ifndef BT_DISCRETE_DYNAMICS_WORLD_MT_H
+#define BT_DISCRETE_DYNAMICS_WORLD_MT_H
+
+#include "btDiscreteDynamicsWorld.h"
+#include "BulletDynamics/ConstraintSolver/btConstraintSolver.h"
+#include "LinearMath/btThreads.h"
+
+struct ParallelSolverIslandCallback;
+
+
+///btConstraintSolverPoolMt owns a set of constraint solvers and hands out an unused one to each
+///solveGroup call, so that independent islands can be solved at the same time.
+ATTRIBUTE_ALIGNED16(class) btConstraintSolverPoolMt : public btConstraintSolver
+{
+public:
+	///creates numSolvers btSequentialImpulseConstraintSolver instances
+	btConstraintSolverPoolMt( int numSolvers );
+
+	///uses the given solvers, they must all be of the same type and are not deleted by the pool
+	btConstraintSolverPoolMt( btConstraintSolver** solvers, int numSolvers );
+
+	virtual ~btConstraintSolverPoolMt();
+
+	virtual void prepareSolve( int numBodies, int numManifolds );
+
+	///solve a group of constraints with the first solver that isn't busy
+	virtual btScalar solveGroup( btCollisionObject** bodies, int numBodies, btPersistentManifold** manifolds, int numManifolds, btTypedConstraint** constraints, int numConstraints, const btContactSolverInfo& info, btIDebugDraw* debugDrawer, btDispatcher* dispatcher );
+
+	virtual void allSolved( const btContactSolverInfo& info, btIDebugDraw* debugDrawer );
+
+	///clear internal cached data and reset random seed
+	virtual void reset();
+
+	virtual btConstraintSolverType getSolverType() const
+	{
+		return m_solverType;
+	}
+
+	///adds the statistics of all solvers in the pool
+	virtual void accumulateStatistics( btSolverStatistics& stats ) const;
+
+	virtual void resetStatistics();
+
+	virtual void setStatisticsEnabled( bool enable );
+
+	int getNumSolvers() const
+	{
+		return m_solvers.size();
+	}
+
+private:
+	ATTRIBUTE_ALIGNED16(struct) ThreadSolver
+	{
+		btConstraintSolver* m_solver;
+		btSpinMutex m_mutex;
+	};
+	btConstraintSolverType m_solverType;
+	btAlignedObjectArray<ThreadSolver> m_solvers;
+	bool m_ownsSolvers;
+
+	void init( btConstraintSolver** solvers, int numSolvers );
+	ThreadSolver* getAndLockThreadSolver();
+};
+
+
+///btDiscreteDynamicsWorldMt solves the simulation islands in parallel.
+///Islands are sorted by size and the largest ones are dispatched first, islands that are smaller than
+///btContactSolverInfo::m_minimumSolverBatchSize are merged into batches. Each batch is solved by one of the
+///solvers of the btConstraintSolverPoolMt. predictUnconstraintMotion and integrateTransforms are parallel loops
+///over the bodies, the other stages of the step are inherited from btDiscreteDynamicsWorld.
+ATTRIBUTE_ALIGNED16(class) btDiscreteDynamicsWorldMt : public btDiscreteDynamicsWorld
+{
+protected:
+	ParallelSolverIslandCallback*	m_parallelSolverIslandCallback;
+
+	enum
+	{
+		BT_FREE_MOTION = -1,
+		BT_NO_MOTION = -2,
+		BT_CCD_MOTION = -3
+	};
+
+	///predicted transform of each body in integrateTransforms, and its motion: BT_NO_MOTION, BT_FREE_MOTION or the slot of its CCD sweep
+	btAlignedObjectArray<btTransform>	m_predictedTransforms;
+	btAlignedObjectArray<int>			m_bodyMotions;
+	///bodies that need CCD motion clamping in the order of the serial loop, with their hit fraction and whether the sweep tested moving bodies
+	btAlignedObjectArray<int>			m_ccdBodyIndices;
+	btAlignedObjectArray<btScalar>		m_ccdHitFractions;
+	btAlignedObjectArray<int>			m_ccdOrderDependent;
+
+	virtual void	solveConstraints(btContactSolverInfo& solverInfo);
+
+	virtual void	predictUnconstraintMotion(btScalar timeStep);
+
+	///integrates the bodies in parallel, with the same results as the serial loop of btDiscreteDynamicsWorld. The CCD sweeps
+	///run in parallel before any body moves. A sweep that tested a moving body depends on which bodies moved before it in the
+	///serial loop, so from the first such body on the bodies move in order and those sweeps are done again.
+	virtual void	integrateTransforms(btScalar timeStep);
+
+	///moves the body to its predicted transform, or clamps its motion to the hit fraction of its CCD sweep
+	void	applyMotion(btRigidBody* body, int bodyIndex, btScalar timeStep);
+
+public:
+
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	btDiscreteDynamicsWorldMt(btDispatcher* dispatcher,
+		btBroadphaseInterface* pairCache,
+		btConstraintSolverPoolMt* constraintSolver,
+		btCollisionConfiguration* collisionConfiguration);
+
+	virtual ~btDiscreteDynamicsWorldMt();
+};
+
+#endif //BT_DISCRETE_DYNAMICS_WORLD_MT_H
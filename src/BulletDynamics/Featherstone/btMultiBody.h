@@ -460,6 +460,16 @@ void addJointTorque(int i, btScalar Q);
     void wakeUp();
     void goToSleep();
     void checkMotionAndSleepIfRequired(btScalar timestep);
+
+	///time the multibody has been moving slowly enough to fall asleep
+	btScalar getSleepTimer() const
+	{
+		return m_sleepTimer;
+	}
+	void setSleepTimer(btScalar sleepTimer)
+	{
+		m_sleepTimer = sleepTimer;
+	}
     
 	bool hasFixedBase() const
 	{
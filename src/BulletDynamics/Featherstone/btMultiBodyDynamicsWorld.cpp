@@ -387,6 +387,7 @@ btMultiBodyDynamicsWorld::btMultiBodyDynamicsWorld(btDispatcher* dispatcher,btBr
 	getSolverInfo().m_splitImpulse = false;
 	getSolverInfo().m_solverMode |=SOLVER_USE_2_FRICTION_DIRECTIONS;
 	m_solverMultiBodyIslandCallback = new MultiBodyInplaceSolverIslandCallback(constraintSolver,dispatcher);
+	m_multiBodyGrainSize = 16;
 }
 
 btMultiBodyDynamicsWorld::~btMultiBodyDynamicsWorld ()
@@ -394,25 +395,290 @@ btMultiBodyDynamicsWorld::~btMultiBodyDynamicsWorld ()
 	delete m_solverMultiBodyIslandCallback;
 }
 
-void	btMultiBodyDynamicsWorld::forwardKinematics()
+static bool isMultiBodySleeping(const btMultiBody* bod)
 {
-	btAlignedObjectArray<btQuaternion> world_to_local;
-	btAlignedObjectArray<btVector3> local_origin;
+	if (bod->getBaseCollider() && bod->getBaseCollider()->getActivationState() == ISLAND_SLEEPING)
+	{
+		return true;
+	}
+	for (int b=0;b<bod->getNumLinks();b++)
+	{
+		if (bod->getLink(b).m_collider && bod->getLink(b).m_collider->getActivationState()==ISLAND_SLEEPING)
+			return true;
+	}
+	return false;
+}
 
-	for (int b=0;b<m_multiBodies.size();b++)
+static void stepVelocitiesRK4(btMultiBody* bod, btScalar h, btMultiBodyScratchBuffers& scratch)
+{
+	btAlignedObjectArray<btScalar>& scratch_r = scratch.m_scratch_r;
+	btAlignedObjectArray<btVector3>& scratch_v = scratch.m_scratch_v;
+	btAlignedObjectArray<btMatrix3x3>& scratch_m = scratch.m_scratch_m;
+	bool doNotUpdatePos = false;
+
+	//
+	int numDofs = bod->getNumDofs() + 6;
+	int numPosVars = bod->getNumPosVars() + 7;
+	btAlignedObjectArray<btScalar>& scratch_r2 = scratch.m_scratch_r2; scratch_r2.resize(2*numPosVars + 8*numDofs);
+	//convenience
+	btScalar *pMem = &scratch_r2[0];
+	btScalar *scratch_q0 = pMem; pMem += numPosVars;
+	btScalar *scratch_qx = pMem; pMem += numPosVars;
+	btScalar *scratch_qd0 = pMem; pMem += numDofs;
+	btScalar *scratch_qd1 = pMem; pMem += numDofs;
+	btScalar *scratch_qd2 = pMem; pMem += numDofs;
+	btScalar *scratch_qd3 = pMem; pMem += numDofs;
+	btScalar *scratch_qdd0 = pMem; pMem += numDofs;
+	btScalar *scratch_qdd1 = pMem; pMem += numDofs;
+	btScalar *scratch_qdd2 = pMem; pMem += numDofs;
+	btScalar *scratch_qdd3 = pMem; pMem += numDofs;
+	btAssert((pMem - (2*numPosVars + 8*numDofs)) == &scratch_r2[0]);
+
+	/////
+	//copy q0 to scratch_q0 and qd0 to scratch_qd0
+	scratch_q0[0] = bod->getWorldToBaseRot().x();
+	scratch_q0[1] = bod->getWorldToBaseRot().y();
+	scratch_q0[2] = bod->getWorldToBaseRot().z();
+	scratch_q0[3] = bod->getWorldToBaseRot().w();
+	scratch_q0[4] = bod->getBasePos().x();
+	scratch_q0[5] = bod->getBasePos().y();
+	scratch_q0[6] = bod->getBasePos().z();
+	//
+	for(int link = 0; link < bod->getNumLinks(); ++link)
+	{
+		for(int dof = 0; dof < bod->getLink(link).m_posVarCount; ++dof)
+			scratch_q0[7 + bod->getLink(link).m_cfgOffset + dof] = bod->getLink(link).m_jointPos[dof];
+	}
+	//
+	for(int dof = 0; dof < numDofs; ++dof)
+		scratch_qd0[dof] = bod->getVelocityVector()[dof];
+	////
+	struct
+	{
+		btMultiBody *bod;
+		btScalar *scratch_qx, *scratch_q0;
+
+		void operator()()
+		{
+			for(int dof = 0; dof < bod->getNumPosVars() + 7; ++dof)
+				scratch_qx[dof] = scratch_q0[dof];
+		}
+	} pResetQx = {bod, scratch_qx, scratch_q0};
+	//
+	struct
+	{
+		void operator()(btScalar dt, const btScalar *pDer, const btScalar *pCurVal, btScalar *pVal, int size)
+		{
+			for(int i = 0; i < size; ++i)
+				pVal[i] = pCurVal[i] + dt * pDer[i];
+		}
+
+	} pEulerIntegrate;
+	//
+	struct
+	{
+		void operator()(btMultiBody *pBody, const btScalar *pData)
+		{
+			btScalar *pVel = const_cast<btScalar*>(pBody->getVelocityVector());
+
+			for(int i = 0; i < pBody->getNumDofs() + 6; ++i)
+				pVel[i] = pData[i];
+
+		}
+	} pCopyToVelocityVector;
+	//
+	struct
+	{
+		void operator()(const btScalar *pSrc, btScalar *pDst, int start, int size)
+		{
+			for(int i = 0; i < size; ++i)
+				pDst[i] = pSrc[start + i];
+		}
+	} pCopy;
+	//
+
+	#define output &scratch_r[bod->getNumDofs()]
+	//calc qdd0 from: q0 & qd0
+	bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
+	pCopy(output, scratch_qdd0, 0, numDofs);
+	//calc q1 = q0 + h/2 * qd0
+	pResetQx();
+	bod->stepPositionsMultiDof(btScalar(.5)*h, scratch_qx, scratch_qd0);
+	//calc qd1 = qd0 + h/2 * qdd0
+	pEulerIntegrate(btScalar(.5)*h, scratch_qdd0, scratch_qd0, scratch_qd1, numDofs);
+	//
+	//calc qdd1 from: q1 & qd1
+	pCopyToVelocityVector(bod, scratch_qd1);
+	bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
+	pCopy(output, scratch_qdd1, 0, numDofs);
+	//calc q2 = q0 + h/2 * qd1
+	pResetQx();
+	bod->stepPositionsMultiDof(btScalar(.5)*h, scratch_qx, scratch_qd1);
+	//calc qd2 = qd0 + h/2 * qdd1
+	pEulerIntegrate(btScalar(.5)*h, scratch_qdd1, scratch_qd0, scratch_qd2, numDofs);
+	//
+	//calc qdd2 from: q2 & qd2
+	pCopyToVelocityVector(bod, scratch_qd2);
+	bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
+	pCopy(output, scratch_qdd2, 0, numDofs);
+	//calc q3 = q0 + h * qd2
+	pResetQx();
+	bod->stepPositionsMultiDof(h, scratch_qx, scratch_qd2);
+	//calc qd3 = qd0 + h * qdd2
+	pEulerIntegrate(h, scratch_qdd2, scratch_qd0, scratch_qd3, numDofs);
+	//
+	//calc qdd3 from: q3 & qd3
+	pCopyToVelocityVector(bod, scratch_qd3);
+	bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
+	pCopy(output, scratch_qdd3, 0, numDofs);
+	#undef output
+
+	//
+	//calc q = q0 + h/6(qd0 + 2*(qd1 + qd2) + qd3)
+	//calc qd = qd0 + h/6(qdd0 + 2*(qdd1 + qdd2) + qdd3)
+	btAlignedObjectArray<btScalar>& delta_q = scratch.m_delta_q; delta_q.resize(numDofs);
+	btAlignedObjectArray<btScalar>& delta_qd = scratch.m_delta_qd; delta_qd.resize(numDofs);
+	for(int i = 0; i < numDofs; ++i)
 	{
-		btMultiBody* bod = m_multiBodies[b];
-		bod->forwardKinematics(world_to_local,local_origin);
+		delta_q[i] = h/btScalar(6.)*(scratch_qd0[i] + 2*scratch_qd1[i] + 2*scratch_qd2[i] + scratch_qd3[i]);
+		delta_qd[i] = h/btScalar(6.)*(scratch_qdd0[i] + 2*scratch_qdd1[i] + 2*scratch_qdd2[i] + scratch_qdd3[i]);
+		//delta_q[i] = h*scratch_qd0[i];
+		//delta_qd[i] = h*scratch_qdd0[i];
+	}
+	//
+	pCopyToVelocityVector(bod, scratch_qd0);
+	bod->applyDeltaVeeMultiDof(&delta_qd[0], 1);
+	//
+	if(!doNotUpdatePos)
+	{
+		btScalar *pRealBuf = const_cast<btScalar *>(bod->getVelocityVector());
+		pRealBuf += 6 + bod->getNumDofs() + bod->getNumDofs()*bod->getNumDofs();
+
+		for(int i = 0; i < numDofs; ++i)
+			pRealBuf[i] = delta_q[i];
+
+		//bod->stepPositionsMultiDof(1, 0, &delta_q[0]);
+		bod->setPosUpdated(true);
+	}
+
+	//ugly hack which resets the cached data to t0 (needed for constraint solver)
+	{
+		for(int link = 0; link < bod->getNumLinks(); ++link)
+			bod->getLink(link).updateCacheMultiDof();
+		bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0, scratch_r, scratch_v, scratch_m);
 	}
 }
-void	btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
+
+///runs one of the per-multibody passes of btMultiBodyDynamicsWorld, the multibodies are independent of each other
+///so each thread just needs its own scratch buffers
+struct btMultiBodyPassLoop : public btIParallelForBody
 {
-	forwardKinematics();
+	enum Pass
+	{
+		FORWARD_KINEMATICS,
+		STEP_VELOCITIES,
+		CONSTRAINT_PASS,
+		STEP_POSITIONS
+	};
+
+	btMultiBody**				m_bodies;
+	btMultiBodyScratchBuffers*	m_scratchBuffers;
+	Pass						m_pass;
+	btScalar					m_timeStep;
+
+	void forLoop( int iBegin, int iEnd ) const
+	{
+		btMultiBodyScratchBuffers& scratch = m_scratchBuffers[btGetCurrentThreadIndex()];
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			btMultiBody* bod = m_bodies[i];
+			switch (m_pass)
+			{
+			case FORWARD_KINEMATICS:
+				{
+					bod->forwardKinematics(scratch.m_world_to_local,scratch.m_local_origin);
+					break;
+				}
+			case STEP_VELOCITIES:
+				{
+					if (!isMultiBodySleeping(bod))
+					{
+						scratch.reset(bod->getNumLinks()+1);
+						if(!bod->isUsingRK4Integration())
+						{
+							bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(m_timeStep, scratch.m_scratch_r, scratch.m_scratch_v, scratch.m_scratch_m);
+						}
+						else
+						{
+							stepVelocitiesRK4(bod, m_timeStep, scratch);
+						}
+#ifndef BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
+						bod->clearForcesAndTorques();
+#endif //BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
+					}
+					break;
+				}
+			case CONSTRAINT_PASS:
+				{
+					if (!isMultiBodySleeping(bod) && !bod->isUsingRK4Integration())
+					{
+						scratch.reset(bod->getNumLinks()+1);
+						bool isConstraintPass = true;
+						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(m_timeStep, scratch.m_scratch_r, scratch.m_scratch_v, scratch.m_scratch_m, isConstraintPass);
+					}
+					bod->processDeltaVeeMultiDof2();
+					break;
+				}
+			case STEP_POSITIONS:
+				{
+					if (!isMultiBodySleeping(bod))
+					{
+						if(!bod->isPosUpdated())
+							bod->stepPositionsMultiDof(m_timeStep);
+						else
+						{
+							btScalar *pRealBuf = const_cast<btScalar *>(bod->getVelocityVector());
+							pRealBuf += 6 + bod->getNumDofs() + bod->getNumDofs()*bod->getNumDofs();
+
+							bod->stepPositionsMultiDof(1, 0, pRealBuf);
+							bod->setPosUpdated(false);
+						}
+
+						bod->updateCollisionObjectWorldTransforms(scratch.m_world_to_local,scratch.m_local_origin);
+					}
+					else
+					{
+						bod->clearVelocities();
+					}
+					break;
+				}
+			}
+		}
+	}
+};
 
-	btAlignedObjectArray<btScalar> scratch_r;
-	btAlignedObjectArray<btVector3> scratch_v;
-	btAlignedObjectArray<btMatrix3x3> scratch_m;
+void	btMultiBodyDynamicsWorld::runMultiBodyPass(int pass, btScalar timeStep)
+{
+	if (m_multiBodies.size() == 0)
+	{
+		return;
+	}
+	btMultiBodyPassLoop loop;
+	loop.m_bodies = &m_multiBodies[0];
+	loop.m_scratchBuffers = m_scratchBuffers;
+	loop.m_pass = btMultiBodyPassLoop::Pass(pass);
+	loop.m_timeStep = timeStep;
+	btParallelFor(0, m_multiBodies.size(), m_multiBodyGrainSize, loop);
+}
 
+void	btMultiBodyDynamicsWorld::forwardKinematics()
+{
+	BT_PROFILE("btMultiBody forwardKinematics");
+	runMultiBodyPass(btMultiBodyPassLoop::FORWARD_KINEMATICS, 0);
+}
+void	btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
+{
+	forwardKinematics();
 
 	BT_PROFILE("solveConstraints");
 	
@@ -462,11 +728,6 @@ void	btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 
 			if (!isSleeping)
 			{
-				//useless? they get resized in stepVelocities once again (AND DIFFERENTLY)
-				scratch_r.resize(bod->getNumLinks()+1);			//multidof? ("Y"s use it and it is used to store qdd)
-				scratch_v.resize(bod->getNumLinks()+1);
-				scratch_m.resize(bod->getNumLinks()+1);
-
 				bod->addBaseForce(m_gravity * bod->getBaseMass());
 
 				for (int j = 0; j < bod->getNumLinks(); ++j) 
@@ -481,197 +742,7 @@ void	btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 
 	{
 		BT_PROFILE("btMultiBody stepVelocities");
-		for (int i=0;i<this->m_multiBodies.size();i++)
-		{
-			btMultiBody* bod = m_multiBodies[i];
-
-			bool isSleeping = false;
-			
-			if (bod->getBaseCollider() && bod->getBaseCollider()->getActivationState() == ISLAND_SLEEPING)
-			{
-				isSleeping = true;
-			} 
-			for (int b=0;b<bod->getNumLinks();b++)
-			{
-				if (bod->getLink(b).m_collider && bod->getLink(b).m_collider->getActivationState()==ISLAND_SLEEPING)
-					isSleeping = true;
-			} 
-
-			if (!isSleeping)
-			{
-				//useless? they get resized in stepVelocities once again (AND DIFFERENTLY)
-				scratch_r.resize(bod->getNumLinks()+1);			//multidof? ("Y"s use it and it is used to store qdd)
-				scratch_v.resize(bod->getNumLinks()+1);
-				scratch_m.resize(bod->getNumLinks()+1);
-				bool doNotUpdatePos = false;
-
-				{
-					if(!bod->isUsingRK4Integration())
-					{
-						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(solverInfo.m_timeStep, scratch_r, scratch_v, scratch_m);
-					}
-					else
-					{						
-						//
-						int numDofs = bod->getNumDofs() + 6;
-						int numPosVars = bod->getNumPosVars() + 7;
-						btAlignedObjectArray<btScalar> scratch_r2; scratch_r2.resize(2*numPosVars + 8*numDofs);
-						//convenience
-						btScalar *pMem = &scratch_r2[0];
-						btScalar *scratch_q0 = pMem; pMem += numPosVars;
-						btScalar *scratch_qx = pMem; pMem += numPosVars;
-						btScalar *scratch_qd0 = pMem; pMem += numDofs;
-						btScalar *scratch_qd1 = pMem; pMem += numDofs;
-						btScalar *scratch_qd2 = pMem; pMem += numDofs;
-						btScalar *scratch_qd3 = pMem; pMem += numDofs;
-						btScalar *scratch_qdd0 = pMem; pMem += numDofs;
-						btScalar *scratch_qdd1 = pMem; pMem += numDofs;
-						btScalar *scratch_qdd2 = pMem; pMem += numDofs;
-						btScalar *scratch_qdd3 = pMem; pMem += numDofs;
-						btAssert((pMem - (2*numPosVars + 8*numDofs)) == &scratch_r2[0]);
-
-						/////						
-						//copy q0 to scratch_q0 and qd0 to scratch_qd0
-						scratch_q0[0] = bod->getWorldToBaseRot().x();
-						scratch_q0[1] = bod->getWorldToBaseRot().y();
-						scratch_q0[2] = bod->getWorldToBaseRot().z();
-						scratch_q0[3] = bod->getWorldToBaseRot().w();
-						scratch_q0[4] = bod->getBasePos().x();
-						scratch_q0[5] = bod->getBasePos().y();
-						scratch_q0[6] = bod->getBasePos().z();
-						//
-						for(int link = 0; link < bod->getNumLinks(); ++link)
-						{
-							for(int dof = 0; dof < bod->getLink(link).m_posVarCount; ++dof)
-								scratch_q0[7 + bod->getLink(link).m_cfgOffset + dof] = bod->getLink(link).m_jointPos[dof];							
-						}
-						//
-						for(int dof = 0; dof < numDofs; ++dof)								
-							scratch_qd0[dof] = bod->getVelocityVector()[dof];
-						////
-						struct
-						{
-						    btMultiBody *bod;
-                            btScalar *scratch_qx, *scratch_q0;
-
-						    void operator()()
-						    {
-						        for(int dof = 0; dof < bod->getNumPosVars() + 7; ++dof)
-                                    scratch_qx[dof] = scratch_q0[dof];
-						    }
-						} pResetQx = {bod, scratch_qx, scratch_q0};
-						//
-						struct
-						{
-						    void operator()(btScalar dt, const btScalar *pDer, const btScalar *pCurVal, btScalar *pVal, int size)
-						    {
-						        for(int i = 0; i < size; ++i)
-                                    pVal[i] = pCurVal[i] + dt * pDer[i];
-						    }
-
-						} pEulerIntegrate;
-						//
-						struct
-                        {
-                            void operator()(btMultiBody *pBody, const btScalar *pData)
-                            {
-                                btScalar *pVel = const_cast<btScalar*>(pBody->getVelocityVector());
-
-                                for(int i = 0; i < pBody->getNumDofs() + 6; ++i)
-                                    pVel[i] = pData[i];
-
-                            }
-                        } pCopyToVelocityVector;
-						//
-                        struct
-						{
-						    void operator()(const btScalar *pSrc, btScalar *pDst, int start, int size)
-						    {
-						        for(int i = 0; i < size; ++i)
-                                    pDst[i] = pSrc[start + i];
-						    }
-						} pCopy;
-						//
-
-						btScalar h = solverInfo.m_timeStep;
-						#define output &scratch_r[bod->getNumDofs()]
-						//calc qdd0 from: q0 & qd0	
-						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
-						pCopy(output, scratch_qdd0, 0, numDofs);
-						//calc q1 = q0 + h/2 * qd0
-						pResetQx();
-						bod->stepPositionsMultiDof(btScalar(.5)*h, scratch_qx, scratch_qd0);
-						//calc qd1 = qd0 + h/2 * qdd0
-						pEulerIntegrate(btScalar(.5)*h, scratch_qdd0, scratch_qd0, scratch_qd1, numDofs);
-						//
-						//calc qdd1 from: q1 & qd1
-						pCopyToVelocityVector(bod, scratch_qd1);
-						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
-						pCopy(output, scratch_qdd1, 0, numDofs);
-						//calc q2 = q0 + h/2 * qd1
-						pResetQx();
-						bod->stepPositionsMultiDof(btScalar(.5)*h, scratch_qx, scratch_qd1);
-						//calc qd2 = qd0 + h/2 * qdd1
-						pEulerIntegrate(btScalar(.5)*h, scratch_qdd1, scratch_qd0, scratch_qd2, numDofs);
-						//
-						//calc qdd2 from: q2 & qd2
-						pCopyToVelocityVector(bod, scratch_qd2);
-						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
-						pCopy(output, scratch_qdd2, 0, numDofs);
-						//calc q3 = q0 + h * qd2
-						pResetQx();
-						bod->stepPositionsMultiDof(h, scratch_qx, scratch_qd2);
-						//calc qd3 = qd0 + h * qdd2
-						pEulerIntegrate(h, scratch_qdd2, scratch_qd0, scratch_qd3, numDofs);
-						//
-						//calc qdd3 from: q3 & qd3
-						pCopyToVelocityVector(bod, scratch_qd3);
-						bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0., scratch_r, scratch_v, scratch_m);
-						pCopy(output, scratch_qdd3, 0, numDofs);
-
-						//
-						//calc q = q0 + h/6(qd0 + 2*(qd1 + qd2) + qd3)
-						//calc qd = qd0 + h/6(qdd0 + 2*(qdd1 + qdd2) + qdd3)						
-						btAlignedObjectArray<btScalar> delta_q; delta_q.resize(numDofs);
-						btAlignedObjectArray<btScalar> delta_qd; delta_qd.resize(numDofs);
-						for(int i = 0; i < numDofs; ++i)
-						{
-							delta_q[i] = h/btScalar(6.)*(scratch_qd0[i] + 2*scratch_qd1[i] + 2*scratch_qd2[i] + scratch_qd3[i]);
-							delta_qd[i] = h/btScalar(6.)*(scratch_qdd0[i] + 2*scratch_qdd1[i] + 2*scratch_qdd2[i] + scratch_qdd3[i]);							
-							//delta_q[i] = h*scratch_qd0[i];
-							//delta_qd[i] = h*scratch_qdd0[i];
-						}
-						//
-						pCopyToVelocityVector(bod, scratch_qd0);
-						bod->applyDeltaVeeMultiDof(&delta_qd[0], 1);						
-						//
-						if(!doNotUpdatePos)
-						{
-							btScalar *pRealBuf = const_cast<btScalar *>(bod->getVelocityVector());
-							pRealBuf += 6 + bod->getNumDofs() + bod->getNumDofs()*bod->getNumDofs();
-
-							for(int i = 0; i < numDofs; ++i)
-								pRealBuf[i] = delta_q[i];
-
-							//bod->stepPositionsMultiDof(1, 0, &delta_q[0]);
-							bod->setPosUpdated(true);							
-						}
-
-						//ugly hack which resets the cached data to t0 (needed for constraint solver)
-						{
-							for(int link = 0; link < bod->getNumLinks(); ++link)
-								bod->getLink(link).updateCacheMultiDof();
-							bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(0, scratch_r, scratch_v, scratch_m);
-						}
-						
-					}
-				}
-				
-#ifndef BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
-				bod->clearForcesAndTorques();
-#endif //BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
-			}//if (!isSleeping)
-		}
+		runMultiBodyPass(btMultiBodyPassLoop::STEP_VELOCITIES, solverInfo.m_timeStep);
 	}
 
 	clearMultiBodyConstraintForces();
@@ -681,48 +752,9 @@ void	btMultiBodyDynamicsWorld::solveConstraints(btContactSolverInfo& solverInfo)
 	m_constraintSolver->allSolved(solverInfo, m_debugDrawer);
 
 	{
-                BT_PROFILE("btMultiBody stepVelocities");
-                for (int i=0;i<this->m_multiBodies.size();i++)
-                {
-                        btMultiBody* bod = m_multiBodies[i];
-
-                        bool isSleeping = false;
-
-                        if (bod->getBaseCollider() && bod->getBaseCollider()->getActivationState() == ISLAND_SLEEPING)
-                        {
-                                isSleeping = true;
-                        }
-                        for (int b=0;b<bod->getNumLinks();b++)
-                        {
-                                if (bod->getLink(b).m_collider && bod->getLink(b).m_collider->getActivationState()==ISLAND_SLEEPING)
-                                        isSleeping = true;
-                        }
-
-                        if (!isSleeping)
-                        {
-                                //useless? they get resized in stepVelocities once again (AND DIFFERENTLY)
-                                scratch_r.resize(bod->getNumLinks()+1);                 //multidof? ("Y"s use it and it is used to store qdd)
-                                scratch_v.resize(bod->getNumLinks()+1);
-                                scratch_m.resize(bod->getNumLinks()+1);
-
-                                
-                            {
-                                if(!bod->isUsingRK4Integration())
-                                {
-									bool isConstraintPass = true;
-                                    bod->computeAccelerationsArticulatedBodyAlgorithmMultiDof(solverInfo.m_timeStep, scratch_r, scratch_v, scratch_m, isConstraintPass);
-                                }
-				}
-			}
-		}
-	}
-
-	for (int i=0;i<this->m_multiBodies.size();i++)
-	{
-		btMultiBody* bod = m_multiBodies[i];
-		bod->processDeltaVeeMultiDof2();
+		BT_PROFILE("btMultiBody stepVelocities");
+		runMultiBodyPass(btMultiBodyPassLoop::CONSTRAINT_PASS, solverInfo.m_timeStep);
 	}
-
 }
 
 void	btMultiBodyDynamicsWorld::integrateTransforms(btScalar timeStep)
@@ -732,54 +764,7 @@ void	btMultiBodyDynamicsWorld::integrateTransforms(btScalar timeStep)
 	{
 		BT_PROFILE("btMultiBody stepPositions");
 		//integrate and update the Featherstone hierarchies
-		btAlignedObjectArray<btQuaternion> world_to_local;
-		btAlignedObjectArray<btVector3> local_origin;
-
-		for (int b=0;b<m_multiBodies.size();b++)
-		{
-			btMultiBody* bod = m_multiBodies[b];
-			bool isSleeping = false;
-			if (bod->getBaseCollider() && bod->getBaseCollider()->getActivationState() == ISLAND_SLEEPING)
-			{
-				isSleeping = true;
-			} 
-			for (int b=0;b<bod->getNumLinks();b++)
-			{
-				if (bod->getLink(b).m_collider && bod->getLink(b).m_collider->getActivationState()==ISLAND_SLEEPING)
-					isSleeping = true;
-			}
-
-
-			if (!isSleeping)
-			{
-				int nLinks = bod->getNumLinks();
-
-				///base + num m_links
-			
-				
-				{
-					if(!bod->isPosUpdated())
-						bod->stepPositionsMultiDof(timeStep);
-					else
-					{
-						btScalar *pRealBuf = const_cast<btScalar *>(bod->getVelocityVector());
-						pRealBuf += 6 + bod->getNumDofs() + bod->getNumDofs()*bod->getNumDofs();
-
-						bod->stepPositionsMultiDof(1, 0, pRealBuf);
-						bod->setPosUpdated(false);
-					}
-				}
-				
-				world_to_local.resize(nLinks+1);
-				local_origin.resize(nLinks+1);
-
-				bod->updateCollisionObjectWorldTransforms(world_to_local,local_origin);
-				
-			} else
-			{
-				bod->clearVelocities();
-			}
-		}
+		runMultiBodyPass(btMultiBodyPassLoop::STEP_POSITIONS, timeStep);
 	}
 }
 
@@ -17,6 +17,7 @@ subject to the following restrictions:
 #define BT_MULTIBODY_DYNAMICS_WORLD_H
 
 #include "BulletDynamics/Dynamics/btDiscreteDynamicsWorld.h"
+#include "LinearMath/btThreads.h"
 
 #define BT_USE_VIRTUAL_CLEARFORCES_AND_GRAVITY
 
@@ -25,6 +26,29 @@ class btMultiBodyConstraint;
 class btMultiBodyConstraintSolver;
 struct MultiBodyInplaceSolverIslandCallback;
 
+///scratch memory for the per-multibody passes (forward kinematics, articulated body algorithm, position update),
+///one per thread so the passes can run in parallel without reallocating every step
+struct btMultiBodyScratchBuffers
+{
+	btAlignedObjectArray<btScalar>		m_scratch_r;
+	btAlignedObjectArray<btVector3>		m_scratch_v;
+	btAlignedObjectArray<btMatrix3x3>	m_scratch_m;
+	btAlignedObjectArray<btScalar>		m_scratch_r2;		//RK4 integration
+	btAlignedObjectArray<btScalar>		m_delta_q;
+	btAlignedObjectArray<btScalar>		m_delta_qd;
+	btAlignedObjectArray<btQuaternion>	m_world_to_local;
+	btAlignedObjectArray<btVector3>		m_local_origin;
+
+	///computeAccelerationsArticulatedBodyAlgorithmMultiDof grows the arrays from this size, so the refilled tail
+	///does not depend on which multibody used the buffers before (the serial loop resized them the same way)
+	void	reset(int size)
+	{
+		m_scratch_r.resize(size);
+		m_scratch_v.resize(size);
+		m_scratch_m.resize(size);
+	}
+};
+
 ///The btMultiBodyDynamicsWorld adds Featherstone multi body dynamics to Bullet
 ///This implementation is still preliminary/experimental.
 class btMultiBodyDynamicsWorld : public btDiscreteDynamicsWorld
@@ -35,6 +59,8 @@ protected:
 	btAlignedObjectArray<btMultiBodyConstraint*> m_sortedMultiBodyConstraints;
 	btMultiBodyConstraintSolver*	m_multiBodyConstraintSolver;
 	MultiBodyInplaceSolverIslandCallback*	m_solverMultiBodyIslandCallback;
+	btMultiBodyScratchBuffers	m_scratchBuffers[BT_MAX_THREAD_COUNT];
+	int		m_multiBodyGrainSize;
 
 	virtual void	calculateSimulationIslands();
 	virtual void	updateActivationState(btScalar timeStep);
@@ -42,6 +68,8 @@ protected:
 	
 	virtual void	serializeMultiBodies(btSerializer* serializer);
 
+	void	runMultiBodyPass(int pass, btScalar timeStep);
+
 public:
 
 	btMultiBodyDynamicsWorld(btDispatcher* dispatcher,btBroadphaseInterface* pairCache,btMultiBodyConstraintSolver* constraintSolver,btCollisionConfiguration* collisionConfiguration);
@@ -88,6 +116,17 @@ public:
 	virtual void	debugDrawMultiBodyConstraint(btMultiBodyConstraint* constraint);
 	
 	void	forwardKinematics();
+
+	///the per-multibody passes run with btParallelFor, in chunks of this many multibodies
+	void	setMultiBodyGrainSize(int grainSize)
+	{
+		m_multiBodyGrainSize = grainSize;
+	}
+	int		getMultiBodyGrainSize() const
+	{
+		return m_multiBodyGrainSize;
+	}
+
 	virtual void clearForces();
 	virtual void clearMultiBodyConstraintForces();
 	virtual void clearMultiBodyForces();
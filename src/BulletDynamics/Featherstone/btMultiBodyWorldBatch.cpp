@@ -0,0 +1,370 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2013 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btMultiBodyWorldBatch.h"
+#include "btMultiBody.h"
+#include "btMultiBodyLinkCollider.h"
+#include "btMultiBodyConstraintSolver.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcher.h"
+#include "BulletCollision/BroadphaseCollision/btDbvtBroadphase.h"
+#include "LinearMath/btQuickprof.h"
+
+
+///the dispatcher of one environment. The manifold and collision algorithm pools belong to the shared collision
+///configuration, so every allocation from them is guarded by the mutex of the batch.
+class btMultiBodyWorldBatchDispatcher : public btCollisionDispatcher
+{
+	btSpinMutex*	m_poolMutex;
+
+public:
+
+	btMultiBodyWorldBatchDispatcher(btCollisionConfiguration* collisionConfiguration, btSpinMutex* poolMutex)
+		:btCollisionDispatcher(collisionConfiguration),
+		m_poolMutex(poolMutex)
+	{
+	}
+
+	virtual btPersistentManifold*	getNewManifold(const btCollisionObject* b0,const btCollisionObject* b1)
+	{
+		btMutexLock(m_poolMutex);
+		btPersistentManifold* manifold = btCollisionDispatcher::getNewManifold(b0,b1);
+		btMutexUnlock(m_poolMutex);
+		return manifold;
+	}
+
+	virtual void releaseManifold(btPersistentManifold* manifold)
+	{
+		btMutexLock(m_poolMutex);
+		btCollisionDispatcher::releaseManifold(manifold);
+		btMutexUnlock(m_poolMutex);
+	}
+
+	virtual	void* allocateCollisionAlgorithm(int size)
+	{
+		btMutexLock(m_poolMutex);
+		void* mem = btCollisionDispatcher::allocateCollisionAlgorithm(size);
+		btMutexUnlock(m_poolMutex);
+		return mem;
+	}
+
+	virtual	void freeCollisionAlgorithm(void* ptr)
+	{
+		btMutexLock(m_poolMutex);
+		btCollisionDispatcher::freeCollisionAlgorithm(ptr);
+		btMutexUnlock(m_poolMutex);
+	}
+};
+
+
+btMultiBodyWorldBatch::btMultiBodyWorldBatch(int numEnvironments, btCollisionConfiguration* collisionConfiguration)
+	:m_collisionConfiguration(collisionConfiguration),
+	m_numPositions(0),
+	m_numVelocities(0),
+	m_numActions(0),
+	m_grainSize(1),
+	m_finalized(false)
+{
+	m_environments.resize(numEnvironments);
+	for (int i=0;i<numEnvironments;i++)
+	{
+		Environment& env = m_environments[i];
+		void* mem = btAlignedAlloc(sizeof(btDbvtBroadphase),16);
+		env.m_broadphase = new (mem) btDbvtBroadphase();
+		mem = btAlignedAlloc(sizeof(btMultiBodyWorldBatchDispatcher),16);
+		env.m_dispatcher = new (mem) btMultiBodyWorldBatchDispatcher(collisionConfiguration,&m_poolMutex);
+		mem = btAlignedAlloc(sizeof(btMultiBodyConstraintSolver),16);
+		env.m_solver = new (mem) btMultiBodyConstraintSolver();
+		mem = btAlignedAlloc(sizeof(btMultiBodyDynamicsWorld),16);
+		env.m_world = new (mem) btMultiBodyDynamicsWorld(env.m_dispatcher,env.m_broadphase,env.m_solver,collisionConfiguration);
+	}
+}
+
+btMultiBodyWorldBatch::~btMultiBodyWorldBatch()
+{
+	for (int i=0;i<m_environments.size();i++)
+	{
+		Environment& env = m_environments[i];
+		env.m_world->~btMultiBodyDynamicsWorld();
+		btAlignedFree(env.m_world);
+		env.m_solver->~btMultiBodyConstraintSolver();
+		btAlignedFree(env.m_solver);
+		env.m_broadphase->~btBroadphaseInterface();
+		btAlignedFree(env.m_broadphase);
+		env.m_dispatcher->~btCollisionDispatcher();
+		btAlignedFree(env.m_dispatcher);
+	}
+}
+
+bool btMultiBodyWorldBatch::isSameStructure(btMultiBodyDynamicsWorld* world, btMultiBodyDynamicsWorld* reference) const
+{
+	if (world->getNumMultibodies() != reference->getNumMultibodies())
+	{
+		return false;
+	}
+	for (int m=0;m<reference->getNumMultibodies();m++)
+	{
+		const btMultiBody* bod = world->getMultiBody(m);
+		const btMultiBody* ref = reference->getMultiBody(m);
+		if (bod->getNumLinks() != ref->getNumLinks() || bod->getNumDofs() != ref->getNumDofs() || bod->getNumPosVars() != ref->getNumPosVars())
+		{
+			return false;
+		}
+		for (int l=0;l<ref->getNumLinks();l++)
+		{
+			if (bod->getLink(l).m_jointType != ref->getLink(l).m_jointType)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+///writes the positions and velocities of the multibodies of a world, in the layout described in btMultiBodyWorldBatch.h
+template <typename T>
+static void packMultiBodies(btMultiBodyDynamicsWorld* world, T* positions, T* velocities)
+{
+	for (int m=0;m<world->getNumMultibodies();m++)
+	{
+		const btMultiBody* bod = world->getMultiBody(m);
+		const btQuaternion& rot = bod->getWorldToBaseRot();
+		const btVector3& pos = bod->getBasePos();
+		positions[0] = T(rot.x());
+		positions[1] = T(rot.y());
+		positions[2] = T(rot.z());
+		positions[3] = T(rot.w());
+		positions[4] = T(pos.x());
+		positions[5] = T(pos.y());
+		positions[6] = T(pos.z());
+		for (int l=0;l<bod->getNumLinks();l++)
+		{
+			const btMultibodyLink& link = bod->getLink(l);
+			for (int k=0;k<link.m_posVarCount;k++)
+			{
+				positions[7 + link.m_cfgOffset + k] = T(link.m_jointPos[k]);
+			}
+		}
+		positions += 7 + bod->getNumPosVars();
+
+		const btScalar* vel = bod->getVelocityVector();
+		for (int k=0;k<6 + bod->getNumDofs();k++)
+		{
+			velocities[k] = T(vel[k]);
+		}
+		velocities += 6 + bod->getNumDofs();
+	}
+}
+
+static void unpackMultiBodies(btMultiBodyDynamicsWorld* world, const btScalar* positions, const btScalar* velocities)
+{
+	for (int m=0;m<world->getNumMultibodies();m++)
+	{
+		btMultiBody* bod = world->getMultiBody(m);
+		bod->setWorldToBaseRot(btQuaternion(positions[0],positions[1],positions[2],positions[3]));
+		bod->setBasePos(btVector3(positions[4],positions[5],positions[6]));
+		for (int l=0;l<bod->getNumLinks();l++)
+		{
+			const btMultibodyLink& link = bod->getLink(l);
+			btScalar q[4];
+			for (int k=0;k<link.m_posVarCount;k++)
+			{
+				q[k] = positions[7 + link.m_cfgOffset + k];
+			}
+			bod->setJointPosMultiDof(l,q);
+		}
+		positions += 7 + bod->getNumPosVars();
+
+		btScalar* vel = const_cast<btScalar*>(bod->getVelocityVector());
+		for (int k=0;k<6 + bod->getNumDofs();k++)
+		{
+			vel[k] = velocities[k];
+		}
+		velocities += 6 + bod->getNumDofs();
+	}
+}
+
+bool btMultiBodyWorldBatch::finalize()
+{
+	m_finalized = false;
+	if (m_environments.size() == 0)
+	{
+		return false;
+	}
+	btMultiBodyDynamicsWorld* reference = m_environments[0].m_world;
+	for (int i=1;i<m_environments.size();i++)
+	{
+		if (!isSameStructure(m_environments[i].m_world,reference))
+		{
+			return false;
+		}
+	}
+
+	m_numPositions = 0;
+	m_numVelocities = 0;
+	m_numActions = 0;
+	for (int m=0;m<reference->getNumMultibodies();m++)
+	{
+		const btMultiBody* bod = reference->getMultiBody(m);
+		m_numPositions += 7 + bod->getNumPosVars();
+		m_numVelocities += 6 + bod->getNumDofs();
+		m_numActions += bod->getNumDofs();
+	}
+
+	const int numEnvironments = m_environments.size();
+	m_positions.resize(numEnvironments*m_numPositions);
+	m_velocities.resize(numEnvironments*m_numVelocities);
+	m_actions.resize(numEnvironments*m_numActions);
+	for (int i=0;i<m_actions.size();i++)
+	{
+		m_actions[i] = 0.f;
+	}
+	//the initial state is kept at full precision, so resetEnvironment restores it exactly
+	m_initialPositions.resize(numEnvironments*m_numPositions);
+	m_initialVelocities.resize(numEnvironments*m_numVelocities);
+	m_finalized = true;
+	for (int i=0;i<numEnvironments && m_numPositions;i++)
+	{
+		packMultiBodies(m_environments[i].m_world, &m_initialPositions[i*m_numPositions], &m_initialVelocities[i*m_numVelocities]);
+		packMultiBodies(m_environments[i].m_world, &m_positions[i*m_numPositions], &m_velocities[i*m_numVelocities]);
+	}
+	return true;
+}
+
+
+///steps a range of environments, each one completely on the calling thread
+///(the btParallelFor loops inside btMultiBodyDynamicsWorld run sequentially when nested)
+struct btMultiBodyWorldBatchStepper : public btIParallelForBody
+{
+	btMultiBodyWorldBatch::Environment*	m_environments;
+	const float*	m_actions;
+	float*			m_positions;
+	float*			m_velocities;
+	int				m_numPositions;
+	int				m_numVelocities;
+	int				m_numActions;
+	btScalar		m_timeStep;
+	int				m_maxSubSteps;
+	btScalar		m_fixedTimeStep;
+	int*			m_numSubSteps;
+
+	void forLoop( int iBegin, int iEnd ) const
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			btMultiBodyDynamicsWorld* world = m_environments[i].m_world;
+			const float* actions = m_actions + i*m_numActions;
+			for (int m=0;m<world->getNumMultibodies();m++)
+			{
+				btMultiBody* bod = world->getMultiBody(m);
+				for (int l=0;l<bod->getNumLinks();l++)
+				{
+					const btMultibodyLink& link = bod->getLink(l);
+					for (int k=0;k<link.m_dofCount;k++)
+					{
+						bod->addJointTorqueMultiDof(l,k,actions[link.m_dofOffset + k]);
+					}
+				}
+				actions += bod->getNumDofs();
+			}
+
+			int numSubSteps = world->stepSimulation(m_timeStep,m_maxSubSteps,m_fixedTimeStep);
+			if (i == 0)
+			{
+				//the environments are stepped in lockstep, so they all take the same number of substeps
+				*m_numSubSteps = numSubSteps;
+			}
+
+			packMultiBodies(world, m_positions + i*m_numPositions, m_velocities + i*m_numVelocities);
+		}
+	}
+};
+
+int btMultiBodyWorldBatch::stepSimulation(btScalar timeStep, int maxSubSteps, btScalar fixedTimeStep)
+{
+	BT_PROFILE("btMultiBodyWorldBatch::stepSimulation");
+	btAssert(m_finalized);
+	if (!m_finalized || m_environments.size() == 0)
+	{
+		return 0;
+	}
+
+	//keep the pointers valid for environments without multibodies or actions
+	float dummy = 0.f;
+	int numSubSteps = 0;
+	btMultiBodyWorldBatchStepper stepper;
+	stepper.m_environments = &m_environments[0];
+	stepper.m_actions = m_actions.size() ? &m_actions[0] : &dummy;
+	stepper.m_positions = m_positions.size() ? &m_positions[0] : &dummy;
+	stepper.m_velocities = m_velocities.size() ? &m_velocities[0] : &dummy;
+	stepper.m_numPositions = m_numPositions;
+	stepper.m_numVelocities = m_numVelocities;
+	stepper.m_numActions = m_numActions;
+	stepper.m_timeStep = timeStep;
+	stepper.m_maxSubSteps = maxSubSteps;
+	stepper.m_fixedTimeStep = fixedTimeStep;
+	stepper.m_numSubSteps = &numSubSteps;
+	btParallelFor(0, m_environments.size(), m_grainSize, stepper);
+	return numSubSteps;
+}
+
+void btMultiBodyWorldBatch::resetCollider(int env, btCollisionObject* collider)
+{
+	Environment& environment = m_environments[env];
+	btBroadphaseProxy* proxy = collider->getBroadphaseHandle();
+	collider->activate();
+	if (!proxy)
+	{
+		return;
+	}
+	//drop the pairs with their manifolds, so no contact or warm starting impulse survives the reset,
+	//and let the broadphase find the overlaps again at the restored transform
+	environment.m_broadphase->getOverlappingPairCache()->removeOverlappingPairsContainingProxy(proxy, environment.m_dispatcher);
+	environment.m_world->updateSingleAabb(collider);
+	static_cast<btDbvtBroadphase*>(environment.m_broadphase)->setAabbForceUpdate(proxy, proxy->m_aabbMin, proxy->m_aabbMax, environment.m_dispatcher);
+}
+
+void btMultiBodyWorldBatch::resetEnvironment(int env)
+{
+	btAssert(m_finalized);
+	if (!m_finalized || m_numPositions == 0)
+	{
+		return;
+	}
+	btMultiBodyDynamicsWorld* world = m_environments[env].m_world;
+	unpackMultiBodies(world, &m_initialPositions[env*m_numPositions], &m_initialVelocities[env*m_numVelocities]);
+	for (int m=0;m<world->getNumMultibodies();m++)
+	{
+		btMultiBody* bod = world->getMultiBody(m);
+		bod->clearForcesAndTorques();
+		bod->clearConstraintForces();
+		bod->wakeUp();
+		bod->setSleepTimer(0);
+		bod->setPosUpdated(false);
+		bod->forwardKinematics(m_world_to_local,m_local_origin);
+		bod->updateCollisionObjectWorldTransforms(m_world_to_local,m_local_origin);
+		if (bod->getBaseCollider())
+		{
+			resetCollider(env, bod->getBaseCollider());
+		}
+		for (int l=0;l<bod->getNumLinks();l++)
+		{
+			if (bod->getLink(l).m_collider)
+			{
+				resetCollider(env, bod->getLink(l).m_collider);
+			}
+		}
+	}
+	packMultiBodies(world, &m_positions[env*m_numPositions], &m_velocities[env*m_numVelocities]);
+}
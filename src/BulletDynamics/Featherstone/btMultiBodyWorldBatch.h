@@ -0,0 +1,153 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2013 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_MULTIBODY_WORLD_BATCH_H
+#define BT_MULTIBODY_WORLD_BATCH_H
+
+#include "btMultiBodyDynamicsWorld.h"
+#include "LinearMath/btThreads.h"
+
+class btMultiBody;
+class btMultiBodyConstraintSolver;
+class btCollisionConfiguration;
+class btCollisionDispatcher;
+class btBroadphaseInterface;
+
+///btMultiBodyWorldBatch steps a number of structurally identical btMultiBodyDynamicsWorlds ("environments") in lockstep,
+///one environment per task using btParallelFor, for example to run reinforcement learning rollouts.
+///All environments share the collision configuration (collision algorithms and the manifold/algorithm pools), and
+///are expected to share their collision shapes, including triangle mesh BVHs, which are only read while stepping.
+///Each environment keeps its own broadphase, dispatcher, constraint solver and world, since those hold per-environment state.
+///
+///Usage: populate every getWorld(env) with the same multibodies in the same order, call finalize, then write the
+///joint torques to getActions() and call stepSimulation. The state of the multibodies is packed into dense float
+///arrays after every step, with getNumPositions()/getNumVelocities() values per environment. For each multibody the
+///positions are the world to base quaternion (x,y,z,w), the base position and the joint positions (7+getNumPosVars()),
+///the velocities are the base angular and linear velocity and the joint velocities (6+getNumDofs(), the layout of
+///btMultiBody::getVelocityVector), and the actions are the joint torques (getNumDofs()).
+class btMultiBodyWorldBatch
+{
+public:
+
+	struct Environment
+	{
+		btBroadphaseInterface*			m_broadphase;
+		btCollisionDispatcher*			m_dispatcher;
+		btMultiBodyConstraintSolver*	m_solver;
+		btMultiBodyDynamicsWorld*		m_world;
+	};
+
+protected:
+
+	btCollisionConfiguration*	m_collisionConfiguration;
+	btSpinMutex		m_poolMutex;
+
+	btAlignedObjectArray<Environment>	m_environments;
+
+	int		m_numPositions;
+	int		m_numVelocities;
+	int		m_numActions;
+	int		m_grainSize;
+	bool	m_finalized;
+
+	btAlignedObjectArray<float>	m_positions;
+	btAlignedObjectArray<float>	m_velocities;
+	btAlignedObjectArray<float>	m_actions;
+	btAlignedObjectArray<btScalar>	m_initialPositions;
+	btAlignedObjectArray<btScalar>	m_initialVelocities;
+
+	btAlignedObjectArray<btQuaternion>	m_world_to_local;
+	btAlignedObjectArray<btVector3>		m_local_origin;
+
+	bool	isSameStructure(btMultiBodyDynamicsWorld* world, btMultiBodyDynamicsWorld* reference) const;
+
+	void	resetCollider(int env, btCollisionObject* collider);
+
+public:
+
+	///the collision configuration is not owned by the batch, and has to outlive it
+	btMultiBodyWorldBatch(int numEnvironments, btCollisionConfiguration* collisionConfiguration);
+
+	virtual ~btMultiBodyWorldBatch();
+
+	int		getNumEnvironments() const
+	{
+		return m_environments.size();
+	}
+
+	btMultiBodyDynamicsWorld*	getWorld(int env)
+	{
+		return m_environments[env].m_world;
+	}
+
+	const btMultiBodyDynamicsWorld*	getWorld(int env) const
+	{
+		return m_environments[env].m_world;
+	}
+
+	///checks that all environments have the same multibodies as the first one, sizes the packed arrays and
+	///records the current state for resetEnvironment. Returns false (and leaves the batch unusable) if the environments differ.
+	bool	finalize();
+
+	///steps all environments in parallel: applies the actions as joint torques, calls btMultiBodyDynamicsWorld::stepSimulation
+	///and packs the new positions and velocities. Returns the number of simulation substeps, which is the same for all environments.
+	int		stepSimulation(btScalar timeStep, int maxSubSteps = 1, btScalar fixedTimeStep = btScalar(1.)/btScalar(60.));
+
+	///restores the multibody state that was recorded by finalize and refreshes the packed positions and velocities of the environment.
+	///The multibodies are woken up with a cleared sleep timer, and the overlapping pairs and contact manifolds of their colliders
+	///are dropped, so no warm starting impulses are carried over. The time that stepSimulation accumulates for substepping is not reset.
+	void	resetEnvironment(int env);
+
+	int		getNumPositions() const
+	{
+		return m_numPositions;
+	}
+	int		getNumVelocities() const
+	{
+		return m_numVelocities;
+	}
+	int		getNumActions() const
+	{
+		return m_numActions;
+	}
+
+	///getNumEnvironments()*getNumPositions() values, environment after environment
+	const float*	getPositions() const
+	{
+		return m_positions.size() ? &m_positions[0] : 0;
+	}
+	///getNumEnvironments()*getNumVelocities() values, environment after environment
+	const float*	getVelocities() const
+	{
+		return m_velocities.size() ? &m_velocities[0] : 0;
+	}
+	///getNumEnvironments()*getNumActions() joint torques, applied by every stepSimulation until they are overwritten
+	float*	getActions()
+	{
+		return m_actions.size() ? &m_actions[0] : 0;
+	}
+
+	///environments are stepped in chunks of this many environments
+	void	setGrainSize(int grainSize)
+	{
+		m_grainSize = btMax(grainSize, 1);
+	}
+	int		getGrainSize() const
+	{
+		return m_grainSize;
+	}
+};
+
+#endif //BT_MULTIBODY_WORLD_BATCH_H
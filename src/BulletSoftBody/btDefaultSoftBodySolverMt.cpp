@@ -0,0 +1,349 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "btDefaultSoftBodySolverMt.h"
+#include "BulletCollision/BroadphaseCollision/btBroadphaseInterface.h"
+#include "LinearMath/btHashMap.h"
+#include "LinearMath/btQuickprof.h"
+
+
+btDefaultSoftBodySolverMt::btDefaultSoftBodySolverMt(int grainSize)
+{
+	m_linkBatchThreshold = 2048;
+	m_grainSize = grainSize;
+}
+
+btDefaultSoftBodySolverMt::~btDefaultSoftBodySolverMt()
+{
+}
+
+void btDefaultSoftBodySolverMt::optimize( btAlignedObjectArray< btSoftBody * > &softBodies , bool forceUpdate)
+{
+	btDefaultSoftBodySolver::optimize(softBodies, forceUpdate);
+	if (m_linkBatchThreshold > 0)
+	{
+		for (int i=0;i<m_softBodySet.size();i++)
+		{
+			btSoftBody* psb = m_softBodySet[i];
+			if (psb->m_links.size() >= m_linkBatchThreshold && !psb->hasLinkBatches())
+			{
+				psb->generateLinkBatches();
+			}
+		}
+	}
+}
+
+
+///runs a soft body method on a list of bodies
+struct btSoftBodyStepper : public btIParallelForBody
+{
+	enum Stage
+	{
+		PREDICT_MOTION,
+		INTEGRATE_MOTION
+	};
+
+	btSoftBody**	m_bodies;
+	Stage			m_stage;
+	btScalar		m_timeStep;
+
+	void forLoop( int iBegin, int iEnd ) const
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			btSoftBody* psb = m_bodies[i];
+			if (m_stage == PREDICT_MOTION)
+			{
+				psb->predictMotion(m_timeStep);
+			}
+			else
+			{
+				psb->integrateMotion();
+			}
+		}
+	}
+};
+
+static void gatherActiveBodies(const btAlignedObjectArray<btSoftBody*>& softBodies, btAlignedObjectArray<btSoftBody*>& activeBodies)
+{
+	activeBodies.resize(0);
+	for (int i=0;i<softBodies.size();i++)
+	{
+		if (softBodies[i]->isActive())
+		{
+			activeBodies.push_back(softBodies[i]);
+		}
+	}
+}
+
+void btDefaultSoftBodySolverMt::predictMotion( float timeStep )
+{
+	BT_PROFILE("btDefaultSoftBodySolverMt::predictMotion");
+	btAlignedObjectArray<btSoftBody*> activeBodies;
+	gatherActiveBodies(m_softBodySet, activeBodies);
+	if (activeBodies.size() == 0)
+	{
+		return;
+	}
+
+	//the broadphase is not thread safe: hide the handles so btSoftBody::updateBounds leaves the broadphase alone,
+	//and update the aabbs afterwards in body order, like the serial solver does
+	btAlignedObjectArray<btBroadphaseProxy*> handles;
+	handles.resize(activeBodies.size());
+	for (int i=0;i<activeBodies.size();i++)
+	{
+		handles[i] = activeBodies[i]->getBroadphaseHandle();
+		activeBodies[i]->setBroadphaseHandle(0);
+	}
+
+	btSoftBodyStepper stepper;
+	stepper.m_bodies = &activeBodies[0];
+	stepper.m_stage = btSoftBodyStepper::PREDICT_MOTION;
+	stepper.m_timeStep = timeStep;
+	btParallelFor(0, activeBodies.size(), m_grainSize, stepper);
+
+	for (int i=0;i<activeBodies.size();i++)
+	{
+		btSoftBody* psb = activeBodies[i];
+		psb->setBroadphaseHandle(handles[i]);
+		if (handles[i] && psb->m_ndbvt.m_root)
+		{
+			btSoftBodyWorldInfo* worldInfo = psb->getWorldInfo();
+			worldInfo->m_broadphase->setAabb(handles[i], psb->m_bounds[0], psb->m_bounds[1], worldInfo->m_dispatcher);
+		}
+	}
+}
+
+void btDefaultSoftBodySolverMt::updateSoftBodies( )
+{
+	BT_PROFILE("btDefaultSoftBodySolverMt::updateSoftBodies");
+	btAlignedObjectArray<btSoftBody*> activeBodies;
+	gatherActiveBodies(m_softBodySet, activeBodies);
+	if (activeBodies.size() == 0)
+	{
+		return;
+	}
+	btSoftBodyStepper stepper;
+	stepper.m_bodies = &activeBodies[0];
+	stepper.m_stage = btSoftBodyStepper::INTEGRATE_MOTION;
+	stepper.m_timeStep = 0;
+	btParallelFor(0, activeBodies.size(), m_grainSize, stepper);
+}
+
+int btDefaultSoftBodySolverMt::findGroup(int bodyIndex)
+{
+	while (m_groupParent[bodyIndex] != bodyIndex)
+	{
+		m_groupParent[bodyIndex] = m_groupParent[m_groupParent[bodyIndex]];
+		bodyIndex = m_groupParent[bodyIndex];
+	}
+	return bodyIndex;
+}
+
+void btDefaultSoftBodySolverMt::mergeGroups(int bodyIndexA, int bodyIndexB)
+{
+	int rootA = findGroup(bodyIndexA);
+	int rootB = findGroup(bodyIndexB);
+	if (rootA != rootB)
+	{
+		m_groupParent[btMax(rootA, rootB)] = btMin(rootA, rootB);
+	}
+}
+
+int btDefaultSoftBodySolverMt::findBodyOfFace(const btSoftBody::Face* face, int hint) const
+{
+	for (int k=0;k<m_softBodySet.size();k++)
+	{
+		int i = (hint + k) % m_softBodySet.size();
+		const btSoftBody::tFaceArray& faces = m_softBodySet[i]->m_faces;
+		if (faces.size() && face >= &faces[0] && face < &faces[0] + faces.size())
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+///sorts the active bodies into groups that share no dynamic rigid body and no soft contact,
+///m_groupBodies lists the bodies of each group in body order, starting at m_groupOffsets
+void btDefaultSoftBodySolverMt::buildGroups()
+{
+	const int numBodies = m_softBodySet.size();
+	m_groupParent.resize(numBodies);
+	for (int i=0;i<numBodies;i++)
+	{
+		m_groupParent[i] = i;
+	}
+
+	btHashMap<btHashPtr,int> rigidBodyOwner;
+	int faceOwner = 0;
+	for (int i=0;i<numBodies;i++)
+	{
+		btSoftBody* psb = m_softBodySet[i];
+		if (!psb->isActive())
+		{
+			continue;
+		}
+		for (int j=0;j<psb->m_anchors.size();j++)
+		{
+			const btRigidBody* body = psb->m_anchors[j].m_body;
+			if (body && !body->isStaticOrKinematicObject())
+			{
+				const int* owner = rigidBodyOwner.find(body);
+				if (owner)
+				{
+					mergeGroups(*owner, i);
+				}
+				else
+				{
+					rigidBodyOwner.insert(body, i);
+				}
+			}
+		}
+		for (int j=0;j<psb->m_rcontacts.size();j++)
+		{
+			const btRigidBody* body = btRigidBody::upcast(psb->m_rcontacts[j].m_cti.m_colObj);
+			if (body && !body->isStaticOrKinematicObject())
+			{
+				const int* owner = rigidBodyOwner.find(body);
+				if (owner)
+				{
+					mergeGroups(*owner, i);
+				}
+				else
+				{
+					rigidBodyOwner.insert(body, i);
+				}
+			}
+		}
+		for (int j=0;j<psb->m_scontacts.size();j++)
+		{
+			faceOwner = findBodyOfFace(psb->m_scontacts[j].m_face, faceOwner);
+			if (faceOwner >= 0)
+			{
+				mergeGroups(faceOwner, i);
+			}
+			else
+			{
+				faceOwner = 0;
+			}
+		}
+	}
+
+	//number the groups by their first body and bucket the active bodies
+	btAlignedObjectArray<int> groupOfRoot;
+	groupOfRoot.resize(numBodies, -1);
+	m_groupOffsets.resize(0);
+	for (int i=0;i<numBodies;i++)
+	{
+		if (m_softBodySet[i]->isActive())
+		{
+			int root = findGroup(i);
+			if (groupOfRoot[root] < 0)
+			{
+				groupOfRoot[root] = m_groupOffsets.size();
+				m_groupOffsets.push_back(0);
+			}
+			m_groupOffsets[groupOfRoot[root]]++;
+		}
+	}
+	int offset = 0;
+	for (int g=0;g<m_groupOffsets.size();g++)
+	{
+		int count = m_groupOffsets[g];
+		m_groupOffsets[g] = offset;
+		offset += count;
+	}
+	m_groupOffsets.push_back(offset);
+	m_groupBodies.resize(offset);
+	btAlignedObjectArray<int> slot;
+	slot.copyFromArray(m_groupOffsets);
+	for (int i=0;i<numBodies;i++)
+	{
+		if (m_softBodySet[i]->isActive())
+		{
+			m_groupBodies[slot[groupOfRoot[findGroup(i)]]++] = i;
+		}
+	}
+}
+
+
+///solves the constraints of whole groups, the bodies of a group in order
+struct btSoftBodyGroupSolver : public btIParallelForBody
+{
+	btSoftBody* const*	m_bodies;
+	const int*			m_groupBodies;
+	const int*			m_groupOffsets;
+	const int*			m_groups;
+
+	void forLoop( int iBegin, int iEnd ) const
+	{
+		for (int i = iBegin; i < iEnd; ++i)
+		{
+			int group = m_groups[i];
+			for (int j = m_groupOffsets[group]; j < m_groupOffsets[group + 1]; ++j)
+			{
+				m_bodies[m_groupBodies[j]]->solveConstraints();
+			}
+		}
+	}
+};
+
+void btDefaultSoftBodySolverMt::solveConstraints( float /*solverdt*/ )
+{
+	BT_PROFILE("btDefaultSoftBodySolverMt::solveConstraints");
+	buildGroups();
+	const int numGroups = m_groupOffsets.size() - 1;
+	if (numGroups <= 0)
+	{
+		return;
+	}
+
+	//groups with link batches run one after another, so the batches get the worker threads
+	//(a btParallelFor inside another one runs sequentially)
+	btAlignedObjectArray<int> groups;
+	btAlignedObjectArray<int> batchedGroups;
+	for (int g=0;g<numGroups;g++)
+	{
+		bool batched = false;
+		for (int j=m_groupOffsets[g];j<m_groupOffsets[g+1] && !batched;j++)
+		{
+			batched = m_softBodySet[m_groupBodies[j]]->hasLinkBatches();
+		}
+		if (batched)
+		{
+			batchedGroups.push_back(g);
+		}
+		else
+		{
+			groups.push_back(g);
+		}
+	}
+
+	btSoftBodyGroupSolver solver;
+	solver.m_bodies = &m_softBodySet[0];
+	solver.m_groupBodies = &m_groupBodies[0];
+	solver.m_groupOffsets = &m_groupOffsets[0];
+	if (groups.size())
+	{
+		solver.m_groups = &groups[0];
+		btParallelFor(0, groups.size(), m_grainSize, solver);
+	}
+	if (batchedGroups.size())
+	{
+		solver.m_groups = &batchedGroups[0];
+		solver.forLoop(0, batchedGroups.size());
+	}
+} // btDefaultSoftBodySolverMt::solveConstraints
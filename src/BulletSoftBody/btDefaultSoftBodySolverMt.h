@@ -0,0 +1,68 @@
+/*
+Bullet Continuous Collision Detection and Physics Library
+Copyright (c) 2003-2014 Erwin Coumans  http://bulletphysics.org
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef BT_SOFT_BODY_DEFAULT_SOLVER_MT_H
+#define BT_SOFT_BODY_DEFAULT_SOLVER_MT_H
+
+#include "btDefaultSoftBodySolver.h"
+#include "btSoftBody.h"
+#include "LinearMath/btThreads.h"
+
+
+///btDefaultSoftBodySolverMt processes the soft bodies concurrently using btParallelFor, pass it to the btSoftRigidDynamicsWorld constructor.
+///Soft bodies that touch the same dynamic rigid body (anchors, rigid contacts) or each other (soft contacts) are solved
+///by the same task in their original order, so the simulation is identical to btDefaultSoftBodySolver.
+///Bodies with at least getLinkBatchThreshold() links get their links sorted into batches that share no node (see
+///btSoftBody::generateLinkBatches), which are solved in parallel. This reorders the links of those bodies once.
+class btDefaultSoftBodySolverMt : public btDefaultSoftBodySolver
+{
+protected:
+	int		m_linkBatchThreshold;
+	int		m_grainSize;
+
+	btAlignedObjectArray<int>	m_groupParent;
+	btAlignedObjectArray<int>	m_groupBodies;
+	btAlignedObjectArray<int>	m_groupOffsets;
+
+	int		findGroup(int bodyIndex);
+	void	mergeGroups(int bodyIndexA, int bodyIndexB);
+	int		findBodyOfFace(const btSoftBody::Face* face, int hint) const;
+	void	buildGroups();
+
+public:
+	btDefaultSoftBodySolverMt(int grainSize = 1);
+
+	virtual ~btDefaultSoftBodySolverMt();
+
+	virtual void updateSoftBodies( );
+
+	virtual void optimize( btAlignedObjectArray< btSoftBody * > &softBodies,bool forceUpdate=false );
+
+	virtual void solveConstraints( float solverdt );
+
+	virtual void predictMotion( float solverdt );
+
+	///bodies with at least this many links are solved with parallel link batches, 0 disables the batching
+	void	setLinkBatchThreshold(int numLinks)
+	{
+		m_linkBatchThreshold = numLinks;
+	}
+	int		getLinkBatchThreshold() const
+	{
+		return m_linkBatchThreshold;
+	}
+};
+
+#endif //BT_SOFT_BODY_DEFAULT_SOLVER_MT_H
@@ -18,6 +18,7 @@ subject to the following restrictions:
 #include "BulletSoftBody/btSoftBodySolvers.h"
 #include "btSoftBodyData.h"
 #include "LinearMath/btSerializer.h"
+#include "LinearMath/btThreads.h"
 
 
 //
@@ -265,6 +266,7 @@ void			btSoftBody::appendLink(int model,Material* mat)
 	else
 	{ ZeroInitialize(l);l.m_material=mat?mat:m_materials[0]; }
 	m_links.push_back(l);
+	m_linkBatches.resize(0);
 }
 
 //
@@ -1169,9 +1171,77 @@ void			btSoftBody::randomizeConstraints()
 	{
 		btSwap(m_faces[i],m_faces[NEXTRAND%ni]);
 	}
+	m_linkBatches.resize(0);
 #undef NEXTRAND
 }
 
+//
+struct	btSoftBodyLinkOrder
+{
+	int		m_color;
+	int		m_node;
+	int		m_link;
+};
+
+struct	btSoftBodyLinkOrderPredicate
+{
+	bool operator() (const btSoftBodyLinkOrder& a,const btSoftBodyLinkOrder& b) const
+	{
+		return (a.m_color<b.m_color)||((a.m_color==b.m_color)&&(a.m_node<b.m_node));
+	}
+};
+
+//
+int				btSoftBody::generateLinkBatches()
+{
+	const int		nl=m_links.size();
+	const Node*		nbase=m_nodes.size()?&m_nodes[0]:0;
+	btAlignedObjectArray<int>	color;
+	btAlignedObjectArray<int>	stamp;
+	color.resize(nl,-1);
+	stamp.resize(m_nodes.size(),-1);
+	/* Each pass takes the remaining links that touch no node used in this pass	*/ 
+	int	ncolors=0;
+	for(int nleft=nl;nleft>0;++ncolors)
+	{
+		for(int i=0;i<nl;++i)
+		{
+			if(color[i]>=0) continue;
+			const int	ia=int(m_links[i].m_n[0]-nbase);
+			const int	ib=int(m_links[i].m_n[1]-nbase);
+			if((stamp[ia]!=ncolors)&&(stamp[ib]!=ncolors))
+			{
+				stamp[ia]=stamp[ib]=ncolors;
+				color[i]=ncolors;
+				--nleft;
+			}
+		}
+	}
+	/* Sort by color, then by first node; a node is used once per color	*/ 
+	btAlignedObjectArray<btSoftBodyLinkOrder>	order;
+	order.resize(nl);
+	for(int i=0;i<nl;++i)
+	{
+		const int	ia=int(m_links[i].m_n[0]-nbase);
+		const int	ib=int(m_links[i].m_n[1]-nbase);
+		order[i].m_color	=	color[i];
+		order[i].m_node		=	btMin(ia,ib);
+		order[i].m_link		=	i;
+	}
+	order.quickSort(btSoftBodyLinkOrderPredicate());
+	m_linkBatches.resize(0);
+	tLinkArray	links;
+	links.resize(nl);
+	for(int i=0;i<nl;++i)
+	{
+		if((i==0)||(order[i].m_color!=order[i-1].m_color)) m_linkBatches.push_back(i);
+		links[i]=m_links[order[i].m_link];
+	}
+	m_linkBatches.push_back(nl);
+	m_links.copyFromArray(links);
+	return(ncolors);
+}
+
 //
 void			btSoftBody::releaseCluster(int index)
 {
@@ -1390,6 +1460,7 @@ void			btSoftBody::refine(ImplicitFn* ifn,btScalar accurary,bool cut)
 	int					newnodes=0;
 	int i,j,k,ni;
 
+	m_linkBatches.resize(0);
 	/* Filter out		*/ 
 	for(i=0;i<m_links.size();++i)
 	{
@@ -1655,6 +1726,7 @@ bool			btSoftBody::cutLink(int node0,int node1,btScalar position)
 		&m_nodes[m_nodes.size()-1]};
 	pn[0]->m_v=v;
 	pn[1]->m_v=v;
+	m_linkBatches.resize(0);
 	for(i=0,ni=m_links.size();i<ni;++i)
 	{
 		const int mtch=MatchEdge(m_links[i].m_n[0],m_links[i].m_n[1],pa,pb);
@@ -1853,11 +1925,18 @@ void			btSoftBody::solveConstraints()
 
 	int i,ni;
 
-	for(i=0,ni=m_links.size();i<ni;++i)
+	if(m_packedLinks.m_enabled&&hasLinkBatches())
 	{
-		Link&	l=m_links[i];
-		l.m_c3		=	l.m_n[1]->m_q-l.m_n[0]->m_q;
-		l.m_c2		=	1/(l.m_c3.length2()*l.m_c0);
+		packLinks();
+	}
+	else
+	{
+		for(i=0,ni=m_links.size();i<ni;++i)
+		{
+			Link&	l=m_links[i];
+			l.m_c3		=	l.m_n[1]->m_q-l.m_n[0]->m_q;
+			l.m_c2		=	1/(l.m_c3.length2()*l.m_c0);
+		}
 	}
 	/* Prepare anchors		*/ 
 	for(i=0,ni=m_anchors.size();i<ni;++i)
@@ -1940,6 +2019,10 @@ void			btSoftBody::solveConstraints()
 //
 void			btSoftBody::staticSolve(int iterations)
 {
+	if(m_packedLinks.m_enabled&&hasLinkBatches())
+	{
+		packLinks();
+	}
 	for(int isolve=0;isolve<iterations;++isolve)
 	{
 		for(int iseq=0;iseq<m_cfg.m_psequence.size();++iseq)
@@ -3082,37 +3165,373 @@ void				btSoftBody::PSolve_SContacts(btSoftBody* psb,btScalar,btScalar ti)
 }
 
 //
-void				btSoftBody::PSolve_Links(btSoftBody* psb,btScalar kst,btScalar ti)
+static inline void	solveLinkPosition(btSoftBody::Link& l,btScalar kst)
 {
-	for(int i=0,ni=psb->m_links.size();i<ni;++i)
-	{			
-		Link&	l=psb->m_links[i];
-		if(l.m_c0>0)
+	if(l.m_c0>0)
+	{
+		btSoftBody::Node&	a=*l.m_n[0];
+		btSoftBody::Node&	b=*l.m_n[1];
+		const btVector3	del=b.m_x-a.m_x;
+		const btScalar	len=del.length2();
+		if (l.m_c1+len > SIMD_EPSILON)
+		{
+			const btScalar	k=((l.m_c1-len)/(l.m_c0*(l.m_c1+len)))*kst;
+			a.m_x-=del*(k*a.m_im);
+			b.m_x+=del*(k*b.m_im);
+		}
+	}
+}
+
+//
+static inline void	solveLinkVelocity(btSoftBody::Link& l,btScalar kst)
+{
+	btSoftBody::Node**	n=l.m_n;
+	const btScalar	j=-btDot(l.m_c3,n[0]->m_v-n[1]->m_v)*l.m_c2*kst;
+	n[0]->m_v+=	l.m_c3*(j*n[0]->m_im);
+	n[1]->m_v-=	l.m_c3*(j*n[1]->m_im);
+}
+
+//
+// Packed links, the same arithmetic as solveLinkPosition and solveLinkVelocity in the same order,
+// so the packed solvers give the same result as the links
+//
+
+//
+static void			solvePackedLinkPositions(btSoftBody::PackedLinks& p,int iBegin,int iEnd,btScalar kst)
+{
+	btScalar*	x=&p.m_node[0][0];
+	btScalar*	y=&p.m_node[1][0];
+	btScalar*	z=&p.m_node[2][0];
+	for(int i=iBegin;i<iEnd;++i)
+	{
+		const btScalar	c0=p.m_c0[i];
+		if(c0>0)
 		{
-			Node&			a=*l.m_n[0];
-			Node&			b=*l.m_n[1];
-			const btVector3	del=b.m_x-a.m_x;
-			const btScalar	len=del.length2();
-			if (l.m_c1+len > SIMD_EPSILON)
+			const int		a=p.m_nodeA[i];
+			const int		b=p.m_nodeB[i];
+			const btScalar	dx=x[b]-x[a];
+			const btScalar	dy=y[b]-y[a];
+			const btScalar	dz=z[b]-z[a];
+			const btScalar	len=dx*dx+dy*dy+dz*dz;
+			const btScalar	c1=p.m_c1[i];
+			if (c1+len > SIMD_EPSILON)
 			{
-				const btScalar	k=((l.m_c1-len)/(l.m_c0*(l.m_c1+len)))*kst;
-				a.m_x-=del*(k*a.m_im);
-				b.m_x+=del*(k*b.m_im);
+				const btScalar	k=((c1-len)/(c0*(c1+len)))*kst;
+				const btScalar	ka=k*p.m_im[a];
+				const btScalar	kb=k*p.m_im[b];
+				x[a]-=dx*ka;y[a]-=dy*ka;z[a]-=dz*ka;
+				x[b]+=dx*kb;y[b]+=dy*kb;z[b]+=dz*kb;
 			}
 		}
 	}
 }
 
+//
+static void			solvePackedLinkVelocities(btSoftBody::PackedLinks& p,int iBegin,int iEnd,btScalar kst)
+{
+	btScalar*	x=&p.m_node[0][0];
+	btScalar*	y=&p.m_node[1][0];
+	btScalar*	z=&p.m_node[2][0];
+	for(int i=iBegin;i<iEnd;++i)
+	{
+		const int		a=p.m_nodeA[i];
+		const int		b=p.m_nodeB[i];
+		const btScalar	cx=p.m_c3[0][i];
+		const btScalar	cy=p.m_c3[1][i];
+		const btScalar	cz=p.m_c3[2][i];
+		const btScalar	j=-(cx*(x[a]-x[b])+cy*(y[a]-y[b])+cz*(z[a]-z[b]))*p.m_c2[i]*kst;
+		const btScalar	ja=j*p.m_im[a];
+		const btScalar	jb=j*p.m_im[b];
+		x[a]+=cx*ja;y[a]+=cy*ja;z[a]+=cz*ja;
+		x[b]-=cx*jb;y[b]-=cy*jb;z[b]-=cz*jb;
+	}
+}
+
+#if !defined(BT_USE_DOUBLE_PRECISION)&&(defined(__GNUC__)||defined(__clang__))&&(defined(__x86_64__)||defined(__i386__))
+#define BT_USE_AVX2_LINKS
+#define BT_AVX2_LINKS_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif !defined(BT_USE_DOUBLE_PRECISION)&&defined(_MSC_VER)&&defined(BT_ALLOW_SSE4)
+#define BT_USE_AVX2_LINKS
+#define BT_AVX2_LINKS_TARGET
+#include <immintrin.h>
+#endif
+
+#ifdef BT_USE_AVX2_LINKS
+#include "LinearMath/btCpuFeatureUtility.h"
+
+//
+// AVX2 kernels, 8 links per iteration: the links of a batch share no node, so the gathered nodes can be scattered back lane by lane
+//
+
+//
+BT_AVX2_LINKS_TARGET static void	solvePackedLinkPositionsAvx2(btSoftBody::PackedLinks& p,int iBegin,int iEnd,btScalar kst)
+{
+	btScalar*		x=&p.m_node[0][0];
+	btScalar*		y=&p.m_node[1][0];
+	btScalar*		z=&p.m_node[2][0];
+	const btScalar*	im=&p.m_im[0];
+	const __m256	vkst=_mm256_set1_ps(kst);
+	const __m256	veps=_mm256_set1_ps(SIMD_EPSILON);
+	const __m256	vzero=_mm256_setzero_ps();
+	ATTRIBUTE_ALIGNED64(int)		ia[8];
+	ATTRIBUTE_ALIGNED64(int)		ib[8];
+	ATTRIBUTE_ALIGNED64(btScalar)	out[6][8];
+	int i=iBegin;
+	for(;i+8<=iEnd;i+=8)
+	{
+		const __m256i	na=_mm256_loadu_si256((const __m256i*)&p.m_nodeA[i]);
+		const __m256i	nb=_mm256_loadu_si256((const __m256i*)&p.m_nodeB[i]);
+		const __m256	c0=_mm256_loadu_ps(&p.m_c0[i]);
+		const __m256	c1=_mm256_loadu_ps(&p.m_c1[i]);
+		const __m256	ax=_mm256_i32gather_ps(x,na,4);
+		const __m256	ay=_mm256_i32gather_ps(y,na,4);
+		const __m256	az=_mm256_i32gather_ps(z,na,4);
+		const __m256	bx=_mm256_i32gather_ps(x,nb,4);
+		const __m256	by=_mm256_i32gather_ps(y,nb,4);
+		const __m256	bz=_mm256_i32gather_ps(z,nb,4);
+		const __m256	dx=_mm256_sub_ps(bx,ax);
+		const __m256	dy=_mm256_sub_ps(by,ay);
+		const __m256	dz=_mm256_sub_ps(bz,az);
+		const __m256	len=_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx,dx),_mm256_mul_ps(dy,dy)),_mm256_mul_ps(dz,dz));
+		const __m256	c1len=_mm256_add_ps(c1,len);
+		const int		mask=_mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(c0,vzero,_CMP_GT_OQ),_mm256_cmp_ps(c1len,veps,_CMP_GT_OQ)));
+		if(!mask) continue;
+		const __m256	k=_mm256_mul_ps(_mm256_div_ps(_mm256_sub_ps(c1,len),_mm256_mul_ps(c0,c1len)),vkst);
+		const __m256	ka=_mm256_mul_ps(k,_mm256_i32gather_ps(im,na,4));
+		const __m256	kb=_mm256_mul_ps(k,_mm256_i32gather_ps(im,nb,4));
+		_mm256_store_ps(out[0],_mm256_sub_ps(ax,_mm256_mul_ps(dx,ka)));
+		_mm256_store_ps(out[1],_mm256_sub_ps(ay,_mm256_mul_ps(dy,ka)));
+		_mm256_store_ps(out[2],_mm256_sub_ps(az,_mm256_mul_ps(dz,ka)));
+		_mm256_store_ps(out[3],_mm256_add_ps(bx,_mm256_mul_ps(dx,kb)));
+		_mm256_store_ps(out[4],_mm256_add_ps(by,_mm256_mul_ps(dy,kb)));
+		_mm256_store_ps(out[5],_mm256_add_ps(bz,_mm256_mul_ps(dz,kb)));
+		_mm256_store_si256((__m256i*)ia,na);
+		_mm256_store_si256((__m256i*)ib,nb);
+		for(int l=0;l<8;++l)
+		{
+			if(mask&(1<<l))
+			{
+				x[ia[l]]=out[0][l];y[ia[l]]=out[1][l];z[ia[l]]=out[2][l];
+				x[ib[l]]=out[3][l];y[ib[l]]=out[4][l];z[ib[l]]=out[5][l];
+			}
+		}
+	}
+	solvePackedLinkPositions(p,i,iEnd,kst);
+}
+
+//
+BT_AVX2_LINKS_TARGET static void	solvePackedLinkVelocitiesAvx2(btSoftBody::PackedLinks& p,int iBegin,int iEnd,btScalar kst)
+{
+	btScalar*		x=&p.m_node[0][0];
+	btScalar*		y=&p.m_node[1][0];
+	btScalar*		z=&p.m_node[2][0];
+	const btScalar*	im=&p.m_im[0];
+	const __m256	vkst=_mm256_set1_ps(kst);
+	const __m256	vsign=_mm256_set1_ps(-0.f);
+	ATTRIBUTE_ALIGNED64(int)		ia[8];
+	ATTRIBUTE_ALIGNED64(int)		ib[8];
+	ATTRIBUTE_ALIGNED64(btScalar)	out[6][8];
+	int i=iBegin;
+	for(;i+8<=iEnd;i+=8)
+	{
+		const __m256i	na=_mm256_loadu_si256((const __m256i*)&p.m_nodeA[i]);
+		const __m256i	nb=_mm256_loadu_si256((const __m256i*)&p.m_nodeB[i]);
+		const __m256	cx=_mm256_loadu_ps(&p.m_c3[0][i]);
+		const __m256	cy=_mm256_loadu_ps(&p.m_c3[1][i]);
+		const __m256	cz=_mm256_loadu_ps(&p.m_c3[2][i]);
+		const __m256	ax=_mm256_i32gather_ps(x,na,4);
+		const __m256	ay=_mm256_i32gather_ps(y,na,4);
+		const __m256	az=_mm256_i32gather_ps(z,na,4);
+		const __m256	bx=_mm256_i32gather_ps(x,nb,4);
+		const __m256	by=_mm256_i32gather_ps(y,nb,4);
+		const __m256	bz=_mm256_i32gather_ps(z,nb,4);
+		const __m256	dot=_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx,_mm256_sub_ps(ax,bx)),_mm256_mul_ps(cy,_mm256_sub_ps(ay,by))),_mm256_mul_ps(cz,_mm256_sub_ps(az,bz)));
+		const __m256	j=_mm256_mul_ps(_mm256_mul_ps(_mm256_xor_ps(dot,vsign),_mm256_loadu_ps(&p.m_c2[i])),vkst);
+		const __m256	ja=_mm256_mul_ps(j,_mm256_i32gather_ps(im,na,4));
+		const __m256	jb=_mm256_mul_ps(j,_mm256_i32gather_ps(im,nb,4));
+		_mm256_store_ps(out[0],_mm256_add_ps(ax,_mm256_mul_ps(cx,ja)));
+		_mm256_store_ps(out[1],_mm256_add_ps(ay,_mm256_mul_ps(cy,ja)));
+		_mm256_store_ps(out[2],_mm256_add_ps(az,_mm256_mul_ps(cz,ja)));
+		_mm256_store_ps(out[3],_mm256_sub_ps(bx,_mm256_mul_ps(cx,jb)));
+		_mm256_store_ps(out[4],_mm256_sub_ps(by,_mm256_mul_ps(cy,jb)));
+		_mm256_store_ps(out[5],_mm256_sub_ps(bz,_mm256_mul_ps(cz,jb)));
+		_mm256_store_si256((__m256i*)ia,na);
+		_mm256_store_si256((__m256i*)ib,nb);
+		for(int l=0;l<8;++l)
+		{
+			x[ia[l]]=out[0][l];y[ia[l]]=out[1][l];z[ia[l]]=out[2][l];
+			x[ib[l]]=out[3][l];y[ib[l]]=out[4][l];z[ib[l]]=out[5][l];
+		}
+	}
+	solvePackedLinkVelocities(p,i,iEnd,kst);
+}
+#endif //BT_USE_AVX2_LINKS
+
+///solves a range of one link batch, the links of a batch share no node
+struct btSoftLinkBatchSolver : public btIParallelForBody
+{
+	enum Stage
+	{
+		SOLVE_POSITIONS,
+		SOLVE_VELOCITIES,
+		SOLVE_PACKED_POSITIONS,
+		SOLVE_PACKED_VELOCITIES,
+		GATHER_POSITIONS,
+		GATHER_VELOCITIES,
+		SCATTER_POSITIONS,
+		SCATTER_VELOCITIES
+	};
+
+	btSoftBody*			m_body;
+	btScalar			m_kst;
+	Stage				m_stage;
+	bool				m_useAvx2;
+
+	void forLoop( int iBegin, int iEnd ) const
+	{
+		btSoftBody::tLinkArray&		links=m_body->m_links;
+		btSoftBody::tNodeArray&		nodes=m_body->m_nodes;
+		btSoftBody::PackedLinks&	packed=m_body->m_packedLinks;
+		switch(m_stage)
+		{
+		case	SOLVE_POSITIONS:
+			for (int i=iBegin;i<iEnd;++i) solveLinkPosition(links[i],m_kst);
+			break;
+		case	SOLVE_VELOCITIES:
+			for (int i=iBegin;i<iEnd;++i) solveLinkVelocity(links[i],m_kst);
+			break;
+		case	SOLVE_PACKED_POSITIONS:
+#ifdef BT_USE_AVX2_LINKS
+			if (m_useAvx2) { solvePackedLinkPositionsAvx2(packed,iBegin,iEnd,m_kst);break; }
+#endif
+			solvePackedLinkPositions(packed,iBegin,iEnd,m_kst);
+			break;
+		case	SOLVE_PACKED_VELOCITIES:
+#ifdef BT_USE_AVX2_LINKS
+			if (m_useAvx2) { solvePackedLinkVelocitiesAvx2(packed,iBegin,iEnd,m_kst);break; }
+#endif
+			solvePackedLinkVelocities(packed,iBegin,iEnd,m_kst);
+			break;
+		case	GATHER_POSITIONS:
+		case	GATHER_VELOCITIES:
+			for (int i=iBegin;i<iEnd;++i)
+			{
+				const btVector3&	v=(m_stage==GATHER_POSITIONS)?nodes[i].m_x:nodes[i].m_v;
+				packed.m_node[0][i]=v.x();
+				packed.m_node[1][i]=v.y();
+				packed.m_node[2][i]=v.z();
+			}
+			break;
+		case	SCATTER_POSITIONS:
+		case	SCATTER_VELOCITIES:
+			for (int i=iBegin;i<iEnd;++i)
+			{
+				btVector3&	v=(m_stage==SCATTER_POSITIONS)?nodes[i].m_x:nodes[i].m_v;
+				v.setValue(packed.m_node[0][i],packed.m_node[1][i],packed.m_node[2][i]);
+			}
+			break;
+		}
+	}
+};
+
+static const int	gLinkBatchGrainSize=256;
+static const int	gNodeCopyGrainSize=1024;
+
+static void			solveLinkBatches(btSoftBody* psb,btScalar kst,bool velocities)
+{
+	btSoftLinkBatchSolver	solver;
+	solver.m_body		=	psb;
+	solver.m_kst		=	kst;
+	solver.m_useAvx2	=	false;
+	const bool	packed=psb->hasPackedLinks();
+	if(packed)
+	{
+#ifdef BT_USE_AVX2_LINKS
+		solver.m_useAvx2	=	(btCpuFeatureUtility::getCpuFeatures()&btCpuFeatureUtility::CPU_FEATURE_AVX2)!=0;
+#endif
+		solver.m_stage	=	velocities?btSoftLinkBatchSolver::GATHER_VELOCITIES:btSoftLinkBatchSolver::GATHER_POSITIONS;
+		btParallelFor(0,psb->m_nodes.size(),gNodeCopyGrainSize,solver);
+		solver.m_stage	=	velocities?btSoftLinkBatchSolver::SOLVE_PACKED_VELOCITIES:btSoftLinkBatchSolver::SOLVE_PACKED_POSITIONS;
+	}
+	else
+	{
+		solver.m_stage	=	velocities?btSoftLinkBatchSolver::SOLVE_VELOCITIES:btSoftLinkBatchSolver::SOLVE_POSITIONS;
+	}
+	for(int i=0,ni=psb->m_linkBatches.size()-1;i<ni;++i)
+	{
+		btParallelFor(psb->m_linkBatches[i],psb->m_linkBatches[i+1],gLinkBatchGrainSize,solver);
+	}
+	if(packed)
+	{
+		solver.m_stage	=	velocities?btSoftLinkBatchSolver::SCATTER_VELOCITIES:btSoftLinkBatchSolver::SCATTER_POSITIONS;
+		btParallelFor(0,psb->m_nodes.size(),gNodeCopyGrainSize,solver);
+	}
+}
+
+//
+void				btSoftBody::packLinks()
+{
+	PackedLinks&	p=m_packedLinks;
+	const int		nl=m_links.size();
+	const int		nn=m_nodes.size();
+	const Node*		nbase=nn?&m_nodes[0]:0;
+	p.m_nodeA.resize(nl);
+	p.m_nodeB.resize(nl);
+	p.m_c0.resize(nl);
+	p.m_c1.resize(nl);
+	p.m_c2.resize(nl);
+	for(int j=0;j<3;++j)
+	{
+		p.m_c3[j].resize(nl);
+		p.m_node[j].resize(nn);
+	}
+	p.m_im.resize(nn);
+	for(int i=0;i<nl;++i)
+	{
+		Link&	l=m_links[i];
+		l.m_c3		=	l.m_n[1]->m_q-l.m_n[0]->m_q;
+		l.m_c2		=	1/(l.m_c3.length2()*l.m_c0);
+		p.m_nodeA[i]	=	int(l.m_n[0]-nbase);
+		p.m_nodeB[i]	=	int(l.m_n[1]-nbase);
+		p.m_c0[i]		=	l.m_c0;
+		p.m_c1[i]		=	l.m_c1;
+		p.m_c2[i]		=	l.m_c2;
+		p.m_c3[0][i]	=	l.m_c3.x();
+		p.m_c3[1][i]	=	l.m_c3.y();
+		p.m_c3[2][i]	=	l.m_c3.z();
+	}
+	for(int i=0;i<nn;++i)
+	{
+		p.m_im[i]	=	m_nodes[i].m_im;
+	}
+}
+
+//
+void				btSoftBody::PSolve_Links(btSoftBody* psb,btScalar kst,btScalar ti)
+{
+	if(psb->hasLinkBatches())
+	{
+		solveLinkBatches(psb,kst,false);
+		return;
+	}
+	for(int i=0,ni=psb->m_links.size();i<ni;++i)
+	{			
+		solveLinkPosition(psb->m_links[i],kst);
+	}
+}
+
 //
 void				btSoftBody::VSolve_Links(btSoftBody* psb,btScalar kst)
 {
+	if(psb->hasLinkBatches())
+	{
+		solveLinkBatches(psb,kst,true);
+		return;
+	}
 	for(int i=0,ni=psb->m_links.size();i<ni;++i)
 	{			
-		Link&			l=psb->m_links[i];
-		Node**			n=l.m_n;
-		const btScalar	j=-btDot(l.m_c3,n[0]->m_v-n[1]->m_v)*l.m_c2*kst;
-		n[0]->m_v+=	l.m_c3*(j*n[0]->m_im);
-		n[1]->m_v-=	l.m_c3*(j*n[1]->m_im);
+		solveLinkVelocity(psb->m_links[i],kst);
 	}
 }
 
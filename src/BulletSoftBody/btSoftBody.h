@@ -602,6 +602,22 @@ public:
 		btScalar				radmrg;			// radial margin
 		btScalar				updmrg;			// Update margin
 	};	
+	/* PackedLinks	*/ 
+	///structure of arrays copy of the batched links, node indices instead of pointers. While the links are solved
+	///the node positions (or velocities) are gathered into m_node and scattered back afterwards, see packLinks
+	struct	PackedLinks
+	{
+		bool							m_enabled;		// Use the packed links (needs generateLinkBatches)
+		btAlignedObjectArray<int>		m_nodeA;		// First node index
+		btAlignedObjectArray<int>		m_nodeB;		// Second node index
+		btAlignedObjectArray<btScalar>	m_c0;			// Link::m_c0
+		btAlignedObjectArray<btScalar>	m_c1;			// Link::m_c1
+		btAlignedObjectArray<btScalar>	m_c2;			// Link::m_c2
+		btAlignedObjectArray<btScalar>	m_c3[3];		// Link::m_c3
+		btAlignedObjectArray<btScalar>	m_im;			// Node::m_im
+		btAlignedObjectArray<btScalar>	m_node[3];		// Node::m_x or Node::m_v while solving
+		PackedLinks() : m_enabled(false) {}
+	};
 	/// RayFromToCaster takes a ray from, ray to (instead of direction!)
 	struct	RayFromToCaster : btDbvt::ICollide
 	{
@@ -655,6 +671,8 @@ public:
 	tNoteArray				m_notes;		// Notes
 	tNodeArray				m_nodes;		// Nodes
 	tLinkArray				m_links;		// Links
+	btAlignedObjectArray<int>	m_linkBatches;	// Link batch offsets, see generateLinkBatches
+	PackedLinks				m_packedLinks;	// Packed copy of the batched links
 	tFaceArray				m_faces;		// Faces
 	tTetraArray				m_tetras;		// Tetras
 	tAnchorArray			m_anchors;		// Anchors
@@ -848,6 +866,25 @@ public:
 		Material* mat=0);
 	/* Randomize constraints to reduce solver bias							*/ 
 	void				randomizeConstraints();
+	/* Sort links into batches that share no node							*/ 
+	///generateLinkBatches greedily colors the links and reorders m_links so that the links of each color are contiguous,
+	///m_linkBatches holds the offsets of the batches (plus m_links.size() at the end). The links of a batch share no node,
+	///so PSolve_Links and VSolve_Links solve each batch with btParallelFor. Within a batch the links are sorted by node index,
+	///for memory locality. Returns the number of batches.
+	///appendLink, cutLink, refine, randomizeConstraints and btSoftBodyHelpers::ReoptimizeLinkOrder drop the batches, code that
+	///changes m_links directly has to clear m_linkBatches itself.
+	int					generateLinkBatches();
+	bool				hasLinkBatches() const
+	{
+		return (m_linkBatches.size()>1)&&(m_linkBatches[m_linkBatches.size()-1]==m_links.size());
+	}
+	/* Prepare the links and copy them and the node masses into m_packedLinks	*/ 
+	///called by solveConstraints and staticSolve when m_packedLinks.m_enabled is set, the batched links are then solved on the packed copy
+	void				packLinks();
+	bool				hasPackedLinks() const
+	{
+		return m_packedLinks.m_enabled&&hasLinkBatches()&&(m_packedLinks.m_nodeA.size()==m_links.size())&&(m_packedLinks.m_im.size()==m_nodes.size());
+	}
 	/* Release clusters														*/ 
 	void				releaseCluster(int index);
 	void				releaseClusters();
@@ -630,6 +630,8 @@ void btSoftBodyHelpers::ReoptimizeLinkOrder(btSoftBody *psb /* This can be repla
 			linkDep = linkDep->next;
 		}
 	}
+	// The new order breaks the link batches
+	psb->m_linkBatches.resize(0);
 
 	// Delete the temporary buffers
 	delete [] nodeWrittenAt;
@@ -19,6 +19,11 @@ subject to the following restrictions:
 
 #include "BulletCollision/CollisionDispatch/btCollisionObject.h"
 #include "BulletCollision/NarrowPhaseCollision/btGjkEpa2.h"
+#include "LinearMath/btThreads.h"
+#include <string.h> //memset, memcpy
+
+///number of locks that guard the hash buckets of btSparseSdf, bucket i is guarded by lock i%BT_SPARSE_SDF_STRIPES
+#define BT_SPARSE_SDF_STRIPES 64
 
 // Modified Paul Hsieh hash
 template <const int DWORDLEN>
@@ -40,6 +45,11 @@ unsigned int HsiehHash(const void* pdata)
 	return(hash);
 }
 
+///btSparseSdf caches signed distance cells of convex shapes in shape space. It is thread safe: the hash buckets are
+///guarded by BT_SPARSE_SDF_STRIPES spin locks, and cells are built outside of the locks. Each lock keeps its cells in
+///least recently used order and evicts the oldest one when it holds more than its share of the cells that m_clampCells
+///leaves after the pinned cells of Precompute.
+///Evaluate, Precompute and RemoveReferences may run concurrently, Initialize, Reset and GarbageCollect are called between steps.
 template <const int CELLSIZE>
 struct	btSparseSdf
 {
@@ -60,6 +70,18 @@ struct	btSparseSdf
 		unsigned			hash;
 		const btCollisionShape*	pclient;
 		Cell*				next;
+		Cell*				lruprev;	// more recently used cell of the same stripe
+		Cell*				lrunext;	// less recently used cell of the same stripe
+		bool				pinned;		// precomputed, not evicted
+	};
+	struct	Stripe
+	{
+		btSpinMutex			mutex;
+		Cell*				lruhead;
+		Cell*				lrutail;
+		int					ncells;		// evictable cells
+		int					nprobes;
+		int					nqueries;
 	};
 	//
 	// Fields
@@ -69,9 +91,11 @@ struct	btSparseSdf
 	btScalar						voxelsz;
 	int								puid;
 	int								ncells;
+	int								npinned;	// pinned cells, counted against m_clampCells
 	int								m_clampCells;
 	int								nprobes;
 	int								nqueries;	
+	Stripe							stripes[BT_SPARSE_SDF_STRIPES];
 
 	//
 	// Methods
@@ -81,7 +105,7 @@ struct	btSparseSdf
 	void					Initialize(int hashsize=2383, int clampCells = 256*1024)
 	{
 		//avoid a crash due to running out of memory, so clamp the maximum number of cells allocated
-		//if this limit is reached, the SDF is reset (at the cost of some performance during the reset)
+		//if this limit is reached, the least recently used cells are released
 		m_clampCells = clampCells;
 		cells.resize(hashsize,0);
 		Reset();
@@ -100,9 +124,19 @@ struct	btSparseSdf
 				pc=pn;
 			}
 		}
+		for(int i=0;i<BT_SPARSE_SDF_STRIPES;++i)
+		{
+			Stripe&	s=stripes[i];
+			s.lruhead	=0;
+			s.lrutail	=0;
+			s.ncells	=0;
+			s.nprobes	=0;
+			s.nqueries	=0;
+		}
 		voxelsz		=0.25;
 		puid		=0;
 		ncells		=0;
+		npinned		=0;
 		nprobes		=1;
 		nqueries	=1;
 	}
@@ -110,27 +144,32 @@ struct	btSparseSdf
 	void					GarbageCollect(int lifetime=256)
 	{
 		const int life=puid-lifetime;
+		nqueries=1;
+		nprobes=1;
+		for(int i=0;i<BT_SPARSE_SDF_STRIPES;++i)
+		{
+			nqueries+=stripes[i].nqueries;stripes[i].nqueries=0;
+			nprobes+=stripes[i].nprobes;stripes[i].nprobes=0;
+		}
 		for(int i=0;i<cells.size();++i)
 		{
+			Stripe&	s=stripes[i%BT_SPARSE_SDF_STRIPES];
 			Cell*&	root=cells[i];
 			Cell*	pp=0;
 			Cell*	pc=root;
 			while(pc)
 			{
 				Cell*	pn=pc->next;
-				if(pc->puid<life)
+				if((pc->puid<life)&&(!pc->pinned))
 				{
 					if(pp) pp->next=pn; else root=pn;
-					delete pc;pc=pp;--ncells;
+					ReleaseCell(s,pc);pc=pp;
 				}
 				pp=pc;pc=pn;
 			}
 		}
 		//printf("GC[%d]: %d cells, PpQ: %f\r\n",puid,ncells,nprobes/(btScalar)nqueries);
-		nqueries=1;
-		nprobes=1;
 		++puid;	///@todo: Reset puid's when int range limit is reached	*/ 
-		/* else setup a priority list...						*/ 
 	}
 	//
 	int						RemoveReferences(btCollisionShape* pcs)
@@ -138,6 +177,8 @@ struct	btSparseSdf
 		int	refcount=0;
 		for(int i=0;i<cells.size();++i)
 		{
+			Stripe&	s=stripes[i%BT_SPARSE_SDF_STRIPES];
+			btMutexLock(&s.mutex);
 			Cell*&	root=cells[i];
 			Cell*	pp=0;
 			Cell*	pc=root;
@@ -147,14 +188,55 @@ struct	btSparseSdf
 				if(pc->pclient==pcs)
 				{
 					if(pp) pp->next=pn; else root=pn;
-					delete pc;pc=pp;++refcount;
+					ReleaseCell(s,pc);pc=pp;++refcount;
 				}
 				pp=pc;pc=pn;
 			}
+			btMutexUnlock(&s.mutex);
 		}
 		return(refcount);
 	}
 	//
+	///builds the cells that cover the aabb of a convex shape, grown by margin, and pins them so GarbageCollect and the
+	///cell limit keep them. Call it for static shapes at load time to avoid building cells at the first contact.
+	///The cells are built with btParallelFor. Returns the number of cells, or 0 without building anything if pinning them
+	///would take the pinned cells of all Precompute calls beyond m_clampCells.
+	int						Precompute(const btCollisionShape* shape,btScalar margin)
+	{
+		if(!shape->isConvex()) return(0);
+		btTransform	unit;
+		unit.setIdentity();
+		btVector3	mins,maxs;
+		shape->getAabb(unit,mins,maxs);
+		const btVector3	mrg(margin,margin,margin);
+		const btVector3	lo=(mins-mrg)/voxelsz;
+		const btVector3	hi=(maxs+mrg)/voxelsz;
+		const int		b0[]={Decompose(lo.x()).b,Decompose(lo.y()).b,Decompose(lo.z()).b};
+		const int		b1[]={Decompose(hi.x()).b,Decompose(hi.y()).b,Decompose(hi.z()).b};
+		PrecomputeBody	body;
+		body.sdf	=this;
+		body.shape	=shape;
+		for(int j=0;j<3;++j)
+		{
+			body.origin[j]	=b0[j];
+			body.extent[j]	=b1[j]-b0[j]+1;
+		}
+		const btScalar	volume=btScalar(body.extent[0])*btScalar(body.extent[1])*btScalar(body.extent[2]);
+		if(volume>m_clampCells) return(0);
+		const int	count=body.extent[0]*body.extent[1]*body.extent[2];
+		/* Reserve the cells up front, so concurrent calls can't pass the limit together	*/ 
+		if(btAtomicFetchAdd(&npinned,count)+count>m_clampCells)
+		{
+			btAtomicFetchAdd(&npinned,-count);
+			return(0);
+		}
+		body.npinned=0;
+		btParallelFor(0,count,1,body);
+		/* Cells pinned by an earlier call were reserved twice	*/ 
+		btAtomicFetchAdd(&npinned,body.npinned-count);
+		return(count);
+	}
+	//
 	btScalar				Evaluate(	const btVector3& x,
 		const btCollisionShape* shape,
 		btVector3& normal,
@@ -165,43 +247,8 @@ struct	btSparseSdf
 		const IntFrac	ix=Decompose(scx.x());
 		const IntFrac	iy=Decompose(scx.y());
 		const IntFrac	iz=Decompose(scx.z());
-		const unsigned	h=Hash(ix.b,iy.b,iz.b,shape);
-		Cell*&			root=cells[static_cast<int>(h%cells.size())];
-		Cell*			c=root;
-		++nqueries;
-		while(c)
-		{
-			++nprobes;
-			if(	(c->hash==h)	&&
-				(c->c[0]==ix.b)	&&
-				(c->c[1]==iy.b)	&&
-				(c->c[2]==iz.b)	&&
-				(c->pclient==shape))
-			{ break; }
-			else
-			{ c=c->next; }
-		}
-		if(!c)
-		{
-			++nprobes;		
-			++ncells;
-			int sz = sizeof(Cell);
-			if (ncells>m_clampCells)
-			{
-				static int numResets=0;
-				numResets++;
-//				printf("numResets=%d\n",numResets);
-				Reset();
-			}
-
-			c=new Cell();
-			c->next=root;root=c;
-			c->pclient=shape;
-			c->hash=h;
-			c->c[0]=ix.b;c->c[1]=iy.b;c->c[2]=iz.b;
-			BuildCell(*c);
-		}
-		c->puid=puid;
+		Stripe*			s;
+		const Cell*		c=AcquireCell(ix.b,iy.b,iz.b,shape,false,s);
 		/* Extract infos		*/ 
 		const int		o[]={	ix.i,iy.i,iz.i};
 		const btScalar	d[]={	c->d[o[0]+0][o[1]+0][o[2]+0],
@@ -212,6 +259,7 @@ struct	btSparseSdf
 			c->d[o[0]+1][o[1]+0][o[2]+1],
 			c->d[o[0]+1][o[1]+1][o[2]+1],
 			c->d[o[0]+0][o[1]+1][o[2]+1]};
+		btMutexUnlock(&s->mutex);
 		/* Normal	*/ 
 #if 1
 		const btScalar	gx[]={	d[1]-d[0],d[2]-d[3],
@@ -238,6 +286,150 @@ struct	btSparseSdf
 		return(Lerp(d0,d1,iz.f)-margin);
 	}
 	//
+	///returns the cell with its stripe locked, the caller unlocks stripe->mutex. A missing cell is built without holding the lock.
+	///With pin the cell is pinned, and newlyPinned is incremented if it wasn't pinned before; npinned is updated by the caller.
+	Cell*					AcquireCell(int x,int y,int z,const btCollisionShape* shape,bool pin,Stripe*& stripe,volatile int* newlyPinned=0)
+	{
+		const unsigned	h=Hash(x,y,z,shape);
+		const int		bucket=static_cast<int>(h%cells.size());
+		Stripe&			s=stripes[bucket%BT_SPARSE_SDF_STRIPES];
+		btMutexLock(&s.mutex);
+		++s.nqueries;
+		Cell*			c=FindCell(s,bucket,h,x,y,z,shape);
+		if(!c)
+		{
+			btMutexUnlock(&s.mutex);
+			Cell*	nc=new Cell();
+			nc->pclient=shape;
+			nc->hash=h;
+			nc->c[0]=x;nc->c[1]=y;nc->c[2]=z;
+			nc->pinned=false;
+			BuildCell(*nc);
+			btMutexLock(&s.mutex);
+			/* Another thread might have built it meanwhile	*/ 
+			c=FindCell(s,bucket,h,x,y,z,shape);
+			if(c)
+			{
+				delete nc;
+			}
+			else
+			{
+				if((s.ncells>=btMax(1,(m_clampCells-npinned)/BT_SPARSE_SDF_STRIPES))&&s.lrutail)
+				{
+					EvictCell(s);
+				}
+				c=nc;
+				c->next=cells[bucket];cells[bucket]=c;
+				c->lruprev=c->lrunext=0;
+				LinkLru(s,c);
+				++s.ncells;
+				btAtomicFetchAdd(&ncells,1);
+			}
+		}
+		c->puid=puid;
+		if(!c->pinned)
+		{
+			UnlinkLru(s,c);
+			if(pin)
+			{
+				c->pinned=true;
+				--s.ncells;
+				if(newlyPinned) btAtomicFetchAdd(newlyPinned,1);
+			}
+			else
+			{
+				LinkLru(s,c);
+			}
+		}
+		stripe=&s;
+		return(c);
+	}
+	//
+	Cell*					FindCell(Stripe& s,int bucket,unsigned h,int x,int y,int z,const btCollisionShape* shape)
+	{
+		Cell*	c=cells[bucket];
+		while(c)
+		{
+			++s.nprobes;
+			if(	(c->hash==h)	&&
+				(c->c[0]==x)	&&
+				(c->c[1]==y)	&&
+				(c->c[2]==z)	&&
+				(c->pclient==shape))
+			{ break; }
+			else
+			{ c=c->next; }
+		}
+		return(c);
+	}
+	//
+	static void				LinkLru(Stripe& s,Cell* c)
+	{
+		c->lruprev=0;
+		c->lrunext=s.lruhead;
+		if(s.lruhead) s.lruhead->lruprev=c; else s.lrutail=c;
+		s.lruhead=c;
+	}
+	//
+	static void				UnlinkLru(Stripe& s,Cell* c)
+	{
+		if(c->lruprev) c->lruprev->lrunext=c->lrunext; else s.lruhead=c->lrunext;
+		if(c->lrunext) c->lrunext->lruprev=c->lruprev; else s.lrutail=c->lruprev;
+		c->lruprev=c->lrunext=0;
+	}
+	//
+	///deletes a cell that was already removed from its bucket
+	void					ReleaseCell(Stripe& s,Cell* c)
+	{
+		if(!c->pinned)
+		{
+			UnlinkLru(s,c);
+			--s.ncells;
+		}
+		else
+		{
+			btAtomicFetchAdd(&npinned,-1);
+		}
+		btAtomicFetchAdd(&ncells,-1);
+		delete c;
+	}
+	//
+	///releases the least recently used cell of a stripe, the stripe is locked
+	void					EvictCell(Stripe& s)
+	{
+		Cell*	c=s.lrutail;
+		const int	bucket=static_cast<int>(c->hash%cells.size());
+		Cell*	pp=0;
+		Cell*	pc=cells[bucket];
+		while(pc!=c)
+		{
+			pp=pc;pc=pc->next;
+		}
+		if(pp) pp->next=c->next; else cells[bucket]=c->next;
+		ReleaseCell(s,c);
+	}
+	//
+	struct	PrecomputeBody : public btIParallelForBody
+	{
+		btSparseSdf*				sdf;
+		const btCollisionShape*		shape;
+		int							origin[3];
+		int							extent[3];
+		mutable volatile int		npinned;	// cells this call pinned, the others were pinned before
+		void forLoop(int iBegin,int iEnd) const
+		{
+			for(int i=iBegin;i<iEnd;++i)
+			{
+				const int	x=origin[0]+i%extent[0];
+				const int	y=origin[1]+(i/extent[0])%extent[1];
+				const int	z=origin[2]+i/(extent[0]*extent[1]);
+				Stripe*		s;
+				sdf->AcquireCell(x,y,z,shape,true,s,&npinned);
+				btMutexUnlock(&s->mutex);
+			}
+		}
+	};
+	//
 	void					BuildCell(Cell& c)
 	{
 		const btVector3	org=btVector3(	(btScalar)c.c[0],
@@ -299,16 +491,19 @@ struct	btSparseSdf
 	{
 		struct btS
 		{ 
-			int x,y,z;
+			int x,y,z,w;
 			void* p;
 		};
 
 		btS myset;
-
+		//clear the padding, and hash a copy that really is an array of 16 bit words: reading the struct through an
+		//unsigned short pointer let the optimizer drop the stores, so equal cells got different hashes
+		memset(&myset,0,sizeof(btS));
 		myset.x=x;myset.y=y;myset.z=z;myset.p=(void*)shape;
-		const void* ptr = &myset;
+		unsigned short	data[sizeof(btS)/2];
+		memcpy(data,&myset,sizeof(btS));
 
-		unsigned int result = HsiehHash<sizeof(btS)/4> (ptr);
+		unsigned int result = HsiehHash<sizeof(btS)/4> (data);
 
 
 		return result;
@@ -19,7 +19,7 @@
 #include <sys/sysctl.h> //for sysctlbyname
 #endif //BT_USE_NEON
 
-///Rudimentary btCpuFeatureUtility for CPU features: only report the features that Bullet actually uses (SSE4/FMA3, NEON_HPFP)
+///Rudimentary btCpuFeatureUtility for CPU features: only report the features that Bullet actually uses (SSE4/FMA3, AVX, AVX2, NEON_HPFP)
 ///We assume SSE2 in case BT_USE_SSE2 is defined in LinearMath/btScalar.h
 class btCpuFeatureUtility
 {
@@ -28,7 +28,9 @@ public:
 	{
 		CPU_FEATURE_FMA3=1,
 		CPU_FEATURE_SSE4_1=2,
-		CPU_FEATURE_NEON_HPFP=4
+		CPU_FEATURE_NEON_HPFP=4,
+		CPU_FEATURE_AVX=8,
+		CPU_FEATURE_AVX2=16
 	};
 
 	static int getCpuFeatures()
@@ -67,6 +69,10 @@ public:
 			}
 			const int OSXSAVEFlag = (1UL << 27);
 			const int AVXFlag = ((1UL << 28) | OSXSAVEFlag);
+			if ((cpuInfo[2] & AVXFlag) == AVXFlag && (sseExt & 6) == 6)
+			{
+				capabilities |= btCpuFeatureUtility::CPU_FEATURE_AVX;
+			}
 			const int FMAFlag = ((1UL << 12) | AVXFlag | OSXSAVEFlag);
 			if ((cpuInfo[2] & FMAFlag) == FMAFlag && (sseExt & 6) == 6)
 			{
@@ -78,9 +84,30 @@ public:
 			{
 				capabilities |= btCpuFeatureUtility::CPU_FEATURE_SSE4_1;
 			}
+			if (capabilities & btCpuFeatureUtility::CPU_FEATURE_AVX)
+			{
+				__cpuidex(cpuInfo, 7, 0);
+				const int AVX2Flag = (1 << 5);
+				if (cpuInfo[1] & AVX2Flag)
+				{
+					capabilities |= btCpuFeatureUtility::CPU_FEATURE_AVX2;
+				}
+			}
 		}
 #endif//BT_ALLOW_SSE4
 
+#if (defined (__GNUC__) || defined (__clang__)) && (defined (__x86_64__) || defined (__i386__))
+		//GCC and Clang check the OS support for the AVX registers as well
+		if (__builtin_cpu_supports("avx"))
+		{
+			capabilities |= btCpuFeatureUtility::CPU_FEATURE_AVX;
+		}
+		if (__builtin_cpu_supports("avx2"))
+		{
+			capabilities |= btCpuFeatureUtility::CPU_FEATURE_AVX2;
+		}
+#endif
+
 		testedCapabilities = true;
 		return capabilities;
 	}
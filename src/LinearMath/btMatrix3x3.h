@@ -703,7 +703,7 @@ public:
 } btMatrix3x3;
 #endif// __cplusplus
 
-static SIMD_FORCE_INLINE btMatrix3x3 btMatrix3x3_setValue(btMatrix3x3* self,
+static SIMD_FORCE_INLINE void btMatrix3x3_setValue(btMatrix3x3* self,
 	btScalar xx, btScalar xy, btScalar xz,
 	btScalar yx, btScalar yy, btScalar yz,
 	btScalar zx, btScalar zy, btScalar zz)
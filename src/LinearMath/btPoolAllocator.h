@@ -18,8 +18,16 @@ subject to the following restrictions:
 
 #include "btScalar.h"
 #include "btAlignedAllocator.h"
+#include "btMinMax.h"
+
+///maximum number of memory chunks a growable btPoolAllocator can own, chunks grow geometrically so this is never the limit in practice
+#define BT_POOL_ALLOCATOR_MAX_CHUNKS 32
 
 ///The btPoolAllocator class allows to efficiently allocate a large pool of objects, instead of dynamically allocating them separately.
+///By default the pool has a fixed capacity. Use setGrowSize to let the pool add chunks when it runs out, and reserve to raise the capacity at runtime.
+///Freed elements go back on a single free list in O(1), whatever chunk they came from. Chunks are only released when the pool is destroyed.
+///The pool is not thread safe: allocate, reserve and freeMemory change the chunk list and the free list, so threads that share
+///a pool need to lock around every call, validPtr included.
 class btPoolAllocator
 {
 	int				m_elemSize;
@@ -27,29 +35,63 @@ class btPoolAllocator
 	int				m_freeCount;
 	void*			m_firstFree;
 	unsigned char*	m_pool;
+	int				m_growSize;
+	int				m_highWaterMark;
+	int				m_numChunks;
+	unsigned char*	m_chunks[BT_POOL_ALLOCATOR_MAX_CHUNKS];
+	int				m_chunkBytes[BT_POOL_ALLOCATOR_MAX_CHUNKS];
+
+	void	addChunk(int numElements)
+	{
+		btAssert(numElements>0 && m_numChunks<BT_POOL_ALLOCATOR_MAX_CHUNKS);
+		unsigned char* chunk = (unsigned char*) btAlignedAlloc( static_cast<unsigned int>(m_elemSize*numElements),16);
+
+		unsigned char* p = chunk;
+		int count = numElements;
+		while (--count) {
+			*(void**)p = (p + m_elemSize);
+			p += m_elemSize;
+		}
+		*(void**)p = m_firstFree;
+		m_firstFree = chunk;
+		m_freeCount += numElements;
+		m_maxElements += numElements;
+
+		m_chunks[m_numChunks] = chunk;
+		m_chunkBytes[m_numChunks] = m_elemSize*numElements;
+		m_numChunks++;
+	}
+
+	bool	canGrow() const
+	{
+		return m_growSize>0 && m_numChunks<BT_POOL_ALLOCATOR_MAX_CHUNKS;
+	}
 
 public:
 
 	btPoolAllocator(int elemSize, int maxElements)
 		:m_elemSize(elemSize),
-		m_maxElements(maxElements)
+		m_maxElements(0),
+		m_freeCount(0),
+		m_firstFree(0),
+		m_pool(0),
+		m_growSize(0),
+		m_highWaterMark(0),
+		m_numChunks(0)
 	{
-		m_pool = (unsigned char*) btAlignedAlloc( static_cast<unsigned int>(m_elemSize*m_maxElements),16);
-
-		unsigned char* p = m_pool;
-        m_firstFree = p;
-        m_freeCount = m_maxElements;
-        int count = m_maxElements;
-        while (--count) {
-            *(void**)p = (p + m_elemSize);
-            p += m_elemSize;
-        }
-        *(void**)p = 0;
-    }
+		if (maxElements>0)
+		{
+			addChunk(maxElements);
+			m_pool = m_chunks[0];
+		}
+	}
 
 	~btPoolAllocator()
 	{
-		btAlignedFree( m_pool);
+		for (int i=0;i<m_numChunks;i++)
+		{
+			btAlignedFree( m_chunks[i]);
+		}
 	}
 
 	int	getFreeCount() const
@@ -67,24 +109,88 @@ public:
 		return m_maxElements;
 	}
 
+	///true if allocate can return an element, either from the free list or by adding a chunk
+	bool	canAllocate() const
+	{
+		return m_freeCount>0 || canGrow();
+	}
+
+	///number of elements added when an empty pool grows, 0 (default) keeps the pool at a fixed capacity.
+	///A new chunk holds at least half the current capacity, so the number of chunks stays small.
+	void	setGrowSize(int growSize)
+	{
+		m_growSize = growSize;
+	}
+
+	int	getGrowSize() const
+	{
+		return m_growSize;
+	}
+
+	///grows the pool to hold at least maxElements, existing elements stay valid. The capacity never shrinks.
+	void	reserve(int maxElements)
+	{
+		if (maxElements>m_maxElements && m_numChunks<BT_POOL_ALLOCATOR_MAX_CHUNKS)
+		{
+			addChunk(maxElements-m_maxElements);
+			if (!m_pool)
+			{
+				m_pool = m_chunks[0];
+			}
+		}
+	}
+
+	///largest number of elements in use at once since construction or the last resetHighWaterMark
+	int	getHighWaterMark() const
+	{
+		return m_highWaterMark;
+	}
+
+	void	resetHighWaterMark()
+	{
+		m_highWaterMark = getUsedCount();
+	}
+
+	int	getNumChunks() const
+	{
+		return m_numChunks;
+	}
+
 	void*	allocate(int size)
 	{
 		// release mode fix
 		(void)size;
 		btAssert(!size || size<=m_elemSize);
+		if (!m_freeCount && canGrow())
+		{
+			addChunk(btMax(m_growSize,m_maxElements/2));
+			if (!m_pool)
+			{
+				m_pool = m_chunks[0];
+			}
+		}
 		btAssert(m_freeCount>0);
         void* result = m_firstFree;
         m_firstFree = *(void**)m_firstFree;
         --m_freeCount;
+		int used = m_maxElements - m_freeCount;
+		if (used>m_highWaterMark)
+		{
+			m_highWaterMark = used;
+		}
         return result;
 	}
 
 	bool validPtr(void* ptr)
 	{
 		if (ptr) {
-			if (((unsigned char*)ptr >= m_pool && (unsigned char*)ptr < m_pool + m_maxElements * m_elemSize))
+			int numChunks = m_numChunks;
+			for (int i=0;i<numChunks;i++)
 			{
-				return true;
+				if ((unsigned char*)ptr >= m_chunks[i] && (unsigned char*)ptr < m_chunks[i] + m_chunkBytes[i])
+				{
+					return true;
+				}
 			}
 		}
 		return false;
@@ -93,7 +199,7 @@ public:
 	void	freeMemory(void* ptr)
 	{
 		 if (ptr) {
-            btAssert((unsigned char*)ptr >= m_pool && (unsigned char*)ptr < m_pool + m_maxElements * m_elemSize);
+            btAssert(validPtr(ptr));
 
             *(void**)ptr = m_firstFree;
             m_firstFree = ptr;
@@ -106,6 +212,7 @@ public:
 		return m_elemSize;
 	}
 
+	///address of the first chunk
 	unsigned char*	getPoolAddress()
 	{
 		return m_pool;
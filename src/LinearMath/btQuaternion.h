@@ -190,6 +190,7 @@ public:
 	btQuaternion& operator/=(const btScalar& s) 
 	{
 		btVector_divide(this, s, BT_VEC4_MODE);
+		return *this;
 	}
 
   /**@brief Return a normalized version of this quaternion */
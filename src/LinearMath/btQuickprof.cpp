@@ -14,6 +14,8 @@
 // Ogre (www.ogre3d.org).
 
 #include "btQuickprof.h"
+#include "btThreads.h"
+#include "btAlignedObjectArray.h"
 
 #ifndef BT_NO_PROFILE
 
@@ -55,6 +57,11 @@ static btClock gProfileClock;
 
 #else //_WIN32
 #include <sys/time.h>
+#include <time.h>
+#if defined(CLOCK_MONOTONIC) && !defined(__CELLOS_LV2__)
+//monotonic clock with nanosecond resolution, reading it doesn't enter the kernel on Linux
+#define BT_USE_CLOCK_GETTIME
+#endif
 #endif //_WIN32
 
 #define mymin(a,b) (a > b ? a : b)
@@ -70,6 +77,8 @@ struct btClockData
 #else
 #ifdef __CELLOS_LV2__
 	uint64_t	mStartTime;
+#elif defined(BT_USE_CLOCK_GETTIME)
+	struct timespec mStartTime;
 #else
 	struct timeval mStartTime;
 #endif
@@ -120,6 +129,8 @@ void btClock::reset()
 	//__asm __volatile__( "mftb %0" : "=r" (newTime) : : "memory");
 	SYS_TIMEBASE_GET( newTime );
 	m_data->mStartTime = newTime;
+#elif defined(BT_USE_CLOCK_GETTIME)
+	clock_gettime(CLOCK_MONOTONIC, &m_data->mStartTime);
 #else
 	gettimeofday(&m_data->mStartTime, 0);
 #endif
@@ -172,6 +183,8 @@ unsigned long int btClock::getTimeMilliseconds()
 		//__asm __volatile__( "mftb %0" : "=r" (newTime) : : "memory");
 
 		return (unsigned long int)((double(newTime-m_data->mStartTime)) / dFreq);
+#elif defined(BT_USE_CLOCK_GETTIME)
+		return (unsigned long int)(getTimeNanoseconds() / 1000000);
 #else
 
 		struct timeval currentTime;
@@ -230,6 +243,8 @@ unsigned long int btClock::getTimeMicroseconds()
 		SYS_TIMEBASE_GET( newTime );
 
 		return (unsigned long int)((double(newTime-m_data->mStartTime)) / dFreq);
+#elif defined(BT_USE_CLOCK_GETTIME)
+		return (unsigned long int)(getTimeNanoseconds() / 1000);
 #else
 
 		struct timeval currentTime;
@@ -240,6 +255,44 @@ unsigned long int btClock::getTimeMicroseconds()
 #endif
 }
 
+	/// Returns the time in ns since the last call to reset or since
+	/// the Clock was created.
+unsigned long long int btClock::getTimeNanoseconds()
+{
+#ifdef BT_USE_WINDOWS_TIMERS
+		LARGE_INTEGER currentTime;
+		QueryPerformanceCounter(&currentTime);
+		LONGLONG elapsedTime = currentTime.QuadPart -
+			m_data->mStartTime.QuadPart;
+		LONGLONG frequency = m_data->mClockFrequency.QuadPart;
+		// Split in seconds and the remainder, so the conversion doesn't overflow
+		return (unsigned long long int)(elapsedTime / frequency) * 1000000000ULL +
+			(unsigned long long int)((elapsedTime % frequency) * 1000000000LL / frequency);
+#else
+
+#ifdef __CELLOS_LV2__
+		uint64_t freq=sys_time_get_timebase_frequency();
+		double dFreq=((double) freq)/ 1000000000.0;
+		typedef uint64_t  ClockSize;
+		ClockSize newTime;
+		SYS_TIMEBASE_GET( newTime );
+
+		return (unsigned long long int)((double(newTime-m_data->mStartTime)) / dFreq);
+#elif defined(BT_USE_CLOCK_GETTIME)
+		struct timespec currentTime;
+		clock_gettime(CLOCK_MONOTONIC, &currentTime);
+		return (unsigned long long int)(currentTime.tv_sec - m_data->mStartTime.tv_sec) * 1000000000ULL +
+			(currentTime.tv_nsec - m_data->mStartTime.tv_nsec);
+#else
+
+		struct timeval currentTime;
+		gettimeofday(&currentTime, 0);
+		return (unsigned long long int)(currentTime.tv_sec - m_data->mStartTime.tv_sec) * 1000000000ULL +
+			(currentTime.tv_usec - m_data->mStartTime.tv_usec) * 1000;
+#endif//__CELLOS_LV2__
+#endif
+}
+
 
 
 /// Returns the time in s since the last call to reset or since 
@@ -252,15 +305,15 @@ btScalar btClock::getTimeSeconds()
 
 
 
-inline void Profile_Get_Ticks(unsigned long int * ticks)
+inline void Profile_Get_Ticks(unsigned long long int * ticks)
 {
-	*ticks = gProfileClock.getTimeMicroseconds();
+	*ticks = gProfileClock.getTimeNanoseconds();
 }
 
 inline float Profile_Get_Tick_Rate(void)
 {
-//	return 1000000.f;
-	return 1000.f;
+	//ticks per millisecond
+	return 1000000.f;
 
 }
 
@@ -290,6 +343,7 @@ CProfileNode::CProfileNode( const char * name, CProfileNode * parent ) :
 	Parent( parent ),
 	Child( NULL ),
 	Sibling( NULL ),
+	LastSubNode( NULL ),
 	m_userPtr(0)
 {
 	Reset();
@@ -302,6 +356,7 @@ void	CProfileNode::CleanupMemory()
 	Child = NULL;
 	delete ( Sibling);
 	Sibling = NULL;
+	LastSubNode = NULL;
 }
 
 CProfileNode::~CProfileNode( void )
@@ -317,23 +372,44 @@ CProfileNode::~CProfileNode( void )
  * WARNINGS:                                                                                   *
  * All profile names are assumed to be static strings so this function uses pointer compares   *
  * to find the named node.                                                                     *
+ * Children are kept in the order they were first entered and the search starts after the      *
+ * previously returned child, so a scope that enters the same children in the same order every *
+ * frame finds each of them with a single compare.                                             *
  *=============================================================================================*/
 CProfileNode * CProfileNode::Get_Sub_Node( const char * name )
 {
-	// Try to find this sub node
-	CProfileNode * child = Child;
+	// Try to find this sub node, starting after the last one
+	CProfileNode * start = (LastSubNode && LastSubNode->Sibling) ? LastSubNode->Sibling : Child;
+	CProfileNode * child = start;
 	while ( child ) {
 		if ( child->Name == name ) {
+			LastSubNode = child;
+			return child;
+		}
+		child = child->Sibling;
+	}
+	child = Child;
+	while ( child != start ) {
+		if ( child->Name == name ) {
+			LastSubNode = child;
 			return child;
 		}
 		child = child->Sibling;
 	}
 
-	// We didn't find it, so add it
+	// We didn't find it, so add it at the end
 
 	CProfileNode * node = new CProfileNode( name, this );
-	node->Sibling = Child;
-	Child = node;
+	if ( Child ) {
+		CProfileNode * last = Child;
+		while ( last->Sibling ) {
+			last = last->Sibling;
+		}
+		last->Sibling = node;
+	} else {
+		Child = node;
+	}
+	LastSubNode = node;
 	return node;
 }
 
@@ -365,7 +441,7 @@ void	CProfileNode::Call( void )
 bool	CProfileNode::Return( void )
 {
 	if ( --RecursionCounter == 0 && TotalCalls != 0 ) {
-		unsigned long int time;
+		unsigned long long int time;
 		Profile_Get_Ticks(&time);
 		time-=StartTime;
 		TotalTime += (float)time / Profile_Get_Tick_Rate();
@@ -435,9 +511,54 @@ void	CProfileIterator::Enter_Parent( void )
 ***************************************************************************************************/
 
 CProfileNode	CProfileManager::Root( "Root", NULL );
-CProfileNode *	CProfileManager::CurrentNode = &CProfileManager::Root;
 int				CProfileManager::FrameCounter = 0;
-unsigned long int			CProfileManager::ResetTime = 0;
+unsigned long long int			CProfileManager::ResetTime = 0;
+bool			CProfileManager::TraceEnabled = false;
+
+struct btProfileEvent
+{
+	const char*				m_name;
+	unsigned long long int	m_startTime;
+	unsigned long long int	m_endTime;
+};
+
+///btProfileThreadData is the profile state of one thread, only that thread writes to it while it takes samples
+ATTRIBUTE_ALIGNED64(struct) btProfileThreadData
+{
+	CProfileNode*							m_root;
+	CProfileNode*							m_currentNode;
+	btAlignedObjectArray<btProfileEvent>	m_events;
+	btAlignedObjectArray<int>				m_openEvents;	// Events that are started but not stopped yet
+
+	btProfileThreadData()
+		:m_root(0),
+		m_currentNode(0)
+	{
+	}
+};
+
+static btProfileThreadData gProfileThreads[BT_MAX_THREAD_COUNT];
+
+//trace timestamps are relative to the last Clear_Trace, unlike the profile clock they are not reset every frame
+static btClock gTraceClock;
+
+//the main thread records into mainRoot, the other threads get their own tree on their first sample.
+//Returns 0 for threads without an index of their own (BT_OVERFLOW_THREAD_INDEX is shared), their samples are dropped
+static btProfileThreadData* getProfileThreadData(CProfileNode* mainRoot)
+{
+	unsigned int threadIndex = btGetCurrentThreadIndex();
+	if (threadIndex >= BT_OVERFLOW_THREAD_INDEX)
+	{
+		return 0;
+	}
+	btProfileThreadData& threadData = gProfileThreads[threadIndex];
+	if (!threadData.m_root)
+	{
+		threadData.m_root = btIsMainThread() ? mainRoot : new CProfileNode( "Root", NULL );
+		threadData.m_currentNode = threadData.m_root;
+	}
+	return &threadData;
+}
 
 
 /***********************************************************************************************
@@ -455,11 +576,26 @@ unsigned long int			CProfileManager::ResetTime = 0;
  *=============================================================================================*/
 void	CProfileManager::Start_Profile( const char * name )
 {
-	if (name != CurrentNode->Get_Name()) {
-		CurrentNode = CurrentNode->Get_Sub_Node( name );
+	btProfileThreadData* threadDataPtr = getProfileThreadData(&Root);
+	if (!threadDataPtr)
+	{
+		return;
+	}
+	btProfileThreadData& threadData = *threadDataPtr;
+	if (name != threadData.m_currentNode->Get_Name()) {
+		threadData.m_currentNode = threadData.m_currentNode->Get_Sub_Node( name );
 	}
 
-	CurrentNode->Call();
+	threadData.m_currentNode->Call();
+
+	if (TraceEnabled)
+	{
+		btProfileEvent& event = threadData.m_events.expandNonInitializing();
+		event.m_name = name;
+		event.m_startTime = gTraceClock.getTimeNanoseconds();
+		event.m_endTime = 0;
+		threadData.m_openEvents.push_back(threadData.m_events.size()-1);
+	}
 }
 
 
@@ -468,11 +604,55 @@ void	CProfileManager::Start_Profile( const char * name )
  *=============================================================================================*/
 void	CProfileManager::Stop_Profile( void )
 {
+	btProfileThreadData* threadDataPtr = getProfileThreadData(&Root);
+	if (!threadDataPtr)
+	{
+		return;
+	}
+	btProfileThreadData& threadData = *threadDataPtr;
+	if (TraceEnabled && threadData.m_openEvents.size())
+	{
+		threadData.m_events[threadData.m_openEvents[threadData.m_openEvents.size()-1]].m_endTime = gTraceClock.getTimeNanoseconds();
+		threadData.m_openEvents.pop_back();
+	}
 	// Return will indicate whether we should back up to our parent (we may
 	// be profiling a recursive function)
-	if (CurrentNode->Return()) {
-		CurrentNode = CurrentNode->Get_Parent();
+	if (threadData.m_currentNode->Return()) {
+		threadData.m_currentNode = threadData.m_currentNode->Get_Parent();
+	}
+}
+
+
+void	CProfileManager::CleanupMemory(void)
+{
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		btProfileThreadData& threadData = gProfileThreads[i];
+		if (threadData.m_root == &Root)
+		{
+			Root.CleanupMemory();
+			threadData.m_currentNode = &Root;
+		}
+		else if (threadData.m_root)
+		{
+			//the root of a worker thread was allocated on its first sample, it gets a new one on the next
+			delete threadData.m_root;
+			threadData.m_root = 0;
+			threadData.m_currentNode = 0;
+		}
+	}
+}
+
+
+CProfileIterator *	CProfileManager::Get_Iterator( int threadIndex )
+{
+	if (threadIndex == 0)
+	{
+		return new CProfileIterator( &Root );
 	}
+	btAssert(threadIndex >= 0 && threadIndex < BT_MAX_THREAD_COUNT);
+	CProfileNode* root = gProfileThreads[threadIndex].m_root;
+	return root ? new CProfileIterator( root ) : 0;
 }
 
 
@@ -480,12 +660,22 @@ void	CProfileManager::Stop_Profile( void )
  * CProfileManager::Reset -- Reset the contents of the profiling system                       *
  *                                                                                             *
  *    This resets everything except for the tree structure.  All of the timing data is reset.  *
+ *    The trees of all threads are reset, the worker threads should be idle.                   *
  *=============================================================================================*/
 void	CProfileManager::Reset( void )
 {
 	gProfileClock.reset();
 	Root.Reset();
     Root.Call();
+	for (int i=1;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		CProfileNode* root = gProfileThreads[i].m_root;
+		if (root)
+		{
+			root->Reset();
+			root->Call();
+		}
+	}
 	FrameCounter = 0;
 	Profile_Get_Ticks(&ResetTime);
 }
@@ -505,7 +695,7 @@ void CProfileManager::Increment_Frame_Counter( void )
  *=============================================================================================*/
 float CProfileManager::Get_Time_Since_Reset( void )
 {
-	unsigned long int time;
+	unsigned long long int time;
 	Profile_Get_Ticks(&time);
 	time -= ResetTime;
 	return (float)time / Profile_Get_Tick_Rate();
@@ -564,12 +754,86 @@ void	CProfileManager::dumpRecursive(CProfileIterator* profileIterator, int spaci
 
 void	CProfileManager::dumpAll()
 {
-	CProfileIterator* profileIterator = 0;
-	profileIterator = CProfileManager::Get_Iterator();
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		CProfileIterator* profileIterator = CProfileManager::Get_Iterator(i);
+		if (!profileIterator)
+			continue;
+		if (i > 0)
+		{
+			profileIterator->First();
+			if (!profileIterator->Is_Done())
+				printf("Thread %d\n", i);
+		}
 
-	dumpRecursive(profileIterator,0);
+		dumpRecursive(profileIterator,0);
 
-	CProfileManager::Release_Iterator(profileIterator);
+		CProfileManager::Release_Iterator(profileIterator);
+	}
+}
+
+
+void	CProfileManager::Set_Trace_Enabled( bool enabled )
+{
+	if (enabled && !TraceEnabled)
+	{
+		Clear_Trace();
+	}
+	TraceEnabled = enabled;
+}
+
+
+void	CProfileManager::Clear_Trace( void )
+{
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		gProfileThreads[i].m_events.resize(0);
+		gProfileThreads[i].m_openEvents.resize(0);
+	}
+	gTraceClock.reset();
+}
+
+
+static void writeJsonString(FILE* file, const char* str)
+{
+	fputc('"', file);
+	for (const char* c = str; *c; c++)
+	{
+		if (*c == '"' || *c == '\\')
+			fputc('\\', file);
+		fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+
+bool	CProfileManager::Write_Chrome_Trace( const char * fileName )
+{
+	FILE* file = fopen(fileName, "w");
+	if (!file)
+		return false;
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (int i=0;i<BT_MAX_THREAD_COUNT;i++)
+	{
+		const btAlignedObjectArray<btProfileEvent>& events = gProfileThreads[i].m_events;
+		for (int j=0;j<events.size();j++)
+		{
+			const btProfileEvent& event = events[j];
+			//skip the samples that were still open when the trace was written
+			if (event.m_endTime < event.m_startTime)
+				continue;
+			fprintf(file, first ? "{\"name\":" : ",\n{\"name\":");
+			writeJsonString(file, event.m_name);
+			//complete events, timestamps and durations are in microseconds
+			fprintf(file, ",\"cat\":\"bullet\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				i, event.m_startTime / 1000.0, (event.m_endTime - event.m_startTime) / 1000.0);
+			first = false;
+		}
+	}
+	fprintf(file, "\n]}\n");
+	fclose(file);
+	return true;
 }
 
 
@@ -53,6 +53,10 @@ public:
 	/// the Clock was created.
 	unsigned long int getTimeMicroseconds();
 	
+	/// Returns the time in ns since the last call to reset or since 
+	/// the Clock was created.
+	unsigned long long int getTimeNanoseconds();
+
 	/// Returns the time in s since the last call to reset or since 
 	/// the Clock was created.
 	btScalar getTimeSeconds();
@@ -94,12 +98,13 @@ protected:
 	const char *	Name;
 	int				TotalCalls;
 	float				TotalTime;
-	unsigned long int			StartTime;
+	unsigned long long int			StartTime;
 	int				RecursionCounter;
 
 	CProfileNode *	Parent;
 	CProfileNode *	Child;
 	CProfileNode *	Sibling;
+	CProfileNode *	LastSubNode;	// Child returned by the previous Get_Sub_Node, the search starts after it
 	void*	m_userPtr;
 };
 
@@ -143,37 +148,46 @@ protected:
 
 
 ///The Manager for the Profile system
+///Each thread records its samples in its own profile tree, indexed by btGetCurrentThreadIndex.
+///Reset and the iterators should only be used while no other thread is inside a BT_PROFILE scope.
 class	CProfileManager {
 public:
 	static	void						Start_Profile( const char * name );
 	static	void						Stop_Profile( void );
 
-	static	void						CleanupMemory(void)
-	{
-		Root.CleanupMemory();
-	}
+	static	void						CleanupMemory(void);
 
 	static	void						Reset( void );
 	static	void						Increment_Frame_Counter( void );
 	static	int						Get_Frame_Count_Since_Reset( void )		{ return FrameCounter; }
 	static	float						Get_Time_Since_Reset( void );
 
+	///Get_Iterator returns an iterator over the profile tree of the main thread
 	static	CProfileIterator *	Get_Iterator( void )	
 	{ 
 		
-		return new CProfileIterator( &Root ); 
+		return Get_Iterator( 0 ); 
 	}
+	///returns an iterator over the profile tree of the given thread, or 0 if that thread didn't take any samples
+	static	CProfileIterator *	Get_Iterator( int threadIndex );
 	static	void						Release_Iterator( CProfileIterator * iterator ) { delete ( iterator); }
 
 	static void	dumpRecursive(CProfileIterator* profileIterator, int spacing);
 
 	static void	dumpAll();
 
+	///while trace recording is enabled the start and end time of every sample is kept, on all threads
+	static	void						Set_Trace_Enabled( bool enabled );
+	static	bool						Is_Trace_Enabled( void )		{ return TraceEnabled; }
+	static	void						Clear_Trace( void );
+	///writes the recorded samples in the Chrome trace event format (chrome://tracing, Perfetto), one timeline per thread
+	static	bool						Write_Chrome_Trace( const char * fileName );
+
 private:
 	static	CProfileNode			Root;
-	static	CProfileNode *			CurrentNode;
 	static	int						FrameCounter;
-	static	unsigned long int					ResetTime;
+	static	unsigned long long int					ResetTime;
+	static	bool					TraceEnabled;
 };
 
 
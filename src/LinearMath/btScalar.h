@@ -278,6 +278,42 @@ BT_LINEAR_MATH_API int btGetVersion();
 	#define btLikely(_c)  _c
 	#define btUnlikely(_c) _c
 
+#elif defined (BT_ENABLE_SSE) && (defined (__i386__) || defined (__x86_64__)) && (!defined (BT_USE_DOUBLE_PRECISION))
+		//GCC/Clang on x86, SSE is opt-in with the BULLET2_USE_SSE CMake option (BT_ENABLE_SSE)
+		#define BT_USE_SIMD_VECTOR3
+		#define BT_USE_SSE
+		//btAlignedAlloc, btAlignedObjectArray and BT_DECLARE_ALIGNED_ALLOCATOR return 16 byte aligned memory,
+		//and the ATTRIBUTE_ALIGNED16 classes are aligned on the stack, so the SSE types can be used in the API
+		#define BT_USE_SSE_IN_API
+		//BT_ALLOW_SSE4 is not defined, btCpuFeatureUtility only detects SSE4/FMA3 with MSVC intrinsics
+		#if defined (__SSE4_1__)
+			#include <smmintrin.h>
+		#elif defined (__SSSE3__)
+			#include <tmmintrin.h>
+		#elif defined (__SSE3__)
+			#include <pmmintrin.h>
+		#else
+			#include <emmintrin.h>
+		#endif
+
+		#define SIMD_FORCE_INLINE inline __attribute__ ((always_inline))
+		#define ATTRIBUTE_ALIGNED16(a) a __attribute__ ((aligned (16)))
+		#define ATTRIBUTE_ALIGNED64(a) a __attribute__ ((aligned (64)))
+		#define ATTRIBUTE_ALIGNED128(a) a __attribute__ ((aligned (128)))
+		#ifndef assert
+		#include <assert.h>
+		#endif
+
+#if defined(DEBUG) || defined (_DEBUG)
+		#define btAssert assert
+#else
+		#define btAssert(x)
+#endif
+
+		//btFullAssert is optional, slows down a lot
+		#define btFullAssert(x)
+		#define btLikely(_c)  __builtin_expect((_c), 1)
+		#define btUnlikely(_c) __builtin_expect((_c), 0)
 #else
 
 		#define SIMD_FORCE_INLINE inline
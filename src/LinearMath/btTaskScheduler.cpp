@@ -0,0 +1,297 @@
+/*
+Copyright (c) 2003-2014 Erwin Coumans  http://bullet.googlecode.com
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "btThreads.h"
+#include "btMinMax.h"
+#include "btAlignedAllocator.h"
+#include <new>
+
+#if BT_THREADSAFE && !defined(_WIN32)
+
+#define BT_USE_PTHREADS_TASK_SCHEDULER 1
+
+#include <pthread.h>
+#include <unistd.h>
+
+///btTaskSchedulerPthreads keeps a pool of worker threads that sleep on a condition variable between loops.
+///Each btParallelFor is cut into grain sized chunks that are distributed evenly over per-thread queues,
+///a thread takes chunks from the front of its own queue and steals from the back of the other queues when it runs dry.
+///The calling thread works on the first queue, so a scheduler with N threads creates N-1 workers.
+class btTaskSchedulerPthreads : public btITaskScheduler
+{
+	ATTRIBUTE_ALIGNED16(struct) WorkerQueue
+	{
+		btSpinMutex m_mutex;
+		int m_begin;
+		int m_end;
+		char m_padding[ 64 - 3 * sizeof( int ) ]; // keep each queue on its own cache line
+	};
+
+	struct WorkerInfo
+	{
+		btTaskSchedulerPthreads* m_scheduler;
+		int m_queueIndex;
+	};
+
+	WorkerQueue m_queues[ BT_MAX_THREAD_COUNT ];
+	WorkerInfo m_workerInfo[ BT_MAX_THREAD_COUNT ];
+	pthread_t m_threads[ BT_MAX_THREAD_COUNT ];
+	int m_numCreatedWorkers;
+	int m_maxNumThreads;
+	int m_numThreads;
+
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_wakeUpCondition;
+	int m_jobGeneration;
+	bool m_shutdown;
+
+	//the current loop, valid while busy workers are counted
+	const btIParallelForBody* m_body;
+	int m_iBegin;
+	int m_iEnd;
+	int m_grainSize;
+	int m_numActiveThreads;
+	volatile int m_numBusyWorkers;
+
+	bool popFront( int queueIndex, int* chunk )
+	{
+		WorkerQueue& q = m_queues[ queueIndex ];
+		bool found = false;
+		btMutexLock( &q.m_mutex );
+		if ( q.m_begin < q.m_end )
+		{
+			*chunk = q.m_begin++;
+			found = true;
+		}
+		btMutexUnlock( &q.m_mutex );
+		return found;
+	}
+
+	bool stealBack( int thiefIndex, int* chunk )
+	{
+		for ( int i = 1; i < m_numActiveThreads; ++i )
+		{
+			WorkerQueue& q = m_queues[ ( thiefIndex + i ) % m_numActiveThreads ];
+			if ( q.m_begin >= q.m_end )
+			{
+				continue;
+			}
+			bool found = false;
+			btMutexLock( &q.m_mutex );
+			if ( q.m_begin < q.m_end )
+			{
+				*chunk = --q.m_end;
+				found = true;
+			}
+			btMutexUnlock( &q.m_mutex );
+			if ( found )
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void runChunks( int queueIndex )
+	{
+		int chunk;
+		while ( popFront( queueIndex, &chunk ) || stealBack( queueIndex, &chunk ) )
+		{
+			int i0 = m_iBegin + chunk * m_grainSize;
+			int i1 = btMin( i0 + m_grainSize, m_iEnd );
+			m_body->forLoop( i0, i1 );
+		}
+	}
+
+	static void* workerThreadFunc( void* userPtr )
+	{
+		WorkerInfo* info = static_cast<WorkerInfo*>( userPtr );
+		info->m_scheduler->workerLoop( info->m_queueIndex );
+		return 0;
+	}
+
+	void workerLoop( int queueIndex )
+	{
+		//reserve a thread index for this worker
+		btGetCurrentThreadIndex();
+
+		int lastGeneration = 0;
+		while ( true )
+		{
+			pthread_mutex_lock( &m_mutex );
+			while ( !m_shutdown && m_jobGeneration == lastGeneration )
+			{
+				pthread_cond_wait( &m_wakeUpCondition, &m_mutex );
+			}
+			lastGeneration = m_jobGeneration;
+			bool shutdown = m_shutdown;
+			bool participate = queueIndex < m_numActiveThreads;
+			pthread_mutex_unlock( &m_mutex );
+
+			if ( shutdown )
+			{
+				break;
+			}
+			if ( participate )
+			{
+				runChunks( queueIndex );
+				btAtomicFetchAdd( &m_numBusyWorkers, -1 );
+			}
+		}
+	}
+
+public:
+	btTaskSchedulerPthreads() : btITaskScheduler( "Pthreads" )
+	{
+		long numCores = sysconf( _SC_NPROCESSORS_ONLN );
+		m_maxNumThreads = BT_MAX_THREAD_COUNT;
+		//one thread per core by default, more can be requested with setNumThreads
+		m_numThreads = btMax( 1, btMin( int( numCores ), m_maxNumThreads ) );
+		m_numCreatedWorkers = 0;
+		m_jobGeneration = 0;
+		m_shutdown = false;
+		m_body = 0;
+		m_iBegin = 0;
+		m_iEnd = 0;
+		m_grainSize = 1;
+		m_numActiveThreads = 1;
+		m_numBusyWorkers = 0;
+		pthread_mutex_init( &m_mutex, 0 );
+		pthread_cond_init( &m_wakeUpCondition, 0 );
+	}
+
+	virtual ~btTaskSchedulerPthreads()
+	{
+		pthread_mutex_lock( &m_mutex );
+		m_shutdown = true;
+		pthread_cond_broadcast( &m_wakeUpCondition );
+		pthread_mutex_unlock( &m_mutex );
+		for ( int i = 1; i <= m_numCreatedWorkers; ++i )
+		{
+			pthread_join( m_threads[ i ], 0 );
+		}
+		pthread_cond_destroy( &m_wakeUpCondition );
+		pthread_mutex_destroy( &m_mutex );
+	}
+
+	virtual int getMaxNumThreads() const
+	{
+		return m_maxNumThreads;
+	}
+
+	virtual int getNumThreads() const
+	{
+		return m_numThreads;
+	}
+
+	virtual void setNumThreads( int numThreads )
+	{
+		m_numThreads = btMax( btMin( numThreads, m_maxNumThreads ), 1 );
+		if ( m_isActive )
+		{
+			createWorkers();
+		}
+	}
+
+	virtual void activate()
+	{
+		btITaskScheduler::activate();
+		createWorkers();
+	}
+
+	//workers are created lazily and never destroyed before the scheduler, setNumThreads only limits how many take part
+	void createWorkers()
+	{
+		while ( m_numCreatedWorkers < m_numThreads - 1 )
+		{
+			int queueIndex = m_numCreatedWorkers + 1;
+			m_workerInfo[ queueIndex ].m_scheduler = this;
+			m_workerInfo[ queueIndex ].m_queueIndex = queueIndex;
+			if ( pthread_create( &m_threads[ queueIndex ], 0, &workerThreadFunc, &m_workerInfo[ queueIndex ] ) != 0 )
+			{
+				m_numThreads = m_numCreatedWorkers + 1;
+				break;
+			}
+			m_numCreatedWorkers++;
+		}
+	}
+
+	virtual void parallelFor( int iBegin, int iEnd, int grainSize, const btIParallelForBody& body )
+	{
+		int numChunks = ( iEnd - iBegin + grainSize - 1 ) / grainSize;
+		int numThreads = btMin( btMin( m_numThreads, m_numCreatedWorkers + 1 ), numChunks );
+		if ( numThreads <= 1 )
+		{
+			body.forLoop( iBegin, iEnd );
+			return;
+		}
+
+		m_body = &body;
+		m_iBegin = iBegin;
+		m_iEnd = iEnd;
+		m_grainSize = grainSize;
+
+		//distribute the chunks evenly, threads that finish early steal from the others
+		int chunkBegin = 0;
+		for ( int i = 0; i < numThreads; ++i )
+		{
+			int chunkEnd = ( numChunks * ( i + 1 ) ) / numThreads;
+			m_queues[ i ].m_begin = chunkBegin;
+			m_queues[ i ].m_end = chunkEnd;
+			chunkBegin = chunkEnd;
+		}
+
+		pthread_mutex_lock( &m_mutex );
+		m_numActiveThreads = numThreads;
+		m_numBusyWorkers = numThreads - 1;
+		m_jobGeneration++;
+		pthread_cond_broadcast( &m_wakeUpCondition );
+		pthread_mutex_unlock( &m_mutex );
+
+		runChunks( 0 );
+
+		//body lives on the caller's stack, wait until no worker can touch it anymore
+		while ( m_numBusyWorkers > 0 )
+		{
+		}
+		//full barrier, so the results written by the workers are visible to the caller
+		btAtomicFetchAdd( &m_numBusyWorkers, 0 );
+		m_body = 0;
+	}
+};
+
+#endif //BT_THREADSAFE && !_WIN32
+
+
+btITaskScheduler* btCreateDefaultTaskScheduler()
+{
+#ifdef BT_USE_PTHREADS_TASK_SCHEDULER
+	void* mem = btAlignedAlloc( sizeof( btTaskSchedulerPthreads ), 64 );
+	return new ( mem ) btTaskSchedulerPthreads();
+#else
+	return 0;
+#endif
+}
+
+void btDeleteTaskScheduler( btITaskScheduler* ts )
+{
+	if ( ts )
+	{
+		btAssert( ts != btGetTaskScheduler() );
+		btAssert( ts != btGetSequentialTaskScheduler() );
+		ts->~btITaskScheduler();
+		btAlignedFree( ts );
+	}
+}
@@ -0,0 +1,301 @@
+/*
+Copyright (c) 2003-2014 Erwin Coumans  http://bullet.googlecode.com
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+#include "btThreads.h"
+#include "btMinMax.h"
+
+#if defined(_MSC_VER)
+
+#include <intrin.h>
+
+#define BT_THREAD_LOCAL_STORAGE __declspec( thread )
+
+static int btAtomicCompareExchange(volatile int* dest, int exchange, int comparand)
+{
+	return _InterlockedCompareExchange((volatile long*) dest, exchange, comparand);
+}
+
+int btAtomicFetchAdd(volatile int* dest, int value)
+{
+	return _InterlockedExchangeAdd((volatile long*) dest, value);
+}
+
+static void btAtomicRelease(volatile int* dest)
+{
+	_InterlockedExchange((volatile long*) dest, 0);
+}
+
+#else //_MSC_VER
+
+#define BT_THREAD_LOCAL_STORAGE __thread
+
+static int btAtomicCompareExchange(volatile int* dest, int exchange, int comparand)
+{
+	return __sync_val_compare_and_swap(dest, comparand, exchange);
+}
+
+int btAtomicFetchAdd(volatile int* dest, int value)
+{
+	return __sync_fetch_and_add(dest, value);
+}
+
+static void btAtomicRelease(volatile int* dest)
+{
+	__sync_lock_release(dest);
+}
+
+#endif //_MSC_VER
+
+
+void btSpinMutex::lock()
+{
+	// busy-wait until we are the one who flips the lock from 0 to 1
+	while (btAtomicCompareExchange(&m_lock, 1, 0) != 0)
+	{
+		// spin on a plain read to avoid hammering the cache line with writes
+		while (m_lock)
+		{
+		}
+	}
+}
+
+void btSpinMutex::unlock()
+{
+	btAtomicRelease(&m_lock);
+}
+
+bool btSpinMutex::tryLock()
+{
+	return btAtomicCompareExchange(&m_lock, 1, 0) == 0;
+}
+
+
+#define BT_THREAD_INDEX_UNASSIGNED (~0U)
+
+static BT_THREAD_LOCAL_STORAGE unsigned int sThreadIndex = BT_THREAD_INDEX_UNASSIGNED;
+static volatile int sThreadIndexInUse[BT_MAX_THREAD_COUNT];	//1 while a live thread owns the index
+static volatile int sThreadIndexOverflowCount = 0;
+
+static void btReleaseThreadIndex(unsigned int threadIndex)
+{
+	if (threadIndex < BT_OVERFLOW_THREAD_INDEX)
+	{
+		btAtomicRelease(&sThreadIndexInUse[threadIndex]);
+	}
+}
+
+#if BT_THREADSAFE && defined(_WIN32)
+
+#include <windows.h>
+
+//a fiber local storage slot with a callback gives back the index when the thread exits
+static DWORD sThreadExitSlot = FLS_OUT_OF_INDEXES;
+static volatile int sThreadExitSlotLock = 0;
+
+static void WINAPI btThreadExitCallback(void* value)
+{
+	if (value)
+	{
+		btReleaseThreadIndex((unsigned int)((size_t)value - 1));
+	}
+}
+
+static void btRegisterThreadExit(unsigned int threadIndex)
+{
+	if (sThreadExitSlot == FLS_OUT_OF_INDEXES)
+	{
+		while (btAtomicCompareExchange(&sThreadExitSlotLock, 1, 0) != 0)
+		{
+		}
+		if (sThreadExitSlot == FLS_OUT_OF_INDEXES)
+		{
+			sThreadExitSlot = FlsAlloc(btThreadExitCallback);
+		}
+		btAtomicRelease(&sThreadExitSlotLock);
+	}
+	if (sThreadExitSlot != FLS_OUT_OF_INDEXES)
+	{
+		FlsSetValue(sThreadExitSlot, (void*)(size_t)(threadIndex + 1));
+	}
+}
+
+#elif BT_THREADSAFE
+
+#include <pthread.h>
+
+//a pthread key destructor gives back the index when the thread exits
+static pthread_key_t sThreadExitKey;
+static pthread_once_t sThreadExitKeyOnce = PTHREAD_ONCE_INIT;
+
+static void btThreadExitDestructor(void* value)
+{
+	if (value)
+	{
+		btReleaseThreadIndex((unsigned int)((size_t)value - 1));
+	}
+}
+
+static void btCreateThreadExitKey()
+{
+	pthread_key_create(&sThreadExitKey, btThreadExitDestructor);
+}
+
+static void btRegisterThreadExit(unsigned int threadIndex)
+{
+	pthread_once(&sThreadExitKeyOnce, btCreateThreadExitKey);
+	pthread_setspecific(sThreadExitKey, (void*)(size_t)(threadIndex + 1));
+}
+
+#else
+
+static void btRegisterThreadExit(unsigned int /*threadIndex*/)
+{
+}
+
+#endif
+
+unsigned int btGetCurrentThreadIndex()
+{
+	if (sThreadIndex == BT_THREAD_INDEX_UNASSIGNED)
+	{
+		//take the lowest free index, so the first thread (normally the main thread) gets 0
+		//and indices of threads that exited are used again
+		for (unsigned int i = 0; i < BT_OVERFLOW_THREAD_INDEX; i++)
+		{
+			if (sThreadIndexInUse[i] == 0 && btAtomicCompareExchange(&sThreadIndexInUse[i], 1, 0) == 0)
+			{
+				sThreadIndex = i;
+				btRegisterThreadExit(i);
+				return sThreadIndex;
+			}
+		}
+		//more live threads than indices: share the last index, and count it so the application can notice
+		btAtomicFetchAdd(&sThreadIndexOverflowCount, 1);
+		sThreadIndex = BT_OVERFLOW_THREAD_INDEX;
+	}
+	return sThreadIndex;
+}
+
+int btGetThreadIndexOverflowCount()
+{
+	return sThreadIndexOverflowCount;
+}
+
+bool btIsMainThread()
+{
+	return btGetCurrentThreadIndex() == 0;
+}
+
+
+btITaskScheduler::btITaskScheduler( const char* name )
+{
+	m_name = name;
+	m_isActive = false;
+}
+
+void btITaskScheduler::activate()
+{
+	//make sure the main thread is thread 0 before any worker asks for an index
+	btGetCurrentThreadIndex();
+	m_isActive = true;
+}
+
+void btITaskScheduler::deactivate()
+{
+	m_isActive = false;
+}
+
+
+///btTaskSchedulerSequential runs all the chunks on the calling thread
+class btTaskSchedulerSequential : public btITaskScheduler
+{
+public:
+	btTaskSchedulerSequential() : btITaskScheduler( "Sequential" ) {}
+
+	virtual int getMaxNumThreads() const
+	{
+		return 1;
+	}
+
+	virtual int getNumThreads() const
+	{
+		return 1;
+	}
+
+	virtual void setNumThreads( int numThreads )
+	{
+		(void) numThreads;
+	}
+
+	virtual void parallelFor( int iBegin, int iEnd, int grainSize, const btIParallelForBody& body )
+	{
+		(void) grainSize;
+		body.forLoop( iBegin, iEnd );
+	}
+};
+
+
+static btTaskSchedulerSequential sSequentialTaskScheduler;
+static btITaskScheduler* sTaskScheduler = 0;
+static volatile int sParallelForNestingCount = 0;
+
+btITaskScheduler* btGetSequentialTaskScheduler()
+{
+	return &sSequentialTaskScheduler;
+}
+
+void btSetTaskScheduler( btITaskScheduler* ts )
+{
+	btAssert( sParallelForNestingCount == 0 );
+	if ( !ts )
+	{
+		ts = btGetSequentialTaskScheduler();
+	}
+	if ( sTaskScheduler && sTaskScheduler != ts )
+	{
+		sTaskScheduler->deactivate();
+	}
+	sTaskScheduler = ts;
+	ts->activate();
+}
+
+btITaskScheduler* btGetTaskScheduler()
+{
+	if ( !sTaskScheduler )
+	{
+		btSetTaskScheduler( btGetSequentialTaskScheduler() );
+	}
+	return sTaskScheduler;
+}
+
+void btParallelFor( int iBegin, int iEnd, int grainSize, const btIParallelForBody& body )
+{
+	if ( iBegin >= iEnd )
+	{
+		return;
+	}
+	btAssert( grainSize > 0 );
+	grainSize = btMax( grainSize, 1 );
+
+	//nested loops and loops issued from worker threads are not split again
+	if ( btAtomicFetchAdd( &sParallelForNestingCount, 1 ) != 0 )
+	{
+		btAtomicFetchAdd( &sParallelForNestingCount, -1 );
+		body.forLoop( iBegin, iEnd );
+		return;
+	}
+	btGetTaskScheduler()->parallelFor( iBegin, iEnd, grainSize, body );
+	btAtomicFetchAdd( &sParallelForNestingCount, -1 );
+}
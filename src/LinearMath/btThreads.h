@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2003-2014 Erwin Coumans  http://bullet.googlecode.com
+
+This software is provided 'as-is', without any express or implied warranty.
+In no event will the authors be held liable for any damages arising from the use of this software.
+Permission is granted to anyone to use this software for any purpose,
+including commercial applications, and to alter it and redistribute it freely,
+subject to the following restrictions:
+
+1. The origin of this software must not be misrepresented; you must not claim that you wrote the original software. If you use this software in a product, an acknowledgment in the product documentation would be appreciated but is not required.
+2. Altered source versions must be plainly marked as such, and must not be misrepresented as being the original software.
+3. This notice may not be removed or altered from any source distribution.
+*/
+
+
+
+#ifndef BT_THREADS_H
+#define BT_THREADS_H
+
+#include "btScalar.h" // has definitions like SIMD_FORCE_INLINE
+
+///maximum number of threads that may call into Bullet concurrently, used to size per-thread data
+#define BT_MAX_THREAD_COUNT 64
+
+///the last index is shared by the threads that find all other indices taken
+#define BT_OVERFLOW_THREAD_INDEX (BT_MAX_THREAD_COUNT-1)
+
+///btSpinMutex is a lightweight lock that busy-waits, suitable for protecting very short critical sections
+///such as a pool allocation or a push_back. It uses compiler intrinsics so it does not depend on any threading library.
+class btSpinMutex
+{
+	volatile int m_lock;
+
+public:
+	btSpinMutex()
+	{
+		m_lock = 0;
+	}
+	void lock();
+	void unlock();
+	bool tryLock();
+};
+
+SIMD_FORCE_INLINE void btMutexLock( btSpinMutex* mutex )
+{
+	mutex->lock();
+}
+
+SIMD_FORCE_INLINE void btMutexUnlock( btSpinMutex* mutex )
+{
+	mutex->unlock();
+}
+
+SIMD_FORCE_INLINE bool btMutexTryLock( btSpinMutex* mutex )
+{
+	return mutex->tryLock();
+}
+
+///atomically adds 'value' to '*dest' and returns the previous value
+int btAtomicFetchAdd(volatile int* dest, int value);
+
+///btGetCurrentThreadIndex returns a small integer in the range [0, BT_MAX_THREAD_COUNT) that is unique
+///for the calling thread. The first thread that asks for an index (normally the main thread) gets 0, and
+///the index of a thread is given back when it exits. If more than BT_OVERFLOW_THREAD_INDEX threads are alive
+///at once, the extra threads all get BT_OVERFLOW_THREAD_INDEX (see btGetThreadIndexOverflowCount); they must
+///not run Bullet concurrently with each other.
+unsigned int btGetCurrentThreadIndex();
+
+///number of threads that could not get an index of their own
+int btGetThreadIndexOverflowCount();
+
+bool btIsMainThread();
+
+
+///btIParallelForBody is the work item for btParallelFor, the body is called with sub-ranges of [iBegin, iEnd)
+///and must only touch data that belongs to its own range (or protect shared data with a btSpinMutex).
+class btIParallelForBody
+{
+public:
+	virtual ~btIParallelForBody() {}
+	virtual void forLoop( int iBegin, int iEnd ) const = 0;
+};
+
+///btITaskScheduler is the interface to the job system that runs btParallelFor. Bullet ships with a sequential
+///scheduler and a work-stealing pthread scheduler, applications can implement it on top of their own job system
+///so Bullet shares their worker threads instead of creating more.
+class btITaskScheduler
+{
+public:
+	btITaskScheduler( const char* name );
+	virtual ~btITaskScheduler() {}
+
+	const char* getName() const
+	{
+		return m_name;
+	}
+
+	virtual int getMaxNumThreads() const = 0;
+	virtual int getNumThreads() const = 0;
+	virtual void setNumThreads( int numThreads ) = 0;
+
+	///must run body.forLoop on sub-ranges that together cover [iBegin, iEnd) exactly once, and only return when all of them are done
+	virtual void parallelFor( int iBegin, int iEnd, int grainSize, const btIParallelForBody& body ) = 0;
+
+	///activate is called by btSetTaskScheduler when the scheduler becomes current, deactivate when it is replaced
+	virtual void activate();
+	virtual void deactivate();
+
+protected:
+	const char* m_name;
+	bool m_isActive;
+};
+
+///sets the scheduler used by btParallelFor, passing NULL selects the sequential scheduler. Call it from the main thread,
+///while no simulation is in progress. The scheduler is not owned by Bullet.
+void btSetTaskScheduler( btITaskScheduler* ts );
+
+///returns the scheduler used by btParallelFor, never NULL
+btITaskScheduler* btGetTaskScheduler();
+
+///returns the built-in scheduler that runs everything on the calling thread
+btITaskScheduler* btGetSequentialTaskScheduler();
+
+///creates the built-in work-stealing scheduler that uses one pthread per core by default, returns NULL when Bullet
+///was built without BT_THREADSAFE or on a platform without pthreads. Delete it with btDeleteTaskScheduler.
+btITaskScheduler* btCreateDefaultTaskScheduler();
+
+void btDeleteTaskScheduler( btITaskScheduler* ts );
+
+///btParallelFor splits [iBegin, iEnd) into chunks of at most grainSize iterations and runs body on them with the
+///current task scheduler. A btParallelFor that is issued while another one is running is processed sequentially, and
+///like the sequential scheduler calls body once with the whole range.
+void btParallelFor( int iBegin, int iEnd, int grainSize, const btIParallelForBody& body );
+
+
+#endif //BT_THREADS_H
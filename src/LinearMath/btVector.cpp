@@ -1666,3 +1666,328 @@ long _mindot_large_v1( const float* BT_RESTRICT vv, const float* BT_RESTRICT vec
 #endif  /* __APPLE__ */
 
 
+
+
+//Structure of arrays kernels for the btVector3_packSoa layout. The layout doesn't depend on the instruction set,
+//the kernel is picked at the first call: AVX processes a block of 8 vectors at once, SSE half a block, otherwise one vector at a time.
+//Each lane keeps its first extreme and the lanes are reduced to the smallest index, so all kernels return what the scalar loop returns.
+
+#include "btCpuFeatureUtility.h"
+
+#if !defined (BT_USE_DOUBLE_PRECISION) && (defined (__SSE__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 1))
+#define BT_USE_SSE_SOA
+#include <xmmintrin.h>
+#if (defined (__GNUC__) || defined (__clang__)) && (defined (__x86_64__) || defined (__i386__))
+#define BT_USE_AVX_SOA
+#define BT_AVX_SOA_TARGET __attribute__((target("avx")))
+#include <immintrin.h>
+#elif defined (_MSC_VER) && defined (BT_ALLOW_SSE4)
+#define BT_USE_AVX_SOA
+#define BT_AVX_SOA_TARGET
+#include <immintrin.h>
+#endif
+#endif
+
+void btVector3_packSoa(const btVector3* array, long array_count, btScalar* soaOut)
+{
+	long numBlocks = (array_count + BT_VECTOR3_SOA_BLOCK - 1) / BT_VECTOR3_SOA_BLOCK;
+	for (long b = 0; b < numBlocks; b++)
+	{
+		btScalar* block = soaOut + b * 3 * BT_VECTOR3_SOA_BLOCK;
+		for (long l = 0; l < BT_VECTOR3_SOA_BLOCK; l++)
+		{
+			const btVector3& v = array[btMin(b * BT_VECTOR3_SOA_BLOCK + l, array_count - 1)];
+			block[l] = v.m_floats[0];
+			block[BT_VECTOR3_SOA_BLOCK + l] = v.m_floats[1];
+			block[2 * BT_VECTOR3_SOA_BLOCK + l] = v.m_floats[2];
+		}
+	}
+}
+
+static long btMaxDotSoaScalar(const btScalar* soa, long count, const btScalar* dir, btScalar* dotOut)
+{
+	btScalar maxDot = -SIMD_INFINITY;
+	long index = -1;
+	for (long i = 0; i < count; i++)
+	{
+		const btScalar* p = soa + (i / BT_VECTOR3_SOA_BLOCK) * 3 * BT_VECTOR3_SOA_BLOCK + (i % BT_VECTOR3_SOA_BLOCK);
+		btScalar dot = p[0] * dir[0] + p[BT_VECTOR3_SOA_BLOCK] * dir[1] + p[2 * BT_VECTOR3_SOA_BLOCK] * dir[2];
+		if (dot > maxDot)
+		{
+			maxDot = dot;
+			index = i;
+		}
+	}
+	*dotOut = maxDot;
+	return index;
+}
+
+static void btProjectSoaScalar(const btScalar* soa, long count, const btScalar* scaling, const btScalar* basis, const btScalar* origin, const btScalar* dir,
+	long* minIndexOut, btScalar* minProjOut, long* maxIndexOut, btScalar* maxProjOut)
+{
+	btScalar minProj = FLT_MAX;
+	btScalar maxProj = -FLT_MAX;
+	long minIndex = -1;
+	long maxIndex = -1;
+	for (long i = 0; i < count; i++)
+	{
+		const btScalar* p = soa + (i / BT_VECTOR3_SOA_BLOCK) * 3 * BT_VECTOR3_SOA_BLOCK + (i % BT_VECTOR3_SOA_BLOCK);
+		btScalar vx = p[0] * scaling[0];
+		btScalar vy = p[BT_VECTOR3_SOA_BLOCK] * scaling[1];
+		btScalar vz = p[2 * BT_VECTOR3_SOA_BLOCK] * scaling[2];
+		btScalar px = vx * basis[0] + vy * basis[1] + vz * basis[2] + origin[0];
+		btScalar py = vx * basis[4] + vy * basis[5] + vz * basis[6] + origin[1];
+		btScalar pz = vx * basis[8] + vy * basis[9] + vz * basis[10] + origin[2];
+		btScalar dp = px * dir[0] + py * dir[1] + pz * dir[2];
+		if (dp < minProj)
+		{
+			minProj = dp;
+			minIndex = i;
+		}
+		if (dp > maxProj)
+		{
+			maxProj = dp;
+			maxIndex = i;
+		}
+	}
+	*minIndexOut = minIndex;
+	*minProjOut = minProj;
+	*maxIndexOut = maxIndex;
+	*maxProjOut = maxProj;
+}
+
+#ifdef BT_USE_SSE_SOA
+
+static SIMD_FORCE_INLINE __m128 btSoaSelectSse(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+//keeps the larger value of each lane pair, ties go to the smaller index. Lanes that never got a value hold the initial value and index -1,
+//every value that was taken is strictly larger, so these lanes never win.
+static SIMD_FORCE_INLINE void btSoaFoldMaxSse(__m128& values, __m128& indices, __m128 otherValues, __m128 otherIndices)
+{
+	__m128 take = _mm_or_ps(_mm_cmpgt_ps(otherValues, values), _mm_and_ps(_mm_cmpeq_ps(otherValues, values), _mm_cmplt_ps(otherIndices, indices)));
+	values = btSoaSelectSse(take, otherValues, values);
+	indices = btSoaSelectSse(take, otherIndices, indices);
+}
+
+static SIMD_FORCE_INLINE long btSoaReduceMaxSse(__m128 values, __m128 indices, float* valueOut)
+{
+	btSoaFoldMaxSse(values, indices, _mm_movehl_ps(values, values), _mm_movehl_ps(indices, indices));
+	btSoaFoldMaxSse(values, indices, _mm_shuffle_ps(values, values, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(indices, indices, _MM_SHUFFLE(1, 1, 1, 1)));
+	*valueOut = _mm_cvtss_f32(values);
+	return (long)_mm_cvtss_f32(indices);
+}
+
+static long btMaxDotSoaSse(const float* soa, long count, const float* dir, float* dotOut)
+{
+	const __m128 dx = _mm_set1_ps(dir[0]);
+	const __m128 dy = _mm_set1_ps(dir[1]);
+	const __m128 dz = _mm_set1_ps(dir[2]);
+	const __m128 four = _mm_set1_ps(4.f);
+	__m128 best = _mm_set1_ps(-SIMD_INFINITY);
+	__m128 bestIndex = _mm_set1_ps(-1.f);
+	__m128 index = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+	long numBlocks = (count + BT_VECTOR3_SOA_BLOCK - 1) / BT_VECTOR3_SOA_BLOCK;
+	for (long b = 0; b < numBlocks; b++, soa += 3 * BT_VECTOR3_SOA_BLOCK)
+	{
+		for (int l = 0; l < BT_VECTOR3_SOA_BLOCK; l += 4)
+		{
+			__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(soa + l), dx), _mm_mul_ps(_mm_loadu_ps(soa + BT_VECTOR3_SOA_BLOCK + l), dy)),
+				_mm_mul_ps(_mm_loadu_ps(soa + 2 * BT_VECTOR3_SOA_BLOCK + l), dz));
+			__m128 greater = _mm_cmpgt_ps(dot, best);
+			best = btSoaSelectSse(greater, dot, best);
+			bestIndex = btSoaSelectSse(greater, index, bestIndex);
+			index = _mm_add_ps(index, four);
+		}
+	}
+	return btSoaReduceMaxSse(best, bestIndex, dotOut);
+}
+
+static void btProjectSoaSse(const float* soa, long count, const float* scaling, const float* basis, const float* origin, const float* dir,
+	long* minIndexOut, float* minProjOut, long* maxIndexOut, float* maxProjOut)
+{
+	const __m128 sx = _mm_set1_ps(scaling[0]), sy = _mm_set1_ps(scaling[1]), sz = _mm_set1_ps(scaling[2]);
+	const __m128 b00 = _mm_set1_ps(basis[0]), b01 = _mm_set1_ps(basis[1]), b02 = _mm_set1_ps(basis[2]);
+	const __m128 b10 = _mm_set1_ps(basis[4]), b11 = _mm_set1_ps(basis[5]), b12 = _mm_set1_ps(basis[6]);
+	const __m128 b20 = _mm_set1_ps(basis[8]), b21 = _mm_set1_ps(basis[9]), b22 = _mm_set1_ps(basis[10]);
+	const __m128 ox = _mm_set1_ps(origin[0]), oy = _mm_set1_ps(origin[1]), oz = _mm_set1_ps(origin[2]);
+	const __m128 dx = _mm_set1_ps(dir[0]), dy = _mm_set1_ps(dir[1]), dz = _mm_set1_ps(dir[2]);
+	const __m128 four = _mm_set1_ps(4.f);
+	__m128 minProj = _mm_set1_ps(FLT_MAX);
+	__m128 maxProj = _mm_set1_ps(-FLT_MAX);
+	__m128 minIndex = _mm_set1_ps(-1.f);
+	__m128 maxIndex = _mm_set1_ps(-1.f);
+	__m128 index = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+	long numBlocks = (count + BT_VECTOR3_SOA_BLOCK - 1) / BT_VECTOR3_SOA_BLOCK;
+	for (long b = 0; b < numBlocks; b++, soa += 3 * BT_VECTOR3_SOA_BLOCK)
+	{
+		for (int l = 0; l < BT_VECTOR3_SOA_BLOCK; l += 4)
+		{
+			__m128 vx = _mm_mul_ps(_mm_loadu_ps(soa + l), sx);
+			__m128 vy = _mm_mul_ps(_mm_loadu_ps(soa + BT_VECTOR3_SOA_BLOCK + l), sy);
+			__m128 vz = _mm_mul_ps(_mm_loadu_ps(soa + 2 * BT_VECTOR3_SOA_BLOCK + l), sz);
+			__m128 px = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, b00), _mm_mul_ps(vy, b01)), _mm_mul_ps(vz, b02)), ox);
+			__m128 py = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, b10), _mm_mul_ps(vy, b11)), _mm_mul_ps(vz, b12)), oy);
+			__m128 pz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, b20), _mm_mul_ps(vy, b21)), _mm_mul_ps(vz, b22)), oz);
+			__m128 dp = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, dx), _mm_mul_ps(py, dy)), _mm_mul_ps(pz, dz));
+			__m128 less = _mm_cmplt_ps(dp, minProj);
+			__m128 greater = _mm_cmpgt_ps(dp, maxProj);
+			minProj = btSoaSelectSse(less, dp, minProj);
+			minIndex = btSoaSelectSse(less, index, minIndex);
+			maxProj = btSoaSelectSse(greater, dp, maxProj);
+			maxIndex = btSoaSelectSse(greater, index, maxIndex);
+			index = _mm_add_ps(index, four);
+		}
+	}
+	//the smallest projection is the largest negated one, flipping the sign bit is exact
+	float negatedMin;
+	*minIndexOut = btSoaReduceMaxSse(_mm_xor_ps(minProj, _mm_set1_ps(-0.f)), minIndex, &negatedMin);
+	*minProjOut = -negatedMin;
+	*maxIndexOut = btSoaReduceMaxSse(maxProj, maxIndex, maxProjOut);
+}
+
+#endif //BT_USE_SSE_SOA
+
+#ifdef BT_USE_AVX_SOA
+
+//_mm256_blendv_ps is slower than and/andnot/or on some CPUs
+BT_AVX_SOA_TARGET static SIMD_FORCE_INLINE __m256 btSoaSelectAvx(__m256 mask, __m256 a, __m256 b)
+{
+	return _mm256_or_ps(_mm256_and_ps(mask, a), _mm256_andnot_ps(mask, b));
+}
+
+BT_AVX_SOA_TARGET static SIMD_FORCE_INLINE long btSoaReduceMaxAvx(__m256 values, __m256 indices, float* valueOut)
+{
+	__m128 lowValues = _mm256_castps256_ps128(values);
+	__m128 lowIndices = _mm256_castps256_ps128(indices);
+	btSoaFoldMaxSse(lowValues, lowIndices, _mm256_extractf128_ps(values, 1), _mm256_extractf128_ps(indices, 1));
+	return btSoaReduceMaxSse(lowValues, lowIndices, valueOut);
+}
+
+BT_AVX_SOA_TARGET static long btMaxDotSoaAvx(const float* soa, long count, const float* dir, float* dotOut)
+{
+	const __m256 dx = _mm256_set1_ps(dir[0]);
+	const __m256 dy = _mm256_set1_ps(dir[1]);
+	const __m256 dz = _mm256_set1_ps(dir[2]);
+	const __m256 eight = _mm256_set1_ps(8.f);
+	__m256 best = _mm256_set1_ps(-SIMD_INFINITY);
+	__m256 bestIndex = _mm256_set1_ps(-1.f);
+	__m256 index = _mm256_set_ps(7.f, 6.f, 5.f, 4.f, 3.f, 2.f, 1.f, 0.f);
+	long numBlocks = (count + BT_VECTOR3_SOA_BLOCK - 1) / BT_VECTOR3_SOA_BLOCK;
+	for (long b = 0; b < numBlocks; b++, soa += 3 * BT_VECTOR3_SOA_BLOCK)
+	{
+		__m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(soa), dx), _mm256_mul_ps(_mm256_loadu_ps(soa + BT_VECTOR3_SOA_BLOCK), dy)),
+			_mm256_mul_ps(_mm256_loadu_ps(soa + 2 * BT_VECTOR3_SOA_BLOCK), dz));
+		__m256 greater = _mm256_cmp_ps(dot, best, _CMP_GT_OQ);
+		best = btSoaSelectAvx(greater, dot, best);
+		bestIndex = btSoaSelectAvx(greater, index, bestIndex);
+		index = _mm256_add_ps(index, eight);
+	}
+	return btSoaReduceMaxAvx(best, bestIndex, dotOut);
+}
+
+BT_AVX_SOA_TARGET static void btProjectSoaAvx(const float* soa, long count, const float* scaling, const float* basis, const float* origin, const float* dir,
+	long* minIndexOut, float* minProjOut, long* maxIndexOut, float* maxProjOut)
+{
+	const __m256 sx = _mm256_set1_ps(scaling[0]), sy = _mm256_set1_ps(scaling[1]), sz = _mm256_set1_ps(scaling[2]);
+	const __m256 b00 = _mm256_set1_ps(basis[0]), b01 = _mm256_set1_ps(basis[1]), b02 = _mm256_set1_ps(basis[2]);
+	const __m256 b10 = _mm256_set1_ps(basis[4]), b11 = _mm256_set1_ps(basis[5]), b12 = _mm256_set1_ps(basis[6]);
+	const __m256 b20 = _mm256_set1_ps(basis[8]), b21 = _mm256_set1_ps(basis[9]), b22 = _mm256_set1_ps(basis[10]);
+	const __m256 ox = _mm256_set1_ps(origin[0]), oy = _mm256_set1_ps(origin[1]), oz = _mm256_set1_ps(origin[2]);
+	const __m256 dx = _mm256_set1_ps(dir[0]), dy = _mm256_set1_ps(dir[1]), dz = _mm256_set1_ps(dir[2]);
+	const __m256 eight = _mm256_set1_ps(8.f);
+	__m256 minProj = _mm256_set1_ps(FLT_MAX);
+	__m256 maxProj = _mm256_set1_ps(-FLT_MAX);
+	__m256 minIndex = _mm256_set1_ps(-1.f);
+	__m256 maxIndex = _mm256_set1_ps(-1.f);
+	__m256 index = _mm256_set_ps(7.f, 6.f, 5.f, 4.f, 3.f, 2.f, 1.f, 0.f);
+	long numBlocks = (count + BT_VECTOR3_SOA_BLOCK - 1) / BT_VECTOR3_SOA_BLOCK;
+	for (long b = 0; b < numBlocks; b++, soa += 3 * BT_VECTOR3_SOA_BLOCK)
+	{
+		__m256 vx = _mm256_mul_ps(_mm256_loadu_ps(soa), sx);
+		__m256 vy = _mm256_mul_ps(_mm256_loadu_ps(soa + BT_VECTOR3_SOA_BLOCK), sy);
+		__m256 vz = _mm256_mul_ps(_mm256_loadu_ps(soa + 2 * BT_VECTOR3_SOA_BLOCK), sz);
+		__m256 px = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, b00), _mm256_mul_ps(vy, b01)), _mm256_mul_ps(vz, b02)), ox);
+		__m256 py = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, b10), _mm256_mul_ps(vy, b11)), _mm256_mul_ps(vz, b12)), oy);
+		__m256 pz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, b20), _mm256_mul_ps(vy, b21)), _mm256_mul_ps(vz, b22)), oz);
+		__m256 dp = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, dx), _mm256_mul_ps(py, dy)), _mm256_mul_ps(pz, dz));
+		__m256 less = _mm256_cmp_ps(dp, minProj, _CMP_LT_OQ);
+		__m256 greater = _mm256_cmp_ps(dp, maxProj, _CMP_GT_OQ);
+		minProj = btSoaSelectAvx(less, dp, minProj);
+		minIndex = btSoaSelectAvx(less, index, minIndex);
+		maxProj = btSoaSelectAvx(greater, dp, maxProj);
+		maxIndex = btSoaSelectAvx(greater, index, maxIndex);
+		index = _mm256_add_ps(index, eight);
+	}
+	float negatedMin;
+	*minIndexOut = btSoaReduceMaxAvx(_mm256_xor_ps(minProj, _mm256_set1_ps(-0.f)), minIndex, &negatedMin);
+	*minProjOut = -negatedMin;
+	*maxIndexOut = btSoaReduceMaxAvx(maxProj, maxIndex, maxProjOut);
+}
+
+#endif //BT_USE_AVX_SOA
+
+typedef long (*btMaxDotSoaFunc)(const btScalar* soa, long count, const btScalar* dir, btScalar* dotOut);
+typedef void (*btProjectSoaFunc)(const btScalar* soa, long count, const btScalar* scaling, const btScalar* basis, const btScalar* origin, const btScalar* dir,
+	long* minIndexOut, btScalar* minProjOut, long* maxIndexOut, btScalar* maxProjOut);
+
+static long btMaxDotSoaSel(const btScalar* soa, long count, const btScalar* dir, btScalar* dotOut);
+static void btProjectSoaSel(const btScalar* soa, long count, const btScalar* scaling, const btScalar* basis, const btScalar* origin, const btScalar* dir,
+	long* minIndexOut, btScalar* minProjOut, long* maxIndexOut, btScalar* maxProjOut);
+
+static btMaxDotSoaFunc gMaxDotSoa = btMaxDotSoaSel;
+static btProjectSoaFunc gProjectSoa = btProjectSoaSel;
+
+static void btSelectSoaKernels()
+{
+	gMaxDotSoa = btMaxDotSoaScalar;
+	gProjectSoa = btProjectSoaScalar;
+#ifdef BT_USE_SSE_SOA
+	gMaxDotSoa = btMaxDotSoaSse;
+	gProjectSoa = btProjectSoaSse;
+#endif
+#ifdef BT_USE_AVX_SOA
+	if (btCpuFeatureUtility::getCpuFeatures() & btCpuFeatureUtility::CPU_FEATURE_AVX)
+	{
+		gMaxDotSoa = btMaxDotSoaAvx;
+		gProjectSoa = btProjectSoaAvx;
+	}
+#endif
+}
+
+static long btMaxDotSoaSel(const btScalar* soa, long count, const btScalar* dir, btScalar* dotOut)
+{
+	btSelectSoaKernels();
+	return gMaxDotSoa(soa, count, dir, dotOut);
+}
+
+static void btProjectSoaSel(const btScalar* soa, long count, const btScalar* scaling, const btScalar* basis, const btScalar* origin, const btScalar* dir,
+	long* minIndexOut, btScalar* minProjOut, long* maxIndexOut, btScalar* maxProjOut)
+{
+	btSelectSoaKernels();
+	gProjectSoa(soa, count, scaling, basis, origin, dir, minIndexOut, minProjOut, maxIndexOut, maxProjOut);
+}
+
+long btVector3_maxDotSoa(const btVector3* self, const btScalar* soa, long array_count, btScalar* dotOut)
+{
+	return gMaxDotSoa(soa, array_count, self->m_floats, dotOut);
+}
+
+long btVector3_minDotSoa(const btVector3* self, const btScalar* soa, long array_count, btScalar* dotOut)
+{
+	//negating the direction negates every product and sum exactly, so the first maximum of -dot is the first minimum of dot
+	btScalar negated[3] = { -self->m_floats[0], -self->m_floats[1], -self->m_floats[2] };
+	btScalar maxDot;
+	long index = gMaxDotSoa(soa, array_count, negated, &maxDot);
+	*dotOut = -maxDot;
+	return index;
+}
+
+void btVector3_projectSoa(const btScalar* soa, long array_count, const btVector3* scaling, const btVector3* basisRows, const btVector3* origin, const btVector3* dir,
+	long* minIndexOut, btScalar* minProjOut, long* maxIndexOut, btScalar* maxProjOut)
+{
+	//the rows are btVector3 with 4 scalars each
+	gProjectSoa(soa, array_count, scaling->m_floats, basisRows[0].m_floats, origin->m_floats, dir->m_floats, minIndexOut, minProjOut, maxIndexOut, maxProjOut);
+}
@@ -499,7 +499,7 @@ static SIMD_FORCE_INLINE void btVector_makeMultiplicationInv(btVector* BT_RESTRI
 	__m128 vec = _mm_div_ps(a->mVec128, b->mVec128);
 	if (mode == BT_VEC3_MODE)
 		vec = _mm_and_ps(vec, btvFFF0fMask);
-	self->mVec128 = vec;
+	result->mVec128 = vec;
 #elif defined(BT_USE_NEON)
 	float32x4_t x, y, inv, m;
 
@@ -526,11 +526,21 @@ static SIMD_FORCE_INLINE btScalar btVector_dot(const btVector* a, const btVector
 	// First, multiply each component
 	__m128 vd = _mm_mul_ps(a->mVec128, b->mVec128);
 	
-	// We sum the component in the lower 32 bits
-	__m128 t = _mm_movehl_ps(vd, vd);
-	vd = _mm_add_ps(vd, t);
-	t = _mm_shuffle_ps(vd, vd, 0x55);
-	vd = _mm_add_ss(vd, t);
+	// We sum the component in the lower 32 bits, the w component only takes part in BT_VEC4_MODE
+	if (mode == BT_VEC4_MODE)
+	{
+		__m128 t = _mm_movehl_ps(vd, vd);
+		vd = _mm_add_ps(vd, t);
+		t = _mm_shuffle_ps(vd, vd, 0x55);
+		vd = _mm_add_ss(vd, t);
+	}
+	else
+	{
+		__m128 z = _mm_movehl_ps(vd, vd);
+		__m128 y = _mm_shuffle_ps(vd, vd, 0x55);
+		vd = _mm_add_ss(vd, y);
+		vd = _mm_add_ss(vd, z);
+	}
 	
 	return _mm_cvtss_f32(vd);
 #elif defined(BT_USE_NEON)
@@ -556,11 +566,21 @@ static SIMD_FORCE_INLINE btScalar btVector_length2(const btVector* self, btVecto
 	// First, multiply each component
 	__m128 vd = _mm_mul_ps(self->mVec128, self->mVec128);
 	
-	// We sum the component in the lower 32 bits
-	__m128 t = _mm_movehl_ps(vd, vd);
-	vd = _mm_add_ps(vd, t);
-	t = _mm_shuffle_ps(vd, vd, 0x55);
-	vd = _mm_add_ss(vd, t);
+	// We sum the component in the lower 32 bits, the w component only takes part in BT_VEC4_MODE
+	if (mode == BT_VEC4_MODE)
+	{
+		__m128 t = _mm_movehl_ps(vd, vd);
+		vd = _mm_add_ps(vd, t);
+		t = _mm_shuffle_ps(vd, vd, 0x55);
+		vd = _mm_add_ss(vd, t);
+	}
+	else
+	{
+		__m128 z = _mm_movehl_ps(vd, vd);
+		__m128 y = _mm_shuffle_ps(vd, vd, 0x55);
+		vd = _mm_add_ss(vd, y);
+		vd = _mm_add_ss(vd, z);
+	}
 	
 	return _mm_cvtss_f32(vd);
 #elif defined(BT_USE_NEON)
@@ -596,7 +616,7 @@ static SIMD_FORCE_INLINE btScalar btVector_distance2(const btVector* a, const bt
 static SIMD_FORCE_INLINE btVector btVector_absolute(const btVector* self, btVectorMode mode)
 {
 #if defined BT_USE_SIMD_VECTOR3 && defined (BT_USE_SSE_IN_API) && defined (BT_USE_SSE) 
-	return btVector_fromSimd(_mm_and_ps(self->mVec128, (mode == BT_VEC4_MODE) ? btvAbsMask : btv3AbsfMask));
+	return btVector_fromSimd(_mm_and_ps(self->mVec128, (mode == BT_VEC4_MODE) ? btvAbsfMask : btv3AbsfMask));
 #elif defined(BT_USE_NEON)
 	return btVector_fromSimd(vabsq_f32(self->mVec128));
 #else	
@@ -796,13 +816,13 @@ static SIMD_FORCE_INLINE btVector btVector_lerp(const btVector* self, const btVe
 	vl = _mm_mul_ps(vl, vt);
 	vl = _mm_add_ps(vl, self->mVec128);
 	
-	return btVector(vl);
+	return btVector_fromSimd(vl);
 #elif defined(BT_USE_NEON)
 	float32x4_t vl = vsubq_f32(v->mVec128, self->mVec128);
 	vl = vmulq_n_f32(vl, t);
 	vl = vaddq_f32(vl, self->mVec128);
 	
-	return btVector(vl);
+	return btVector_fromSimd(vl);
 #else
 	return
 		btVector(self->m_floats[0] + (v->m_floats[0] - self->m_floats[0]) * t,
@@ -1261,6 +1281,18 @@ public:
      * @param dotOut The minimum dot product */    
     SIMD_FORCE_INLINE   long    minDot( const btVector3 *array, long array_count, btScalar &dotOut ) const; 
 
+    /**@brief returns index of maximum dot product between this and vectors packed with btVector3_packSoa
+     * @param soa The packed vectors
+     * @param array_count The number of packed vectors
+     * @param dotOut The maximum dot product */
+    SIMD_FORCE_INLINE   long    maxDotSoa( const btScalar *soa, long array_count, btScalar &dotOut ) const;
+
+    /**@brief returns index of minimum dot product between this and vectors packed with btVector3_packSoa
+     * @param soa The packed vectors
+     * @param array_count The number of packed vectors
+     * @param dotOut The minimum dot product */
+    SIMD_FORCE_INLINE   long    minDotSoa( const btScalar *soa, long array_count, btScalar &dotOut ) const;
+
     /* create a vector as  btVector3( this->dot( btVector3 v0 ), this->dot( btVector3 v1), this->dot( btVector3 v2 ))  */
     SIMD_FORCE_INLINE btVector3  dot3( const btVector3 &v0, const btVector3 &v1, const btVector3 &v2 ) const
     {
@@ -1485,7 +1517,7 @@ static SIMD_FORCE_INLINE btVector3 btVector3_rotate(const btVector3* self, const
     __m128 O = _mm_mul_ps(wAxis->mVec128, self->mVec128);
 	btScalar ssin = btSin( _angle );
 	btVector3 cross = btVector3_cross(wAxis, self);
-    __m128 C = cross->mVec128;
+    __m128 C = cross.mVec128;
     btScalar scos = btCos( _angle );
 	
 	__m128 Y = bt_pshufd_ps(O, 0xC9);	//	(Y Z X 0)
@@ -1602,7 +1634,7 @@ static SIMD_FORCE_INLINE long btVector3_maxDot(const btVector3* BT_RESTRICT self
         return ptIndex;
     }
 #if (defined BT_USE_SSE && defined BT_USE_SIMD_VECTOR3 && defined BT_USE_SSE_IN_API) || defined (BT_USE_NEON)
-    return _maxdot_large( (float*) &self.m_floats[0], (float*) &array[0].m_floats[0], array_count, &dotOut );
+    return _maxdot_large( (float*) &array[0].m_floats[0], (float*) &self->m_floats[0], array_count, dotOut );
 #endif
 }
 
@@ -1645,11 +1677,43 @@ static SIMD_FORCE_INLINE long btVector3_minDot(const btVector3* BT_RESTRICT self
         return ptIndex;
     }
 #if (defined BT_USE_SSE && defined BT_USE_SIMD_VECTOR3 && defined BT_USE_SSE_IN_API) || defined (BT_USE_NEON)
-    return _mindot_large( (float*) &self.m_floats[0], (float*) &array[0].m_floats[0], array_count, &dotOut );
+    return _mindot_large( (float*) &array[0].m_floats[0], (float*) &self->m_floats[0], array_count, dotOut );
 #endif//BT_USE_SIMD_VECTOR3
 }
 
 
+///number of vectors in one block of the btVector3_packSoa layout
+#define BT_VECTOR3_SOA_BLOCK 8
+
+/**@brief returns the number of scalars btVector3_packSoa writes for array_count vectors */
+static SIMD_FORCE_INLINE long btVector3_soaSize(long array_count)
+{
+	return ((array_count + BT_VECTOR3_SOA_BLOCK - 1) / BT_VECTOR3_SOA_BLOCK) * 3 * BT_VECTOR3_SOA_BLOCK;
+}
+
+/**@brief packs vectors as blocks of BT_VECTOR3_SOA_BLOCK x values, then y values, then z values, for the Soa dot product kernels
+  * The last block is padded with copies of the last vector
+  * @param array The vectors to pack
+  * @param array_count The number of vectors
+  * @param soaOut Receives btVector3_soaSize(array_count) scalars */
+void btVector3_packSoa(const btVector3* array, long array_count, btScalar* soaOut);
+
+/**@brief returns index of maximum dot product between self and the vectors packed with btVector3_packSoa
+  * Uses AVX or SSE when the CPU has them, and returns the same index and dot product as the scalar btVector3_maxDot loop
+  * @param dotOut The maximum dot product, mustn't be NULL */
+long btVector3_maxDotSoa(const btVector3* self, const btScalar* soa, long array_count, btScalar* dotOut);
+
+/**@brief returns index of minimum dot product between self and the vectors packed with btVector3_packSoa
+  * @param dotOut The minimum dot product, mustn't be NULL */
+long btVector3_minDotSoa(const btVector3* self, const btScalar* soa, long array_count, btScalar* dotOut);
+
+/**@brief finds the smallest and largest projection (basis * (v * scaling) + origin).dot(dir) of the vectors packed with btVector3_packSoa
+  * The projections are computed in the same order as btTransform and btVector3::dot, so they match the scalar loop bit for bit.
+  * Like btConvexPolyhedron::project the search starts at FLT_MAX and -FLT_MAX, an index is -1 if no projection passed it.
+  * @param basisRows The three rows of the basis */
+void btVector3_projectSoa(const btScalar* soa, long array_count, const btVector3* scaling, const btVector3* basisRows, const btVector3* origin, const btVector3* dir,
+	long* minIndexOut, btScalar* minProjOut, long* maxIndexOut, btScalar* maxProjOut);
+
 #ifdef __cplusplus
 /**@brief Return the sum of two vectors (Point symantics)*/
 SIMD_FORCE_INLINE btVector3 
@@ -1801,6 +1865,16 @@ SIMD_FORCE_INLINE   long    btVector3::minDot( const btVector3 *array, long arra
 {
 	return btVector3_minDot(this, array, array_count, &dotOut);
 }
+
+SIMD_FORCE_INLINE   long    btVector3::maxDotSoa( const btScalar *soa, long array_count, btScalar &dotOut ) const
+{
+	return btVector3_maxDotSoa(this, soa, array_count, &dotOut);
+}
+
+SIMD_FORCE_INLINE   long    btVector3::minDotSoa( const btScalar *soa, long array_count, btScalar &dotOut ) const
+{
+	return btVector3_minDotSoa(this, soa, array_count, &dotOut);
+}
 #endif//__cplusplus
 
 
@@ -14,9 +14,9 @@
 
 #ifdef __APPLE__
 #include <mach/mach_time.h>
+#include <sys/sysctl.h>
 #endif //__APPLE__
 
-#include <sys/sysctl.h>
 #include <sys/mman.h>
 #include <errno.h>
 
@@ -0,0 +1,278 @@
+#include <gtest/gtest.h>
+
+#include "btBulletCollisionCommon.h"
+#include "TestScheduler.h"
+
+namespace
+{
+
+	///small deterministic random number generator, so failures reproduce on every platform
+	struct TestRandom
+	{
+		unsigned int m_state;
+
+		TestRandom(unsigned int seed) : m_state(seed)
+		{
+		}
+
+		int next(int range)
+		{
+			m_state = m_state * 1664525u + 1013904223u;
+			return int((m_state >> 8) % unsigned(range));
+		}
+
+		btScalar nextScalar(btScalar lo, btScalar hi)
+		{
+			return lo + (hi - lo) * btScalar(next(10000)) / btScalar(10000);
+		}
+
+		btVector3 nextVector(btScalar lo, btScalar hi)
+		{
+			btScalar x = nextScalar(lo, hi);
+			btScalar y = nextScalar(lo, hi);
+			btScalar z = nextScalar(lo, hi);
+			return btVector3(x, y, z);
+		}
+	};
+
+	///boxes in a cube, moved by small steps that stay in the fattened leaf volume, by larger steps that leave it,
+	///and by teleports that leave the old volume completely
+	struct MovingBoxes
+	{
+		TestRandom m_random;
+		btAlignedObjectArray<btVector3> m_aabbMin;
+		btAlignedObjectArray<btVector3> m_aabbMax;
+
+		MovingBoxes(int numBoxes) : m_random(7)
+		{
+			for (int i = 0; i < numBoxes; i++)
+			{
+				btVector3 center = m_random.nextVector(-20, 20);
+				btVector3 extent = m_random.nextVector(btScalar(0.25), 1);
+				m_aabbMin.push_back(center - extent);
+				m_aabbMax.push_back(center + extent);
+			}
+		}
+
+		void move(int index)
+		{
+			int kind = m_random.next(10);
+			btVector3 delta = kind < 4 ? m_random.nextVector(btScalar(-0.02), btScalar(0.02)) : kind < 9 ? m_random.nextVector(-1, 1) : m_random.nextVector(-30, 30);
+			m_aabbMin[index] += delta;
+			m_aabbMax[index] += delta;
+		}
+	};
+
+	btBroadphaseProxy* createProxy(btBroadphaseInterface& broadphase, const MovingBoxes& boxes, int index)
+	{
+		return broadphase.createProxy(boxes.m_aabbMin[index], boxes.m_aabbMax[index], BOX_SHAPE_PROXYTYPE, (void*)(size_t)index,
+			btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter, 0, 0);
+	}
+
+	///every leaf volume bounds the aabb of its proxy, and every node volume bounds its children
+	void expectValidTree(const btDbvt& tree)
+	{
+		btAlignedObjectArray<const btDbvtNode*> stack;
+		if (tree.m_root)
+		{
+			stack.push_back(tree.m_root);
+		}
+		int numLeaves = 0;
+		while (stack.size())
+		{
+			const btDbvtNode* node = stack[stack.size() - 1];
+			stack.pop_back();
+			if (node->isinternal())
+			{
+				for (int i = 0; i < 2; i++)
+				{
+					ASSERT_EQ(node, node->childs[i]->parent);
+					ASSERT_TRUE(node->volume.Contain(node->childs[i]->volume));
+					stack.push_back(node->childs[i]);
+				}
+			}
+			else
+			{
+				const btDbvtProxy* proxy = (const btDbvtProxy*)node->data;
+				ASSERT_EQ(node, proxy->leaf);
+				ASSERT_TRUE(node->volume.Contain(btDbvtVolume::FromMM(proxy->m_aabbMin, proxy->m_aabbMax)));
+				numLeaves++;
+			}
+		}
+		EXPECT_EQ(tree.m_leaves, numLeaves);
+	}
+
+	///the pair cache may keep pairs that stopped overlapping until the cleanup finds them, but it has all overlapping pairs
+	void expectAllOverlapsFound(btBroadphaseInterface& broadphase, const btAlignedObjectArray<btBroadphaseProxy*>& proxies, const MovingBoxes& boxes)
+	{
+		btOverlappingPairCache* pairCache = broadphase.getOverlappingPairCache();
+		int numOverlaps = 0;
+		for (int i = 0; i < proxies.size(); i++)
+		{
+			for (int j = i + 1; j < proxies.size(); j++)
+			{
+				if (TestAabbAgainstAabb2(boxes.m_aabbMin[i], boxes.m_aabbMax[i], boxes.m_aabbMin[j], boxes.m_aabbMax[j]))
+				{
+					ASSERT_TRUE(pairCache->findPair(proxies[i], proxies[j]) != 0) << "proxies " << i << " " << j;
+					numOverlaps++;
+				}
+			}
+		}
+		EXPECT_LE(numOverlaps, pairCache->getNumOverlappingPairs());
+	}
+
+}
+
+
+///setAabbs applies the moves of a whole batch before it collides the leaves, the tree has to stay valid and the pairs
+///have to cover the same overlaps as with one setAabb call per proxy. Small batches update leaf by leaf, batches over 1/16
+///of the tree refit once.
+TEST(AabbBatchTest, SetAabbsMatchesSetAabb)
+{
+	const int numBoxes = 600;
+	const int batchSizes[] = {10, 300, numBoxes};
+	const int threadCounts[] = {1, 4};
+	for (int t = 0; t < 2; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		MovingBoxes boxes(numBoxes);
+		btDbvtBroadphase expected;
+		btDbvtBroadphase actual;
+		btAlignedObjectArray<btBroadphaseProxy*> expectedProxies;
+		btAlignedObjectArray<btBroadphaseProxy*> actualProxies;
+		for (int i = 0; i < numBoxes; i++)
+		{
+			expectedProxies.push_back(createProxy(expected, boxes, i));
+			actualProxies.push_back(createProxy(actual, boxes, i));
+		}
+
+		btAlignedObjectArray<btBroadphaseProxy*> batchProxies;
+		btAlignedObjectArray<btVector3> batchMin;
+		btAlignedObjectArray<btVector3> batchMax;
+		for (int frame = 0; frame < 30; frame++)
+		{
+			int batchSize = batchSizes[frame % 3];
+			batchProxies.resize(0);
+			batchMin.resize(0);
+			batchMax.resize(0);
+			int first = boxes.m_random.next(numBoxes);
+			for (int k = 0; k < batchSize; k++)
+			{
+				int i = (first + k) % numBoxes;
+				boxes.move(i);
+				expected.setAabb(expectedProxies[i], boxes.m_aabbMin[i], boxes.m_aabbMax[i], 0);
+				batchProxies.push_back(actualProxies[i]);
+				batchMin.push_back(boxes.m_aabbMin[i]);
+				batchMax.push_back(boxes.m_aabbMax[i]);
+			}
+			actual.setAabbs(&batchProxies[0], &batchMin[0], &batchMax[0], batchSize, 0);
+			expected.calculateOverlappingPairs(0);
+			actual.calculateOverlappingPairs(0);
+
+			expectValidTree(actual.m_sets[0]);
+			expectAllOverlapsFound(expected, expectedProxies, boxes);
+			expectAllOverlapsFound(actual, actualProxies, boxes);
+			if (::testing::Test::HasFatalFailure())
+			{
+				setTestNumThreads(1);
+				return;
+			}
+			for (int i = 0; i < numBoxes; i++)
+			{
+				btVector3 aabbMin, aabbMax;
+				actual.getAabb(actualProxies[i], aabbMin, aabbMax);
+				ASSERT_TRUE(aabbMin == boxes.m_aabbMin[i] && aabbMax == boxes.m_aabbMax[i]) << "proxy " << i << " frame " << frame;
+			}
+		}
+		EXPECT_EQ(expected.m_sets[0].m_leaves, actual.m_sets[0].m_leaves);
+		for (int i = 0; i < numBoxes; i++)
+		{
+			expected.destroyProxy(expectedProxies[i], 0);
+			actual.destroyProxy(actualProxies[i], 0);
+		}
+	}
+	setTestNumThreads(1);
+}
+
+///updateAabbs computes the aabbs with btParallelFor and passes them in one batch, the broadphase gets the same aabbs
+///and pairs as from one updateSingleAabb call per object
+TEST(AabbBatchTest, UpdateAabbsMatchesUpdateSingleAabb)
+{
+	const int numObjects = 400;
+	const int threadCounts[] = {1, 4};
+	for (int t = 0; t < 2; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		btDefaultCollisionConfiguration configuration;
+		btCollisionDispatcher dispatcher(&configuration);
+		btDbvtBroadphase expectedBroadphase;
+		btDbvtBroadphase actualBroadphase;
+		btCollisionWorld expected(&dispatcher, &expectedBroadphase, &configuration);
+		btCollisionWorld actual(&dispatcher, &actualBroadphase, &configuration);
+		btBoxShape box(btVector3(btScalar(0.5), btScalar(0.3), btScalar(0.8)));
+		btSphereShape sphere(btScalar(0.6));
+		btAlignedObjectArray<btCollisionObject*> objects;
+		TestRandom random(11);
+		for (int i = 0; i < 2 * numObjects; i++)
+		{
+			btCollisionObject* obj = new btCollisionObject();
+			obj->setCollisionShape((i % numObjects) % 3 ? (btCollisionShape*)&box : (btCollisionShape*)&sphere);
+			objects.push_back(obj);
+		}
+		for (int frame = 0; frame < 20; frame++)
+		{
+			for (int i = 0; i < numObjects; i++)
+			{
+				btTransform tr;
+				tr.setOrigin(random.nextVector(-15, 15));
+				tr.setRotation(btQuaternion(random.nextVector(-1, 1) + btVector3(0, 0, btScalar(1.5)), random.nextScalar(0, SIMD_PI)));
+				objects[i]->setWorldTransform(tr);
+				objects[numObjects + i]->setWorldTransform(tr);
+				if (frame == 0)
+				{
+					expected.addCollisionObject(objects[i]);
+					actual.addCollisionObject(objects[numObjects + i]);
+				}
+			}
+			for (int i = 0; i < numObjects; i++)
+			{
+				expected.updateSingleAabb(objects[i]);
+			}
+			actual.updateAabbs();
+			expected.computeOverlappingPairs();
+			actual.computeOverlappingPairs();
+			for (int i = 0; i < numObjects; i++)
+			{
+				const btBroadphaseProxy* a = objects[i]->getBroadphaseHandle();
+				const btBroadphaseProxy* b = objects[numObjects + i]->getBroadphaseHandle();
+				ASSERT_TRUE(a->m_aabbMin == b->m_aabbMin && a->m_aabbMax == b->m_aabbMax) << "object " << i << " frame " << frame;
+			}
+			//the same overlapping proxies are paired in both worlds
+			btBroadphasePairArray& pairs = expected.getPairCache()->getOverlappingPairArray();
+			int numOverlaps = 0;
+			for (int i = 0; i < pairs.size(); i++)
+			{
+				const btBroadphaseProxy* p0 = pairs[i].m_pProxy0;
+				const btBroadphaseProxy* p1 = pairs[i].m_pProxy1;
+				if (TestAabbAgainstAabb2(p0->m_aabbMin, p0->m_aabbMax, p1->m_aabbMin, p1->m_aabbMax))
+				{
+					btCollisionObject* a = objects[numObjects + objects.findLinearSearch((btCollisionObject*)p0->m_clientObject)];
+					btCollisionObject* b = objects[numObjects + objects.findLinearSearch((btCollisionObject*)p1->m_clientObject)];
+					ASSERT_TRUE(actual.getPairCache()->findPair(a->getBroadphaseHandle(), b->getBroadphaseHandle()) != 0) << "pair " << i << " frame " << frame;
+					numOverlaps++;
+				}
+			}
+			EXPECT_GT(numOverlaps, 0);
+		}
+		for (int i = 0; i < numObjects; i++)
+		{
+			expected.removeCollisionObject(objects[i]);
+			actual.removeCollisionObject(objects[numObjects + i]);
+		}
+		for (int i = 0; i < objects.size(); i++)
+		{
+			delete objects[i];
+		}
+	}
+	setTestNumThreads(1);
+}
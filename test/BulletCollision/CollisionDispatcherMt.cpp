@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+
+#include "btBulletCollisionCommon.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "TestScheduler.h"
+
+namespace
+{
+
+	///a grid of overlapping boxes and spheres, moved between frames so manifolds are created and released
+	struct CollisionScene
+	{
+		btDefaultCollisionConfiguration		m_configuration;
+		btCollisionDispatcher*				m_dispatcher;
+		btDbvtBroadphase					m_broadphase;
+		btCollisionWorld*					m_world;
+		btBoxShape							m_box;
+		btSphereShape						m_sphere;
+		btAlignedObjectArray<btCollisionObject*>	m_objects;
+
+		CollisionScene(bool multiThreaded)
+			:m_box(btVector3(0.5, 0.5, 0.5)),
+			m_sphere(0.6)
+		{
+			if (multiThreaded)
+			{
+				m_dispatcher = new btCollisionDispatcherMt(&m_configuration, 8);
+			}
+			else
+			{
+				m_dispatcher = new btCollisionDispatcher(&m_configuration);
+			}
+			m_world = new btCollisionWorld(m_dispatcher, &m_broadphase, &m_configuration);
+			for (int i = 0; i < 216; i++)
+			{
+				btCollisionObject* obj = new btCollisionObject();
+				obj->setCollisionShape(i & 1 ? (btCollisionShape*)&m_sphere : (btCollisionShape*)&m_box);
+				obj->setUserIndex(i);
+				m_objects.push_back(obj);
+				m_world->addCollisionObject(obj);
+			}
+			setPositions(0);
+		}
+
+		~CollisionScene()
+		{
+			for (int i = 0; i < m_objects.size(); i++)
+			{
+				m_world->removeCollisionObject(m_objects[i]);
+				delete m_objects[i];
+			}
+			delete m_world;
+			delete m_dispatcher;
+		}
+
+		void setPositions(int frame)
+		{
+			for (int i = 0; i < m_objects.size(); i++)
+			{
+				btScalar phase = btScalar(i * 7 + frame * 3);
+				btVector3 pos(btScalar(i % 6), btScalar((i / 6) % 6), btScalar(i / 36));
+				pos += btVector3(btSin(phase), btCos(phase * 1.3f), btSin(phase * 0.7f)) * btScalar(0.2);
+				btTransform tr(btQuaternion(btVector3(1, 1, 0).normalized(), phase * 0.1f), pos);
+				m_objects[i]->setWorldTransform(tr);
+			}
+		}
+	};
+
+	void expectSameManifolds(btDispatcher* expected, btDispatcher* actual)
+	{
+		ASSERT_EQ(expected->getNumManifolds(), actual->getNumManifolds());
+		for (int i = 0; i < expected->getNumManifolds(); i++)
+		{
+			const btPersistentManifold* a = expected->getManifoldByIndexInternal(i);
+			const btPersistentManifold* b = actual->getManifoldByIndexInternal(i);
+			EXPECT_EQ(a->getBody0()->getUserIndex(), b->getBody0()->getUserIndex());
+			EXPECT_EQ(a->getBody1()->getUserIndex(), b->getBody1()->getUserIndex());
+			ASSERT_EQ(a->getNumContacts(), b->getNumContacts());
+			for (int c = 0; c < a->getNumContacts(); c++)
+			{
+				EXPECT_EQ(a->getContactPoint(c).getDistance(), b->getContactPoint(c).getDistance());
+				EXPECT_TRUE(a->getContactPoint(c).m_positionWorldOnB == b->getContactPoint(c).m_positionWorldOnB);
+				EXPECT_TRUE(a->getContactPoint(c).m_normalWorldOnB == b->getContactPoint(c).m_normalWorldOnB);
+			}
+		}
+	}
+
+}
+
+
+TEST(CollisionDispatcherMtTest, SameManifoldsAsSerialDispatcher)
+{
+	const int threadCounts[] = {1, 2, 4};
+	for (int t = 0; t < 3; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		CollisionScene serial(false);
+		CollisionScene parallel(true);
+		for (int frame = 0; frame < 4; frame++)
+		{
+			serial.setPositions(frame);
+			parallel.setPositions(frame);
+			serial.m_world->performDiscreteCollisionDetection();
+			parallel.m_world->performDiscreteCollisionDetection();
+			EXPECT_GT(serial.m_dispatcher->getNumManifolds(), 0);
+			expectSameManifolds(serial.m_dispatcher, parallel.m_dispatcher);
+		}
+	}
+	setTestNumThreads(1);
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include "btBulletCollisionCommon.h"
+#include <float.h>
+#include <string.h>
+
+namespace
+{
+
+	///points on a coarse integer grid, so many of them have the same dot product with an axis aligned direction
+	void makePoints(btAlignedObjectArray<btVector3>& points, int count, bool grid)
+	{
+		points.resize(0);
+		for (int i = 0; i < count; i++)
+		{
+			if (grid)
+			{
+				points.push_back(btVector3(btScalar(i % 3 - 1), btScalar((i / 3) % 3 - 1), btScalar(i % 2)));
+			}
+			else
+			{
+				btScalar a = btScalar(i) * 0.37f;
+				points.push_back(btVector3(btSin(a) * 2, btCos(a * 1.3f), btSin(a * 2.1f + 1) * 1.5f));
+			}
+		}
+	}
+
+	///the scalar loops the packed kernels have to match, ties go to the first index
+	long maxDotLoop(const btVector3& dir, const btAlignedObjectArray<btVector3>& points, btScalar& dotOut)
+	{
+		long index = -1;
+		btScalar best = -BT_LARGE_FLOAT;
+		for (int i = 0; i < points.size(); i++)
+		{
+			btScalar dot = dir.dot(points[i]);
+			if (dot > best)
+			{
+				best = dot;
+				index = i;
+			}
+		}
+		dotOut = best;
+		return index;
+	}
+
+	long minDotLoop(const btVector3& dir, const btAlignedObjectArray<btVector3>& points, btScalar& dotOut)
+	{
+		long index = -1;
+		btScalar best = BT_LARGE_FLOAT;
+		for (int i = 0; i < points.size(); i++)
+		{
+			btScalar dot = dir.dot(points[i]);
+			if (dot < best)
+			{
+				best = dot;
+				index = i;
+			}
+		}
+		dotOut = best;
+		return index;
+	}
+
+	void projectLoop(const btAlignedObjectArray<btVector3>& points, const btVector3& scaling, const btTransform& trans, const btVector3& dir,
+		long& minIndex, btScalar& minProj, long& maxIndex, btScalar& maxProj)
+	{
+		minIndex = -1;
+		maxIndex = -1;
+		minProj = FLT_MAX;
+		maxProj = -FLT_MAX;
+		for (int i = 0; i < points.size(); i++)
+		{
+			btScalar dp = (trans * (points[i] * scaling)).dot(dir);
+			if (dp < minProj)
+			{
+				minProj = dp;
+				minIndex = i;
+			}
+			if (dp > maxProj)
+			{
+				maxProj = dp;
+				maxIndex = i;
+			}
+		}
+	}
+
+	void makeDirections(btAlignedObjectArray<btVector3>& directions)
+	{
+		//axis aligned directions give ties on the grid
+		directions.push_back(btVector3(1, 0, 0));
+		directions.push_back(btVector3(0, -1, 0));
+		directions.push_back(btVector3(0, 0, 1));
+		directions.push_back(btVector3(1, 1, 0));
+		directions.push_back(btVector3(0, 0, 0));
+		for (int i = 0; i < 20; i++)
+		{
+			btScalar a = btScalar(i) * 0.91f;
+			directions.push_back(btVector3(btCos(a), btSin(a * 1.7f), btSin(a) * 0.5f));
+		}
+	}
+
+}
+
+
+TEST(ConvexHullSoaTest, PackedKernelsMatchScalarLoops)
+{
+	btAlignedObjectArray<btVector3> directions;
+	makeDirections(directions);
+	btAlignedObjectArray<btVector3> points;
+	btAlignedObjectArray<btScalar> soa;
+	const int counts[] = {1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 64, 101};
+	int numTies = 0;
+	for (int c = 0; c < 12; c++)
+	{
+		for (int grid = 0; grid < 2; grid++)
+		{
+			makePoints(points, counts[c], grid != 0);
+			soa.resize(btVector3_soaSize(points.size()));
+			btVector3_packSoa(&points[0], points.size(), &soa[0]);
+			for (int d = 0; d < directions.size(); d++)
+			{
+				const btVector3& dir = directions[d];
+				btScalar expectedDot, dot;
+				long expectedIndex = maxDotLoop(dir, points, expectedDot);
+				long index = dir.maxDotSoa(&soa[0], points.size(), dot);
+				EXPECT_EQ(expectedIndex, index) << counts[c] << " points, direction " << d;
+				EXPECT_EQ(expectedDot, dot) << counts[c] << " points, direction " << d;
+				for (int i = expectedIndex + 1; i < points.size(); i++)
+				{
+					numTies += dir.dot(points[i]) == expectedDot ? 1 : 0;
+				}
+
+				expectedIndex = minDotLoop(dir, points, expectedDot);
+				index = dir.minDotSoa(&soa[0], points.size(), dot);
+				EXPECT_EQ(expectedIndex, index) << counts[c] << " points, direction " << d;
+				EXPECT_EQ(expectedDot, dot) << counts[c] << " points, direction " << d;
+
+				btTransform trans(btQuaternion(btVector3(1, 2, 3).normalized(), btScalar(d) * 0.4f), btVector3(btScalar(d), -1, 2));
+				btVector3 scaling(1, btScalar(0.5) + btScalar(d % 3), 2);
+				if (d < 5)
+				{
+					//keep the ties of the axis aligned directions
+					trans.setIdentity();
+					scaling.setValue(1, 1, 1);
+				}
+				long expectedMinIndex, expectedMaxIndex, minIndex, maxIndex;
+				btScalar expectedMinProj, expectedMaxProj, minProj, maxProj;
+				projectLoop(points, scaling, trans, dir, expectedMinIndex, expectedMinProj, expectedMaxIndex, expectedMaxProj);
+				btVector3_projectSoa(&soa[0], points.size(), &scaling, &trans.getBasis()[0], &trans.getOrigin(), &dir, &minIndex, &minProj, &maxIndex, &maxProj);
+				EXPECT_EQ(expectedMinIndex, minIndex) << counts[c] << " points, direction " << d;
+				EXPECT_EQ(expectedMaxIndex, maxIndex) << counts[c] << " points, direction " << d;
+				EXPECT_EQ(expectedMinProj, minProj) << counts[c] << " points, direction " << d;
+				EXPECT_EQ(expectedMaxProj, maxProj) << counts[c] << " points, direction " << d;
+			}
+		}
+	}
+	//the grid points and the zero direction give plenty of ties after the first maximum
+	EXPECT_GT(numTies, 100);
+}
+
+///reading the points through the non-const getUnscaledPoints doesn't change the packed points, only recalcLocalAabb
+///and packPoints repack them
+TEST(ConvexHullSoaTest, PackedPointsOnlyChangeOnRecalc)
+{
+	btAlignedObjectArray<btVector3> points;
+	makePoints(points, 37, false);
+	btConvexHullShape hull(&points[0].m_floats[0], points.size(), sizeof(btVector3));
+	const btScalar* soa = hull.getSoaPoints();
+	ASSERT_TRUE(soa != 0);
+	btAlignedObjectArray<btScalar> packed;
+	packed.resize(btVector3_soaSize(points.size()));
+	memcpy(&packed[0], soa, sizeof(btScalar) * packed.size());
+
+	btVector3* unscaledPoints = hull.getUnscaledPoints();
+	EXPECT_EQ(soa, hull.getSoaPoints());
+	EXPECT_EQ(0, memcmp(&packed[0], hull.getSoaPoints(), sizeof(btScalar) * packed.size()));
+
+	//a changed point is only used after recalcLocalAabb
+	btVector3 dir(0.3f, 1, 0.2f);
+	btVector3 oldSupport = hull.localGetSupportingVertexWithoutMargin(dir);
+	unscaledPoints[5] = btVector3(0, 10, 0);
+	EXPECT_EQ(0, memcmp(&packed[0], hull.getSoaPoints(), sizeof(btScalar) * packed.size()));
+	EXPECT_TRUE(hull.localGetSupportingVertexWithoutMargin(dir) == oldSupport);
+	hull.recalcLocalAabb();
+	EXPECT_TRUE(hull.localGetSupportingVertexWithoutMargin(dir) == btVector3(0, 10, 0));
+	btVector3 aabbMin, aabbMax;
+	hull.getAabb(btTransform::getIdentity(), aabbMin, aabbMax);
+	EXPECT_GE(aabbMax.y(), 10);
+
+	//addPoint after a change through getUnscaledPoints repacks all points
+	hull.getUnscaledPoints()[6] = btVector3(0, -10, 0);
+	hull.addPoint(btVector3(20, 0, 0));
+	EXPECT_TRUE(hull.localGetSupportingVertexWithoutMargin(btVector3(0, -1, 0)) == btVector3(0, -10, 0));
+	EXPECT_TRUE(hull.localGetSupportingVertexWithoutMargin(btVector3(1, 0, 0)) == btVector3(20, 0, 0));
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include "btBulletCollisionCommon.h"
+#include "TestScheduler.h"
+
+namespace
+{
+
+	///small deterministic random number generator, so failures reproduce on every platform
+	struct TestRandom
+	{
+		unsigned int m_state;
+
+		TestRandom(unsigned int seed) : m_state(seed)
+		{
+		}
+
+		int next(int range)
+		{
+			m_state = m_state * 1664525u + 1013904223u;
+			return int((m_state >> 8) % unsigned(range));
+		}
+
+		btVector3 nextVector(btScalar lo, btScalar hi)
+		{
+			btScalar x = lo + (hi - lo) * btScalar(next(10000)) / btScalar(10000);
+			btScalar y = lo + (hi - lo) * btScalar(next(10000)) / btScalar(10000);
+			btScalar z = lo + (hi - lo) * btScalar(next(10000)) / btScalar(10000);
+			return btVector3(x, y, z);
+		}
+	};
+
+	///the same proxies in two broadphases, one collided with the sequential scheduler and one with worker threads.
+	///A third of the boxes never moves, so their proxies end up in the fixed set.
+	struct PairOrderScene
+	{
+		TestRandom m_random;
+		btDbvtBroadphase m_expected;
+		btDbvtBroadphase m_actual;
+		btAlignedObjectArray<btBroadphaseProxy*> m_expectedProxies;
+		btAlignedObjectArray<btBroadphaseProxy*> m_actualProxies;
+		btAlignedObjectArray<btVector3> m_aabbMin;
+		btAlignedObjectArray<btVector3> m_aabbMax;
+		btAlignedObjectArray<btBroadphaseProxy*> m_batchProxies;
+		btAlignedObjectArray<btVector3> m_batchMin;
+		btAlignedObjectArray<btVector3> m_batchMax;
+
+		PairOrderScene(int numBoxes, bool deferred) : m_random(5)
+		{
+			m_expected.m_deferedcollide = deferred;
+			m_actual.m_deferedcollide = deferred;
+			for (int i = 0; i < numBoxes; i++)
+			{
+				btVector3 center = m_random.nextVector(-25, 25);
+				btVector3 extent = m_random.nextVector(btScalar(0.3), btScalar(1.2));
+				m_aabbMin.push_back(center - extent);
+				m_aabbMax.push_back(center + extent);
+				m_expectedProxies.push_back(createProxy(m_expected, i));
+				m_actualProxies.push_back(createProxy(m_actual, i));
+			}
+		}
+
+		~PairOrderScene()
+		{
+			for (int i = 0; i < m_aabbMin.size(); i++)
+			{
+				m_expected.destroyProxy(m_expectedProxies[i], 0);
+				m_actual.destroyProxy(m_actualProxies[i], 0);
+			}
+		}
+
+		btBroadphaseProxy* createProxy(btDbvtBroadphase& broadphase, int index)
+		{
+			return broadphase.createProxy(m_aabbMin[index], m_aabbMax[index], BOX_SHAPE_PROXYTYPE, (void*)(size_t)index,
+				btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter, 0, 0);
+		}
+
+		void setAabbs(btDbvtBroadphase& broadphase, btAlignedObjectArray<btBroadphaseProxy*>& proxies)
+		{
+			m_batchProxies.resize(0);
+			m_batchMin.resize(0);
+			m_batchMax.resize(0);
+			for (int i = 0; i < m_aabbMin.size(); i++)
+			{
+				if (i % 3)
+				{
+					m_batchProxies.push_back(proxies[i]);
+					m_batchMin.push_back(m_aabbMin[i]);
+					m_batchMax.push_back(m_aabbMax[i]);
+				}
+			}
+			broadphase.setAabbs(&m_batchProxies[0], &m_batchMin[0], &m_batchMax[0], m_batchProxies.size(), 0);
+			broadphase.calculateOverlappingPairs(0);
+		}
+
+		void step(int numThreads)
+		{
+			for (int i = 0; i < m_aabbMin.size(); i++)
+			{
+				if (i % 3)
+				{
+					btVector3 delta = m_random.next(20) ? m_random.nextVector(btScalar(-0.5), btScalar(0.5)) : m_random.nextVector(-20, 20);
+					m_aabbMin[i] += delta;
+					m_aabbMax[i] += delta;
+				}
+			}
+			setTestNumThreads(1);
+			setAabbs(m_expected, m_expectedProxies);
+			setTestNumThreads(numThreads);
+			setAabbs(m_actual, m_actualProxies);
+			setTestNumThreads(1);
+		}
+	};
+
+	///the proxies of both broadphases get the same unique ids, so the pairs can be compared entry for entry
+	void expectSamePairArrays(btOverlappingPairCache& expected, btOverlappingPairCache& actual, int step)
+	{
+		ASSERT_EQ(expected.getNumOverlappingPairs(), actual.getNumOverlappingPairs()) << "step " << step;
+		const btBroadphasePairArray& expectedPairs = expected.getOverlappingPairArray();
+		const btBroadphasePairArray& actualPairs = actual.getOverlappingPairArray();
+		for (int i = 0; i < expectedPairs.size(); i++)
+		{
+			ASSERT_EQ(expectedPairs[i].m_pProxy0->m_uniqueId, actualPairs[i].m_pProxy0->m_uniqueId) << "pair " << i << " step " << step;
+			ASSERT_EQ(expectedPairs[i].m_pProxy1->m_uniqueId, actualPairs[i].m_pProxy1->m_uniqueId) << "pair " << i << " step " << step;
+		}
+	}
+
+	void checkPairOrder(bool deferred)
+	{
+		const int threadCounts[] = {2, 4};
+		for (int t = 0; t < 2; t++)
+		{
+			PairOrderScene scene(3000, deferred);
+			int maxPairs = 0;
+			for (int step = 0; step < 12; step++)
+			{
+				scene.step(threadCounts[t]);
+				expectSamePairArrays(*scene.m_expected.getOverlappingPairCache(), *scene.m_actual.getOverlappingPairCache(), step);
+				if (::testing::Test::HasFatalFailure())
+				{
+					return;
+				}
+				maxPairs = btMax(maxPairs, scene.m_actual.getOverlappingPairCache()->getNumOverlappingPairs());
+			}
+			//enough pairs and leaves to be split over several tasks, and the boxes that don't move went to the fixed set
+			EXPECT_GT(maxPairs, 500);
+			EXPECT_GT(scene.m_actual.m_sets[1].m_leaves, 0);
+			EXPECT_GT(scene.m_actual.m_sets[0].m_leaves, 0);
+		}
+	}
+
+}
+
+
+///setAabbs collides the moved proxies in parallel, the pairs are added in the order of a serial loop for any thread count
+TEST(DbvtPairOrderTest, SetAabbsSameOrderForAnyThreadCount)
+{
+	checkPairOrder(false);
+}
+
+///the deferred collide splits the trees into a fixed set of tasks, so the thread count doesn't change the pair order
+TEST(DbvtPairOrderTest, CollideTreesSameOrderForAnyThreadCount)
+{
+	checkPairOrder(true);
+}
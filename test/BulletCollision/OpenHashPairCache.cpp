@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include "btBulletCollisionCommon.h"
+
+namespace
+{
+
+	///small deterministic random number generator, so failures reproduce on every platform
+	struct TestRandom
+	{
+		unsigned int m_state;
+
+		TestRandom(unsigned int seed) : m_state(seed)
+		{
+		}
+
+		int next(int range)
+		{
+			m_state = m_state * 1664525u + 1013904223u;
+			return int((m_state >> 8) % unsigned(range));
+		}
+	};
+
+	void expectSamePairArrays(btOverlappingPairCache& expected, btOverlappingPairCache& actual)
+	{
+		ASSERT_EQ(expected.getNumOverlappingPairs(), actual.getNumOverlappingPairs());
+		const btBroadphasePairArray& expectedPairs = expected.getOverlappingPairArray();
+		const btBroadphasePairArray& actualPairs = actual.getOverlappingPairArray();
+		for (int i = 0; i < expectedPairs.size(); i++)
+		{
+			ASSERT_EQ(expectedPairs[i].m_pProxy0, actualPairs[i].m_pProxy0) << "pair " << i;
+			ASSERT_EQ(expectedPairs[i].m_pProxy1, actualPairs[i].m_pProxy1) << "pair " << i;
+			ASSERT_EQ(expectedPairs[i].m_internalInfo1, actualPairs[i].m_internalInfo1) << "pair " << i;
+			//every pair of the array can be found again
+			ASSERT_EQ(&actualPairs[i], actual.findPair(actualPairs[i].m_pProxy1, actualPairs[i].m_pProxy0)) << "pair " << i;
+		}
+	}
+
+	void tagPair(btBroadphasePair* pair, int tag)
+	{
+		if (pair && !pair->m_internalInfo1)
+		{
+			pair->m_internalInfo1 = (void*)(size_t)tag;
+		}
+	}
+
+}
+
+
+///applies the same random adds, removes, lookups and proxy removals to both caches, the open-addressing cache has to keep
+///the same pairs in the same order as btHashedOverlappingPairCache
+TEST(OpenHashPairCacheTest, MatchesHashedPairCacheUnderChurn)
+{
+	const int numProxies = 300;
+	btAlignedObjectArray<btBroadphaseProxy> proxies;
+	proxies.resize(numProxies);
+	for (int i = 0; i < numProxies; i++)
+	{
+		//a few proxies only collide with each other, so the filter rejects some pairs
+		short int group = (i % 17 == 0) ? btBroadphaseProxy::SensorTrigger : btBroadphaseProxy::DefaultFilter;
+		short int mask = (i % 17 == 0) ? btBroadphaseProxy::SensorTrigger : btBroadphaseProxy::DefaultFilter;
+		proxies[i] = btBroadphaseProxy(btVector3(0, 0, 0), btVector3(1, 1, 1), 0, group, mask);
+		//unique ids are not in address order
+		proxies[i].m_uniqueId = (i * 7919) % numProxies + 1;
+	}
+
+	btHashedOverlappingPairCache expected;
+	btOpenHashOverlappingPairCache actual;
+	TestRandom random(12345);
+	int tag = 1;
+	int numFound = 0;
+	int numRejected = 0;
+	btAlignedObjectArray<btBroadphaseProxy*> batch;
+
+	for (int step = 0; step < 40000; step++)
+	{
+		//pairs between nearby proxies, so the same pairs come up again
+		int index0 = random.next(numProxies);
+		btBroadphaseProxy* proxy0 = &proxies[index0];
+		btBroadphaseProxy* proxy1 = &proxies[(index0 + 1 + random.next(16)) % numProxies];
+		if (random.next(2))
+		{
+			btSwap(proxy0, proxy1);
+		}
+		int op = random.next(100);
+		if (op < 45)
+		{
+			btBroadphasePair* expectedPair = expected.addOverlappingPair(proxy0, proxy1);
+			btBroadphasePair* actualPair = actual.addOverlappingPair(proxy0, proxy1);
+			ASSERT_EQ(expectedPair == 0, actualPair == 0);
+			if (actualPair)
+			{
+				EXPECT_EQ(expectedPair->m_pProxy0, actualPair->m_pProxy0);
+				EXPECT_EQ(expectedPair->m_pProxy1, actualPair->m_pProxy1);
+				tagPair(expectedPair, tag);
+				tagPair(actualPair, tag);
+				tag++;
+			}
+			else
+			{
+				numRejected++;
+			}
+		}
+		else if (op < 75)
+		{
+			void* expectedInfo = expected.removeOverlappingPair(proxy0, proxy1, 0);
+			void* actualInfo = actual.removeOverlappingPair(proxy0, proxy1, 0);
+			ASSERT_EQ(expectedInfo, actualInfo);
+		}
+		else if (op < 95)
+		{
+			btBroadphasePair* expectedPair = expected.findPair(proxy0, proxy1);
+			btBroadphasePair* actualPair = actual.findPair(proxy0, proxy1);
+			ASSERT_EQ(expectedPair == 0, actualPair == 0);
+			if (actualPair)
+			{
+				EXPECT_EQ(expectedPair->m_internalInfo1, actualPair->m_internalInfo1);
+				numFound++;
+			}
+		}
+		else if (op < 97)
+		{
+			expected.removeOverlappingPairsContainingProxy(proxy0, 0);
+			actual.removeOverlappingPairsContainingProxy(proxy0, 0);
+		}
+		else if (op < 99)
+		{
+			//a batch of pairs around proxy0, which grows the table in one go
+			batch.resize(0);
+			for (int i = 0; i < 64; i++)
+			{
+				btBroadphaseProxy* other = &proxies[random.next(numProxies)];
+				if (other != proxy0)
+				{
+					batch.push_back(proxy0);
+					batch.push_back(other);
+				}
+			}
+			expected.addOverlappingPairs(&batch[0], batch.size() / 2);
+			actual.addOverlappingPairs(&batch[0], batch.size() / 2);
+		}
+		else
+		{
+			batch.resize(0);
+			const btBroadphasePairArray& pairs = expected.getOverlappingPairArray();
+			for (int i = 0; i < pairs.size(); i += 3)
+			{
+				batch.push_back(pairs[i].m_pProxy0);
+				batch.push_back(pairs[i].m_pProxy1);
+			}
+			if (batch.size())
+			{
+				expected.removeOverlappingPairs(&batch[0], batch.size() / 2, 0);
+				actual.removeOverlappingPairs(&batch[0], batch.size() / 2, 0);
+			}
+		}
+		if (step % 1000 == 0)
+		{
+			expectSamePairArrays(expected, actual);
+		}
+	}
+	expectSamePairArrays(expected, actual);
+	EXPECT_GT(expected.getNumOverlappingPairs(), 100);
+	EXPECT_GT(numFound, 100);
+	EXPECT_GT(numRejected, 0);
+
+	//empty both caches proxy by proxy
+	for (int i = 0; i < numProxies; i++)
+	{
+		expected.cleanProxyFromPairs(&proxies[i], 0);
+		actual.cleanProxyFromPairs(&proxies[i], 0);
+		expected.removeOverlappingPairsContainingProxy(&proxies[i], 0);
+		actual.removeOverlappingPairsContainingProxy(&proxies[i], 0);
+	}
+	EXPECT_EQ(0, actual.getNumOverlappingPairs());
+	EXPECT_EQ(0, expected.getNumOverlappingPairs());
+	EXPECT_TRUE(actual.findPair(&proxies[1], &proxies[2]) == 0);
+}
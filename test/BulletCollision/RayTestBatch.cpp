@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+
+#include "btBulletCollisionCommon.h"
+#include "TestScheduler.h"
+
+namespace
+{
+
+	///separated boxes, spheres and cylinders above a triangle mesh ground, with one object in a filter group of its own
+	struct RayScene
+	{
+		btDefaultCollisionConfiguration		m_configuration;
+		btCollisionDispatcher				m_dispatcher;
+		btDbvtBroadphase					m_broadphase;
+		btCollisionWorld					m_world;
+		btTriangleMesh						m_mesh;
+		btBvhTriangleMeshShape*				m_groundShape;
+		btBoxShape							m_box;
+		btSphereShape						m_sphere;
+		btCylinderShape						m_cylinder;
+		btAlignedObjectArray<btCollisionObject*>	m_objects;
+
+		RayScene()
+			:m_dispatcher(&m_configuration),
+			m_world(&m_dispatcher, &m_broadphase, &m_configuration),
+			m_box(btVector3(0.4, 0.3, 0.5)),
+			m_sphere(0.45),
+			m_cylinder(btVector3(0.3, 0.5, 0.3))
+		{
+			const int gridSize = 16;
+			for (int i = 0; i < gridSize; i++)
+			{
+				for (int j = 0; j < gridSize; j++)
+				{
+					btVector3 v00(btScalar(i - 8), btSin(btScalar(i + j)) * 0.3f, btScalar(j - 8));
+					btVector3 v10(btScalar(i - 7), btSin(btScalar(i + 1 + j)) * 0.3f, btScalar(j - 8));
+					btVector3 v01(btScalar(i - 8), btSin(btScalar(i + j + 1)) * 0.3f, btScalar(j - 7));
+					btVector3 v11(btScalar(i - 7), btSin(btScalar(i + j + 2)) * 0.3f, btScalar(j - 7));
+					m_mesh.addTriangle(v00, v10, v11);
+					m_mesh.addTriangle(v00, v11, v01);
+				}
+			}
+			m_groundShape = new btBvhTriangleMeshShape(&m_mesh, true);
+			addObject(m_groundShape, btTransform::getIdentity());
+			for (int i = 0; i < 49; i++)
+			{
+				btCollisionShape* shape = (i % 3 == 0) ? (btCollisionShape*)&m_box : (i % 3 == 1) ? (btCollisionShape*)&m_sphere : (btCollisionShape*)&m_cylinder;
+				btVector3 pos(btScalar(i % 7 - 3) * 2, btScalar(2 + (i % 4)), btScalar(i / 7 - 3) * 2);
+				addObject(shape, btTransform(btQuaternion(btVector3(0, 1, 1).normalized(), btScalar(i) * 0.3f), pos));
+			}
+			//an object that default filtered rays must not see
+			btCollisionObject* filtered = new btCollisionObject();
+			filtered->setCollisionShape(&m_box);
+			filtered->setWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(1, 8, 1)));
+			filtered->setUserIndex(m_objects.size());
+			m_objects.push_back(filtered);
+			m_world.addCollisionObject(filtered, btBroadphaseProxy::SensorTrigger, btBroadphaseProxy::AllFilter);
+			m_world.updateAabbs();
+		}
+
+		~RayScene()
+		{
+			for (int i = 0; i < m_objects.size(); i++)
+			{
+				m_world.removeCollisionObject(m_objects[i]);
+				delete m_objects[i];
+			}
+			delete m_groundShape;
+		}
+
+		void addObject(btCollisionShape* shape, const btTransform& tr)
+		{
+			btCollisionObject* obj = new btCollisionObject();
+			obj->setCollisionShape(shape);
+			obj->setWorldTransform(tr);
+			obj->setUserIndex(m_objects.size());
+			m_objects.push_back(obj);
+			m_world.addCollisionObject(obj);
+		}
+	};
+
+	///rays from a few camera positions through a grid of directions, so consecutive rays are coherent,
+	///followed by incoherent rays in all directions
+	void makeRays(btAlignedObjectArray<btVector3>& rayFrom, btAlignedObjectArray<btVector3>& rayTo)
+	{
+		const btVector3 eyes[] = {btVector3(0, 12, -14), btVector3(9, 4, 9), btVector3(-2, 9, 0)};
+		for (int e = 0; e < 3; e++)
+		{
+			for (int y = 0; y < 24; y++)
+			{
+				for (int x = 0; x < 32; x++)
+				{
+					btVector3 target(btScalar(x - 16) * 0.6f, btScalar(y - 12) * 0.4f, btScalar(y % 5));
+					rayFrom.push_back(eyes[e]);
+					rayTo.push_back(eyes[e] + (target - eyes[e]) * 2);
+				}
+			}
+		}
+		for (int i = 0; i < 203; i++)
+		{
+			btScalar a = btScalar(i) * 0.7f;
+			btScalar b = btScalar(i) * 1.9f;
+			btVector3 from(btSin(a) * 6, 3 + btCos(b) * 4, btCos(a) * 6);
+			rayFrom.push_back(from);
+			rayTo.push_back(from + btVector3(btCos(b), btSin(a + b), btSin(b)) * 20);
+		}
+	}
+
+	void checkAgainstRayTest(const RayScene& scene, const btAlignedObjectArray<btVector3>& rayFrom, const btAlignedObjectArray<btVector3>& rayTo,
+		short int group, short int mask, int& numHits)
+	{
+		btAlignedObjectArray<btCollisionWorld::BatchedRayResult> results;
+		results.resize(rayFrom.size());
+		scene.m_world.rayTestBatch(&rayFrom[0], &rayTo[0], rayFrom.size(), &results[0], group, mask);
+		numHits = 0;
+		for (int i = 0; i < rayFrom.size(); i++)
+		{
+			btCollisionWorld::ClosestRayResultCallback expected(rayFrom[i], rayTo[i]);
+			expected.m_collisionFilterGroup = group;
+			expected.m_collisionFilterMask = mask;
+			scene.m_world.rayTest(rayFrom[i], rayTo[i], expected);
+			ASSERT_EQ(expected.hasHit(), results[i].hasHit()) << "ray " << i;
+			if (!expected.hasHit())
+			{
+				continue;
+			}
+			numHits++;
+			EXPECT_EQ(expected.m_collisionObject->getUserIndex(), results[i].m_collisionObject->getUserIndex()) << "ray " << i;
+			EXPECT_NEAR(expected.m_closestHitFraction, results[i].m_hitFraction, 1e-5) << "ray " << i;
+			EXPECT_NEAR(0, (expected.m_hitPointWorld - results[i].m_hitPointWorld).length(), 1e-4) << "ray " << i;
+			EXPECT_NEAR(1, expected.m_hitNormalWorld.dot(results[i].m_hitNormalWorld), 1e-4) << "ray " << i;
+		}
+	}
+
+	///collects the leaves a ray reaches
+	struct CollectLeaves : public btDbvt::ICollide
+	{
+		btAlignedObjectArray<const btDbvtNode*>	m_leaves;
+
+		void Process(const btDbvtNode* leaf)
+		{
+			m_leaves.push_back(leaf);
+		}
+	};
+
+	void rayTestLeaves(const btDbvt& tree, const btVector3& rayFrom, const btVector3& rayTo, btAlignedObjectArray<const btDbvtNode*>* stack, CollectLeaves& leaves)
+	{
+		btVector3 rayDir = (rayTo - rayFrom).normalized();
+		btVector3 rayDirectionInverse(rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0],
+			rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1],
+			rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2]);
+		unsigned int signs[3] = {rayDirectionInverse[0] < 0.0, rayDirectionInverse[1] < 0.0, rayDirectionInverse[2] < 0.0};
+		btScalar lambdaMax = rayDir.dot(rayTo - rayFrom);
+		btVector3 aabbMin(0, 0, 0);
+		btVector3 aabbMax(0, 0, 0);
+		if (stack)
+		{
+			tree.rayTestInternal(tree.m_root, rayFrom, rayTo, rayDirectionInverse, signs, lambdaMax, aabbMin, aabbMax, *stack, leaves);
+		}
+		else
+		{
+			tree.rayTestInternal(tree.m_root, rayFrom, rayTo, rayDirectionInverse, signs, lambdaMax, aabbMin, aabbMax, leaves);
+		}
+	}
+
+}
+
+
+TEST(RayTestBatchTest, SameClosestHitsAsRayTest)
+{
+	RayScene scene;
+	btAlignedObjectArray<btVector3> rayFrom;
+	btAlignedObjectArray<btVector3> rayTo;
+	makeRays(rayFrom, rayTo);
+	const int threadCounts[] = {1, 2, 4};
+	for (int t = 0; t < 3; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		int numHits = 0;
+		checkAgainstRayTest(scene, rayFrom, rayTo, btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter, numHits);
+		EXPECT_GT(numHits, rayFrom.size() / 2);
+		EXPECT_LT(numHits, rayFrom.size());
+	}
+	setTestNumThreads(1);
+}
+
+TEST(RayTestBatchTest, RespectsCollisionFilter)
+{
+	RayScene scene;
+	btAlignedObjectArray<btVector3> rayFrom;
+	btAlignedObjectArray<btVector3> rayTo;
+	//straight down onto the filtered box
+	for (int i = 0; i < 11; i++)
+	{
+		rayFrom.push_back(btVector3(1 + btScalar(i - 5) * 0.05f, 20, 1));
+		rayTo.push_back(btVector3(1 + btScalar(i - 5) * 0.05f, -20, 1));
+	}
+	int numHits = 0;
+	checkAgainstRayTest(scene, rayFrom, rayTo, btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter, numHits);
+	EXPECT_EQ(rayFrom.size(), numHits);
+	checkAgainstRayTest(scene, rayFrom, rayTo, btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::StaticFilter | btBroadphaseProxy::DefaultFilter, numHits);
+	EXPECT_EQ(rayFrom.size(), numHits);
+
+	btAlignedObjectArray<btCollisionWorld::BatchedRayResult> results;
+	results.resize(rayFrom.size());
+	scene.m_world.rayTestBatch(&rayFrom[0], &rayTo[0], rayFrom.size(), &results[0], btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter);
+	for (int i = 0; i < results.size(); i++)
+	{
+		ASSERT_TRUE(results[i].hasHit());
+		EXPECT_EQ(scene.m_objects.size() - 1, results[i].m_collisionObject->getUserIndex());
+	}
+	scene.m_world.rayTestBatch(&rayFrom[0], &rayTo[0], rayFrom.size(), &results[0], btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::DefaultFilter);
+	for (int i = 0; i < results.size(); i++)
+	{
+		ASSERT_TRUE(results[i].hasHit());
+		EXPECT_NE(scene.m_objects.size() - 1, results[i].m_collisionObject->getUserIndex());
+	}
+}
+
+///the rayTestInternal overload that uses the tree's own stack visits the same leaves as the one given a stack
+TEST(RayTestBatchTest, RayTestInternalOverloadsAgree)
+{
+	RayScene scene;
+	btAlignedObjectArray<btVector3> rayFrom;
+	btAlignedObjectArray<btVector3> rayTo;
+	makeRays(rayFrom, rayTo);
+	const btDbvt& tree = scene.m_broadphase.m_sets[0];
+	ASSERT_TRUE(tree.m_root != 0);
+	btAlignedObjectArray<const btDbvtNode*> stack;
+	int numLeaves = 0;
+	for (int i = 0; i < rayFrom.size(); i++)
+	{
+		CollectLeaves expected;
+		CollectLeaves actual;
+		rayTestLeaves(tree, rayFrom[i], rayTo[i], 0, expected);
+		rayTestLeaves(tree, rayFrom[i], rayTo[i], &stack, actual);
+		ASSERT_EQ(expected.m_leaves.size(), actual.m_leaves.size()) << "ray " << i;
+		for (int j = 0; j < expected.m_leaves.size(); j++)
+		{
+			EXPECT_EQ(expected.m_leaves[j], actual.m_leaves[j]) << "ray " << i;
+		}
+		numLeaves += actual.m_leaves.size();
+	}
+	EXPECT_GT(numLeaves, rayFrom.size() / 2);
+}
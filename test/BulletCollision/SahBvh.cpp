@@ -0,0 +1,304 @@
+#include <gtest/gtest.h>
+
+#include "btBulletCollisionCommon.h"
+#include "TestScheduler.h"
+
+namespace
+{
+
+	///a bumpy terrain with a dense cluster of small triangles above it, large enough for the parallel SAH passes
+	struct TestMesh
+	{
+		btAlignedObjectArray<btScalar>	m_vertices;
+		btAlignedObjectArray<int>		m_indices;
+		btTriangleIndexVertexArray*		m_meshInterface;
+
+		TestMesh()
+		{
+			const int gridX = 90;
+			const int gridZ = 60;
+			for (int z = 0; z <= gridZ; z++)
+			{
+				for (int x = 0; x <= gridX; x++)
+				{
+					addVertex(btVector3(btScalar(x), btSin(btScalar(x) * 0.3f) * btCos(btScalar(z) * 0.2f) * 3, btScalar(z)));
+				}
+			}
+			for (int z = 0; z < gridZ; z++)
+			{
+				for (int x = 0; x < gridX; x++)
+				{
+					int v00 = z * (gridX + 1) + x;
+					int v10 = v00 + 1;
+					int v01 = v00 + gridX + 1;
+					int v11 = v01 + 1;
+					addTriangle(v00, v10, v11);
+					addTriangle(v00, v11, v01);
+				}
+			}
+			for (int i = 0; i < 3000; i++)
+			{
+				btScalar a = btScalar(i) * 0.37f;
+				btVector3 center(40 + btSin(a) * 5, 6 + btCos(a * 1.7f) * 2, 30 + btSin(a * 0.61f) * 5);
+				int first = m_vertices.size() / 3;
+				addVertex(center);
+				addVertex(center + btVector3(0.2f, btSin(a) * 0.1f, 0));
+				addVertex(center + btVector3(0, 0.1f, 0.2f));
+				addTriangle(first, first + 1, first + 2);
+			}
+			m_meshInterface = new btTriangleIndexVertexArray(m_indices.size() / 3, &m_indices[0], 3 * sizeof(int),
+				m_vertices.size() / 3, &m_vertices[0], 3 * sizeof(btScalar));
+		}
+
+		~TestMesh()
+		{
+			delete m_meshInterface;
+		}
+
+		void addVertex(const btVector3& v)
+		{
+			m_vertices.push_back(v.x());
+			m_vertices.push_back(v.y());
+			m_vertices.push_back(v.z());
+		}
+
+		void addTriangle(int i0, int i1, int i2)
+		{
+			m_indices.push_back(i0);
+			m_indices.push_back(i1);
+			m_indices.push_back(i2);
+		}
+
+		btVector3 getBvhAabbMin() const
+		{
+			return btVector3(-1, -10, -1);
+		}
+
+		btVector3 getBvhAabbMax() const
+		{
+			return btVector3(91, 10, 61);
+		}
+
+		int getNumTriangles() const
+		{
+			return m_indices.size() / 3;
+		}
+
+		void getTriangleAabb(int triangleIndex, btVector3& aabbMin, btVector3& aabbMax) const
+		{
+			aabbMin.setValue(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+			aabbMax.setValue(-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT);
+			for (int j = 0; j < 3; j++)
+			{
+				int v = m_indices[triangleIndex * 3 + j];
+				btVector3 vertex(m_vertices[v * 3], m_vertices[v * 3 + 1], m_vertices[v * 3 + 2]);
+				aabbMin.setMin(vertex);
+				aabbMax.setMax(vertex);
+			}
+		}
+	};
+
+	struct CollectTrianglesCallback : public btNodeOverlapCallback
+	{
+		btAlignedObjectArray<int> m_triangles;
+
+		virtual void processNode(int subPart, int triangleIndex)
+		{
+			(void)subPart;
+			m_triangles.push_back(triangleIndex);
+		}
+	};
+
+	struct IntLess
+	{
+		bool operator()(int a, int b) const
+		{
+			return a < b;
+		}
+	};
+
+	///the trees are quantized to fixed bounds, so a refitted tree and a rebuilt one quantize the triangles the same way
+	btBvhTriangleMeshShape* buildShape(TestMesh& mesh, bool useSahBuilder, bool useQuantization)
+	{
+		bool saved = gBvhUseSahBuilder;
+		gBvhUseSahBuilder = useSahBuilder;
+		btBvhTriangleMeshShape* shape = new btBvhTriangleMeshShape(mesh.m_meshInterface, useQuantization, mesh.getBvhAabbMin(), mesh.getBvhAabbMax());
+		gBvhUseSahBuilder = saved;
+		return shape;
+	}
+
+	void queryAabb(const btQuantizedBvh* bvh, const btVector3& aabbMin, const btVector3& aabbMax, btAlignedObjectArray<int>& triangles)
+	{
+		CollectTrianglesCallback callback;
+		bvh->reportAabbOverlappingNodex(&callback, aabbMin, aabbMax);
+		callback.m_triangles.quickSort(IntLess());
+		triangles = callback.m_triangles;
+	}
+
+	void queryRay(const btQuantizedBvh* bvh, const btVector3& from, const btVector3& to, btAlignedObjectArray<int>& triangles)
+	{
+		CollectTrianglesCallback callback;
+		bvh->reportRayOverlappingNodex(&callback, from, to);
+		callback.m_triangles.quickSort(IntLess());
+		triangles = callback.m_triangles;
+	}
+
+	void getQueryAabb(int i, btVector3& aabbMin, btVector3& aabbMax)
+	{
+		btScalar a = btScalar(i) * 0.71f;
+		btVector3 center(45 + btSin(a) * 45, btSin(a * 2.3f) * 4 + 2, 30 + btCos(a * 1.3f) * 30);
+		btVector3 halfExtents(btScalar(0.1f + (i % 7) * 0.8f), btScalar(0.2f + (i % 3)), btScalar(0.1f + (i % 5) * 0.6f));
+		aabbMin = center - halfExtents;
+		aabbMax = center + halfExtents;
+	}
+
+	void getQueryRay(int i, btVector3& from, btVector3& to)
+	{
+		btScalar a = btScalar(i) * 1.13f;
+		from.setValue(45 + btSin(a) * 50, 12, 30 + btCos(a) * 35);
+		to.setValue(45 + btCos(a * 0.7f) * 40, -6, 30 + btSin(a * 1.9f) * 25);
+	}
+
+	///the leaves are quantized the same way by both builders, so any valid tree reports exactly the same triangles
+	void expectSameQueryResults(const btQuantizedBvh* expected, const btQuantizedBvh* actual, const TestMesh& mesh)
+	{
+		btAlignedObjectArray<int> expectedTriangles;
+		btAlignedObjectArray<int> actualTriangles;
+		int numReported = 0;
+		for (int i = 0; i < 200; i++)
+		{
+			btVector3 aabbMin, aabbMax;
+			getQueryAabb(i, aabbMin, aabbMax);
+			queryAabb(expected, aabbMin, aabbMax, expectedTriangles);
+			queryAabb(actual, aabbMin, aabbMax, actualTriangles);
+			ASSERT_EQ(expectedTriangles.size(), actualTriangles.size()) << "aabb query " << i;
+			for (int j = 0; j < expectedTriangles.size(); j++)
+			{
+				ASSERT_EQ(expectedTriangles[j], actualTriangles[j]) << "aabb query " << i;
+			}
+			numReported += actualTriangles.size();
+			//the tree is conservative, it may not miss any triangle that overlaps the query
+			int numMissed = 0;
+			for (int t = 0; t < mesh.getNumTriangles(); t++)
+			{
+				btVector3 triangleMin, triangleMax;
+				mesh.getTriangleAabb(t, triangleMin, triangleMax);
+				if (TestAabbAgainstAabb2(triangleMin, triangleMax, aabbMin, aabbMax) && actualTriangles.findBinarySearch(t) == actualTriangles.size())
+				{
+					numMissed++;
+				}
+			}
+			EXPECT_EQ(0, numMissed) << "aabb query " << i;
+		}
+		EXPECT_GT(numReported, 0);
+		for (int i = 0; i < 100; i++)
+		{
+			btVector3 from, to;
+			getQueryRay(i, from, to);
+			queryRay(expected, from, to, expectedTriangles);
+			queryRay(actual, from, to, actualTriangles);
+			ASSERT_EQ(expectedTriangles.size(), actualTriangles.size()) << "ray query " << i;
+			for (int j = 0; j < expectedTriangles.size(); j++)
+			{
+				ASSERT_EQ(expectedTriangles[j], actualTriangles[j]) << "ray query " << i;
+			}
+		}
+	}
+
+}
+
+
+TEST(SahBvhTest, SameQueryResultsAsMeanSplitBuilder)
+{
+	TestMesh mesh;
+	const int threadCounts[] = {1, 4};
+	for (int quantized = 0; quantized < 2; quantized++)
+	{
+		btBvhTriangleMeshShape* reference = buildShape(mesh, false, quantized != 0);
+		for (int t = 0; t < 2; t++)
+		{
+			setTestNumThreads(threadCounts[t]);
+			btBvhTriangleMeshShape* sah = buildShape(mesh, true, quantized != 0);
+			expectSameQueryResults(reference->getOptimizedBvh(), sah->getOptimizedBvh(), mesh);
+			delete sah;
+		}
+		delete reference;
+	}
+	setTestNumThreads(1);
+}
+
+TEST(SahBvhTest, SameTreeForAnyThreadCount)
+{
+	TestMesh mesh;
+	btBvhTriangleMeshShape* reference = buildShape(mesh, true, true);
+	QuantizedNodeArray& expectedNodes = reference->getOptimizedBvh()->getQuantizedNodeArray();
+	BvhSubtreeInfoArray& expectedSubtrees = reference->getOptimizedBvh()->getSubtreeInfoArray();
+	EXPECT_GT(expectedSubtrees.size(), 1);
+	const int threadCounts[] = {2, 4};
+	for (int t = 0; t < 2; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		btBvhTriangleMeshShape* sah = buildShape(mesh, true, true);
+		QuantizedNodeArray& nodes = sah->getOptimizedBvh()->getQuantizedNodeArray();
+		BvhSubtreeInfoArray& subtrees = sah->getOptimizedBvh()->getSubtreeInfoArray();
+		ASSERT_EQ(expectedNodes.size(), nodes.size());
+		int numDifferent = 0;
+		for (int i = 0; i < nodes.size(); i++)
+		{
+			numDifferent += memcmp(&expectedNodes[i], &nodes[i], sizeof(btQuantizedBvhNode)) != 0;
+		}
+		EXPECT_EQ(0, numDifferent) << threadCounts[t] << " threads";
+		ASSERT_EQ(expectedSubtrees.size(), subtrees.size());
+		for (int i = 0; i < subtrees.size(); i++)
+		{
+			EXPECT_EQ(expectedSubtrees[i].m_rootNodeIndex, subtrees[i].m_rootNodeIndex);
+			EXPECT_EQ(expectedSubtrees[i].m_subtreeSize, subtrees[i].m_subtreeSize);
+			EXPECT_EQ(0, memcmp(expectedSubtrees[i].m_quantizedAabbMin, subtrees[i].m_quantizedAabbMin, sizeof(subtrees[i].m_quantizedAabbMin)));
+			EXPECT_EQ(0, memcmp(expectedSubtrees[i].m_quantizedAabbMax, subtrees[i].m_quantizedAabbMax, sizeof(subtrees[i].m_quantizedAabbMax)));
+		}
+		delete sah;
+	}
+	setTestNumThreads(1);
+	delete reference;
+}
+
+TEST(SahBvhTest, SerializeRoundTrip)
+{
+	TestMesh mesh;
+	btBvhTriangleMeshShape* sah = buildShape(mesh, true, true);
+	btOptimizedBvh* bvh = sah->getOptimizedBvh();
+	unsigned int bufferSize = bvh->calculateSerializeBufferSize();
+	void* buffer = btAlignedAlloc(bufferSize, 16);
+	ASSERT_TRUE(bvh->serializeInPlace(buffer, bufferSize, false));
+	btOptimizedBvh* loaded = btOptimizedBvh::deSerializeInPlace(buffer, bufferSize, false);
+	ASSERT_TRUE(loaded != 0);
+	EXPECT_EQ(bvh->isQuantized(), loaded->isQuantized());
+	expectSameQueryResults(bvh, loaded, mesh);
+	loaded->~btOptimizedBvh();
+	btAlignedFree(buffer);
+	delete sah;
+}
+
+TEST(SahBvhTest, RefitMatchesRebuild)
+{
+	TestMesh mesh;
+	btBvhTriangleMeshShape* sah = buildShape(mesh, true, true);
+	//mirror part of the terrain and lower the top of the cluster
+	for (int v = 0; v < mesh.m_vertices.size() / 3; v++)
+	{
+		btScalar& y = mesh.m_vertices[v * 3 + 1];
+		if (mesh.m_vertices[v * 3] < 30)
+		{
+			y = -y;
+		}
+		else if (y > 3.5f)
+		{
+			y -= 1;
+		}
+	}
+	sah->refitTree(mesh.getBvhAabbMin(), mesh.getBvhAabbMax());
+	btBvhTriangleMeshShape* rebuilt = buildShape(mesh, false, true);
+	expectSameQueryResults(rebuilt->getOptimizedBvh(), sah->getOptimizedBvh(), mesh);
+	delete rebuilt;
+	delete sah;
+}
@@ -0,0 +1,251 @@
+#include <gtest/gtest.h>
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletDynamics/ConstraintSolver/btSolverConstraintBatch.h"
+
+namespace
+{
+
+	///spheres with rolling friction that spin and roll on a static ground
+	struct RollingScene
+	{
+		btDefaultCollisionConfiguration		m_configuration;
+		btCollisionDispatcher				m_dispatcher;
+		btDbvtBroadphase					m_broadphase;
+		btSequentialImpulseConstraintSolver	m_solver;
+		btDiscreteDynamicsWorld				m_world;
+		btBoxShape							m_groundShape;
+		btSphereShape						m_sphere;
+		btAlignedObjectArray<btRigidBody*>	m_bodies;
+
+		RollingScene(int solverMode)
+			:m_dispatcher(&m_configuration),
+			m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_configuration),
+			m_groundShape(btVector3(50, 1, 50)),
+			m_sphere(0.5)
+		{
+			m_world.getSolverInfo().m_solverMode = solverMode;
+			m_world.setGravity(btVector3(0, -10, 0));
+			btRigidBody* ground = addBody(&m_groundShape, 0, btVector3(0, -1, 0));
+			ground->setRollingFriction(1);
+			for (int i = 0; i < 32; i++)
+			{
+				btVector3 pos(btScalar(i % 8) * 3, 0.49f, btScalar(i / 8) * 3);
+				btRigidBody* body = addBody(&m_sphere, 1, pos);
+				body->setRollingFriction(btScalar(0.05) + btScalar(i % 3) * 0.05f);
+				body->setLinearVelocity(btVector3(btScalar(i % 5) - 2, 0, btScalar(i % 3)));
+				body->setAngularVelocity(btVector3(btScalar(i % 4), btScalar(i % 7) - 3, 0));
+				body->setActivationState(DISABLE_DEACTIVATION);
+			}
+		}
+
+		~RollingScene()
+		{
+			for (int i = 0; i < m_bodies.size(); i++)
+			{
+				m_world.removeRigidBody(m_bodies[i]);
+				delete m_bodies[i];
+			}
+		}
+
+		btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& pos)
+		{
+			btVector3 inertia(0, 0, 0);
+			if (mass != 0)
+			{
+				shape->calculateLocalInertia(mass, inertia);
+			}
+			btRigidBody::btRigidBodyConstructionInfo info(mass, 0, shape, inertia);
+			info.m_startWorldTransform.setOrigin(pos);
+			btRigidBody* body = new btRigidBody(info);
+			m_world.addRigidBody(body);
+			m_bodies.push_back(body);
+			return body;
+		}
+
+		btScalar angularSpeed() const
+		{
+			btScalar speed = 0;
+			for (int i = 1; i < m_bodies.size(); i++)
+			{
+				speed += m_bodies[i]->getAngularVelocity().length();
+			}
+			return speed;
+		}
+	};
+
+	void checkBatchedMatchesUnbatched(int solverMode)
+	{
+		RollingScene expected(solverMode);
+		RollingScene actual(solverMode | SOLVER_BATCHED_CONTACT_ROWS);
+		btScalar initialSpeed = expected.angularSpeed();
+		for (int step = 0; step < 60; step++)
+		{
+			expected.m_world.stepSimulation(btScalar(1.) / btScalar(60.), 0);
+			actual.m_world.stepSimulation(btScalar(1.) / btScalar(60.), 0);
+			for (int i = 1; i < expected.m_bodies.size(); i++)
+			{
+				const btRigidBody* a = expected.m_bodies[i];
+				const btRigidBody* b = actual.m_bodies[i];
+				ASSERT_NEAR(0, (a->getWorldTransform().getOrigin() - b->getWorldTransform().getOrigin()).length(), 1e-4) << "body " << i << " step " << step;
+				ASSERT_NEAR(0, (a->getLinearVelocity() - b->getLinearVelocity()).length(), 1e-4) << "body " << i << " step " << step;
+				ASSERT_NEAR(0, (a->getAngularVelocity() - b->getAngularVelocity()).length(), 1e-4) << "body " << i << " step " << step;
+				//start the next step from the same state, rounding differences of the batches would build up over the steps
+				actual.m_bodies[i]->setWorldTransform(a->getWorldTransform());
+				actual.m_bodies[i]->setLinearVelocity(a->getLinearVelocity());
+				actual.m_bodies[i]->setAngularVelocity(a->getAngularVelocity());
+			}
+		}
+		//rolling friction slowed the spheres down
+		EXPECT_LT(actual.angularSpeed(), initialSpeed * 0.5f);
+	}
+
+	///chains of boxes joined by point to point constraints that slide over the ground, so every iteration solves the
+	///joint rows on the solver bodies and the batched contact rows on the packed velocities
+	struct ChainScene
+	{
+		btDefaultCollisionConfiguration		m_configuration;
+		btCollisionDispatcher				m_dispatcher;
+		btDbvtBroadphase					m_broadphase;
+		btSequentialImpulseConstraintSolver	m_solver;
+		btDiscreteDynamicsWorld				m_world;
+		btBoxShape							m_groundShape;
+		btBoxShape							m_box;
+		btAlignedObjectArray<btRigidBody*>	m_bodies;
+		btAlignedObjectArray<btTypedConstraint*>	m_constraints;
+
+		ChainScene(int solverMode)
+			:m_dispatcher(&m_configuration),
+			m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_configuration),
+			m_groundShape(btVector3(50, 1, 50)),
+			m_box(btVector3(0.4, 0.25, 0.25))
+		{
+			m_world.getSolverInfo().m_solverMode = solverMode;
+			m_world.setGravity(btVector3(0, -10, 0));
+			btRigidBody::btRigidBodyConstructionInfo groundInfo(0, 0, &m_groundShape);
+			groundInfo.m_startWorldTransform.setOrigin(btVector3(0, -1, 0));
+			m_bodies.push_back(new btRigidBody(groundInfo));
+			m_world.addRigidBody(m_bodies[0]);
+			btVector3 inertia;
+			m_box.calculateLocalInertia(1, inertia);
+			for (int chain = 0; chain < 4; chain++)
+			{
+				btRigidBody* previous = 0;
+				for (int i = 0; i < 8; i++)
+				{
+					btRigidBody::btRigidBodyConstructionInfo info(1, 0, &m_box, inertia);
+					info.m_startWorldTransform.setOrigin(btVector3(btScalar(i) - 4, 0.249f, btScalar(chain) * 2));
+					btRigidBody* body = new btRigidBody(info);
+					body->setLinearVelocity(btVector3(btScalar(chain % 2) * 2 - 1, 0, btScalar(i % 3) - 1));
+					body->setActivationState(DISABLE_DEACTIVATION);
+					m_world.addRigidBody(body);
+					m_bodies.push_back(body);
+					if (previous)
+					{
+						btTypedConstraint* joint = new btPoint2PointConstraint(*previous, *body, btVector3(0.5, 0, 0), btVector3(-0.5, 0, 0));
+						m_world.addConstraint(joint, true);
+						m_constraints.push_back(joint);
+					}
+					previous = body;
+				}
+			}
+		}
+
+		~ChainScene()
+		{
+			for (int i = 0; i < m_constraints.size(); i++)
+			{
+				m_world.removeConstraint(m_constraints[i]);
+				delete m_constraints[i];
+			}
+			for (int i = 0; i < m_bodies.size(); i++)
+			{
+				m_world.removeRigidBody(m_bodies[i]);
+				delete m_bodies[i];
+			}
+		}
+	};
+
+}
+
+
+///rolling friction uses the impulses of the current iteration, which the batched mode keeps in the batches
+TEST(BatchedContactRowsTest, RollingFrictionMatchesUnbatchedSolve)
+{
+	checkBatchedMatchesUnbatched(SOLVER_USE_WARMSTARTING | SOLVER_SIMD);
+	checkBatchedMatchesUnbatched(SOLVER_USE_WARMSTARTING);
+	checkBatchedMatchesUnbatched(SOLVER_SIMD);
+}
+
+///the packed velocities are copied back before the joint rows of the same iteration run
+TEST(BatchedContactRowsTest, JointsMatchUnbatchedSolve)
+{
+	const int solverModes[] = {SOLVER_USE_WARMSTARTING | SOLVER_SIMD, SOLVER_USE_WARMSTARTING};
+	for (int m = 0; m < 2; m++)
+	{
+		ChainScene expected(solverModes[m]);
+		ChainScene actual(solverModes[m] | SOLVER_BATCHED_CONTACT_ROWS);
+		for (int step = 0; step < 60; step++)
+		{
+			expected.m_world.stepSimulation(btScalar(1.) / btScalar(60.), 0);
+			actual.m_world.stepSimulation(btScalar(1.) / btScalar(60.), 0);
+			for (int i = 1; i < expected.m_bodies.size(); i++)
+			{
+				const btRigidBody* a = expected.m_bodies[i];
+				const btRigidBody* b = actual.m_bodies[i];
+				ASSERT_NEAR(0, (a->getWorldTransform().getOrigin() - b->getWorldTransform().getOrigin()).length(), 1e-4) << "body " << i << " step " << step;
+				ASSERT_NEAR(0, (a->getLinearVelocity() - b->getLinearVelocity()).length(), 1e-4) << "body " << i << " step " << step;
+				ASSERT_NEAR(0, (a->getAngularVelocity() - b->getAngularVelocity()).length(), 1e-4) << "body " << i << " step " << step;
+				actual.m_bodies[i]->setWorldTransform(a->getWorldTransform());
+				actual.m_bodies[i]->setLinearVelocity(a->getLinearVelocity());
+				actual.m_bodies[i]->setAngularVelocity(a->getAngularVelocity());
+			}
+		}
+		//the chains are still connected
+		for (int i = 2; i < actual.m_bodies.size(); i++)
+		{
+			if ((i - 1) % 8)
+			{
+				btScalar distance = (actual.m_bodies[i]->getWorldTransform().getOrigin() - actual.m_bodies[i - 1]->getWorldTransform().getOrigin()).length();
+				EXPECT_NEAR(1, distance, 0.05) << "body " << i;
+			}
+		}
+	}
+}
+
+///load and store only move the delta velocities between the solver bodies and the packed arrays
+TEST(BatchedContactRowsTest, VelocityPoolRoundTrip)
+{
+	btAlignedObjectArray<btSolverBody> bodies;
+	bodies.resize(37);
+	for (int i = 0; i < bodies.size(); i++)
+	{
+		btScalar s = btScalar(i);
+		bodies[i].m_deltaLinearVelocity.setValue(s, s + 0.5f, -s);
+		bodies[i].m_deltaAngularVelocity.setValue(-s, 2 * s, s + 0.25f);
+		bodies[i].m_linearVelocity.setValue(7, s, 7);
+		bodies[i].m_angularVelocity.setValue(s, 9, 9);
+	}
+	btSolverBodyVelocityPool pool;
+	pool.load(bodies);
+	ASSERT_EQ(bodies.size(), pool.size());
+	for (int i = 0; i < pool.size(); i++)
+	{
+		EXPECT_TRUE(pool.getDeltaLinearVelocities()[i] == bodies[i].m_deltaLinearVelocity);
+		EXPECT_TRUE(pool.getDeltaAngularVelocities()[i] == bodies[i].m_deltaAngularVelocity);
+		pool.getDeltaLinearVelocities()[i] *= 3;
+		pool.getDeltaAngularVelocities()[i] += btVector3(1, 1, 1);
+	}
+	pool.store(bodies);
+	for (int i = 0; i < bodies.size(); i++)
+	{
+		btScalar s = btScalar(i);
+		EXPECT_TRUE(bodies[i].m_deltaLinearVelocity == btVector3(s, s + 0.5f, -s) * 3) << "body " << i;
+		EXPECT_TRUE(bodies[i].m_deltaAngularVelocity == btVector3(1 - s, 2 * s + 1, s + 1.25f)) << "body " << i;
+		EXPECT_TRUE(bodies[i].m_linearVelocity == btVector3(7, s, 7)) << "body " << i;
+		EXPECT_TRUE(bodies[i].m_angularVelocity == btVector3(s, 9, 9)) << "body " << i;
+	}
+	pool.clear();
+	EXPECT_EQ(0, pool.size());
+	EXPECT_TRUE(pool.getDeltaLinearVelocities() == 0);
+}
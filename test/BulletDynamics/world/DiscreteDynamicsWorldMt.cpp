@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "TestScheduler.h"
+#include <string.h>
+
+namespace
+{
+
+	///fast CCD spheres shot at slowly moving dynamic boxes above a static ground. Half of the spheres are added before
+	///the box they hit, so the result of their sweep depends on whether the box moved already.
+	struct CcdScene
+	{
+		btDefaultCollisionConfiguration		m_configuration;
+		btCollisionDispatcher				m_dispatcher;
+		btDbvtBroadphase					m_broadphase;
+		btSequentialImpulseConstraintSolver	m_solver;
+		btConstraintSolverPoolMt			m_solverPool;
+		btDiscreteDynamicsWorld*			m_world;
+		btBoxShape							m_groundShape;
+		btBoxShape							m_box;
+		btSphereShape						m_sphere;
+		btAlignedObjectArray<btRigidBody*>	m_bodies;
+
+		CcdScene(bool mt)
+			:m_dispatcher(&m_configuration),
+			m_solverPool(4),
+			m_groundShape(btVector3(50, 1, 50)),
+			m_box(btVector3(0.5, 0.5, 0.05)),
+			m_sphere(0.1)
+		{
+			if (mt)
+			{
+				m_world = new btDiscreteDynamicsWorldMt(&m_dispatcher, &m_broadphase, &m_solverPool, &m_configuration);
+			}
+			else
+			{
+				m_world = new btDiscreteDynamicsWorld(&m_dispatcher, &m_broadphase, &m_solver, &m_configuration);
+			}
+			m_world->setGravity(btVector3(0, -10, 0));
+			addBody(&m_groundShape, 0, btVector3(0, -1, 0), btVector3(0, 0, 0));
+			for (int i = 0; i < 24; i++)
+			{
+				btVector3 pos(btScalar(i % 6 - 3) * 3, 2, btScalar(i / 6 - 2) * 3);
+				//the thin box slides along the path of the sphere, the sphere reaches it in the first steps
+				btVector3 boxVelocity(0, 0, btScalar(-2 - i % 3));
+				btVector3 sphereVelocity(btScalar(i % 5 - 2) * 0.3f, 0, 120);
+				btVector3 spherePos = pos - btVector3(0, 0, 1.5f + btScalar(i % 4) * 0.2f);
+				if (i & 1)
+				{
+					addSphere(spherePos, sphereVelocity);
+					addBody(&m_box, 1, pos, boxVelocity);
+				}
+				else
+				{
+					addBody(&m_box, 1, pos, boxVelocity);
+					addSphere(spherePos, sphereVelocity);
+				}
+			}
+		}
+
+		~CcdScene()
+		{
+			for (int i = 0; i < m_bodies.size(); i++)
+			{
+				m_world->removeRigidBody(m_bodies[i]);
+				delete m_bodies[i]->getMotionState();
+				delete m_bodies[i];
+			}
+			delete m_world;
+		}
+
+		btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& pos, const btVector3& velocity)
+		{
+			btVector3 inertia(0, 0, 0);
+			if (mass != 0)
+			{
+				shape->calculateLocalInertia(mass, inertia);
+			}
+			btDefaultMotionState* motionState = new btDefaultMotionState(btTransform(btQuaternion::getIdentity(), pos));
+			btRigidBody* body = new btRigidBody(mass, motionState, shape, inertia);
+			body->setLinearVelocity(velocity);
+			m_world->addRigidBody(body);
+			m_bodies.push_back(body);
+			return body;
+		}
+
+		void addSphere(const btVector3& pos, const btVector3& velocity)
+		{
+			btRigidBody* body = addBody(&m_sphere, btScalar(0.1), pos, velocity);
+			body->setCcdMotionThreshold(btScalar(0.05));
+			body->setCcdSweptSphereRadius(btScalar(0.08));
+		}
+	};
+
+	void expectSameTransforms(const CcdScene& expected, const CcdScene& actual, int step)
+	{
+		for (int i = 0; i < expected.m_bodies.size(); i++)
+		{
+			const btTransform& a = expected.m_bodies[i]->getWorldTransform();
+			const btTransform& b = actual.m_bodies[i]->getWorldTransform();
+			EXPECT_TRUE(a.getOrigin() == b.getOrigin() && a.getBasis() == b.getBasis()) << "body " << i << " step " << step;
+		}
+	}
+
+}
+
+
+///the Mt world keeps the semantics of the serial integrateTransforms, also when CCD sweeps hit dynamic bodies
+TEST(DiscreteDynamicsWorldMtTest, CcdAgainstDynamicBodiesMatchesSerialWorld)
+{
+	const int threadCounts[] = {1, 2, 4};
+	for (int t = 0; t < 3; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		CcdScene expected(false);
+		CcdScene actual(true);
+		expected.m_world->setStepStatsEnabled(true);
+		actual.m_world->setStepStatsEnabled(true);
+		int numClamped = 0;
+		for (int step = 0; step < 30; step++)
+		{
+			expected.m_world->stepSimulation(btScalar(1.) / btScalar(60.), 0);
+			actual.m_world->stepSimulation(btScalar(1.) / btScalar(60.), 0);
+			expectSameTransforms(expected, actual, step);
+			const btSimulationStepStats& expectedStats = expected.m_world->getStepStats();
+			const btSimulationStepStats& actualStats = actual.m_world->getStepStats();
+			EXPECT_EQ(expectedStats.m_numCcdSweeps, actualStats.m_numCcdSweeps) << "step " << step;
+			EXPECT_EQ(expectedStats.m_numCcdClampedMotions, actualStats.m_numCcdClampedMotions) << "step " << step;
+			numClamped += actualStats.m_numCcdClampedMotions;
+		}
+		//the spheres were stopped by the boxes
+		EXPECT_GE(numClamped, 12) << threadCounts[t] << " threads";
+	}
+	setTestNumThreads(1);
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+
+#include "BulletCollision/CollisionDispatch/btSimulationIslandManager.h"
+#include "SleepScene.h"
+#include "TestScheduler.h"
+
+namespace
+{
+
+	///island ids differ between the modes, the islands are compared through a one to one mapping of the ids
+	void expectSameIslands(SleepScene& expected, SleepScene& actual, int step)
+	{
+		ASSERT_EQ(expected.m_bodies.size(), actual.m_bodies.size());
+		btAlignedObjectArray<int> expectedToActual;
+		btAlignedObjectArray<int> actualToExpected;
+		int numBodies = expected.m_world->getNumCollisionObjects();
+		expectedToActual.resize(numBodies, -1);
+		actualToExpected.resize(numBodies, -1);
+		for (int i = 0; i < expected.m_bodies.size(); i++)
+		{
+			const btRigidBody* a = expected.m_bodies[i];
+			const btRigidBody* b = actual.m_bodies[i];
+			ASSERT_EQ(a->getActivationState() == ISLAND_SLEEPING, b->getActivationState() == ISLAND_SLEEPING) << "body " << i << " step " << step;
+			int expectedTag = a->getIslandTag();
+			int actualTag = b->getIslandTag();
+			ASSERT_EQ(expectedTag < 0, actualTag < 0) << "body " << i << " step " << step;
+			if (expectedTag < 0)
+			{
+				continue;
+			}
+			ASSERT_LT(expectedTag, numBodies);
+			ASSERT_LT(actualTag, numBodies);
+			if (expectedToActual[expectedTag] < 0 && actualToExpected[actualTag] < 0)
+			{
+				expectedToActual[expectedTag] = actualTag;
+				actualToExpected[actualTag] = expectedTag;
+			}
+			ASSERT_EQ(expectedToActual[expectedTag], actualTag) << "body " << i << " step " << step;
+			ASSERT_EQ(actualToExpected[actualTag], expectedTag) << "body " << i << " step " << step;
+		}
+	}
+
+	///the bodies of an island are solved in a different order, which changes the velocities, and with them whether a body
+	///wants to sleep. The state of the default world is copied over after every step, so both worlds build their islands
+	///from the same contacts and put them to sleep from the same body states.
+	void copyMotion(SleepScene& from, SleepScene& to)
+	{
+		for (int i = 0; i < from.m_bodies.size(); i++)
+		{
+			btRigidBody* a = from.m_bodies[i];
+			btRigidBody* b = to.m_bodies[i];
+			b->setWorldTransform(a->getWorldTransform());
+			b->setInterpolationWorldTransform(a->getInterpolationWorldTransform());
+			b->setLinearVelocity(a->getLinearVelocity());
+			b->setAngularVelocity(a->getAngularVelocity());
+			b->setDeactivationTime(a->getDeactivationTime());
+			b->forceActivationState(a->getActivationState());
+		}
+	}
+
+	int countIslands(SleepScene& scene)
+	{
+		btAlignedObjectArray<int> tags;
+		for (int i = 0; i < scene.m_bodies.size(); i++)
+		{
+			int tag = scene.m_bodies[i]->getIslandTag();
+			if (tag >= 0 && tags.findLinearSearch(tag) == tags.size())
+			{
+				tags.push_back(tag);
+			}
+		}
+		return tags.size();
+	}
+
+	void checkIncrementalMatchesDefault(bool mt)
+	{
+		SleepScene expected(mt);
+		SleepScene actual(mt);
+		actual.m_world->getSimulationIslandManager()->setIncrementalIslands(true);
+		int maxSleeping = 0;
+		int numWakeUps = 0;
+		int minIslands = expected.m_bodies.size();
+		for (int step = 0; step < 600; step++)
+		{
+			int numSleeping = actual.countSleepingBodies();
+			expected.step(step);
+			actual.step(step);
+			expectSameIslands(expected, actual, step);
+			if (::testing::Test::HasFatalFailure())
+			{
+				return;
+			}
+			copyMotion(expected, actual);
+			numWakeUps += actual.countSleepingBodies() < numSleeping ? 1 : 0;
+			maxSleeping = btMax(maxSleeping, actual.countSleepingBodies());
+			minIslands = btMin(minIslands, countIslands(actual));
+		}
+		//most bodies fell asleep, some of them woke up again, and the stacks were islands of several bodies
+		EXPECT_GT(maxSleeping, actual.m_bodies.size() / 2);
+		EXPECT_GT(numWakeUps, 3);
+		EXPECT_LT(minIslands, actual.m_bodies.size() - 1);
+	}
+
+}
+
+
+///incremental islands put the same bodies together and let the same bodies sleep as the default islands
+TEST(IncrementalIslandsTest, MatchesDefaultIslands)
+{
+	checkIncrementalMatchesDefault(false);
+}
+
+TEST(IncrementalIslandsTest, MatchesDefaultIslandsMt)
+{
+	const int threadCounts[] = {1, 4};
+	for (int t = 0; t < 2; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		checkIncrementalMatchesDefault(true);
+	}
+	setTestNumThreads(1);
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletDynamics/Featherstone/btMultiBody.h"
+#include "BulletDynamics/Featherstone/btMultiBodyLinkCollider.h"
+#include "BulletDynamics/Featherstone/btMultiBodyDynamicsWorld.h"
+#include "BulletDynamics/Featherstone/btMultiBodyConstraintSolver.h"
+#include "TestScheduler.h"
+
+namespace
+{
+
+	///swinging and falling arms on a static ground, some of them integrated with RK4. The upright arms start at rest
+	///and fall asleep, one of them is woken again by a push.
+	struct ArmScene
+	{
+		btDefaultCollisionConfiguration	m_configuration;
+		btCollisionDispatcher			m_dispatcher;
+		btDbvtBroadphase				m_broadphase;
+		btMultiBodyConstraintSolver		m_solver;
+		btMultiBodyDynamicsWorld		m_world;
+		btBoxShape						m_groundShape;
+		btBoxShape						m_linkShape;
+		btRigidBody*					m_ground;
+		btAlignedObjectArray<btMultiBody*>	m_bodies;
+
+		enum
+		{
+			NUM_ARMS = 12,
+			NUM_LINKS = 4
+		};
+
+		ArmScene()
+			:m_dispatcher(&m_configuration),
+			m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_configuration),
+			m_groundShape(btVector3(20, 1, 20)),
+			m_linkShape(btVector3(0.05, 0.2, 0.05))
+		{
+			m_world.setGravity(btVector3(0, -10, 0));
+			m_world.setMultiBodyGrainSize(1);
+			btRigidBody::btRigidBodyConstructionInfo info(0, 0, &m_groundShape);
+			info.m_startWorldTransform.setOrigin(btVector3(0, -1, 0));
+			m_ground = new btRigidBody(info);
+			m_world.addRigidBody(m_ground);
+			for (int i = 0; i < NUM_ARMS; i++)
+			{
+				//every third arm stands upright at rest, the others swing or fall from a bent pose
+				bool upright = (i % 3 == 2);
+				bool fixedBase = upright || (i % 2 == 0);
+				btVector3 basePos(btScalar(i % 4) * 2 - 3, fixedBase ? btScalar(0.6) : btScalar(1.5), btScalar(i / 4) * 2 - 2);
+				btMultiBody* body = addArm(basePos, fixedBase, upright ? 0 : btScalar(0.3) + btScalar(i) * btScalar(0.1));
+				body->useRK4Integration(i % 4 == 1 || i % 4 == 2);
+			}
+		}
+
+		~ArmScene()
+		{
+			for (int i = 0; i < m_bodies.size(); i++)
+			{
+				btMultiBody* body = m_bodies[i];
+				m_world.removeMultiBody(body);
+				for (int j = -1; j < body->getNumLinks(); j++)
+				{
+					btMultiBodyLinkCollider* collider = getCollider(body, j);
+					m_world.removeCollisionObject(collider);
+					delete collider;
+				}
+				delete body;
+			}
+			m_world.removeRigidBody(m_ground);
+			delete m_ground;
+		}
+
+		static btMultiBodyLinkCollider* getCollider(btMultiBody* body, int link)
+		{
+			return link < 0 ? body->getBaseCollider() : body->getLink(link).m_collider;
+		}
+
+		btMultiBody* addArm(const btVector3& basePos, bool fixedBase, btScalar bend)
+		{
+			btVector3 inertia;
+			m_linkShape.calculateLocalInertia(1, inertia);
+			btMultiBody* body = new btMultiBody(NUM_LINKS, 1, inertia, fixedBase, true);
+			body->setBasePos(basePos);
+			for (int i = 0; i < NUM_LINKS; i++)
+			{
+				if (i % 2 == 0)
+				{
+					body->setupRevolute(i, 1, inertia, i - 1, btQuaternion::getIdentity(), btVector3(1, 0, 0), btVector3(0, 0.2, 0), btVector3(0, 0.2, 0), true);
+				}
+				else
+				{
+					body->setupSpherical(i, 1, inertia, i - 1, btQuaternion::getIdentity(), btVector3(0, 0.2, 0), btVector3(0, 0.2, 0), true);
+				}
+			}
+			body->finalizeMultiDof();
+			for (int i = 0; i < NUM_LINKS; i += 2)
+			{
+				body->setJointPos(i, bend * btScalar(i + 1));
+			}
+			m_world.addMultiBody(body);
+			m_bodies.push_back(body);
+
+			btAlignedObjectArray<btQuaternion> worldToLocal;
+			btAlignedObjectArray<btVector3> localOrigin;
+			body->forwardKinematics(worldToLocal, localOrigin);
+			for (int i = -1; i < NUM_LINKS; i++)
+			{
+				btMultiBodyLinkCollider* collider = new btMultiBodyLinkCollider(body, i);
+				collider->setCollisionShape(&m_linkShape);
+				m_world.addCollisionObject(collider, btBroadphaseProxy::DefaultFilter, btBroadphaseProxy::AllFilter);
+				if (i < 0)
+				{
+					body->setBaseCollider(collider);
+				}
+				else
+				{
+					body->getLink(i).m_collider = collider;
+				}
+			}
+			body->updateCollisionObjectWorldTransforms(worldToLocal, localOrigin);
+			return body;
+		}
+
+		bool isSleeping(int index)
+		{
+			return m_bodies[index]->getBaseCollider()->getActivationState() == ISLAND_SLEEPING;
+		}
+
+		void step(int step)
+		{
+			if (step == 320)
+			{
+				//a push wakes the first upright arm
+				btMultiBody* body = m_bodies[2];
+				for (int j = -1; j < body->getNumLinks(); j++)
+				{
+					getCollider(body, j)->activate(true);
+				}
+				body->wakeUp();
+				body->addJointTorque(0, 2);
+			}
+			m_world.stepSimulation(btScalar(1.) / btScalar(60.), 0);
+		}
+	};
+
+	void expectSameState(ArmScene& expected, ArmScene& actual, int step)
+	{
+		for (int i = 0; i < expected.m_bodies.size(); i++)
+		{
+			btMultiBody* a = expected.m_bodies[i];
+			btMultiBody* b = actual.m_bodies[i];
+			ASSERT_TRUE(a->getBasePos() == b->getBasePos()) << "body " << i << " step " << step;
+			ASSERT_TRUE(a->getWorldToBaseRot() == b->getWorldToBaseRot()) << "body " << i << " step " << step;
+			for (int j = 0; j < 6 + a->getNumDofs(); j++)
+			{
+				ASSERT_EQ(a->getVelocityVector()[j], b->getVelocityVector()[j]) << "body " << i << " dof " << j << " step " << step;
+			}
+			for (int j = -1; j < a->getNumLinks(); j++)
+			{
+				const btCollisionObject* ca = ArmScene::getCollider(a, j);
+				const btCollisionObject* cb = ArmScene::getCollider(b, j);
+				if (j >= 0)
+				{
+					for (int k = 0; k < a->getLink(j).m_posVarCount; k++)
+					{
+						ASSERT_EQ(a->getJointPosMultiDof(j)[k], b->getJointPosMultiDof(j)[k]) << "body " << i << " link " << j << " step " << step;
+					}
+				}
+				ASSERT_TRUE(ca->getWorldTransform().getOrigin() == cb->getWorldTransform().getOrigin() &&
+					ca->getWorldTransform().getBasis() == cb->getWorldTransform().getBasis()) << "body " << i << " link " << j << " step " << step;
+				ASSERT_EQ(ca->getActivationState(), cb->getActivationState()) << "body " << i << " link " << j << " step " << step;
+			}
+		}
+	}
+
+}
+
+
+///the per-multibody passes give the same results with the sequential scheduler and with worker threads
+TEST(MultiBodyPassesTest, SameStateForAnyThreadCount)
+{
+	ArmScene expected;
+	ArmScene actual;
+	int numSleepingBefore = 0;
+	int numSleepingAfter = 0;
+	int numMovingRk4Steps = 0;
+	for (int step = 0; step < 400; step++)
+	{
+		setTestNumThreads(0);
+		expected.step(step);
+		setTestNumThreads(4);
+		actual.step(step);
+		expectSameState(expected, actual, step);
+		if (::testing::Test::HasFatalFailure())
+		{
+			break;
+		}
+		for (int i = 0; i < actual.m_bodies.size(); i++)
+		{
+			if (actual.m_bodies[i]->isUsingRK4Integration() && !actual.isSleeping(i) && actual.m_bodies[i]->getBaseVel() != btVector3(0, 0, 0))
+			{
+				numMovingRk4Steps++;
+				break;
+			}
+		}
+		if (step == 319)
+		{
+			for (int i = 0; i < actual.m_bodies.size(); i++)
+			{
+				numSleepingBefore += actual.isSleeping(i) ? 1 : 0;
+			}
+			EXPECT_TRUE(actual.isSleeping(2));
+		}
+	}
+	setTestNumThreads(1);
+	for (int i = 0; i < actual.m_bodies.size(); i++)
+	{
+		numSleepingAfter += actual.isSleeping(i) ? 1 : 0;
+	}
+	//the upright arms slept, the pushed one woke up and swings, and the RK4 arms moved for a while
+	EXPECT_GE(numSleepingBefore, ArmScene::NUM_ARMS / 3);
+	EXPECT_FALSE(actual.isSleeping(2));
+	EXPECT_LT(numSleepingAfter, numSleepingBefore);
+	EXPECT_GT(numMovingRk4Steps, 60);
+}
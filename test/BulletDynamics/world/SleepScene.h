@@ -0,0 +1,127 @@
+#ifndef SLEEP_SCENE_H
+#define SLEEP_SCENE_H
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+
+///stacks of boxes that settle and fall asleep on a static ground. applyChurn adds boxes that wake the stacks they land on,
+///removes bodies and wakes sleeping bodies by hand, so the sleeping objects and islands change during the run.
+struct SleepScene
+{
+	btDefaultCollisionConfiguration		m_configuration;
+	btCollisionDispatcher*				m_dispatcher;
+	btDbvtBroadphase					m_broadphase;
+	btSequentialImpulseConstraintSolver	m_solver;
+	btConstraintSolverPoolMt			m_solverPool;
+	btDiscreteDynamicsWorld*			m_world;
+	btBoxShape							m_groundShape;
+	btBoxShape							m_box;
+	btAlignedObjectArray<btRigidBody*>	m_bodies;
+
+	SleepScene(bool mt)
+		:m_solverPool(4),
+		m_groundShape(btVector3(30, 1, 30)),
+		m_box(btVector3(0.5, 0.5, 0.5))
+	{
+		if (mt)
+		{
+			m_dispatcher = new btCollisionDispatcherMt(&m_configuration, 8);
+			m_world = new btDiscreteDynamicsWorldMt(m_dispatcher, &m_broadphase, &m_solverPool, &m_configuration);
+		}
+		else
+		{
+			m_dispatcher = new btCollisionDispatcher(&m_configuration);
+			m_world = new btDiscreteDynamicsWorld(m_dispatcher, &m_broadphase, &m_solver, &m_configuration);
+		}
+		m_world->setGravity(btVector3(0, -10, 0));
+		addBody(&m_groundShape, 0, btVector3(0, -1, 0));
+		for (int i = 0; i < 48; i++)
+		{
+			//6 separate stacks of 4 boxes, and 24 boxes lying apart
+			btVector3 pos = i < 24 ? getStackPosition(i % 6, i / 6) : btVector3(btScalar(i % 6) * 3 - 8, 0.5, btScalar(i / 6) * 2 - 2);
+			addBody(&m_box, 1, pos);
+		}
+	}
+
+	~SleepScene()
+	{
+		for (int i = 0; i < m_bodies.size(); i++)
+		{
+			m_world->removeRigidBody(m_bodies[i]);
+			delete m_bodies[i];
+		}
+		delete m_world;
+		delete m_dispatcher;
+	}
+
+	static btVector3 getStackPosition(int stack, int level)
+	{
+		return btVector3(btScalar(stack) * 3 - 8, btScalar(0.5) + btScalar(level) * 1.05f, -10);
+	}
+
+	btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& pos)
+	{
+		btVector3 inertia(0, 0, 0);
+		if (mass != 0)
+		{
+			shape->calculateLocalInertia(mass, inertia);
+		}
+		btRigidBody::btRigidBodyConstructionInfo info(mass, 0, shape, inertia);
+		info.m_startWorldTransform.setOrigin(pos);
+		btRigidBody* body = new btRigidBody(info);
+		m_world->addRigidBody(body);
+		m_bodies.push_back(body);
+		return body;
+	}
+
+	void removeBody(int index)
+	{
+		btRigidBody* body = m_bodies[index];
+		m_world->removeRigidBody(body);
+		delete body;
+		m_bodies.swap(index, m_bodies.size() - 1);
+		m_bodies.pop_back();
+	}
+
+	///the same changes for every world, depending on the step
+	void applyChurn(int step)
+	{
+		if (step % 60 == 30)
+		{
+			//lands on a stack, which may be asleep
+			btRigidBody* body = addBody(&m_box, 1, getStackPosition((step / 60) % 6, 6));
+			body->setLinearVelocity(btVector3(0, -2, 0));
+		}
+		if (step % 85 == 50 && m_bodies.size() > 30)
+		{
+			//a box out of the middle of the arrays
+			removeBody(1 + (step / 85) % (m_bodies.size() - 1));
+		}
+		if (step % 40 == 20)
+		{
+			//nudges a box, the box and whatever it touches wake up
+			btRigidBody* body = m_bodies[1 + (step / 40 * 7) % (m_bodies.size() - 1)];
+			body->activate(true);
+			body->applyCentralImpulse(btVector3(0.5, 1, 0));
+		}
+	}
+
+	void step(int step)
+	{
+		applyChurn(step);
+		m_world->stepSimulation(btScalar(1.) / btScalar(60.), 0);
+	}
+
+	int countSleepingBodies() const
+	{
+		int numSleeping = 0;
+		for (int i = 1; i < m_bodies.size(); i++)
+		{
+			numSleeping += m_bodies[i]->isActive() ? 0 : 1;
+		}
+		return numSleeping;
+	}
+};
+
+#endif //SLEEP_SCENE_H
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include "btBulletDynamicsCommon.h"
+
+namespace
+{
+
+	///a single stack of boxes on a static ground, so every step solves one island and the solver reports on that island
+	struct StackScene
+	{
+		btDefaultCollisionConfiguration		m_configuration;
+		btCollisionDispatcher				m_dispatcher;
+		btDbvtBroadphase					m_broadphase;
+		btSequentialImpulseConstraintSolver	m_solver;
+		btDiscreteDynamicsWorld				m_world;
+		btBoxShape							m_groundShape;
+		btBoxShape							m_box;
+		btAlignedObjectArray<btRigidBody*>	m_bodies;
+
+		StackScene(btScalar threshold)
+			:m_dispatcher(&m_configuration),
+			m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_configuration),
+			m_groundShape(btVector3(10, 1, 10)),
+			m_box(btVector3(0.5, 0.5, 0.5))
+		{
+			m_world.setGravity(btVector3(0, -10, 0));
+			m_world.getSolverInfo().m_numIterations = 20;
+			m_world.getSolverInfo().m_leastSquaresResidualThreshold = threshold;
+			addBody(&m_groundShape, 0, btVector3(0, -1, 0));
+			for (int i = 0; i < 6; i++)
+			{
+				btRigidBody* body = addBody(&m_box, 1, btVector3(0, btScalar(0.5) + btScalar(i) * btScalar(1.01), 0));
+				body->setActivationState(DISABLE_DEACTIVATION);
+			}
+		}
+
+		~StackScene()
+		{
+			for (int i = 0; i < m_bodies.size(); i++)
+			{
+				m_world.removeRigidBody(m_bodies[i]);
+				delete m_bodies[i];
+			}
+		}
+
+		btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& pos)
+		{
+			btVector3 inertia(0, 0, 0);
+			if (mass != 0)
+			{
+				shape->calculateLocalInertia(mass, inertia);
+			}
+			btRigidBody::btRigidBodyConstructionInfo info(mass, 0, shape, inertia);
+			info.m_startWorldTransform.setOrigin(pos);
+			btRigidBody* body = new btRigidBody(info);
+			m_world.addRigidBody(body);
+			m_bodies.push_back(body);
+			return body;
+		}
+
+		void step()
+		{
+			m_world.stepSimulation(btScalar(1.) / btScalar(60.), 0);
+		}
+	};
+
+}
+
+
+///without a threshold every iteration runs, as before the early exit existed
+TEST(SolverEarlyExitTest, ZeroThresholdRunsAllIterations)
+{
+	StackScene scene(0);
+	for (int step = 0; step < 120; step++)
+	{
+		scene.step();
+		if (step > 10)
+		{
+			ASSERT_EQ(20, scene.m_solver.getNumIterationsUsed()) << "step " << step;
+		}
+	}
+	EXPECT_GT(scene.m_solver.getLeastSquaresResidual(), 0);
+}
+
+///the iterations stop once the residual of an iteration is below the threshold, and the stack still stands
+TEST(SolverEarlyExitTest, StopsOnceResidualIsBelowThreshold)
+{
+	const btScalar threshold = btScalar(1e-5);
+	StackScene expected(0);
+	StackScene actual(threshold);
+	int minIterations = 20;
+	int numEarlyExits = 0;
+	for (int step = 0; step < 240; step++)
+	{
+		expected.step();
+		actual.step();
+		int numIterations = actual.m_solver.getNumIterationsUsed();
+		ASSERT_GT(numIterations, 0);
+		ASSERT_LE(numIterations, 20);
+		if (numIterations < 20)
+		{
+			//it only stops on a converged iteration
+			ASSERT_LT(actual.m_solver.getLeastSquaresResidual(), threshold) << "step " << step;
+			numEarlyExits++;
+		}
+		minIterations = btMin(minIterations, numIterations);
+	}
+	//the resting stack converges in fewer iterations
+	EXPECT_GT(numEarlyExits, 100);
+	EXPECT_LT(minIterations, 10);
+	for (int i = 1; i < expected.m_bodies.size(); i++)
+	{
+		btVector3 a = expected.m_bodies[i]->getWorldTransform().getOrigin();
+		btVector3 b = actual.m_bodies[i]->getWorldTransform().getOrigin();
+		EXPECT_NEAR(0, (a - b).length(), 0.01) << "body " << i;
+	}
+}
+
+///a huge threshold stops after the first iteration
+TEST(SolverEarlyExitTest, HugeThresholdStopsAfterOneIteration)
+{
+	StackScene scene(BT_LARGE_FLOAT);
+	for (int step = 0; step < 30; step++)
+	{
+		scene.step();
+		ASSERT_EQ(1, scene.m_solver.getNumIterationsUsed()) << "step " << step;
+	}
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include "SleepScene.h"
+#include "TestScheduler.h"
+
+namespace
+{
+
+	void expectSameState(SleepScene& expected, SleepScene& actual, int step)
+	{
+		ASSERT_EQ(expected.m_bodies.size(), actual.m_bodies.size());
+		for (int i = 0; i < expected.m_bodies.size(); i++)
+		{
+			const btRigidBody* a = expected.m_bodies[i];
+			const btRigidBody* b = actual.m_bodies[i];
+			ASSERT_TRUE(a->getWorldTransform().getOrigin() == b->getWorldTransform().getOrigin() && a->getWorldTransform().getBasis() == b->getWorldTransform().getBasis())
+				<< "body " << i << " step " << step;
+			ASSERT_TRUE(a->getLinearVelocity() == b->getLinearVelocity()) << "body " << i << " step " << step;
+			ASSERT_EQ(a->getActivationState(), b->getActivationState()) << "body " << i << " step " << step;
+		}
+		btOverlappingPairCache* expectedPairs = expected.m_world->getPairCache();
+		btOverlappingPairCache* actualPairs = actual.m_world->getPairCache();
+		ASSERT_EQ(expectedPairs->getNumOverlappingPairs(), actualPairs->getNumOverlappingPairs()) << "step " << step;
+		for (int i = 0; i < expectedPairs->getNumOverlappingPairs(); i++)
+		{
+			const btBroadphasePair& a = expectedPairs->getOverlappingPairArray()[i];
+			const btBroadphasePair& b = actualPairs->getOverlappingPairArray()[i];
+			ASSERT_EQ(a.m_pProxy0->m_uniqueId, b.m_pProxy0->m_uniqueId) << "pair " << i << " step " << step;
+			ASSERT_EQ(a.m_pProxy1->m_uniqueId, b.m_pProxy1->m_uniqueId) << "pair " << i << " step " << step;
+		}
+		ASSERT_EQ(expected.m_dispatcher->getNumManifolds(), actual.m_dispatcher->getNumManifolds()) << "step " << step;
+	}
+
+	void checkSplitMatchesDefault(bool mt)
+	{
+		SleepScene expected(mt);
+		SleepScene actual(mt);
+		//only the awake objects update their aabbs in both worlds, so the broadphase sees the same updates
+		expected.m_world->setForceUpdateAllAabbs(false);
+		actual.m_world->setForceUpdateAllAabbs(false);
+		actual.m_world->setSplitActiveObjects(true);
+		int maxSleeping = 0;
+		int numWakeUps = 0;
+		for (int step = 0; step < 600; step++)
+		{
+			int numSleeping = actual.countSleepingBodies();
+			expected.step(step);
+			actual.step(step);
+			expectSameState(expected, actual, step);
+			if (::testing::Test::HasFatalFailure())
+			{
+				return;
+			}
+			//the lists of the split world follow the activation states
+			EXPECT_EQ(actual.countSleepingBodies(), actual.m_world->getSleepingObjectArray().size() - 1) << "step " << step;
+			numWakeUps += actual.countSleepingBodies() < numSleeping ? 1 : 0;
+			maxSleeping = btMax(maxSleeping, actual.countSleepingBodies());
+		}
+		//most bodies fell asleep, and some of them woke up again
+		EXPECT_GT(maxSleeping, actual.m_bodies.size() / 2);
+		EXPECT_GT(numWakeUps, 3);
+	}
+
+}
+
+
+///split awake and sleeping lists give the same simulation as the default world
+TEST(SplitActiveObjectsTest, MatchesDefaultWorld)
+{
+	checkSplitMatchesDefault(false);
+}
+
+TEST(SplitActiveObjectsTest, MatchesDefaultWorldMt)
+{
+	const int threadCounts[] = {1, 4};
+	for (int t = 0; t < 2; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		checkSplitMatchesDefault(true);
+	}
+	setTestNumThreads(1);
+}
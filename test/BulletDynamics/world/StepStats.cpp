@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+
+#include "btBulletDynamicsCommon.h"
+
+namespace
+{
+
+	///two stacks of 3 and 5 boxes, a pendulum hanging from a point to point constraint and a fast sphere that is shot
+	///at the ground, so it needs a CCD sweep. Nothing falls asleep.
+	struct StatsScene
+	{
+		btDefaultCollisionConfiguration		m_configuration;
+		btCollisionDispatcher				m_dispatcher;
+		btDbvtBroadphase					m_broadphase;
+		btSequentialImpulseConstraintSolver	m_solver;
+		btDiscreteDynamicsWorld				m_world;
+		btBoxShape							m_groundShape;
+		btBoxShape							m_box;
+		btSphereShape						m_sphereShape;
+		btAlignedObjectArray<btRigidBody*>	m_bodies;
+		btRigidBody*						m_sphere;
+		btPoint2PointConstraint*			m_joint;
+
+		StatsScene()
+			:m_dispatcher(&m_configuration),
+			m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_configuration),
+			m_groundShape(btVector3(20, 1, 20)),
+			m_box(btVector3(0.5, 0.5, 0.5)),
+			m_sphereShape(btScalar(0.1))
+		{
+			m_world.setGravity(btVector3(0, -10, 0));
+			addBody(&m_groundShape, 0, btVector3(0, -1, 0));
+			for (int i = 0; i < 3; i++)
+			{
+				addBody(&m_box, 1, btVector3(-5, btScalar(0.5) + btScalar(i) * btScalar(1.01), 0));
+			}
+			for (int i = 0; i < 5; i++)
+			{
+				addBody(&m_box, 1, btVector3(5, btScalar(0.5) + btScalar(i) * btScalar(1.01), 0));
+			}
+			btRigidBody* pendulum = addBody(&m_box, 1, btVector3(0, 10, 5));
+			m_joint = new btPoint2PointConstraint(*pendulum, btVector3(-2, 0, 0));
+			m_world.addConstraint(m_joint);
+
+			m_sphere = addBody(&m_sphereShape, 1, btVector3(0, 3, -5));
+			m_sphere->setLinearVelocity(btVector3(0, -300, 0));
+			m_sphere->setCcdMotionThreshold(btScalar(0.1));
+			m_sphere->setCcdSweptSphereRadius(btScalar(0.05));
+			m_sphere->setRestitution(0);
+		}
+
+		~StatsScene()
+		{
+			m_world.removeConstraint(m_joint);
+			delete m_joint;
+			for (int i = 0; i < m_bodies.size(); i++)
+			{
+				m_world.removeRigidBody(m_bodies[i]);
+				delete m_bodies[i];
+			}
+		}
+
+		btRigidBody* addBody(btCollisionShape* shape, btScalar mass, const btVector3& pos)
+		{
+			btVector3 inertia(0, 0, 0);
+			if (mass != 0)
+			{
+				shape->calculateLocalInertia(mass, inertia);
+			}
+			btRigidBody::btRigidBodyConstructionInfo info(mass, 0, shape, inertia);
+			info.m_startWorldTransform.setOrigin(pos);
+			btRigidBody* body = new btRigidBody(info);
+			if (mass != 0)
+			{
+				body->setActivationState(DISABLE_DEACTIVATION);
+			}
+			m_world.addRigidBody(body);
+			m_bodies.push_back(body);
+			return body;
+		}
+
+		///two substeps per call
+		void step()
+		{
+			m_world.stepSimulation(btScalar(1.) / btScalar(30.), 4, btScalar(1.) / btScalar(60.));
+		}
+	};
+
+}
+
+
+///the counts of a step with two substeps, the island counts describe the last substep
+TEST(StepStatsTest, CountsTheLastStep)
+{
+	StatsScene scene;
+	scene.m_world.setStepStatsEnabled(true);
+	const btSimulationStepStats& stats = scene.m_world.getStepStats();
+
+	scene.step();
+	EXPECT_EQ(2, stats.m_numSubSteps);
+	//the sphere is swept and stopped before it goes through the ground
+	EXPECT_GE(stats.m_numCcdSweeps, 1);
+	EXPECT_GE(stats.m_numCcdClampedMotions, 1);
+	EXPECT_LE(stats.m_numCcdClampedMotions, stats.m_numCcdSweeps);
+	EXPECT_GT(scene.m_sphere->getWorldTransform().getOrigin().getY(), 0);
+
+	for (int i = 0; i < 60; i++)
+	{
+		scene.step();
+	}
+	EXPECT_EQ(2, stats.m_numSubSteps);
+	EXPECT_EQ(0, stats.m_numCcdSweeps);
+	EXPECT_EQ(0, stats.m_numAddedPairs);
+	EXPECT_EQ(0, stats.m_numRemovedPairs);
+	//3 and 5 manifolds in the stacks with 4 points each, and one point of the sphere on the ground
+	EXPECT_EQ(9, stats.m_numManifolds);
+	EXPECT_EQ(33, stats.m_numContactPoints);
+	EXPECT_GE(stats.m_numOverlappingPairs, stats.m_numManifolds);
+	//the stacks, the pendulum and the sphere
+	EXPECT_EQ(4, stats.m_numIslands);
+	EXPECT_EQ(10, stats.m_numIslandBodies);
+	EXPECT_EQ(5, stats.m_largestIsland);
+	EXPECT_EQ(2, stats.m_islandSizeHistogram[0]);
+	EXPECT_EQ(1, stats.m_islandSizeHistogram[1]);
+	EXPECT_EQ(1, stats.m_islandSizeHistogram[2]);
+	for (int i = 3; i < BT_STEP_STATS_ISLAND_HISTOGRAM_SIZE; i++)
+	{
+		EXPECT_EQ(0, stats.m_islandSizeHistogram[i]);
+	}
+	//the islands are solved in one batch per substep, the solver counts are summed over the substeps
+	const btSolverStatistics& solver = stats.m_solver;
+	EXPECT_EQ(2, solver.m_numSolveGroupCalls);
+	EXPECT_EQ(2 * 10, solver.m_numBodies);
+	EXPECT_EQ(2 * 33, solver.m_numContactRows);
+	EXPECT_EQ(2 * 33, solver.m_numFrictionRows);
+	EXPECT_EQ(2 * 3, solver.m_numNonContactRows);
+	EXPECT_EQ(2 * scene.m_world.getSolverInfo().m_numIterations, solver.m_numIterations);
+	EXPECT_EQ(scene.m_world.getSolverInfo().m_numIterations, solver.m_maxIterations);
+}
+
+///pairs of a body that lands on the ground or is moved away are counted by the steps that find or drop them.
+///btDbvtBroadphase removes pairs incrementally, so they are summed over the following steps.
+TEST(StepStatsTest, CountsAddedAndRemovedPairs)
+{
+	StatsScene scene;
+	scene.m_world.setStepStatsEnabled(true);
+	const btSimulationStepStats& stats = scene.m_world.getStepStats();
+	for (int i = 0; i < 30; i++)
+	{
+		scene.step();
+	}
+	int numPairs = stats.m_numOverlappingPairs;
+
+	//a box dropped on the ground next to the small stack
+	scene.addBody(&scene.m_box, 1, btVector3(-7, 3, 0));
+	int numAdded = 0;
+	int numRemoved = 0;
+	for (int i = 0; i < 40; i++)
+	{
+		scene.step();
+		numAdded += stats.m_numAddedPairs;
+		numRemoved += stats.m_numRemovedPairs;
+	}
+	EXPECT_EQ(1, numAdded);
+	EXPECT_EQ(0, numRemoved);
+	EXPECT_EQ(numPairs + 1, stats.m_numOverlappingPairs);
+
+	//the sphere leaves the ground
+	btTransform tr = scene.m_sphere->getWorldTransform();
+	tr.setOrigin(btVector3(0, 50, -5));
+	scene.m_sphere->setWorldTransform(tr);
+	numAdded = 0;
+	for (int i = 0; i < 10; i++)
+	{
+		scene.step();
+		numAdded += stats.m_numAddedPairs;
+		numRemoved += stats.m_numRemovedPairs;
+	}
+	EXPECT_EQ(0, numAdded);
+	EXPECT_EQ(1, numRemoved);
+	EXPECT_EQ(numPairs, stats.m_numOverlappingPairs);
+}
+
+///without step stats nothing is counted
+TEST(StepStatsTest, DisabledStatsStayZero)
+{
+	StatsScene scene;
+	for (int i = 0; i < 30; i++)
+	{
+		scene.step();
+	}
+	EXPECT_FALSE(scene.m_world.isStepStatsEnabled());
+	const btSimulationStepStats& stats = scene.m_world.getStepStats();
+	EXPECT_EQ(0, stats.m_numSubSteps);
+	EXPECT_EQ(0, stats.m_numOverlappingPairs);
+	EXPECT_EQ(0, stats.m_numManifolds);
+	EXPECT_EQ(0, stats.m_numIslands);
+	EXPECT_EQ(0, stats.m_numCcdSweeps);
+	EXPECT_EQ(0, stats.m_solver.m_numSolveGroupCalls);
+	EXPECT_EQ(0, stats.m_solver.m_numContactRows);
+
+	//enabling them counts from the next step on
+	scene.m_world.setStepStatsEnabled(true);
+	scene.step();
+	EXPECT_EQ(2, stats.m_numSubSteps);
+	EXPECT_EQ(2, stats.m_solver.m_numSolveGroupCalls);
+	scene.m_world.setStepStatsEnabled(false);
+	scene.step();
+	EXPECT_EQ(2, stats.m_numSubSteps);
+}
@@ -0,0 +1,291 @@
+#include <gtest/gtest.h>
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletDynamics/Featherstone/btMultiBody.h"
+#include "BulletDynamics/Featherstone/btMultiBodyLinkCollider.h"
+#include "BulletDynamics/Featherstone/btMultiBodyWorldBatch.h"
+#include "TestScheduler.h"
+#include <string.h>
+
+namespace
+{
+
+	///shapes shared by all environments, as the batch expects
+	struct SharedShapes
+	{
+		btBoxShape				m_box;
+		btTriangleMesh			m_mesh;
+		btBvhTriangleMeshShape*	m_ground;
+
+		SharedShapes()
+			:m_box(btVector3(0.05, 0.2, 0.05))
+		{
+			for (int x = -10; x < 10; x++)
+			{
+				for (int z = -10; z < 10; z++)
+				{
+					btScalar h = btScalar(0.05) * btScalar((x + z) & 1);
+					btVector3 a(btScalar(x), h, btScalar(z));
+					btVector3 b(btScalar(x + 1), 0, btScalar(z));
+					btVector3 c(btScalar(x), 0, btScalar(z + 1));
+					btVector3 d(btScalar(x + 1), h, btScalar(z + 1));
+					m_mesh.addTriangle(a, b, c);
+					m_mesh.addTriangle(b, d, c);
+				}
+			}
+			m_ground = new btBvhTriangleMeshShape(&m_mesh, true);
+		}
+
+		~SharedShapes()
+		{
+			delete m_ground;
+		}
+	};
+
+	///an arm of revolute and spherical joints, its colliders use the given collision filter
+	void addArm(btMultiBodyDynamicsWorld* world, btCollisionShape* shape, const btVector3& basePos, bool fixedBase, int filterMask)
+	{
+		const int numLinks = 5;
+		btVector3 inertia;
+		shape->calculateLocalInertia(1, inertia);
+		btMultiBody* body = new btMultiBody(numLinks, 1, inertia, fixedBase, false);
+		body->setBasePos(basePos);
+		for (int i = 0; i < numLinks; i++)
+		{
+			if (i % 2 == 0)
+			{
+				body->setupRevolute(i, 1, inertia, i - 1, btQuaternion::getIdentity(), btVector3(1, 0, 0), btVector3(0, 0.2, 0), btVector3(0, 0.2, 0), true);
+			}
+			else
+			{
+				body->setupSpherical(i, 1, inertia, i - 1, btQuaternion::getIdentity(), btVector3(0, 0.2, 0), btVector3(0, 0.2, 0), true);
+			}
+		}
+		body->finalizeMultiDof();
+		for (int i = 0; i < numLinks; i += 2)
+		{
+			body->setJointPos(i, btScalar(0.4) * btScalar(i + 1));
+		}
+		world->addMultiBody(body);
+
+		btAlignedObjectArray<btQuaternion> worldToLocal;
+		btAlignedObjectArray<btVector3> localOrigin;
+		body->forwardKinematics(worldToLocal, localOrigin);
+		btMultiBodyLinkCollider* collider = new btMultiBodyLinkCollider(body, -1);
+		collider->setCollisionShape(shape);
+		world->addCollisionObject(collider, btBroadphaseProxy::DefaultFilter, filterMask);
+		body->setBaseCollider(collider);
+		for (int i = 0; i < numLinks; i++)
+		{
+			collider = new btMultiBodyLinkCollider(body, i);
+			collider->setCollisionShape(shape);
+			world->addCollisionObject(collider, btBroadphaseProxy::DefaultFilter, filterMask);
+			body->getLink(i).m_collider = collider;
+		}
+		body->updateCollisionObjectWorldTransforms(worldToLocal, localOrigin);
+	}
+
+	///a batch of identical environments: a fixed and a free falling arm, with or without the ground and contacts
+	struct BatchScene
+	{
+		btDefaultCollisionConfiguration	m_configuration;
+		btMultiBodyWorldBatch*			m_batch;
+
+		BatchScene(SharedShapes& shapes, int numEnvironments, bool withContacts)
+		{
+			m_batch = new btMultiBodyWorldBatch(numEnvironments, &m_configuration);
+			int filterMask = withContacts ? btBroadphaseProxy::AllFilter : 0;
+			for (int env = 0; env < numEnvironments; env++)
+			{
+				btMultiBodyDynamicsWorld* world = m_batch->getWorld(env);
+				world->setGravity(btVector3(0, -10, 0));
+				if (withContacts)
+				{
+					world->addRigidBody(new btRigidBody(0, 0, shapes.m_ground));
+				}
+				addArm(world, &shapes.m_box, btVector3(0, 0.6, 0), true, filterMask);
+				addArm(world, &shapes.m_box, btVector3(1, 1.5, 1), false, filterMask);
+			}
+		}
+
+		~BatchScene()
+		{
+			for (int env = 0; env < m_batch->getNumEnvironments(); env++)
+			{
+				btMultiBodyDynamicsWorld* world = m_batch->getWorld(env);
+				for (int i = world->getNumCollisionObjects() - 1; i >= 0; i--)
+				{
+					btCollisionObject* obj = world->getCollisionObjectArray()[i];
+					world->removeCollisionObject(obj);
+					delete obj;
+				}
+				for (int i = world->getNumMultibodies() - 1; i >= 0; i--)
+				{
+					btMultiBody* body = world->getMultiBody(i);
+					world->removeMultiBody(body);
+					delete body;
+				}
+			}
+			delete m_batch;
+		}
+
+		///joint torques that differ per environment unless sameActions, t is the step of the environment
+		void setActions(int env, int t, bool sameActions)
+		{
+			float* actions = m_batch->getActions() + env * m_batch->getNumActions();
+			for (int k = 0; k < m_batch->getNumActions(); k++)
+			{
+				actions[k] = 2.0f * sinf(0.05f * float(t) + float(k) + (sameActions ? 0.f : 0.3f * float(env)));
+			}
+		}
+
+		void step(int t, bool sameActions)
+		{
+			for (int env = 0; env < m_batch->getNumEnvironments(); env++)
+			{
+				setActions(env, t, sameActions);
+			}
+			m_batch->stepSimulation(btScalar(1. / 60.), 1, btScalar(1. / 60.));
+		}
+	};
+
+	bool isSameEnvironmentState(const btMultiBodyWorldBatch& batch, int env0, const btMultiBodyWorldBatch& other, int env1)
+	{
+		return memcmp(batch.getPositions() + env0 * batch.getNumPositions(), other.getPositions() + env1 * other.getNumPositions(), sizeof(float) * batch.getNumPositions()) == 0 &&
+			memcmp(batch.getVelocities() + env0 * batch.getNumVelocities(), other.getVelocities() + env1 * other.getNumVelocities(), sizeof(float) * batch.getNumVelocities()) == 0;
+	}
+
+}
+
+
+TEST(MultiBodyWorldBatchTest, PackedStateLayout)
+{
+	SharedShapes shapes;
+	BatchScene scene(shapes, 3, true);
+	ASSERT_TRUE(scene.m_batch->finalize());
+	//per arm: quaternion, base position and 3 revolute + 2 spherical joint positions; base velocity and 3 + 2*3 dofs
+	EXPECT_EQ(2 * (7 + 3 + 2 * 4), scene.m_batch->getNumPositions());
+	EXPECT_EQ(2 * (6 + 3 + 2 * 3), scene.m_batch->getNumVelocities());
+	EXPECT_EQ(2 * (3 + 2 * 3), scene.m_batch->getNumActions());
+	const btMultiBody* freeArm = scene.m_batch->getWorld(2)->getMultiBody(1);
+	const float* positions = scene.m_batch->getPositions() + 2 * scene.m_batch->getNumPositions() + 7 + 3 + 2 * 4;
+	EXPECT_FLOAT_EQ(float(freeArm->getBasePos().x()), positions[4]);
+	EXPECT_FLOAT_EQ(float(freeArm->getBasePos().y()), positions[5]);
+	EXPECT_FLOAT_EQ(float(freeArm->getBasePos().z()), positions[6]);
+}
+
+TEST(MultiBodyWorldBatchTest, FinalizeRejectsDifferentEnvironments)
+{
+	SharedShapes shapes;
+	BatchScene scene(shapes, 2, false);
+	btMultiBodyDynamicsWorld* world = scene.m_batch->getWorld(1);
+	addArm(world, &shapes.m_box, btVector3(3, 1, 0), true, 0);
+	EXPECT_FALSE(scene.m_batch->finalize());
+}
+
+TEST(MultiBodyWorldBatchTest, SameStateForAnyThreadCount)
+{
+	SharedShapes shapes;
+	const int numEnvironments = 12;
+	//without contacts the environments don't depend on the memory layout of their pairs and manifolds,
+	//so batches stepped with different thread counts can be compared bit for bit
+	setTestNumThreads(1);
+	BatchScene reference(shapes, numEnvironments, false);
+	ASSERT_TRUE(reference.m_batch->finalize());
+	for (int t = 0; t < 120; t++)
+	{
+		reference.step(t, false);
+	}
+	const int threadCounts[] = {2, 4};
+	for (int i = 0; i < 2; i++)
+	{
+		setTestNumThreads(threadCounts[i]);
+		BatchScene scene(shapes, numEnvironments, false);
+		ASSERT_TRUE(scene.m_batch->finalize());
+		scene.m_batch->setGrainSize(i + 1);
+		for (int t = 0; t < 120; t++)
+		{
+			scene.step(t, false);
+		}
+		for (int env = 0; env < numEnvironments; env++)
+		{
+			EXPECT_TRUE(isSameEnvironmentState(*reference.m_batch, env, *scene.m_batch, env)) << "environment " << env << ", " << threadCounts[i] << " threads";
+		}
+	}
+	setTestNumThreads(1);
+	//the environments got different actions
+	EXPECT_FALSE(isSameEnvironmentState(*reference.m_batch, 0, *reference.m_batch, 1));
+}
+
+TEST(MultiBodyWorldBatchTest, EnvironmentsWithSameActionsMatch)
+{
+	SharedShapes shapes;
+	const int numEnvironments = 8;
+	setTestNumThreads(4);
+	BatchScene scene(shapes, numEnvironments, true);
+	ASSERT_TRUE(scene.m_batch->finalize());
+	for (int t = 0; t < 150; t++)
+	{
+		scene.step(t, true);
+	}
+	setTestNumThreads(1);
+	int numContacts = 0;
+	for (int i = 0; i < scene.m_batch->getWorld(0)->getDispatcher()->getNumManifolds(); i++)
+	{
+		numContacts += scene.m_batch->getWorld(0)->getDispatcher()->getManifoldByIndexInternal(i)->getNumContacts();
+	}
+	EXPECT_GT(numContacts, 0);
+	for (int env = 1; env < numEnvironments; env++)
+	{
+		EXPECT_TRUE(isSameEnvironmentState(*scene.m_batch, 0, *scene.m_batch, env)) << "environment " << env;
+	}
+}
+
+TEST(MultiBodyWorldBatchTest, ResetEnvironmentMatchesFreshEnvironment)
+{
+	SharedShapes shapes;
+	const int numEnvironments = 4;
+	const int half = 100;
+	setTestNumThreads(2);
+	BatchScene scene(shapes, numEnvironments, true);
+	ASSERT_TRUE(scene.m_batch->finalize());
+	btAlignedObjectArray<float> initialPositions;
+	initialPositions.resize(scene.m_batch->getNumPositions());
+	memcpy(&initialPositions[0], scene.m_batch->getPositions(), sizeof(float) * initialPositions.size());
+	btAlignedObjectArray<float> positionsAtHalf;
+	btAlignedObjectArray<float> velocitiesAtHalf;
+	for (int t = 0; t < 2 * half; t++)
+	{
+		if (t == half)
+		{
+			positionsAtHalf.resize(scene.m_batch->getNumPositions());
+			velocitiesAtHalf.resize(scene.m_batch->getNumVelocities());
+			memcpy(&positionsAtHalf[0], scene.m_batch->getPositions(), sizeof(float) * positionsAtHalf.size());
+			memcpy(&velocitiesAtHalf[0], scene.m_batch->getVelocities(), sizeof(float) * velocitiesAtHalf.size());
+			scene.m_batch->resetEnvironment(1);
+			//the packed state is refreshed right away
+			EXPECT_EQ(0, memcmp(&initialPositions[0], scene.m_batch->getPositions() + scene.m_batch->getNumPositions(), sizeof(float) * initialPositions.size()));
+		}
+		for (int env = 0; env < numEnvironments; env++)
+		{
+			//environment 1 replays the actions of environment 0 after its reset
+			int envStep = (env == 1 && t >= half) ? t - half : t;
+			scene.setActions(env, envStep, true);
+		}
+		scene.m_batch->stepSimulation(btScalar(1. / 60.), 1, btScalar(1. / 60.));
+	}
+	setTestNumThreads(1);
+	//after the reset, environment 1 went through the same states as environment 0 did from the start,
+	//including the contacts with the ground, sleeping and warm starting
+	EXPECT_EQ(0, memcmp(&positionsAtHalf[0], scene.m_batch->getPositions() + scene.m_batch->getNumPositions(), sizeof(float) * positionsAtHalf.size()));
+	EXPECT_EQ(0, memcmp(&velocitiesAtHalf[0], scene.m_batch->getVelocities() + scene.m_batch->getNumVelocities(), sizeof(float) * velocitiesAtHalf.size()));
+}
+
+
+int main(int argc, char **argv) {
+#if _MSC_VER
+        _CrtSetDbgFlag ( _CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF );
+#endif
+        ::testing::InitGoogleTest(&argc, argv);
+        return RUN_ALL_TESTS();
+}
@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletSoftBody/btSoftRigidDynamicsWorld.h"
+#include "BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h"
+#include "BulletSoftBody/btSoftBodyHelpers.h"
+#include "TestScheduler.h"
+
+namespace
+{
+
+	///a batched cloth fixed at two corners that drapes over a sphere
+	struct DrapeScene
+	{
+		btSoftBodyRigidBodyCollisionConfiguration	m_configuration;
+		btCollisionDispatcher						m_dispatcher;
+		btDbvtBroadphase							m_broadphase;
+		btSequentialImpulseConstraintSolver			m_solver;
+		btSoftRigidDynamicsWorld					m_world;
+		btSphereShape								m_sphereShape;
+		btRigidBody*								m_sphere;
+		btSoftBody*									m_cloth;
+
+		DrapeScene(bool packed, int velocityIterations)
+			:m_dispatcher(&m_configuration),
+			m_world(&m_dispatcher, &m_broadphase, &m_solver, &m_configuration),
+			m_sphereShape(2)
+		{
+			m_world.setGravity(btVector3(0, -10, 0));
+			m_world.getWorldInfo().m_gravity = m_world.getGravity();
+			btRigidBody::btRigidBodyConstructionInfo info(0, 0, &m_sphereShape);
+			m_sphere = new btRigidBody(info);
+			m_world.addRigidBody(m_sphere);
+
+			//odd resolution, so the batches don't end on a multiple of the kernel width
+			m_cloth = btSoftBodyHelpers::CreatePatch(m_world.getWorldInfo(), btVector3(-4, 3, -4), btVector3(4, 3, -4),
+				btVector3(-4, 3, 4), btVector3(4, 3, 4), 37, 37, 1 + 2, true);
+			m_cloth->getCollisionShape()->setMargin(btScalar(0.1));
+			m_cloth->m_cfg.piterations = 6;
+			m_cloth->m_cfg.viterations = velocityIterations;
+			m_cloth->m_materials[0]->m_kLST = btScalar(0.8);
+			m_cloth->setTotalMass(2);
+			m_cloth->generateLinkBatches();
+			m_cloth->m_packedLinks.m_enabled = packed;
+			m_world.addSoftBody(m_cloth);
+		}
+
+		~DrapeScene()
+		{
+			m_world.removeSoftBody(m_cloth);
+			delete m_cloth;
+			m_world.removeRigidBody(m_sphere);
+			delete m_sphere;
+		}
+	};
+
+	void checkPackedMatchesLinks(int velocityIterations)
+	{
+		DrapeScene expected(false, velocityIterations);
+		DrapeScene actual(true, velocityIterations);
+		for (int step = 0; step < 120; step++)
+		{
+			expected.m_world.stepSimulation(btScalar(1.) / btScalar(60.), 0);
+			actual.m_world.stepSimulation(btScalar(1.) / btScalar(60.), 0);
+			const btSoftBody::tNodeArray& a = expected.m_cloth->m_nodes;
+			const btSoftBody::tNodeArray& b = actual.m_cloth->m_nodes;
+			int numDifferent = 0;
+			for (int i = 0; i < a.size(); i++)
+			{
+				numDifferent += !(a[i].m_x == b[i].m_x) || !(a[i].m_v == b[i].m_v);
+			}
+			ASSERT_EQ(0, numDifferent) << "step " << step;
+		}
+		EXPECT_TRUE(actual.m_cloth->hasPackedLinks());
+		EXPECT_FALSE(expected.m_cloth->hasPackedLinks());
+		//the cloth hangs on the sphere
+		EXPECT_GT(actual.m_cloth->m_rcontacts.size(), 0);
+	}
+
+}
+
+
+///the packed links, solved by the AVX2 kernel where the CPU has it, give the same cloth as the links
+TEST(PackedLinksTest, MatchesLinks)
+{
+	const int threadCounts[] = {1, 4};
+	for (int t = 0; t < 2; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		checkPackedMatchesLinks(0);
+	}
+	setTestNumThreads(1);
+}
+
+TEST(PackedLinksTest, MatchesLinksWithVelocityIterations)
+{
+	const int threadCounts[] = {1, 4};
+	for (int t = 0; t < 2; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		checkPackedMatchesLinks(4);
+	}
+	setTestNumThreads(1);
+}
+
+///links changed after packing drop the batches, the body then goes back to the links
+TEST(PackedLinksTest, LinkChangesFallBackToLinks)
+{
+	DrapeScene scene(true, 2);
+	scene.m_world.stepSimulation(btScalar(1.) / btScalar(60.), 0);
+	EXPECT_TRUE(scene.m_cloth->hasPackedLinks());
+	scene.m_cloth->appendLink(0, 38);
+	EXPECT_FALSE(scene.m_cloth->hasPackedLinks());
+	scene.m_world.stepSimulation(btScalar(1.) / btScalar(60.), 0);
+	EXPECT_FALSE(scene.m_cloth->hasPackedLinks());
+	scene.m_cloth->generateLinkBatches();
+	scene.m_world.stepSimulation(btScalar(1.) / btScalar(60.), 0);
+	EXPECT_TRUE(scene.m_cloth->hasPackedLinks());
+}
@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletSoftBody/btSoftRigidDynamicsWorld.h"
+#include "BulletSoftBody/btSoftBodyRigidBodyCollisionConfiguration.h"
+#include "BulletSoftBody/btSoftBodyHelpers.h"
+#include "BulletSoftBody/btDefaultSoftBodySolverMt.h"
+#include "TestScheduler.h"
+
+namespace
+{
+
+	///cloths hanging from a dynamic box they share, a cloth falling onto a dynamic sphere with a second cloth falling on
+	///top of it, and a cloth large enough to get link batches from btDefaultSoftBodySolverMt
+	struct ClothScene
+	{
+		btSoftBodyRigidBodyCollisionConfiguration	m_configuration;
+		btCollisionDispatcher						m_dispatcher;
+		btDbvtBroadphase							m_broadphase;
+		btSequentialImpulseConstraintSolver			m_solver;
+		btSoftBodySolver*							m_softBodySolver;
+		btSoftRigidDynamicsWorld*					m_world;
+		btBoxShape									m_groundShape;
+		btBoxShape									m_boxShape;
+		btSphereShape								m_sphereShape;
+		btAlignedObjectArray<btRigidBody*>			m_rigidBodies;
+		btAlignedObjectArray<btSoftBody*>			m_softBodies;
+
+		enum
+		{
+			LARGE_CLOTH_RESOLUTION = 30,
+			LINK_BATCH_THRESHOLD = 1000
+		};
+
+		ClothScene(bool mt)
+			:m_dispatcher(&m_configuration),
+			m_groundShape(btVector3(20, 1, 20)),
+			m_boxShape(btVector3(1, 1, 1)),
+			m_sphereShape(1)
+		{
+			if (mt)
+			{
+				btDefaultSoftBodySolverMt* solver = new btDefaultSoftBodySolverMt();
+				solver->setLinkBatchThreshold(LINK_BATCH_THRESHOLD);
+				m_softBodySolver = solver;
+			}
+			else
+			{
+				m_softBodySolver = new btDefaultSoftBodySolver();
+			}
+			m_world = new btSoftRigidDynamicsWorld(&m_dispatcher, &m_broadphase, &m_solver, &m_configuration, m_softBodySolver);
+			m_world->setGravity(btVector3(0, -10, 0));
+			btSoftBodyWorldInfo& worldInfo = m_world->getWorldInfo();
+			worldInfo.m_gravity = m_world->getGravity();
+
+			addRigidBody(&m_groundShape, 0, btVector3(0, -1, 0));
+			btRigidBody* box = addRigidBody(&m_boxShape, 2, btVector3(-6, 1, 0));
+			btRigidBody* sphere = addRigidBody(&m_sphereShape, 3, btVector3(6, 1, 0));
+
+			//two cloths anchored to the same box
+			for (int i = 0; i < 2; i++)
+			{
+				btScalar z = i ? btScalar(-1) : btScalar(1);
+				btSoftBody* cloth = addCloth(btVector3(-6, 2, 0), btVector3(-3, 2, 0), btVector3(-6, 2, z * 3), btVector3(-3, 2, z * 3), 8, 0);
+				cloth->appendAnchor(0, box);
+				cloth->appendAnchor(7, box);
+			}
+			//a cloth on the sphere and one on top of it, they collide with each other
+			for (int i = 0; i < 2; i++)
+			{
+				btScalar y = btScalar(2.5) + btScalar(i) * btScalar(0.6);
+				btSoftBody* cloth = addCloth(btVector3(4, y, -2), btVector3(8, y, -2), btVector3(4, y, 2), btVector3(8, y, 2), 10, 0);
+				cloth->m_cfg.collisions |= btSoftBody::fCollision::VF_SS;
+			}
+			//a large cloth fixed at two corners, away from the rest
+			addCloth(btVector3(-4, 4, 6), btVector3(4, 4, 6), btVector3(-4, 4, 14), btVector3(4, 4, 14), LARGE_CLOTH_RESOLUTION, 1 + 2);
+		}
+
+		~ClothScene()
+		{
+			for (int i = 0; i < m_softBodies.size(); i++)
+			{
+				m_world->removeSoftBody(m_softBodies[i]);
+				delete m_softBodies[i];
+			}
+			for (int i = 0; i < m_rigidBodies.size(); i++)
+			{
+				m_world->removeRigidBody(m_rigidBodies[i]);
+				delete m_rigidBodies[i];
+			}
+			delete m_world;
+			delete m_softBodySolver;
+		}
+
+		btRigidBody* addRigidBody(btCollisionShape* shape, btScalar mass, const btVector3& pos)
+		{
+			btVector3 inertia(0, 0, 0);
+			if (mass != 0)
+			{
+				shape->calculateLocalInertia(mass, inertia);
+			}
+			btRigidBody::btRigidBodyConstructionInfo info(mass, 0, shape, inertia);
+			info.m_startWorldTransform.setOrigin(pos);
+			btRigidBody* body = new btRigidBody(info);
+			m_world->addRigidBody(body);
+			m_rigidBodies.push_back(body);
+			return body;
+		}
+
+		btSoftBody* addCloth(const btVector3& c00, const btVector3& c10, const btVector3& c01, const btVector3& c11, int resolution, int fixeds)
+		{
+			btSoftBody* cloth = btSoftBodyHelpers::CreatePatch(m_world->getWorldInfo(), c00, c10, c01, c11, resolution, resolution, fixeds, true);
+			cloth->getCollisionShape()->setMargin(btScalar(0.1));
+			cloth->m_cfg.piterations = 4;
+			cloth->setTotalMass(1);
+			m_world->addSoftBody(cloth);
+			m_softBodies.push_back(cloth);
+			return cloth;
+		}
+	};
+
+	void expectSameState(ClothScene& expected, ClothScene& actual, int step)
+	{
+		for (int i = 0; i < expected.m_rigidBodies.size(); i++)
+		{
+			const btTransform& a = expected.m_rigidBodies[i]->getWorldTransform();
+			const btTransform& b = actual.m_rigidBodies[i]->getWorldTransform();
+			ASSERT_TRUE(a.getOrigin() == b.getOrigin() && a.getBasis() == b.getBasis()) << "rigid body " << i << " step " << step;
+		}
+		for (int i = 0; i < expected.m_softBodies.size(); i++)
+		{
+			const btSoftBody* a = expected.m_softBodies[i];
+			const btSoftBody* b = actual.m_softBodies[i];
+			ASSERT_EQ(a->m_nodes.size(), b->m_nodes.size());
+			int numDifferent = 0;
+			for (int j = 0; j < a->m_nodes.size(); j++)
+			{
+				numDifferent += !(a->m_nodes[j].m_x == b->m_nodes[j].m_x) || !(a->m_nodes[j].m_v == b->m_nodes[j].m_v);
+			}
+			ASSERT_EQ(0, numDifferent) << "soft body " << i << " step " << step;
+			ASSERT_EQ(a->m_rcontacts.size(), b->m_rcontacts.size()) << "soft body " << i << " step " << step;
+			ASSERT_EQ(a->m_scontacts.size(), b->m_scontacts.size()) << "soft body " << i << " step " << step;
+		}
+	}
+
+	///the links of a batch share no node, and every link is in one batch
+	void expectValidLinkBatches(const btSoftBody* psb)
+	{
+		ASSERT_TRUE(psb->hasLinkBatches());
+		EXPECT_EQ(0, psb->m_linkBatches[0]);
+		btAlignedObjectArray<int> stamp;
+		stamp.resize(psb->m_nodes.size(), -1);
+		const btSoftBody::Node* nbase = &psb->m_nodes[0];
+		int numShared = 0;
+		for (int b = 0; b < psb->m_linkBatches.size() - 1; b++)
+		{
+			EXPECT_LT(psb->m_linkBatches[b], psb->m_linkBatches[b + 1]);
+			for (int i = psb->m_linkBatches[b]; i < psb->m_linkBatches[b + 1]; i++)
+			{
+				for (int j = 0; j < 2; j++)
+				{
+					int node = int(psb->m_links[i].m_n[j] - nbase);
+					numShared += (stamp[node] == b);
+					stamp[node] = b;
+				}
+			}
+		}
+		EXPECT_EQ(0, numShared);
+	}
+
+	void checkMtMatchesDefault()
+	{
+		ClothScene expected(false);
+		ClothScene actual(true);
+		//the Mt solver reorders the links of the large cloth into batches, the default world gets the same order
+		for (int i = 0; i < expected.m_softBodies.size(); i++)
+		{
+			if (expected.m_softBodies[i]->m_links.size() >= ClothScene::LINK_BATCH_THRESHOLD)
+			{
+				expected.m_softBodies[i]->generateLinkBatches();
+			}
+		}
+		int maxRigidContacts = 0;
+		int maxSoftContacts = 0;
+		for (int step = 0; step < 150; step++)
+		{
+			expected.m_world->stepSimulation(btScalar(1.) / btScalar(60.), 0);
+			actual.m_world->stepSimulation(btScalar(1.) / btScalar(60.), 0);
+			expectSameState(expected, actual, step);
+			if (::testing::Test::HasFatalFailure())
+			{
+				return;
+			}
+			maxRigidContacts = btMax(maxRigidContacts, actual.m_softBodies[2]->m_rcontacts.size());
+			maxSoftContacts = btMax(maxSoftContacts, actual.m_softBodies[2]->m_scontacts.size() + actual.m_softBodies[3]->m_scontacts.size());
+		}
+		//the scene had rigid and soft contacts, and the large cloth was solved with link batches
+		EXPECT_GT(maxRigidContacts, 0);
+		EXPECT_GT(maxSoftContacts, 0);
+		expectValidLinkBatches(actual.m_softBodies[4]);
+		EXPECT_FALSE(actual.m_softBodies[0]->hasLinkBatches());
+	}
+
+}
+
+
+///bodies sharing a dynamic rigid body or touching each other are solved together, so the Mt solver gives the same results
+TEST(SoftBodySolverMtTest, MatchesDefaultSolver)
+{
+	const int threadCounts[] = {1, 4};
+	for (int t = 0; t < 2; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		checkMtMatchesDefault();
+	}
+	setTestNumThreads(1);
+}
+
+///every change of the links drops the batches, even if the number of links stays the same
+TEST(SoftBodySolverMtTest, LinkChangesDropBatches)
+{
+	btSoftBodyWorldInfo worldInfo;
+	worldInfo.m_sparsesdf.Initialize();
+	btSoftBody* psb = btSoftBodyHelpers::CreatePatch(worldInfo, btVector3(0, 0, 0), btVector3(4, 0, 0), btVector3(0, 0, 4), btVector3(4, 0, 4), 12, 12, 0, true);
+
+	EXPECT_GT(psb->generateLinkBatches(), 1);
+	expectValidLinkBatches(psb);
+	btSoftBodyHelpers::ReoptimizeLinkOrder(psb);
+	EXPECT_FALSE(psb->hasLinkBatches());
+
+	psb->generateLinkBatches();
+	psb->randomizeConstraints();
+	EXPECT_FALSE(psb->hasLinkBatches());
+
+	psb->generateLinkBatches();
+	psb->appendLink(0, 20);
+	EXPECT_FALSE(psb->hasLinkBatches());
+
+	psb->generateLinkBatches();
+	EXPECT_TRUE(psb->cutLink(0, 1, btScalar(0.5)));
+	EXPECT_FALSE(psb->hasLinkBatches());
+
+	psb->generateLinkBatches();
+	expectValidLinkBatches(psb);
+	delete psb;
+}
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include "btBulletCollisionCommon.h"
+#include "BulletSoftBody/btSparseSDF.h"
+#include "TestScheduler.h"
+
+namespace
+{
+
+	struct SdfShapes
+	{
+		btBoxShape			m_box;
+		btSphereShape		m_sphere;
+		btConvexHullShape	m_hull;
+		btCapsuleShape		m_capsule;
+
+		SdfShapes()
+			:m_box(btVector3(1.5, 0.5, 1)),
+			m_sphere(1.2),
+			m_capsule(0.4, 2)
+		{
+			for (int i = 0; i < 20; i++)
+			{
+				btScalar a = btScalar(i) * 0.9f;
+				m_hull.addPoint(btVector3(btSin(a) * 1.3f, btCos(a * 1.7f), btSin(a * 0.4f) * 0.8f), false);
+			}
+			m_hull.recalcLocalAabb();
+		}
+
+		const btCollisionShape* getShape(int i) const
+		{
+			switch (i & 3)
+			{
+				case 0: return &m_box;
+				case 1: return &m_sphere;
+				case 2: return &m_hull;
+				default: return &m_capsule;
+			}
+		}
+	};
+
+	///evaluates every query point in parallel, point i against shape i&3
+	struct EvaluateBody : public btIParallelForBody
+	{
+		btSparseSdf<3>*		m_sdf;
+		const SdfShapes*	m_shapes;
+		const btVector3*	m_points;
+		btScalar*			m_distances;
+		btVector3*			m_normals;
+
+		void forLoop(int iBegin, int iEnd) const
+		{
+			for (int i = iBegin; i < iEnd; i++)
+			{
+				m_distances[i] = m_sdf->Evaluate(m_points[i], m_shapes->getShape(i), m_normals[i], btScalar(0.05));
+			}
+		}
+	};
+
+	void makeQueryPoints(btAlignedObjectArray<btVector3>& points)
+	{
+		for (int i = 0; i < 6000; i++)
+		{
+			btScalar a = btScalar(i) * 0.013f;
+			points.push_back(btVector3(btSin(a * 3.1f) * 2.5f, btCos(a * 1.7f) * 2, btSin(a * 0.9f + 1) * 2.2f));
+		}
+	}
+
+	void evaluate(btSparseSdf<3>& sdf, const SdfShapes& shapes, const btAlignedObjectArray<btVector3>& points,
+		btAlignedObjectArray<btScalar>& distances, btAlignedObjectArray<btVector3>& normals)
+	{
+		distances.resize(points.size());
+		normals.resize(points.size());
+		EvaluateBody body;
+		body.m_sdf = &sdf;
+		body.m_shapes = &shapes;
+		body.m_points = &points[0];
+		body.m_distances = &distances[0];
+		body.m_normals = &normals[0];
+		btParallelFor(0, points.size(), 16, body);
+	}
+
+	int countDifferences(const btAlignedObjectArray<btScalar>& expectedDistances, const btAlignedObjectArray<btVector3>& expectedNormals,
+		const btAlignedObjectArray<btScalar>& distances, const btAlignedObjectArray<btVector3>& normals)
+	{
+		int numDifferent = 0;
+		for (int i = 0; i < expectedDistances.size(); i++)
+		{
+			numDifferent += (expectedDistances[i] != distances[i]) || !(expectedNormals[i] == normals[i]);
+		}
+		return numDifferent;
+	}
+
+	int countEvictableCells(btSparseSdf<3>& sdf)
+	{
+		int numCells = 0;
+		for (int i = 0; i < BT_SPARSE_SDF_STRIPES; i++)
+		{
+			numCells += sdf.stripes[i].ncells;
+		}
+		return numCells;
+	}
+
+}
+
+
+TEST(SparseSdfTest, SameResultsForAnyThreadCount)
+{
+	SdfShapes shapes;
+	btAlignedObjectArray<btVector3> points;
+	makeQueryPoints(points);
+
+	btSparseSdf<3> reference;
+	reference.Initialize();
+	btAlignedObjectArray<btScalar> expectedDistances;
+	btAlignedObjectArray<btVector3> expectedNormals;
+	setTestNumThreads(1);
+	evaluate(reference, shapes, points, expectedDistances, expectedNormals);
+	EXPECT_GT(reference.ncells, 0);
+
+	btAlignedObjectArray<btScalar> distances;
+	btAlignedObjectArray<btVector3> normals;
+	const int threadCounts[] = {2, 4, 8};
+	for (int t = 0; t < 3; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		//cells built concurrently
+		btSparseSdf<3> sdf;
+		sdf.Initialize();
+		evaluate(sdf, shapes, points, distances, normals);
+		EXPECT_EQ(0, countDifferences(expectedDistances, expectedNormals, distances, normals)) << threadCounts[t] << " threads";
+		EXPECT_EQ(reference.ncells, sdf.ncells);
+		//cached cells
+		evaluate(sdf, shapes, points, distances, normals);
+		EXPECT_EQ(0, countDifferences(expectedDistances, expectedNormals, distances, normals)) << threadCounts[t] << " threads, cached";
+		//a cell limit far below the working set, so cells are evicted and rebuilt while other threads read
+		btSparseSdf<3> small;
+		small.Initialize(2383, 256);
+		evaluate(small, shapes, points, distances, normals);
+		EXPECT_EQ(0, countDifferences(expectedDistances, expectedNormals, distances, normals)) << threadCounts[t] << " threads, evicting";
+		EXPECT_LE(small.ncells, btMax(small.m_clampCells, BT_SPARSE_SDF_STRIPES));
+		EXPECT_EQ(small.ncells, countEvictableCells(small));
+	}
+	setTestNumThreads(1);
+}
+
+TEST(SparseSdfTest, PrecomputedCellsCountAgainstLimit)
+{
+	SdfShapes shapes;
+	btSparseSdf<3> sdf;
+	sdf.Initialize(2383, 512);
+
+	const int threadCounts[] = {1, 4};
+	for (int t = 0; t < 2; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		sdf.Reset();
+		int numBoxCells = sdf.Precompute(&shapes.m_box, btScalar(0.1));
+		ASSERT_GT(numBoxCells, 0);
+		EXPECT_EQ(numBoxCells, sdf.npinned);
+		EXPECT_EQ(numBoxCells, sdf.ncells);
+		EXPECT_EQ(0, countEvictableCells(sdf));
+
+		//pinning the same cells again does not count them twice
+		EXPECT_EQ(numBoxCells, sdf.Precompute(&shapes.m_box, btScalar(0.1)));
+		EXPECT_EQ(numBoxCells, sdf.npinned);
+
+		//a shape whose cells don't fit next to the pinned ones is rejected without building anything
+		btBoxShape large(btVector3(6, 6, 6));
+		EXPECT_EQ(0, sdf.Precompute(&large, btScalar(0.1)));
+		EXPECT_EQ(numBoxCells, sdf.npinned);
+		EXPECT_EQ(numBoxCells, sdf.ncells);
+
+		//evaluating other shapes evicts their cells but keeps the pinned ones
+		btAlignedObjectArray<btVector3> points;
+		makeQueryPoints(points);
+		btAlignedObjectArray<btScalar> distances;
+		btAlignedObjectArray<btVector3> normals;
+		for (int pass = 0; pass < 3; pass++)
+		{
+			evaluate(sdf, shapes, points, distances, normals);
+			EXPECT_EQ(numBoxCells, sdf.npinned);
+			EXPECT_EQ(sdf.ncells, sdf.npinned + countEvictableCells(sdf));
+			EXPECT_LE(countEvictableCells(sdf), btMax(sdf.m_clampCells - sdf.npinned, BT_SPARSE_SDF_STRIPES));
+		}
+		for (int i = 0; i < 300; i++)
+		{
+			sdf.GarbageCollect(1);
+		}
+		EXPECT_EQ(numBoxCells, sdf.npinned);
+		EXPECT_EQ(numBoxCells, sdf.ncells);
+
+		//removing the references of a shape releases its pinned cells too
+		sdf.RemoveReferences(&shapes.m_box);
+		EXPECT_EQ(0, sdf.npinned);
+		EXPECT_EQ(0, sdf.ncells);
+	}
+	setTestNumThreads(1);
+}
+
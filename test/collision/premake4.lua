@@ -34,6 +34,7 @@
 		"../../src/BulletCollision/CollisionShapes/btMultiSphereShape.cpp",
 		"../../src/BulletCollision/CollisionShapes/btPolyhedralConvexShape.cpp",
 		"../../src/BulletCollision/CollisionShapes/btConvexShape.cpp",
+		"../../src/BulletCollision/CollisionShapes/btConvexHullShape.cpp",
 		"../../src/BulletCollision/CollisionShapes/btConvexInternalShape.cpp",
 		"../../src/BulletCollision/CollisionShapes/btCollisionShape.cpp",
 		"../../src/BulletCollision/CollisionShapes/btConvexPolyhedron.cpp",
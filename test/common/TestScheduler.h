@@ -0,0 +1,21 @@
+#ifndef TEST_SCHEDULER_H
+#define TEST_SCHEDULER_H
+
+#include "LinearMath/btThreads.h"
+
+///makes btParallelFor use numThreads threads and returns the number it got. Without BT_THREADSAFE (or pthreads)
+///there is no default scheduler, and everything runs on the sequential scheduler with 1 thread.
+inline int setTestNumThreads(int numThreads)
+{
+	static btITaskScheduler* scheduler = btCreateDefaultTaskScheduler();
+	if (scheduler == 0 || numThreads <= 1)
+	{
+		btSetTaskScheduler(0);
+		return 1;
+	}
+	scheduler->setNumThreads(numThreads);
+	btSetTaskScheduler(scheduler);
+	return scheduler->getNumThreads();
+}
+
+#endif //TEST_SCHEDULER_H
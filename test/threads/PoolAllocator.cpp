@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+
+#include "LinearMath/btPoolAllocator.h"
+#include "LinearMath/btAlignedObjectArray.h"
+
+namespace
+{
+
+	const int elementSize = 24;
+
+	///fills each element with its index, so overlapping elements are noticed
+	void fillElements(const btAlignedObjectArray<void*>& elements)
+	{
+		for (int i = 0; i < elements.size(); i++)
+		{
+			int* data = (int*)elements[i];
+			for (int j = 0; j < elementSize / int(sizeof(int)); j++)
+			{
+				data[j] = i;
+			}
+		}
+	}
+
+	int countDamagedElements(btPoolAllocator& pool, const btAlignedObjectArray<void*>& elements)
+	{
+		int numDamaged = 0;
+		for (int i = 0; i < elements.size(); i++)
+		{
+			const int* data = (const int*)elements[i];
+			bool damaged = !pool.validPtr(elements[i]);
+			for (int j = 0; j < elementSize / int(sizeof(int)); j++)
+			{
+				damaged |= data[j] != i;
+			}
+			numDamaged += damaged ? 1 : 0;
+		}
+		return numDamaged;
+	}
+
+}
+
+
+TEST(PoolAllocatorTest, FixedCapacityByDefault)
+{
+	btPoolAllocator pool(elementSize, 10);
+	EXPECT_EQ(0, pool.getGrowSize());
+	EXPECT_EQ(1, pool.getNumChunks());
+	btAlignedObjectArray<void*> elements;
+	while (pool.canAllocate())
+	{
+		elements.push_back(pool.allocate(elementSize));
+	}
+	EXPECT_EQ(10, elements.size());
+	EXPECT_EQ(10, pool.getMaxCount());
+	EXPECT_EQ(1, pool.getNumChunks());
+	fillElements(elements);
+	EXPECT_EQ(0, countDamagedElements(pool, elements));
+	int local = 0;
+	EXPECT_FALSE(pool.validPtr(&local));
+	EXPECT_FALSE(pool.validPtr(0));
+	for (int i = 0; i < elements.size(); i++)
+	{
+		pool.freeMemory(elements[i]);
+	}
+	EXPECT_EQ(10, pool.getFreeCount());
+}
+
+TEST(PoolAllocatorTest, GrowsInFewChunksAndReusesFreedElements)
+{
+	btPoolAllocator pool(elementSize, 4);
+	pool.setGrowSize(3);
+	btAlignedObjectArray<void*> elements;
+	for (int i = 0; i < 1000; i++)
+	{
+		ASSERT_TRUE(pool.canAllocate());
+		elements.push_back(pool.allocate(elementSize));
+	}
+	EXPECT_EQ(1000, pool.getUsedCount());
+	EXPECT_GE(pool.getMaxCount(), 1000);
+	//a new chunk holds at least half the capacity, so the capacity grows geometrically
+	EXPECT_LE(pool.getNumChunks(), 16);
+	fillElements(elements);
+	EXPECT_EQ(0, countDamagedElements(pool, elements));
+
+	//free every other element, allocating them again doesn't add chunks
+	int numChunks = pool.getNumChunks();
+	int maxCount = pool.getMaxCount();
+	for (int i = 0; i < elements.size(); i += 2)
+	{
+		pool.freeMemory(elements[i]);
+	}
+	for (int i = 0; i < elements.size(); i += 2)
+	{
+		elements[i] = pool.allocate(elementSize);
+	}
+	EXPECT_EQ(numChunks, pool.getNumChunks());
+	EXPECT_EQ(maxCount, pool.getMaxCount());
+	fillElements(elements);
+	EXPECT_EQ(0, countDamagedElements(pool, elements));
+}
+
+TEST(PoolAllocatorTest, ReserveKeepsElementsValid)
+{
+	btPoolAllocator pool(elementSize, 0);
+	EXPECT_EQ(0, pool.getMaxCount());
+	EXPECT_EQ(0, pool.getNumChunks());
+	EXPECT_FALSE(pool.canAllocate());
+	EXPECT_TRUE(pool.getPoolAddress() == 0);
+
+	pool.reserve(10);
+	EXPECT_EQ(10, pool.getMaxCount());
+	EXPECT_TRUE(pool.getPoolAddress() != 0);
+	btAlignedObjectArray<void*> elements;
+	for (int i = 0; i < 7; i++)
+	{
+		elements.push_back(pool.allocate(elementSize));
+	}
+	fillElements(elements);
+	const unsigned char* firstChunk = pool.getPoolAddress();
+
+	//the capacity never shrinks
+	pool.reserve(5);
+	EXPECT_EQ(10, pool.getMaxCount());
+	EXPECT_EQ(1, pool.getNumChunks());
+
+	pool.reserve(50);
+	EXPECT_EQ(50, pool.getMaxCount());
+	EXPECT_EQ(2, pool.getNumChunks());
+	EXPECT_EQ(firstChunk, pool.getPoolAddress());
+	EXPECT_EQ(0, countDamagedElements(pool, elements));
+	while (pool.canAllocate())
+	{
+		elements.push_back(pool.allocate(elementSize));
+	}
+	EXPECT_EQ(50, elements.size());
+	fillElements(elements);
+	EXPECT_EQ(0, countDamagedElements(pool, elements));
+}
+
+TEST(PoolAllocatorTest, HighWaterMark)
+{
+	btPoolAllocator pool(elementSize, 20);
+	EXPECT_EQ(0, pool.getHighWaterMark());
+	btAlignedObjectArray<void*> elements;
+	for (int i = 0; i < 15; i++)
+	{
+		elements.push_back(pool.allocate(elementSize));
+	}
+	EXPECT_EQ(15, pool.getHighWaterMark());
+	for (int i = 0; i < 10; i++)
+	{
+		pool.freeMemory(elements[elements.size() - 1]);
+		elements.pop_back();
+	}
+	//freeing keeps the mark
+	EXPECT_EQ(15, pool.getHighWaterMark());
+	elements.push_back(pool.allocate(elementSize));
+	EXPECT_EQ(15, pool.getHighWaterMark());
+
+	//a reset starts from the elements in use
+	pool.resetHighWaterMark();
+	EXPECT_EQ(6, pool.getHighWaterMark());
+	for (int i = 0; i < 3; i++)
+	{
+		elements.push_back(pool.allocate(elementSize));
+	}
+	EXPECT_EQ(9, pool.getHighWaterMark());
+
+	//the mark counts elements of chunks added by growing as well
+	pool.setGrowSize(8);
+	while (elements.size() < 40)
+	{
+		elements.push_back(pool.allocate(elementSize));
+	}
+	EXPECT_EQ(40, pool.getHighWaterMark());
+	EXPECT_GT(pool.getNumChunks(), 1);
+}
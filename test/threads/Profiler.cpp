@@ -0,0 +1,283 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "LinearMath/btQuickprof.h"
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "TestScheduler.h"
+
+#ifndef BT_NO_PROFILE
+
+namespace
+{
+
+	///profiles every range it is given and counts the ranges of each thread. Each range takes a while, so the worker
+	///threads get some of them even on a single core.
+	struct ProfiledBody : public btIParallelForBody
+	{
+		volatile int* m_rangesPerThread;
+		mutable volatile int m_numIterations;
+
+		void forLoop(int iBegin, int iEnd) const
+		{
+			BT_PROFILE("profiledRange");
+			btClock clock;
+			while (clock.getTimeMicroseconds() < 300)
+			{
+			}
+			{
+				BT_PROFILE("innerScope");
+			}
+			btAtomicFetchAdd(&m_rangesPerThread[btGetCurrentThreadIndex()], 1);
+			btAtomicFetchAdd(&m_numIterations, iEnd - iBegin);
+		}
+	};
+
+	///runs a profiled loop of 64 iterations with grain size 1 inside a "profiledLoop" scope on the main thread
+	void runProfiledLoop(btAlignedObjectArray<int>& rangesPerThread)
+	{
+		rangesPerThread.resize(0);
+		rangesPerThread.resize(BT_MAX_THREAD_COUNT, 0);
+		ProfiledBody body;
+		body.m_rangesPerThread = &rangesPerThread[0];
+		body.m_numIterations = 0;
+		{
+			BT_PROFILE("profiledLoop");
+			btParallelFor(0, 64, 1, body);
+		}
+		EXPECT_EQ(64, body.m_numIterations);
+	}
+
+	///the number of calls of the child with the given name, 0 if there is no such child
+	int getChildCalls(CProfileIterator* iterator, const char* name)
+	{
+		for (iterator->First(); !iterator->Is_Done(); iterator->Next())
+		{
+			if (strcmp(iterator->Get_Current_Name(), name) == 0)
+			{
+				return iterator->Get_Current_Total_Calls();
+			}
+		}
+		return 0;
+	}
+
+	bool enterChild(CProfileIterator* iterator, const char* name)
+	{
+		int index = 0;
+		for (iterator->First(); !iterator->Is_Done(); iterator->Next(), index++)
+		{
+			if (strcmp(iterator->Get_Current_Name(), name) == 0)
+			{
+				iterator->Enter_Child(index);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	///one sample of the parsed trace
+	struct TraceEvent
+	{
+		std::string m_name;
+		int m_tid;
+		double m_start;
+		double m_duration;
+	};
+
+	///reads back the events written by Write_Chrome_Trace, one per line
+	bool readChromeTrace(const char* fileName, btAlignedObjectArray<TraceEvent>& events)
+	{
+		FILE* file = fopen(fileName, "r");
+		if (!file)
+		{
+			return false;
+		}
+		char line[1024];
+		bool valid = fgets(line, sizeof(line), file) && strcmp(line, "{\"traceEvents\":[\n") == 0;
+		bool closed = false;
+		while (valid && fgets(line, sizeof(line), file))
+		{
+			if (strcmp(line, "]}\n") == 0)
+			{
+				closed = true;
+				continue;
+			}
+			if (strcmp(line, "\n") == 0)
+			{
+				continue;
+			}
+			const char* nameBegin = strstr(line, "{\"name\":\"");
+			const char* nameEnd = strstr(line, "\",\"cat\":\"bullet\",\"ph\":\"X\",\"pid\":0,");
+			if (!nameBegin || !nameEnd || closed)
+			{
+				valid = false;
+				break;
+			}
+			TraceEvent event;
+			event.m_name.assign(nameBegin + 9, nameEnd);
+			valid = sscanf(nameEnd, "\",\"cat\":\"bullet\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%lf,\"dur\":%lf}", &event.m_tid, &event.m_start, &event.m_duration) == 3;
+			events.push_back(event);
+		}
+		fclose(file);
+		return valid && closed;
+	}
+
+}
+
+
+///every thread records its samples in its own tree, with the calls of the ranges it ran
+TEST(ProfilerTest, PerThreadTrees)
+{
+	const int threadCounts[] = {1, 4};
+	for (int t = 0; t < 2; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		CProfileManager::Reset();
+		btAlignedObjectArray<int> rangesPerThread;
+		runProfiledLoop(rangesPerThread);
+		setTestNumThreads(1);
+
+		int numThreadsUsed = 0;
+		for (int i = 0; i < BT_MAX_THREAD_COUNT; i++)
+		{
+			numThreadsUsed += rangesPerThread[i] ? 1 : 0;
+			CProfileIterator* iterator = CProfileManager::Get_Iterator(i);
+			if (i == 0)
+			{
+				//the main thread runs its ranges inside the loop scope
+				ASSERT_TRUE(iterator != 0);
+				EXPECT_EQ(1, getChildCalls(iterator, "profiledLoop"));
+				ASSERT_TRUE(enterChild(iterator, "profiledLoop"));
+			}
+			if (iterator)
+			{
+				EXPECT_EQ(rangesPerThread[i], getChildCalls(iterator, "profiledRange")) << "thread " << i;
+				if (rangesPerThread[i])
+				{
+					ASSERT_TRUE(enterChild(iterator, "profiledRange"));
+					EXPECT_EQ(rangesPerThread[i], getChildCalls(iterator, "innerScope")) << "thread " << i;
+				}
+				CProfileManager::Release_Iterator(iterator);
+			}
+			else
+			{
+				EXPECT_EQ(0, rangesPerThread[i]) << "thread " << i;
+			}
+		}
+		EXPECT_GT(rangesPerThread[0], 0);
+		if (threadCounts[t] == 1)
+		{
+			EXPECT_EQ(1, numThreadsUsed);
+		}
+#if BT_THREADSAFE
+		else
+		{
+			EXPECT_GT(numThreadsUsed, 1);
+		}
+#endif
+	}
+	//Reset clears the calls of the worker trees too
+	CProfileManager::Reset();
+	for (int i = 1; i < BT_MAX_THREAD_COUNT; i++)
+	{
+		CProfileIterator* iterator = CProfileManager::Get_Iterator(i);
+		if (iterator)
+		{
+			EXPECT_EQ(0, getChildCalls(iterator, "profiledRange")) << "thread " << i;
+			CProfileManager::Release_Iterator(iterator);
+		}
+	}
+}
+
+///the trace has one complete event per sample, on the timeline of the thread that took it, with nested samples inside
+///their parent
+TEST(ProfilerTest, WriteChromeTrace)
+{
+	const char* fileName = "ProfilerTest_trace.json";
+	setTestNumThreads(4);
+	CProfileManager::Reset();
+	CProfileManager::Set_Trace_Enabled(true);
+	btAlignedObjectArray<int> rangesPerThread;
+	runProfiledLoop(rangesPerThread);
+	{
+		BT_PROFILE("name \"with\" quotes\\");
+	}
+	CProfileManager::Set_Trace_Enabled(false);
+	setTestNumThreads(1);
+	//samples taken after the trace was disabled are not recorded
+	{
+		BT_PROFILE("profiledLoop");
+	}
+	ASSERT_TRUE(CProfileManager::Write_Chrome_Trace(fileName));
+	CProfileManager::Clear_Trace();
+
+	btAlignedObjectArray<TraceEvent> events;
+	ASSERT_TRUE(readChromeTrace(fileName, events));
+	remove(fileName);
+
+	btAlignedObjectArray<int> rangeEvents;
+	rangeEvents.resize(BT_MAX_THREAD_COUNT, 0);
+	int numLoops = 0;
+	int numQuoted = 0;
+	const TraceEvent* loop = 0;
+	for (int i = 0; i < events.size(); i++)
+	{
+		const TraceEvent& event = events[i];
+		ASSERT_GE(event.m_tid, 0);
+		ASSERT_LT(event.m_tid, BT_MAX_THREAD_COUNT);
+		EXPECT_GE(event.m_duration, 0);
+		if (event.m_name == "profiledLoop")
+		{
+			EXPECT_EQ(0, event.m_tid);
+			loop = &event;
+			numLoops++;
+		}
+		else if (event.m_name == "profiledRange")
+		{
+			rangeEvents[event.m_tid]++;
+			//the inner scope is recorded right after its range, on the same thread and inside the range
+			ASSERT_LT(i + 1, events.size());
+			const TraceEvent& inner = events[i + 1];
+			EXPECT_EQ("innerScope", inner.m_name);
+			EXPECT_EQ(event.m_tid, inner.m_tid);
+			EXPECT_GE(inner.m_start, event.m_start);
+			EXPECT_LE(inner.m_start + inner.m_duration, event.m_start + event.m_duration + 0.001);
+		}
+		else if (event.m_name == "name \\\"with\\\" quotes\\\\")
+		{
+			numQuoted++;
+		}
+		else
+		{
+			EXPECT_EQ("innerScope", event.m_name);
+		}
+	}
+	EXPECT_EQ(1, numLoops);
+	EXPECT_EQ(1, numQuoted);
+	for (int i = 0; i < BT_MAX_THREAD_COUNT; i++)
+	{
+		EXPECT_EQ(rangesPerThread[i], rangeEvents[i]) << "thread " << i;
+	}
+	//the ranges of the main thread lie inside the loop
+	ASSERT_TRUE(loop != 0);
+	for (int i = 0; i < events.size(); i++)
+	{
+		if (events[i].m_tid == 0 && events[i].m_name == "profiledRange")
+		{
+			EXPECT_GE(events[i].m_start, loop->m_start);
+			EXPECT_LE(events[i].m_start + events[i].m_duration, loop->m_start + loop->m_duration + 0.001);
+		}
+	}
+
+	//the cleared trace has no events left
+	ASSERT_TRUE(CProfileManager::Write_Chrome_Trace(fileName));
+	events.resize(0);
+	EXPECT_TRUE(readChromeTrace(fileName, events));
+	EXPECT_EQ(0, events.size());
+	remove(fileName);
+}
+
+#endif //BT_NO_PROFILE
@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+
+#include "LinearMath/btThreads.h"
+#include "LinearMath/btAlignedObjectArray.h"
+#include "LinearMath/btMinMax.h"
+#include "TestScheduler.h"
+
+#if BT_THREADSAFE && !defined(_WIN32)
+#include <pthread.h>
+#endif
+
+namespace
+{
+
+	///counts how often each index was visited and checks that the sub-ranges it is given are not empty and inside the loop
+	struct CountingBody : public btIParallelForBody
+	{
+		int m_begin;
+		int m_end;
+		volatile int* m_counts;
+		mutable volatile int m_badRanges;
+		mutable volatile int m_badThreadIndices;
+
+		void forLoop(int iBegin, int iEnd) const
+		{
+			if (iBegin < m_begin || iEnd > m_end || iBegin >= iEnd)
+			{
+				btAtomicFetchAdd(&m_badRanges, 1);
+				return;
+			}
+			if (btGetCurrentThreadIndex() >= BT_OVERFLOW_THREAD_INDEX)
+			{
+				btAtomicFetchAdd(&m_badThreadIndices, 1);
+			}
+			for (int i = iBegin; i < iEnd; i++)
+			{
+				btAtomicFetchAdd(&m_counts[i - m_begin], 1);
+			}
+		}
+	};
+
+	void checkParallelFor(int iBegin, int iEnd, int grainSize)
+	{
+		btAlignedObjectArray<int> counts;
+		counts.resize(btMax(iEnd - iBegin, 1), 0);
+		CountingBody body;
+		body.m_begin = iBegin;
+		body.m_end = iEnd;
+		body.m_counts = &counts[0];
+		body.m_badRanges = 0;
+		body.m_badThreadIndices = 0;
+		btParallelFor(iBegin, iEnd, grainSize, body);
+		EXPECT_EQ(0, body.m_badRanges);
+		EXPECT_EQ(0, body.m_badThreadIndices);
+		int numWrong = 0;
+		for (int i = 0; i < iEnd - iBegin; i++)
+		{
+			numWrong += (counts[i] != 1);
+		}
+		EXPECT_EQ(0, numWrong) << "range [" << iBegin << "," << iEnd << ") grain " << grainSize;
+	}
+
+	///runs a btParallelFor from inside each chunk of an outer one
+	struct NestedBody : public btIParallelForBody
+	{
+		volatile int* m_counts;
+		int m_innerSize;
+
+		void forLoop(int iBegin, int iEnd) const
+		{
+			for (int i = iBegin; i < iEnd; i++)
+			{
+				CountingBody inner;
+				inner.m_begin = i * m_innerSize;
+				inner.m_end = (i + 1) * m_innerSize;
+				inner.m_counts = m_counts + i * m_innerSize;
+				inner.m_badRanges = 0;
+				inner.m_badThreadIndices = 0;
+				btParallelFor(inner.m_begin, inner.m_end, 5, inner);
+				if (inner.m_badRanges)
+				{
+					m_counts[i * m_innerSize] += 1000;
+				}
+			}
+		}
+	};
+
+}
+
+
+TEST(ThreadsTest, ParallelForCoversRangeExactlyOnce)
+{
+	const int threadCounts[] = {1, 2, 4, 8};
+	const int ranges[][2] = {{0, 0}, {0, 1}, {3, 10}, {-50, 50}, {0, 1000}, {17, 10024}};
+	const int grainSizes[] = {1, 3, 64, 100000};
+	for (int t = 0; t < 4; t++)
+	{
+		setTestNumThreads(threadCounts[t]);
+		for (int r = 0; r < 6; r++)
+		{
+			for (int g = 0; g < 4; g++)
+			{
+				checkParallelFor(ranges[r][0], ranges[r][1], grainSizes[g]);
+			}
+		}
+	}
+	setTestNumThreads(1);
+}
+
+TEST(ThreadsTest, NestedParallelForCoversRangeExactlyOnce)
+{
+	const int outerSize = 40;
+	const int innerSize = 33;
+	btAlignedObjectArray<int> counts;
+	counts.resize(outerSize * innerSize, 0);
+	NestedBody body;
+	body.m_counts = &counts[0];
+	body.m_innerSize = innerSize;
+	setTestNumThreads(4);
+	btParallelFor(0, outerSize, 1, body);
+	setTestNumThreads(1);
+	int numWrong = 0;
+	for (int i = 0; i < counts.size(); i++)
+	{
+		numWrong += (counts[i] != 1);
+	}
+	EXPECT_EQ(0, numWrong);
+}
+
+#if BT_THREADSAFE && !defined(_WIN32)
+
+namespace
+{
+	struct ThreadIndexQuery
+	{
+		pthread_mutex_t* m_mutex;
+		pthread_cond_t* m_cond;
+		volatile int* m_numWaiting;
+		int m_numThreads;
+		unsigned int m_index;
+	};
+
+	///gets an index, then waits until all threads of the test have one so they are alive at the same time
+	void* queryThreadIndex(void* arg)
+	{
+		ThreadIndexQuery* query = (ThreadIndexQuery*)arg;
+		query->m_index = btGetCurrentThreadIndex();
+		if (query->m_mutex)
+		{
+			pthread_mutex_lock(query->m_mutex);
+			if (++*query->m_numWaiting == query->m_numThreads)
+			{
+				pthread_cond_broadcast(query->m_cond);
+			}
+			while (*query->m_numWaiting < query->m_numThreads)
+			{
+				pthread_cond_wait(query->m_cond, query->m_mutex);
+			}
+			pthread_mutex_unlock(query->m_mutex);
+		}
+		return 0;
+	}
+}
+
+TEST(ThreadsTest, ThreadIndexIsReusedAfterThreadExit)
+{
+	EXPECT_EQ(0u, btGetCurrentThreadIndex());
+	int overflowCountBefore = btGetThreadIndexOverflowCount();
+	unsigned int firstIndex = 0;
+	for (int i = 0; i < 3 * BT_MAX_THREAD_COUNT; i++)
+	{
+		ThreadIndexQuery query;
+		query.m_mutex = 0;
+		pthread_t thread;
+		ASSERT_EQ(0, pthread_create(&thread, 0, queryThreadIndex, &query));
+		pthread_join(thread, 0);
+		if (i == 0)
+		{
+			firstIndex = query.m_index;
+		}
+		EXPECT_EQ(firstIndex, query.m_index);
+	}
+	EXPECT_GT(firstIndex, 0u);
+	EXPECT_LT(firstIndex, (unsigned int)BT_OVERFLOW_THREAD_INDEX);
+	EXPECT_EQ(overflowCountBefore, btGetThreadIndexOverflowCount());
+}
+
+TEST(ThreadsTest, ConcurrentThreadsGetUniqueIndicesOrOverflow)
+{
+	const int numThreads = BT_MAX_THREAD_COUNT + 8;
+	pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+	volatile int numWaiting = 0;
+	btAlignedObjectArray<ThreadIndexQuery> queries;
+	btAlignedObjectArray<pthread_t> threads;
+	queries.resize(numThreads);
+	threads.resize(numThreads);
+	int overflowCountBefore = btGetThreadIndexOverflowCount();
+	for (int i = 0; i < numThreads; i++)
+	{
+		queries[i].m_mutex = &mutex;
+		queries[i].m_cond = &cond;
+		queries[i].m_numWaiting = &numWaiting;
+		queries[i].m_numThreads = numThreads;
+		ASSERT_EQ(0, pthread_create(&threads[i], 0, queryThreadIndex, &queries[i]));
+	}
+	for (int i = 0; i < numThreads; i++)
+	{
+		pthread_join(threads[i], 0);
+	}
+	int useCount[BT_MAX_THREAD_COUNT] = {0};
+	for (int i = 0; i < numThreads; i++)
+	{
+		ASSERT_LT(queries[i].m_index, (unsigned int)BT_MAX_THREAD_COUNT);
+		useCount[queries[i].m_index]++;
+	}
+	EXPECT_EQ(0, useCount[0]);
+	int numOverflow = useCount[BT_OVERFLOW_THREAD_INDEX];
+	for (int i = 1; i < BT_OVERFLOW_THREAD_INDEX; i++)
+	{
+		//an index can only be missing if a scheduler worker still holds it
+		EXPECT_LE(useCount[i], 1);
+	}
+	EXPECT_GE(numOverflow, numThreads - (BT_OVERFLOW_THREAD_INDEX - 1));
+	EXPECT_EQ(overflowCountBefore + numOverflow, btGetThreadIndexOverflowCount());
+}
+
+#endif //BT_THREADSAFE && !_WIN32
+
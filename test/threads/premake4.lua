@@ -0,0 +1,30 @@
+
+	project "Test_Threads"
+		
+	kind "ConsoleApp"
+	
+	includedirs 
+	{
+		".",
+		"../common",
+		"../../src",
+		"../gtest-1.7.0/include"
+	
+	}
+
+
+	if os.is("Windows") then
+		--see http://stackoverflow.com/questions/12558327/google-test-in-visual-studio-2012
+		defines {"_VARIADIC_MAX=10"}
+	end
+	
+	links {"LinearMath", "gtest"}
+	
+	files {
+		"**.cpp",
+		"../common/TestScheduler.h",
+	}
+
+	if os.is("Linux") then
+                links {"pthread"}
+        end